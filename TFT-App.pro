@@ -15,37 +15,95 @@ PKGCONFIG += gstreamer-1.0 gstreamer-app-1.0 gstreamer-audio-1.0
 # Si quieres desactivar APIs obsoletas antes de Qt 6.0:
 # DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000
 
+# Nivel mínimo de logging compilado (0=debug, 1=info, 2=warning, 3=critical)
+# DEFINES += TFT_LOG_MIN_LEVEL=1
+
 SOURCES += \
+    core/async_logger.cpp \
+    core/async_task.cpp \
     core/audio_db.cpp \
+    core/audio_db_reader.cpp \
+    core/compact_spectrum.cpp \
     core/controller.cpp \
+    core/cross_correlator.cpp \
+    core/envelope_analyzer.cpp \
+    core/feature_extractor.cpp \
+    core/fingerprinter.cpp \
+    core/frame_bus.cpp \
+    core/fft_plan_cache.cpp \
+    core/gorilla_codec.cpp \
+    core/metrics_registry.cpp \
     core/realtime_data_service.cpp \
+    core/rollup_aggregator.cpp \
+    core/session_file.cpp \
+    core/session_store_pool.cpp \
+    core/sparse_block_index.cpp \
     models/audio_block_model.cpp \
     receivers/audio_receiver.cpp \
     core/dsp_worker.cpp \
     core/spectrogram_calculator.cpp \
+    core/render_timing_stats.cpp \
+    core/spectrogram_pyramid.cpp \
+    core/spectrum_kernels.cpp \
+    core/spectrum_store.cpp \
+    core/startup_profiler.cpp \
+    core/thread_tuning.cpp \
+    core/transfer_function.cpp \
     main.cpp \
     main_moc.cpp \
     gui/mainwindow.cpp \
     receivers/network_receiver.cpp \
+    views/rendered_tile_cache.cpp \
     views/spectrogram_renderer.cpp \
+    views/spectrum_analyzer_view.cpp \
+    views/waveform_data_provider.cpp \
+    views/waveform_raster.cpp \
     views/waveform_render.cpp
     #tests/audio_processor_test.cpp \
 
 HEADERS += \
     config/audio_configs.h \
+    core/analysis_types.h \
+    core/async_logger.h \
+    core/async_task.h \
     core/audio_db.h \
+    core/audio_db_reader.h \
+    core/compact_spectrum.h \
     core/controller.h \
+    core/cross_correlator.h \
+    core/envelope_analyzer.h \
+    core/feature_extractor.h \
+    core/fingerprinter.h \
+    core/frame_bus.h \
+    core/fft_plan_cache.h \
+    core/gorilla_codec.h \
+    core/metrics_registry.h \
     core/realtime_data_service.h \
+    core/rollup_aggregator.h \
+    core/session_file.h \
+    core/session_store_pool.h \
+    core/sparse_block_index.h \
     models/audio_block_model.h \
     receivers/audio_receiver.h \
     core/dsp_worker.h \
     core/spectrogram_calculator.h \
+    core/render_timing_stats.h \
+    core/spectrogram_pyramid.h \
+    core/spectrum_kernels.h \
+    core/spectrum_store.h \
+    core/startup_profiler.h \
+    core/thread_tuning.h \
+    core/transfer_function.h \
     receivers/ireceiver.h \
     models/peak_model.h \
     models/spectrogram_model.h \
     gui/mainwindow.h \
     receivers/network_receiver.h \
+    views/rendered_tile_cache.h \
     views/spectrogram_renderer.h \
+    views/spectrum_analyzer_view.h \
+    views/waveform_data_provider.h \
+    views/waveform_raster.h \
     views/waveform_render.h
 
 FORMS += \
@@ -3,6 +3,8 @@
 #include "qobject.h"
 #include "qurl.h"
 #include <QString>
+#include <QVector>
+#include <QPair>
 #include <QAudioFormat>
 
 struct IReceiverConfig {
@@ -240,6 +242,54 @@ struct DSPConfig {
     bool logScale = true;       ///< Aplicar escala logarítmica (dB)
     float noiseFloor = -100.0f; ///< Piso de ruido en dB
 
+    // Formato compacto del espectro (FrameData::compactSpectrum, vistas y DB)
+    int spectrumFormat = 0;        ///< 0=Float32 (FrameData::spectrum), 1=Float16, 2=UInt16, 3=UInt8
+    float spectrumMaxDb = 20.0f;   ///< Rango cuantificado [noiseFloor, spectrumMaxDb]
+    bool storeSpectrum = false;    ///< Guardar el espectro de cada bloque en audio_spectra
+
+    // Pirámide de teselas del espectrograma (zoom rápido en sesiones largas)
+    bool enablePyramid = false;       ///< Mantener y guardar spectrogram_tiles
+    int pyramidTileColumns = 256;     ///< Columnas por tesela
+    int pyramidLevels = 12;           ///< Niveles (el nivel k reduce 2^k bloques)
+    int pyramidFreqDecimation = 1;    ///< Bins de entrada por bin de tesela
+    bool pyramidUseMax = true;        ///< Reducción temporal por máximo (false = media)
+
+    // Fichero de sesión columnar (core/session_file.h), escrito junto a la DB
+    QString sessionFilePath;          ///< Vacío = no se escribe
+    int sessionChunkBlocks = 64;      ///< Bloques por chunk (pérdida máxima si se interrumpe)
+
+    // Análisis multicanal
+    int channelCount = 1;       ///< Canales intercalados en cada bloque (1 = mono)
+    bool enableTdoa = false;    ///< Estimar TDOA (GCC-PHAT) entre pares de canales
+    QVector<QPair<int, int>> tdoaPairs; ///< Pares a correlar (vacío = todos)
+    double tdoaMaxDelaySec = 0.0;       ///< Retardo máximo buscado (0 = fftSize/2)
+    bool enableTransferFunction = false; ///< Estimar H1/H2 y coherencia entre dos canales
+    int tfReferenceChannel = 0;  ///< Canal de referencia (excitación)
+    int tfResponseChannel = 1;   ///< Canal de respuesta medida
+    int tfAverages = 64;         ///< Frames del promedio Welch (0 = acumulativo sin límite)
+
+    // Análisis de envolvente (demodulación Hilbert, por canal)
+    bool enableEnvelope = false;     ///< Calcular espectros de envolvente
+    float envBandLowHz = 1000.0f;    ///< Límite inferior del pasa-banda
+    float envBandHighHz = 5000.0f;   ///< Límite superior del pasa-banda
+    int envSegmentSize = 4096;       ///< Longitud FFT de la señal analítica
+    int envDecimation = 0;           ///< Decimación de la envolvente (0 = automática)
+    int envSpectrumSize = 0;         ///< Longitud FFT de la envolvente (0 = fftSize)
+
+    // Descriptores de audio (MFCC, centroide, rolloff, planitud, ZCR)
+    bool enableFeatures = false; ///< Calcular y almacenar descriptores por bloque
+    int melBands = 26;           ///< Filtros del banco mel
+    int mfccCount = 13;          ///< Coeficientes MFCC
+
+    // Huella de audio (constelación de picos) para búsqueda en sesiones
+    bool enableFingerprint = false;     ///< Generar hashes e indexarlos en AudioDb
+    float fingerprintMinHz = 250.0f;    ///< Banda de búsqueda de picos
+    float fingerprintMaxHz = 5000.0f;
+
+    /// Contenido de FrameData::spectrum (0=Magnitud, 1=|H1| dB, 2=|H2| dB, 3=Coherencia dB,
+    /// 4=Espectro de envolvente del canal 0)
+    int spectrumView = 0;
+
     // Constructor por defecto
     DSPConfig() = default;
 
@@ -251,3 +301,23 @@ struct DSPConfig {
         , hopSize(fftSz / 2)  // Hop size típico es la mitad del FFT size
     {}
 };
+
+/**
+ * @brief Planificación de un hilo del pipeline (captura o DSP)
+ *
+ * Se aplica dentro del propio hilo. Si no hay privilegios para la
+ * política de tiempo real se recurre a niceValue y se registra el motivo.
+ */
+struct ThreadSchedulingConfig {
+    enum Policy { Default = 0, Fifo, RoundRobin };
+
+    Policy policy       = Default;  ///< SCHED_OTHER / SCHED_FIFO / SCHED_RR
+    int realtimePriority = 50;      ///< 1–99, sólo para Fifo/RoundRobin
+    int niceValue        = 0;       ///< -20–19 (0 = no tocar); también fallback sin privilegios
+    QVector<int> cpuAffinity;       ///< Núcleos permitidos (vacío = sin fijar)
+    bool lockMemory      = false;   ///< mlock de los buffers calientes del hilo
+
+    bool isDefault() const {
+        return policy == Default && niceValue == 0 && cpuAffinity.isEmpty() && !lockMemory;
+    }
+};
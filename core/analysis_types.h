@@ -0,0 +1,94 @@
+#ifndef ANALYSIS_TYPES_H
+#define ANALYSIS_TYPES_H
+
+#include <QVector>
+#include <QtTypes>
+
+/**
+ * @brief Tipos compartidos entre las etapas de análisis del DSPWorker
+ *
+ * Este header no depende de SpectrogramCalculator para que FrameData
+ * pueda transportar los resultados sin arrastrar sus configuraciones.
+ */
+
+/**
+ * @brief Espectro complejo de un frame en formato separado (re/im)
+ *
+ * El formato separado permite que las etapas que combinan canales
+ * (correlación cruzada, espectros cruzados) operen con bucles
+ * vectorizables sobre arrays contiguos.
+ */
+struct ComplexSpectrum {
+    QVector<float> re;            ///< Parte real de cada bin
+    QVector<float> im;            ///< Parte imaginaria de cada bin
+    int fftSize = 0;              ///< Tamaño de la FFT que lo generó
+
+    int bins() const { return re.size(); }
+    bool isEmpty() const { return re.isEmpty(); }
+};
+
+/**
+ * @brief Estimación de retardo (TDOA) entre dos canales
+ */
+struct TdoaEstimate {
+    int   channelA = 0;           ///< Canal de referencia
+    int   channelB = 0;           ///< Canal comparado
+    float delaySamples = 0.0f;    ///< Retardo de B respecto de A (interpolado)
+    float delaySeconds = 0.0f;    ///< Retardo de B respecto de A en segundos
+    float peak = 0.0f;            ///< Altura del pico GCC-PHAT normalizada (0..1)
+};
+
+/**
+ * @brief Función de transferencia y coherencia entre dos canales
+ *
+ * Estimada con espectros cruzados promediados (Welch):
+ * H1 = Gxy/Gxx, H2 = Gyy/Gyx y γ² = |Gxy|²/(Gxx·Gyy).
+ */
+struct TransferFunctionFrame {
+    QVector<float> h1MagDb;       ///< |H1| en dB
+    QVector<float> h2MagDb;       ///< |H2| en dB
+    QVector<float> phaseRad;      ///< Fase de H1 (= fase de H2) en radianes
+    QVector<float> coherence;     ///< Coherencia magnitud-cuadrado (0..1)
+    int averages = 0;             ///< Frames acumulados en el promedio
+
+    bool isEmpty() const { return h1MagDb.isEmpty(); }
+};
+
+/**
+ * @brief Espectro de envolvente (demodulación Hilbert) de un canal
+ */
+struct EnvelopeSpectrum {
+    int channel = 0;              ///< Canal analizado
+    float binHz = 0.0f;           ///< Resolución en Hz de cada bin
+    float envelopeRate = 0.0f;    ///< Frecuencia de muestreo de la envolvente decimada
+    QVector<float> magnitudesDb;  ///< Magnitudes del espectro de envolvente en dB
+};
+
+/**
+ * @brief Descriptores de audio de un frame (MFCC y espectrales)
+ */
+struct AudioFeatures {
+    float centroidHz = 0.0f;       ///< Centroide espectral
+    float rolloffHz = 0.0f;        ///< Frecuencia bajo la que queda rolloffFraction de la energía
+    float flatness = 0.0f;         ///< Planitud espectral (0 = tonal, 1 = ruido blanco)
+    float zeroCrossingRate = 0.0f; ///< Cruces por cero por muestra
+    QVector<float> mfcc;           ///< Coeficientes cepstrales en escala mel
+
+    /** Número de descriptores escalares (todo salvo los MFCC) */
+    static constexpr int ScalarCount = 4;
+
+    bool isEmpty() const { return mfcc.isEmpty(); }
+};
+
+/**
+ * @brief Hash de un par de picos espectrales (huella de audio)
+ *
+ * Codifica (bin del ancla, bin del destino, Δframes) en 32 bits; anchorFrame
+ * es el índice de bloque del pico ancla.
+ */
+struct FingerprintHash {
+    quint32 hash = 0;
+    qint64 anchorFrame = 0;
+};
+
+#endif // ANALYSIS_TYPES_H
@@ -0,0 +1,319 @@
+#include "async_logger.h"
+#include <QDateTime>
+#include <QFile>
+#include <QThread>
+#include <cstdio>
+#include <cstdlib>
+#include <utility>
+
+Q_LOGGING_CATEGORY(lcDsp, "tft.dsp")
+Q_LOGGING_CATEGORY(lcDb,  "tft.db")
+Q_LOGGING_CATEGORY(lcNet, "tft.net")
+Q_LOGGING_CATEGORY(lcUi,  "tft.ui")
+
+namespace {
+struct LogRecord {
+    QtMsgType type = QtDebugMsg;
+    qint64 msecs = 0;
+    const char* category = nullptr;   ///< Literal estático de QLoggingCategory
+    QString text;
+    quint32 suppressed = 0;           ///< Mensajes omitidos justo antes de éste
+};
+
+const char* levelName(QtMsgType type) {
+    switch (type) {
+    case QtDebugMsg:    return "debug";
+    case QtInfoMsg:     return "info";
+    case QtWarningMsg:  return "warning";
+    case QtCriticalMsg: return "critical";
+    case QtFatalMsg:    return "fatal";
+    }
+    return "?";
+}
+
+QByteArray formatRecord(const LogRecord& r) {
+    QByteArray line = QDateTime::fromMSecsSinceEpoch(r.msecs).toString("HH:mm:ss.zzz").toUtf8();
+    line += " [";
+    line += levelName(r.type);
+    line += "] ";
+    if (r.category && qstrcmp(r.category, "default") != 0) {
+        line += r.category;
+        line += ": ";
+    }
+    line += r.text.toUtf8();
+    if (r.suppressed > 0) {
+        line += " (+" + QByteArray::number(r.suppressed) + " suprimidos)";
+    }
+    line += '\n';
+    return line;
+}
+}
+
+/**
+ * @brief Anillo SPSC de registros: un hilo productor, el hilo de volcado consumidor
+ */
+class LogRing
+{
+public:
+    explicit LogRing(int capacity) : m_slots(size_t(capacity)) {}
+
+    bool push(LogRecord&& record) {
+        const size_t head = m_head.load(std::memory_order_relaxed);
+        const size_t next = (head + 1) % m_slots.size();
+        if (next == m_tail.load(std::memory_order_acquire)) {
+            return false;
+        }
+        m_slots[head] = std::move(record);
+        m_head.store(next, std::memory_order_release);
+        return true;
+    }
+
+    bool pop(LogRecord& out) {
+        const size_t tail = m_tail.load(std::memory_order_relaxed);
+        if (tail == m_head.load(std::memory_order_acquire)) {
+            return false;
+        }
+        out = std::exchange(m_slots[tail], LogRecord());
+        m_tail.store((tail + 1) % m_slots.size(), std::memory_order_release);
+        return true;
+    }
+
+    bool isEmpty() const {
+        return m_tail.load(std::memory_order_acquire) == m_head.load(std::memory_order_acquire);
+    }
+
+    std::atomic<bool> orphaned { false };   ///< El hilo propietario terminó
+
+private:
+    std::vector<LogRecord> m_slots;
+    std::atomic<size_t> m_head { 0 };
+    std::atomic<size_t> m_tail { 0 };
+};
+
+/**
+ * @brief Estado por hilo: su anillo y sus cubos de tokens por categoría
+ */
+struct LoggerThreadState {
+    struct Bucket {
+        double tokens = 0.0;
+        qint64 lastMs = 0;
+        double perSecond = 0.0;
+        int burst = 0;
+        quint32 suppressed = 0;
+    };
+
+    std::shared_ptr<LogRing> ring;
+    QHash<const char*, Bucket> buckets;
+    int generation = -1;
+
+    ~LoggerThreadState() {
+        if (ring) ring->orphaned.store(true, std::memory_order_release);
+    }
+};
+
+namespace {
+thread_local LoggerThreadState t_state;
+constexpr int kRingCapacity = 1024;
+}
+
+AsyncLogger& AsyncLogger::instance() {
+    static AsyncLogger logger;
+    return logger;
+}
+
+AsyncLogger::~AsyncLogger() {
+    shutdown();
+}
+
+void AsyncLogger::install(const QString& logFilePath) {
+    if (m_running.load()) {
+        return;
+    }
+
+    if (!logFilePath.isEmpty()) {
+        m_file = std::make_unique<QFile>(logFilePath);
+        if (!m_file->open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text)) {
+            std::fprintf(stderr, "AsyncLogger: no se pudo abrir %s\n", qPrintable(logFilePath));
+            m_file.reset();
+        }
+    }
+
+    m_running.store(true);
+    m_flusher = QThread::create([this]() { flusherLoop(); });
+    m_flusher->setObjectName("AsyncLogger");
+    m_flusher->start(QThread::LowPriority);
+
+    m_previous = qInstallMessageHandler(&AsyncLogger::messageHandler);
+}
+
+void AsyncLogger::shutdown() {
+    if (!m_running.exchange(false)) {
+        return;
+    }
+
+    qInstallMessageHandler(m_previous);
+    m_previous = nullptr;
+
+    {
+        QMutexLocker lock(&m_wakeMutex);
+        m_wake.wakeAll();
+    }
+    if (m_flusher) {
+        m_flusher->wait();
+        delete m_flusher;
+        m_flusher = nullptr;
+    }
+
+    // Lo que quedase tras la última vuelta del hilo de volcado
+    drainAll();
+    m_file.reset();
+}
+
+void AsyncLogger::setDefaultRate(double messagesPerSecond, int burst) {
+    QMutexLocker lock(&m_rateMutex);
+    m_defaultRate = { messagesPerSecond, burst };
+    m_rateGeneration.fetch_add(1, std::memory_order_release);
+}
+
+void AsyncLogger::setCategoryRate(const QByteArray& category, double messagesPerSecond, int burst) {
+    QMutexLocker lock(&m_rateMutex);
+    m_rates.insert(category, { messagesPerSecond, burst });
+    m_rateGeneration.fetch_add(1, std::memory_order_release);
+}
+
+AsyncLogger::Rate AsyncLogger::rateFor(const char* category) {
+    QMutexLocker lock(&m_rateMutex);
+    return m_rates.value(QByteArray(category), m_defaultRate);
+}
+
+void AsyncLogger::messageHandler(QtMsgType type, const QMessageLogContext& context, const QString& msg) {
+    AsyncLogger& self = instance();
+
+    if (type == QtFatalMsg || !self.m_running.load(std::memory_order_acquire)) {
+        // Síncrono: el proceso puede terminar justo después
+        self.drainAll();
+        if (self.m_previous) {
+            self.m_previous(type, context, msg);
+        } else {
+            std::fprintf(stderr, "%s\n", qPrintable(qFormatLogMessage(type, context, msg)));
+        }
+        if (type == QtFatalMsg) {
+            std::abort();
+        }
+        return;
+    }
+
+    self.enqueue(type, context.category ? context.category : "default", msg);
+}
+
+bool AsyncLogger::admit(const char* category, quint32& suppressedBefore) {
+    LoggerThreadState& state = t_state;
+
+    // Configuración cambiada: descartar cubos para recargar las tasas
+    const int generation = m_rateGeneration.load(std::memory_order_acquire);
+    if (state.generation != generation) {
+        state.buckets.clear();
+        state.generation = generation;
+    }
+
+    auto it = state.buckets.find(category);
+    if (it == state.buckets.end()) {
+        const Rate rate = rateFor(category);
+        LoggerThreadState::Bucket bucket;
+        bucket.perSecond = rate.perSecond;
+        bucket.burst = qMax(1, rate.burst);
+        bucket.tokens = bucket.burst;
+        bucket.lastMs = QDateTime::currentMSecsSinceEpoch();
+        it = state.buckets.insert(category, bucket);
+    }
+
+    LoggerThreadState::Bucket& b = it.value();
+    if (b.perSecond <= 0.0) {
+        suppressedBefore = 0;
+        return true;
+    }
+
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    b.tokens = qMin<double>(b.burst, b.tokens + (now - b.lastMs) * b.perSecond / 1000.0);
+    b.lastMs = now;
+
+    if (b.tokens < 1.0) {
+        ++b.suppressed;
+        m_suppressed.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    b.tokens -= 1.0;
+    suppressedBefore = std::exchange(b.suppressed, 0);
+    return true;
+}
+
+std::shared_ptr<LogRing> AsyncLogger::ringForCurrentThread() {
+    LoggerThreadState& state = t_state;
+    if (!state.ring) {
+        state.ring = std::make_shared<LogRing>(kRingCapacity);
+        QMutexLocker lock(&m_ringsMutex);
+        m_rings.push_back(state.ring);
+    }
+    return state.ring;
+}
+
+void AsyncLogger::enqueue(QtMsgType type, const char* category, const QString& msg) {
+    LogRecord record;
+    record.type = type;
+    record.category = category;
+
+    // critical nunca se limita
+    if (type != QtCriticalMsg && !admit(category, record.suppressed)) {
+        return;
+    }
+
+    record.msecs = QDateTime::currentMSecsSinceEpoch();
+    record.text = msg;
+
+    if (!ringForCurrentThread()->push(std::move(record))) {
+        m_dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void AsyncLogger::flusherLoop() {
+    while (m_running.load(std::memory_order_acquire)) {
+        {
+            QMutexLocker lock(&m_wakeMutex);
+            m_wake.wait(&m_wakeMutex, m_flushIntervalMs);
+        }
+        drainAll();
+    }
+}
+
+void AsyncLogger::drainAll() {
+    QMutexLocker lock(&m_ringsMutex);
+
+    QByteArray out;
+    LogRecord record;
+    for (auto it = m_rings.begin(); it != m_rings.end();) {
+        LogRing& ring = **it;
+        while (ring.pop(record)) {
+            out += formatRecord(record);
+        }
+        // Anillos de hilos terminados y ya vacíos
+        if (ring.orphaned.load(std::memory_order_acquire) && ring.isEmpty()) {
+            it = m_rings.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    if (!out.isEmpty()) {
+        write(out);
+    }
+}
+
+void AsyncLogger::write(const QByteArray& lines) {
+    std::fwrite(lines.constData(), 1, size_t(lines.size()), stderr);
+    std::fflush(stderr);
+    if (m_file) {
+        m_file->write(lines);
+        m_file->flush();
+    }
+}
@@ -0,0 +1,145 @@
+#ifndef ASYNC_LOGGER_H
+#define ASYNC_LOGGER_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QLoggingCategory>
+#include <QMutex>
+#include <QString>
+#include <QWaitCondition>
+#include <QtTypes>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+class QFile;
+class QThread;
+
+// ─── Categorías ──────────────────────────────────────────────────────────
+Q_DECLARE_LOGGING_CATEGORY(lcDsp)   ///< tft.dsp: DSPWorker y etapas de análisis
+Q_DECLARE_LOGGING_CATEGORY(lcDb)    ///< tft.db: AudioDb
+Q_DECLARE_LOGGING_CATEGORY(lcNet)   ///< tft.net: receptores de audio
+Q_DECLARE_LOGGING_CATEGORY(lcUi)    ///< tft.ui: ventana principal y vistas
+
+// ─── Eliminación en compilación ──────────────────────────────────────────
+// TFT_LOG_MIN_LEVEL: 0 = debug, 1 = info, 2 = warning, 3 = critical.
+// Los niveles inferiores desaparecen del binario (ni se evalúan los
+// argumentos). Por defecto se conserva todo: el filtrado en ejecución
+// lo hacen QLoggingCategory y la limitación de tasa del AsyncLogger.
+#ifndef TFT_LOG_MIN_LEVEL
+#  if defined(QT_NO_DEBUG_OUTPUT)
+#    define TFT_LOG_MIN_LEVEL 1
+#  else
+#    define TFT_LOG_MIN_LEVEL 0
+#  endif
+#endif
+
+#define TFT_LOG_STRIPPED while (false) QMessageLogger().noDebug()
+
+#if TFT_LOG_MIN_LEVEL <= 0
+#  define TFT_DEBUG(category) qCDebug(category)
+#else
+#  define TFT_DEBUG(category) TFT_LOG_STRIPPED
+#endif
+
+#if TFT_LOG_MIN_LEVEL <= 1
+#  define TFT_INFO(category) qCInfo(category)
+#else
+#  define TFT_INFO(category) TFT_LOG_STRIPPED
+#endif
+
+#if TFT_LOG_MIN_LEVEL <= 2
+#  define TFT_WARNING(category) qCWarning(category)
+#else
+#  define TFT_WARNING(category) TFT_LOG_STRIPPED
+#endif
+
+#define TFT_CRITICAL(category) qCCritical(category)
+
+class LogRing;
+
+/**
+ * @brief Backend de logging asíncrono para todo qDebug/qWarning/qCDebug
+ *
+ * Se instala como manejador de mensajes de Qt. Cada hilo productor
+ * escribe en su propio anillo SPSC sin bloqueos (si el anillo está lleno
+ * el mensaje se descarta y se contabiliza), y un hilo de fondo los vacía
+ * periódicamente a stderr y, opcionalmente, a un fichero.
+ *
+ * Cada categoría tiene un cubo de tokens por hilo: los mensajes que
+ * superan la tasa configurada se suprimen y el siguiente mensaje que
+ * pasa indica cuántos se omitieron. Los mensajes critical/fatal nunca
+ * se limitan y los fatal se escriben de forma síncrona.
+ */
+class AsyncLogger
+{
+public:
+    static AsyncLogger& instance();
+
+    /** Instala el manejador y arranca el hilo de volcado */
+    void install(const QString& logFilePath = QString());
+
+    /** Vacía los anillos, detiene el hilo y restaura el manejador anterior */
+    void shutdown();
+
+    /** Tasa por defecto (mensajes/s y ráfaga) para categorías sin configuración */
+    void setDefaultRate(double messagesPerSecond, int burst);
+
+    /** Tasa de una categoría concreta (messagesPerSecond <= 0 = sin límite) */
+    void setCategoryRate(const QByteArray& category, double messagesPerSecond, int burst);
+
+    /** Periodo de volcado del hilo de fondo */
+    void setFlushInterval(int ms) { m_flushIntervalMs = qMax(1, ms); }
+
+    /** Mensajes perdidos por anillo lleno */
+    quint64 droppedMessages() const { return m_dropped.load(std::memory_order_relaxed); }
+
+    /** Mensajes suprimidos por limitación de tasa */
+    quint64 suppressedMessages() const { return m_suppressed.load(std::memory_order_relaxed); }
+
+private:
+    AsyncLogger() = default;
+    ~AsyncLogger();
+    AsyncLogger(const AsyncLogger&) = delete;
+    AsyncLogger& operator=(const AsyncLogger&) = delete;
+
+    struct Rate {
+        double perSecond = 0.0;
+        int burst = 0;
+    };
+
+    static void messageHandler(QtMsgType type, const QMessageLogContext& context, const QString& msg);
+
+    void enqueue(QtMsgType type, const char* category, const QString& msg);
+    bool admit(const char* category, quint32& suppressedBefore);
+    Rate rateFor(const char* category);
+    std::shared_ptr<LogRing> ringForCurrentThread();
+
+    void flusherLoop();
+    void drainAll();
+    void write(const QByteArray& lines);
+
+    std::atomic<bool> m_running { false };
+    QtMessageHandler m_previous = nullptr;
+    QThread* m_flusher = nullptr;
+    int m_flushIntervalMs = 20;
+
+    QMutex m_wakeMutex;
+    QWaitCondition m_wake;
+
+    QMutex m_ringsMutex;                         ///< Sólo al registrar hilos y al vaciar
+    std::vector<std::shared_ptr<LogRing>> m_rings;
+
+    QMutex m_rateMutex;
+    Rate m_defaultRate { 200.0, 400 };
+    QHash<QByteArray, Rate> m_rates;
+    std::atomic<int> m_rateGeneration { 0 };
+
+    std::unique_ptr<QFile> m_file;
+
+    std::atomic<quint64> m_dropped { 0 };
+    std::atomic<quint64> m_suppressed { 0 };
+
+};
+
+#endif // ASYNC_LOGGER_H
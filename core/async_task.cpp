@@ -0,0 +1,42 @@
+#include "async_task.h"
+#include <QDebug>
+#include <QThread>
+
+namespace AsyncTask {
+
+QThreadPool* ioPool() {
+    static QThreadPool* pool = []() {
+        auto* p = new QThreadPool();
+        // Pocas lecturas simultáneas: SQLite serializa por fichero de todos modos
+        p->setMaxThreadCount(qBound(2, QThread::idealThreadCount() / 2, 4));
+        p->setObjectName("AsyncTaskIo");
+        return p;
+    }();
+    return pool;
+}
+
+QString errorMessage(std::exception_ptr error) {
+    if (!error) return QString();
+    try {
+        std::rethrow_exception(error);
+    } catch (const TaskCancelled&) {
+        return QString();
+    } catch (const std::exception& e) {
+        return QString::fromUtf8(e.what());
+    } catch (...) {
+        return QStringLiteral("excepción desconocida");
+    }
+}
+
+} // namespace AsyncTask
+
+namespace detail {
+
+void logUnhandled(std::exception_ptr error) {
+    const QString message = AsyncTask::errorMessage(error);
+    if (!message.isEmpty()) {
+        qWarning() << "AsyncTask: tarea terminada con error:" << message;
+    }
+}
+
+} // namespace detail
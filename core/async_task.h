@@ -0,0 +1,245 @@
+#ifndef ASYNC_TASK_H
+#define ASYNC_TASK_H
+
+#include <QMetaObject>
+#include <QObject>
+#include <QPointer>
+#include <QString>
+#include <QThread>
+#include <QThreadPool>
+#include <atomic>
+#include <coroutine>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <variant>
+
+/**
+ * @brief Tareas asíncronas con corrutinas C++20 sobre el bucle de eventos Qt
+ *
+ * Una corrutina que devuelve Task<T> arranca en el acto y se suspende en
+ * cada `co_await AsyncTask::run(contexto, token, fn)`: fn se ejecuta en el
+ * pool de E/S y la corrutina se reanuda en el hilo de `contexto` (la GUI,
+ * el hilo DSP...), de modo que el código entre esperas no necesita locks
+ * siempre que todas las esperas de una tarea usen el mismo contexto.
+ *
+ * Cancelación: si el token se cancela antes de ejecutar fn o mientras se
+ * ejecuta, la espera lanza TaskCancelled, que atraviesa las tareas que la
+ * esperan sin registrarse como error. Si el contexto se destruye, la
+ * espera termina igual con TaskCancelled (en el hilo que era del
+ * contexto), de modo que los frames se liberan y quien espere a la tarea
+ * no se queda colgado; el código tras un co_await no debe capturar
+ * TaskCancelled si usa el contexto. Si ese hilo termina antes de la
+ * reanudación, la tarea se abandona.
+ *
+ * Los parámetros de una corrutina deben pasarse por valor: las referencias
+ * no sobreviven a la primera suspensión.
+ */
+
+/** Señal de cancelación compartida entre el que pide y la tarea */
+class CancellationToken
+{
+public:
+    CancellationToken() : m_flag(std::make_shared<std::atomic_bool>(false)) {}
+
+    void cancel() const { m_flag->store(true, std::memory_order_relaxed); }
+    bool isCancelled() const { return m_flag->load(std::memory_order_relaxed); }
+
+private:
+    std::shared_ptr<std::atomic_bool> m_flag;
+};
+
+/** Excepción con la que termina una espera cancelada */
+struct TaskCancelled : std::exception {
+    const char* what() const noexcept override { return "tarea cancelada"; }
+};
+
+namespace AsyncTask {
+/** Pool para E/S (DB, ficheros): separado del global para no competir con QtConcurrent */
+QThreadPool* ioPool();
+
+/** Mensaje de una excepción capturada (vacío si es una cancelación) */
+QString errorMessage(std::exception_ptr error);
+} // namespace AsyncTask
+
+namespace detail {
+
+template <typename T>
+using TaskValue = std::conditional_t<std::is_void_v<T>, std::monostate, T>;
+
+template <typename T>
+struct TaskState {
+    std::optional<TaskValue<T>> value;
+    std::exception_ptr error;
+    std::coroutine_handle<> continuation;
+    std::function<void()> onDone;
+    bool done = false;
+};
+
+template <typename T>
+struct TaskPromiseBase {
+    std::shared_ptr<TaskState<T>> state = std::make_shared<TaskState<T>>();
+    void return_value(T value) { state->value.emplace(std::move(value)); }
+};
+
+template <>
+struct TaskPromiseBase<void> {
+    std::shared_ptr<TaskState<void>> state = std::make_shared<TaskState<void>>();
+    void return_void() { state->value.emplace(); }
+};
+
+void logUnhandled(std::exception_ptr error);
+
+} // namespace detail
+
+template <typename T = void>
+class Task
+{
+    using State = detail::TaskState<T>;
+
+public:
+    struct promise_type : detail::TaskPromiseBase<T> {
+        Task get_return_object() { return Task(this->state); }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+
+        struct FinalAwaiter {
+            std::shared_ptr<State> state;
+
+            bool await_ready() noexcept { return false; }
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<> h) noexcept {
+                // Copias locales: destroy() libera este awaiter con el frame
+                std::shared_ptr<State> st = state;
+                std::coroutine_handle<> next = st->continuation;
+                std::function<void()> onDone = std::move(st->onDone);
+                st->done = true;
+                h.destroy();
+
+                if (onDone) {
+                    onDone();
+                } else if (!next && st->error) {
+                    detail::logUnhandled(st->error);
+                }
+                return next ? next : std::noop_coroutine();
+            }
+            void await_resume() noexcept {}
+        };
+
+        FinalAwaiter final_suspend() noexcept { return FinalAwaiter{this->state}; }
+        void unhandled_exception() { this->state->error = std::current_exception(); }
+    };
+
+    bool isDone() const { return m_state && m_state->done; }
+
+    /**
+     * @brief Callback al terminar, en el hilo donde terminó la tarea
+     *
+     * onResult recibe el valor (nada para Task<void>); onError el mensaje
+     * si falló. Una cancelación no llama a ninguno. Si context se destruye
+     * antes, no se llama nada.
+     */
+    template <typename OnResult>
+    void then(QObject* context, OnResult onResult,
+              std::function<void(const QString&)> onError = {}) {
+        std::shared_ptr<State> st = m_state;
+        QPointer<QObject> ctx(context);
+        auto call = [st, ctx, onResult = std::move(onResult), onError = std::move(onError)]() mutable {
+            if (!ctx) return;
+            if (st->error) {
+                const QString message = AsyncTask::errorMessage(st->error);
+                if (message.isEmpty()) return;   // cancelada
+                if (onError) onError(message);
+                else detail::logUnhandled(st->error);
+                return;
+            }
+            if constexpr (std::is_void_v<T>) onResult();
+            else onResult(*st->value);
+        };
+        if (st->done) call();
+        else st->onDone = std::move(call);
+    }
+
+    // Awaitable: una tarea puede esperar a otra (mismo hilo de contexto)
+    bool await_ready() const noexcept { return m_state->done; }
+    void await_suspend(std::coroutine_handle<> h) noexcept { m_state->continuation = h; }
+    T await_resume() {
+        if (m_state->error) std::rethrow_exception(m_state->error);
+        if constexpr (!std::is_void_v<T>) return std::move(*m_state->value);
+    }
+
+private:
+    explicit Task(std::shared_ptr<State> state) : m_state(std::move(state)) {}
+
+    std::shared_ptr<State> m_state;
+};
+
+namespace AsyncTask {
+
+/** Espera que ejecuta fn en un pool y reanuda en el hilo de context */
+template <typename F>
+class PoolAwaiter
+{
+    using R = std::invoke_result_t<F&>;
+
+public:
+    PoolAwaiter(QObject* context, CancellationToken token, F fn, QThreadPool* pool)
+        : m_context(context), m_token(std::move(token)), m_fn(std::move(fn)), m_pool(pool) {}
+
+    // En el hilo de la corrutina, dueño de context: ahí el QPointer es seguro
+    bool await_ready() const noexcept { return m_token.isCancelled() || !m_context; }
+
+    void await_suspend(std::coroutine_handle<> h) {
+        // El pool no toca context: devuelve el control a `target`, un objeto
+        // propio en el hilo de context que sólo borra la propia reanudación
+        auto* target = new QObject;
+        if (target->thread() != m_context->thread()) {
+            target->moveToThread(m_context->thread());
+        }
+
+        m_pool->start([this, h, target]() {
+            if (!m_token.isCancelled()) {
+                try {
+                    if constexpr (std::is_void_v<R>) { m_fn(); m_result.emplace(); }
+                    else m_result.emplace(m_fn());
+                } catch (...) {
+                    m_error = std::current_exception();
+                }
+            }
+
+            // Siempre se reanuda (nunca se destruye el frame desde el pool);
+            // si context murió, await_resume lanza TaskCancelled y la
+            // cancelación sube por las tareas que esperan a ésta
+            QMetaObject::invokeMethod(target, [h, target]() {
+                delete target;
+                h.resume();
+            }, Qt::QueuedConnection);
+        });
+    }
+
+    R await_resume() {
+        // También si se canceló mientras fn corría: el resultado ya no interesa
+        if (!m_context || m_token.isCancelled()) throw TaskCancelled();
+        if (m_error) std::rethrow_exception(m_error);
+        if constexpr (!std::is_void_v<R>) return std::move(*m_result);
+    }
+
+private:
+    QPointer<QObject> m_context;
+    CancellationToken m_token;
+    F m_fn;
+    QThreadPool* m_pool;
+    std::optional<detail::TaskValue<R>> m_result;
+    std::exception_ptr m_error;
+};
+
+template <typename F>
+PoolAwaiter<std::decay_t<F>> run(QObject* context, CancellationToken token, F&& fn,
+                                 QThreadPool* pool = ioPool()) {
+    return PoolAwaiter<std::decay_t<F>>(context, std::move(token), std::forward<F>(fn), pool);
+}
+
+} // namespace AsyncTask
+
+#endif // ASYNC_TASK_H
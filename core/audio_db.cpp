@@ -1,9 +1,119 @@
 #include "audio_db.h"
+#include "async_logger.h"
 #include <QDebug>
 #include <QDir>
 #include <QStandardPaths>
 #include <QSqlRecord>
 #include <QVariant>
+#include <QFloat16>
+#include <QHash>
+#include <QMultiHash>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <limits>
+
+namespace {
+// MFCC en float16: los coeficientes cepstrales caben de sobra en su rango
+QByteArray packMfcc(const QVector<float>& mfcc) {
+    QByteArray blob(mfcc.size() * qsizetype(sizeof(qfloat16)), Qt::Uninitialized);
+    qFloatToFloat16(reinterpret_cast<qfloat16*>(blob.data()), mfcc.constData(), mfcc.size());
+    return blob;
+}
+
+QVector<float> unpackMfcc(const QByteArray& blob) {
+    QVector<float> mfcc(blob.size() / qsizetype(sizeof(qfloat16)));
+    qFloatFromFloat16(mfcc.data(), reinterpret_cast<const qfloat16*>(blob.constData()), mfcc.size());
+    return mfcc;
+}
+
+// Filas anteriores (audio_features_f16): [centroide, rolloff, planitud, zcr, mfcc...] en float16
+AudioFeatures unpackLegacyFeatures(const QByteArray& blob) {
+    AudioFeatures f;
+    const QVector<float> values = unpackMfcc(blob);
+    if (values.size() < AudioFeatures::ScalarCount) {
+        return f;
+    }
+
+    f.centroidHz = values[0];
+    f.rolloffHz = values[1];
+    f.flatness = values[2];
+    f.zeroCrossingRate = values[3];
+    f.mfcc = values.mid(AudioFeatures::ScalarCount);
+    return f;
+}
+
+// Chunks de series temporales: ventanas fijas de 10 s (~470 bloques de 1024 a 48 kHz)
+constexpr qint64 kChunkDurationNs = 10'000'000'000LL;
+constexpr int kChunkMaxRows = 4096;      // Bloques muy cortos: se abre otro chunk en la ventana
+constexpr int kChunkSaveRows = 64;       // Reescritura del chunk abierto para lectores
+constexpr int kWriterBusyTimeoutMs = 5000;  // Cubre el plazo de vaciado + cierre de la sesión saliente
+
+enum PeakColumn { PeakTimestamp = 0, PeakBlock = 1, PeakOffset = 2 };
+enum PeakValue { PeakMin = 0, PeakMax = 1, PeakRms = 2 };
+
+// Mezcla buckets consecutivos en intervalos de groupNs alineados a múltiplos de groupNs
+QList<RollupBucket> groupBuckets(const QList<RollupBucket>& in, qint64 groupNs) {
+    QList<RollupBucket> out;
+    for (const RollupBucket& b : in) {
+        const qint64 rem = b.startNs % groupNs;
+        const qint64 start = b.startNs - (rem < 0 ? rem + groupNs : rem);
+        if (out.isEmpty() || out.last().startNs != start) {
+            RollupBucket group;
+            group.level = b.level;
+            group.startNs = start;
+            out.append(group);
+        }
+        out.last().merge(b);
+    }
+    return out;
+}
+
+// Columnas de rollups en el orden que lee rollupFromQuery
+constexpr const char* kRollupColumns =
+    "bucket_start, last_ts, block_count, min_value, max_value, sum_squares, peak_count, event_count";
+
+RollupBucket rollupFromQuery(const QSqlQuery& q, int level) {
+    RollupBucket b;
+    b.level      = level;
+    b.startNs    = q.value(0).toLongLong();
+    b.lastNs     = q.value(1).toLongLong();
+    b.blockCount = q.value(2).toLongLong();
+    b.minValue   = q.value(3).toFloat();
+    b.maxValue   = q.value(4).toFloat();
+    b.sumSquares = q.value(5).toDouble();
+    b.peakCount  = q.value(6).toLongLong();
+    b.eventCount = q.value(7).toLongLong();
+    return b;
+}
+
+// Bucket previo más lo acumulado por este escritor, con la clave de `b`
+RollupBucket mergedRollup(RollupBucket base, const RollupBucket& b) {
+    base.merge(b);
+    base.level = b.level;
+    base.startNs = b.startNs;
+    return base;
+}
+
+template <typename Keep>
+void appendPeakRows(const QVector<GorillaColumns>& chunks, Keep keep, QList<PeakRecord>& out) {
+    for (const GorillaColumns& c : chunks) {
+        for (int i = 0; i < c.rows; ++i) {
+            PeakRecord rec;
+            rec.timestamp    = c.ints[PeakTimestamp][i];
+            rec.blockIndex   = c.ints[PeakBlock][i];
+            rec.sampleOffset = c.ints[PeakOffset][i];
+            rec.minValue     = c.floats[PeakMin][i];
+            rec.maxValue     = c.floats[PeakMax][i];
+            // Chunks anteriores a la columna RMS: sólo min/max
+            rec.rmsValue     = c.floats.size() > PeakRms ? c.floats[PeakRms][i] : 0.0f;
+            if (keep(rec)) {
+                out.append(rec);
+            }
+        }
+    }
+}
+}
 
 AudioDb::AudioDb(const QString& dbPath, QObject* parent)
     : QObject(parent)
@@ -28,9 +138,20 @@ bool AudioDb::initialize() {
         return true;
     }
 
-    // Configurar conexión SQLite
-    m_db = QSqlDatabase::addDatabase("QSQLITE", "AudioCapture");
+    // Configurar conexión SQLite: nombre único para que una sesión que se
+    // está cerrando en segundo plano conviva con la nueva
+    static std::atomic<int> connectionCounter { 0 };
+    const QString connectionName = QString("AudioCapture-%1").arg(connectionCounter.fetch_add(1));
+    m_db = QSqlDatabase::addDatabase("QSQLITE", connectionName);
     m_db.setDatabaseName(m_dbPath);
+    if (m_readOnly) {
+        // Lector concurrente: no crea el fichero y espera si el escritor bloquea
+        m_db.setConnectOptions("QSQLITE_OPEN_READONLY;QSQLITE_BUSY_TIMEOUT=1000");
+    } else {
+        // En modo persistente la sesión que se cierra y la nueva comparten
+        // fichero un momento: esperar al otro escritor en vez de SQLITE_BUSY
+        m_db.setConnectOptions(QString("QSQLITE_BUSY_TIMEOUT=%1").arg(kWriterBusyTimeoutMs));
+    }
 
     if (!m_db.open()) {
         QString error = QString("No se pudo abrir la base de datos: %1")
@@ -40,6 +161,14 @@ bool AudioDb::initialize() {
         return false;
     }
 
+    if (m_readOnly) {
+        m_initialized = true;
+        detectLegacyFeatures();
+        m_peaksHaveRms = tableHasColumn("audio_peaks", "rms_value");
+        loadBlockIndex();
+        return true;
+    }
+
     // Configurar SQLite para mejor rendimiento
     QSqlQuery pragmaQuery(m_db);
     pragmaQuery.exec("PRAGMA synchronous = OFF");
@@ -52,6 +181,19 @@ bool AudioDb::initialize() {
     }
 
     m_initialized = true;
+    detectLegacyFeatures();
+    m_peaksHaveRms = true;
+    loadBlockIndex();
+
+    // Rollups de una captura anterior en el mismo fichero: se continúan
+    QSqlQuery rollupEnd(m_db);
+    m_persistedRollups.clear();
+    m_persistedRollupsEndNs = std::numeric_limits<qint64>::min();
+    if (rollupEnd.exec("SELECT MAX(last_ts) FROM rollups") && rollupEnd.next() &&
+        !rollupEnd.value(0).isNull()) {
+        m_persistedRollupsEndNs = rollupEnd.value(0).toLongLong();
+    }
+
     qDebug() << "AudioDb inicializada:" << m_dbPath;
     return true;
 }
@@ -74,17 +216,105 @@ bool AudioDb::clearDatabase() {
         return false;
     }
 
+    if (!query.exec("DELETE FROM audio_features")) {
+        logError("limpiar audio_features", query.lastError());
+        return false;
+    }
+    query.exec("DROP TABLE IF EXISTS audio_features_f16");
+    m_legacyFeaturesTable.clear();
+
+    if (!query.exec("DELETE FROM audio_spectra")) {
+        logError("limpiar audio_spectra", query.lastError());
+        return false;
+    }
+
+    if (!query.exec("DELETE FROM spectrogram_tiles")) {
+        logError("limpiar spectrogram_tiles", query.lastError());
+        return false;
+    }
+
+    if (!query.exec("DELETE FROM fingerprints")) {
+        logError("limpiar fingerprints", query.lastError());
+        return false;
+    }
+
+    if (!query.exec("DELETE FROM block_seek_index")) {
+        logError("limpiar block_seek_index", query.lastError());
+        return false;
+    }
+    m_blockIndex.clear();
+
+    if (!query.exec("DELETE FROM ts_chunks")) {
+        logError("limpiar ts_chunks", query.lastError());
+        return false;
+    }
+    for (OpenChunk* chunk : { &m_peakChunk, &m_featureChunk }) {
+        chunk->encoder.clear();
+        chunk->unsavedRows = 0;
+    }
+
+    if (!query.exec("DELETE FROM rollups")) {
+        logError("limpiar rollups", query.lastError());
+        return false;
+    }
+    m_rollups.clear();
+    m_persistedRollups.clear();
+    m_persistedRollupsEndNs = std::numeric_limits<qint64>::min();
+
     // Resetear contadores de autoincremento
     query.exec("DELETE FROM sqlite_sequence WHERE name='audio_blocks'");
     query.exec("DELETE FROM sqlite_sequence WHERE name='audio_peaks'");
 
-    // Vacuum para optimizar
-    query.exec("VACUUM");
-
     qDebug() << "Base de datos limpiada";
     return true;
 }
 
+bool AudioDb::vacuum() {
+    if (!m_initialized) {
+        return false;
+    }
+
+    QSqlQuery query(m_db);
+    if (!query.exec("VACUUM")) {
+        logError("vacuum", query.lastError());
+        return false;
+    }
+    return true;
+}
+
+bool AudioDb::preallocate(qint64 bytes) {
+    if (!m_initialized || bytes <= 0) {
+        return false;
+    }
+
+    // Trozos de 16 MB: lejos del límite de tamaño de BLOB de SQLite
+    constexpr qint64 chunkBytes = 16LL * 1024 * 1024;
+
+    QSqlQuery query(m_db);
+    if (!query.exec("CREATE TABLE IF NOT EXISTS prealloc_scratch (data BLOB)")) {
+        logError("reservar espacio", query.lastError());
+        return false;
+    }
+
+    m_db.transaction();
+    query.prepare("INSERT INTO prealloc_scratch (data) VALUES (zeroblob(?))");
+    for (qint64 done = 0; done < bytes; done += chunkBytes) {
+        query.addBindValue(qMin(chunkBytes, bytes - done));
+        if (!query.exec()) {
+            logError("reservar espacio", query.lastError());
+            m_db.rollback();
+            return false;
+        }
+    }
+    m_db.commit();
+
+    if (!query.exec("DROP TABLE prealloc_scratch")) {
+        logError("reservar espacio", query.lastError());
+        return false;
+    }
+    return true;
+}
+
 bool AudioDb::insertBlock(qint64 blockIndex, qint64 sampleOffset,
                             const QByteArray& audioData,
                             quint64 timestampNs) {
@@ -107,25 +337,35 @@ bool AudioDb::insertBlock(qint64 blockIndex, qint64 sampleOffset,
         return false;
     }
 
+    m_blockIndex.append(blockIndex, sampleOffset, static_cast<qint64>(timestampNs),
+                        query.lastInsertId().toLongLong());
     return true;
 }
 
-bool AudioDb::insertPeak(qint64 blockIndex, qint64 sampleOffset, float minValue, float maxValue, quint64 timestampNs) {
+bool AudioDb::insertPeak(qint64 blockIndex, qint64 sampleOffset, float minValue, float maxValue,
+                         float rmsValue, quint64 timestampNs) {
     if (!m_initialized) {
         return false;
     }
 
+    if (m_compressTimeSeries) {
+        const qint64 ints[] = { static_cast<qint64>(timestampNs), blockIndex, sampleOffset };
+        const float floats[] = { minValue, maxValue, rmsValue };
+        return appendTimeSeries(TimeSeries::Peaks, ints, floats, sampleOffset);
+    }
+
     QSqlQuery query(m_db);
     query.prepare(R"(
         INSERT INTO audio_peaks
-            (block_index, sample_offset, min_value, max_value, timestamp)
-        VALUES (?, ?, ?, ?, ?)
+            (block_index, sample_offset, min_value, max_value, rms_value, timestamp)
+        VALUES (?, ?, ?, ?, ?, ?)
     )");
 
     query.addBindValue(blockIndex);
     query.addBindValue(sampleOffset);
     query.addBindValue(minValue);
     query.addBindValue(maxValue);
+    query.addBindValue(rmsValue);
     query.addBindValue(static_cast<qint64>(timestampNs));
 
     if (!query.exec()) {
@@ -136,6 +376,451 @@ bool AudioDb::insertPeak(qint64 blockIndex, qint64 sampleOffset, float minValue,
     return true;
 }
 
+bool AudioDb::insertFeatures(qint64 blockIndex, quint64 timestampNs,
+                             const AudioFeatures& features) {
+    if (!m_initialized || features.isEmpty()) {
+        return false;
+    }
+
+    QSqlQuery query(m_db);
+    query.prepare(R"(
+        INSERT OR REPLACE INTO audio_features
+            (block_index, timestamp, centroid_hz, rolloff_hz, flatness, zero_crossing_rate, mfcc)
+        VALUES (?, ?, ?, ?, ?, ?, ?)
+    )");
+
+    // Con compresión los escalares sólo van a su serie de ts_chunks: aquí
+    // quedan NULL y getFeaturesByTime los recompone por bloque
+    const bool inlineScalars = !m_compressTimeSeries;
+    auto scalar = [inlineScalars](float v) { return inlineScalars ? QVariant(v) : QVariant(); };
+
+    query.addBindValue(blockIndex);
+    query.addBindValue(static_cast<qint64>(timestampNs));
+    query.addBindValue(scalar(features.centroidHz));
+    query.addBindValue(scalar(features.rolloffHz));
+    query.addBindValue(scalar(features.flatness));
+    query.addBindValue(scalar(features.zeroCrossingRate));
+    query.addBindValue(packMfcc(features.mfcc));
+
+    if (!query.exec()) {
+        logError("insertar descriptores", query.lastError());
+        return false;
+    }
+
+    if (m_compressTimeSeries) {
+        const qint64 ints[] = { static_cast<qint64>(timestampNs), blockIndex };
+        const float floats[] = { features.centroidHz, features.rolloffHz,
+                                 features.flatness, features.zeroCrossingRate };
+        return appendTimeSeries(TimeSeries::FeatureScalars, ints, floats, 0);
+    }
+
+    return true;
+}
+
+bool AudioDb::insertSpectrum(qint64 blockIndex, quint64 timestampNs,
+                             const CompactSpectrum& spectrum) {
+    if (!m_initialized || spectrum.isEmpty()) {
+        return false;
+    }
+
+    QSqlQuery query(m_db);
+    query.prepare(R"(
+        INSERT OR REPLACE INTO audio_spectra
+            (block_index, timestamp, format, bins, min_db, max_db, data)
+        VALUES (?, ?, ?, ?, ?, ?, ?)
+    )");
+
+    query.addBindValue(blockIndex);
+    query.addBindValue(static_cast<qint64>(timestampNs));
+    query.addBindValue(int(spectrum.format));
+    query.addBindValue(spectrum.bins);
+    query.addBindValue(spectrum.minDb);
+    query.addBindValue(spectrum.maxDb);
+    query.addBindValue(spectrum.data);
+
+    if (!query.exec()) {
+        logError("insertar espectro", query.lastError());
+        return false;
+    }
+
+    return true;
+}
+
+QList<SpectrumRecord> AudioDb::getSpectraByTime(qint64 tStart, qint64 tEnd) const {
+    QList<SpectrumRecord> out;
+    if (!m_initialized) return out;
+
+    QSqlQuery q(m_db);
+    q.setForwardOnly(true);
+    q.prepare(R"(
+        SELECT block_index, timestamp, format, bins, min_db, max_db, data
+          FROM audio_spectra
+         WHERE timestamp BETWEEN ? AND ?
+         ORDER BY timestamp ASC
+    )");
+    q.addBindValue(tStart);
+    q.addBindValue(tEnd);
+
+    if (!q.exec()) {
+        qWarning() << "Error leyendo espectros por tiempo:" << q.lastError().text();
+        return out;
+    }
+
+    while (q.next()) {
+        SpectrumRecord rec;
+        rec.blockIndex = q.value(0).toLongLong();
+        rec.timestamp  = q.value(1).toLongLong();
+        rec.spectrum.format = static_cast<SpectrumFormat>(q.value(2).toInt());
+        rec.spectrum.bins   = q.value(3).toInt();
+        rec.spectrum.minDb  = q.value(4).toFloat();
+        rec.spectrum.maxDb  = q.value(5).toFloat();
+        rec.spectrum.data   = q.value(6).toByteArray();
+
+        // Fila truncada o corrupta: no se devuelve
+        if (rec.spectrum.data.size() < qsizetype(rec.spectrum.bins) * CompactSpectrum::bytesPerBin(rec.spectrum.format)) {
+            continue;
+        }
+        out.append(rec);
+    }
+    return out;
+}
+
+bool AudioDb::insertTile(const SpectrogramTile& tile) {
+    if (!m_initialized || tile.isEmpty()) {
+        return false;
+    }
+
+    QSqlQuery query(m_db);
+    query.prepare(R"(
+        INSERT OR REPLACE INTO spectrogram_tiles
+            (level, tile_index, first_ts, last_ts, columns, bins, min_db, max_db, data)
+        VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?)
+    )");
+
+    query.addBindValue(tile.level);
+    query.addBindValue(tile.tileIndex);
+    query.addBindValue(tile.firstTimestamp);
+    query.addBindValue(tile.lastTimestamp);
+    query.addBindValue(tile.columns);
+    query.addBindValue(tile.bins);
+    query.addBindValue(tile.minDb);
+    query.addBindValue(tile.maxDb);
+    query.addBindValue(tile.data.left(qsizetype(tile.columns) * tile.bins));
+
+    if (!query.exec()) {
+        logError("insertar tesela", query.lastError());
+        return false;
+    }
+
+    return true;
+}
+
+QVector<qint64> AudioDb::nextTileIndices(int levels) const {
+    QVector<qint64> next(qMax(0, levels), 0);
+    if (!m_initialized || levels <= 0) return next;
+
+    // Una búsqueda por nivel sobre la clave primaria (level, tile_index)
+    QSqlQuery q(m_db);
+    q.setForwardOnly(true);
+    if (!q.exec("SELECT level, MAX(tile_index) FROM spectrogram_tiles GROUP BY level")) {
+        logError("leer índices de teselas", q.lastError());
+        return next;
+    }
+    while (q.next()) {
+        const int level = q.value(0).toInt();
+        if (level >= 0 && level < levels) {
+            next[level] = q.value(1).toLongLong() + 1;
+        }
+    }
+    return next;
+}
+
+bool AudioDb::getTileTimeSpan(qint64& firstTs, qint64& lastTs) const {
+    if (!m_initialized) return false;
+
+    QSqlQuery q(m_db);
+    q.setForwardOnly(true);
+    if (!q.exec("SELECT MIN(first_ts), MAX(last_ts) FROM spectrogram_tiles WHERE level = 0")
+        || !q.next() || q.value(0).isNull()) {
+        return false;
+    }
+    firstTs = q.value(0).toLongLong();
+    lastTs = q.value(1).toLongLong();
+    return lastTs > firstTs;
+}
+
+QList<SpectrogramTile> AudioDb::getTilesForSpan(qint64 tStart, qint64 tEnd, int maxColumns) const {
+    QList<SpectrogramTile> out;
+    if (!m_initialized || tEnd <= tStart || maxColumns <= 0) return out;
+
+    // 1) Periodo de columna y número de niveles disponibles
+    QSqlQuery meta(m_db);
+    meta.setForwardOnly(true);
+    if (!meta.exec(R"(
+            SELECT (SELECT MAX(level) FROM spectrogram_tiles),
+                   first_ts, last_ts, columns
+              FROM spectrogram_tiles
+             WHERE level = 0 AND columns > 1
+             ORDER BY tile_index ASC
+             LIMIT 1
+        )") || !meta.next()) {
+        return out;
+    }
+
+    const int levels = meta.value(0).toInt() + 1;
+    const qint64 firstTs = meta.value(1).toLongLong();
+    const qint64 lastTs = meta.value(2).toLongLong();
+    const int columns = meta.value(3).toInt();
+    const double periodNs = double(lastTs - firstTs) / double(columns - 1);
+    if (periodNs <= 0.0) return out;
+
+    const qint64 level0Columns = qint64(double(tEnd - tStart) / periodNs) + 1;
+    const int level = SpectrogramPyramid::levelForSpan(level0Columns, maxColumns, levels);
+
+    // 2) Sólo las teselas del nivel que solapan el intervalo. El rango sobre
+    //    first_ts (índice) se amplía una tesela hacia atrás para incluir la
+    //    que empieza antes de tStart
+    const qint64 tileSpanNs = qint64(periodNs * double(qint64(1) << level) * columns);
+    QSqlQuery q(m_db);
+    q.setForwardOnly(true);
+    q.prepare(R"(
+        SELECT tile_index, first_ts, last_ts, columns, bins, min_db, max_db, data
+          FROM spectrogram_tiles
+         WHERE level = ? AND first_ts BETWEEN ? AND ? AND last_ts >= ?
+         ORDER BY tile_index ASC
+    )");
+    q.addBindValue(level);
+    q.addBindValue(tStart - tileSpanNs);
+    q.addBindValue(tEnd);
+    q.addBindValue(tStart);
+
+    if (!q.exec()) {
+        qWarning() << "Error leyendo teselas:" << q.lastError().text();
+        return out;
+    }
+
+    while (q.next()) {
+        SpectrogramTile t;
+        t.level = level;
+        t.tileIndex = q.value(0).toLongLong();
+        t.firstTimestamp = q.value(1).toLongLong();
+        t.lastTimestamp = q.value(2).toLongLong();
+        t.columns = q.value(3).toInt();
+        t.bins = q.value(4).toInt();
+        t.minDb = q.value(5).toFloat();
+        t.maxDb = q.value(6).toFloat();
+        t.data = q.value(7).toByteArray();
+        if (t.data.size() < qsizetype(t.columns) * t.bins) {
+            continue;
+        }
+        out.append(t);
+    }
+    return out;
+}
+
+QList<FeatureRecord> AudioDb::getFeaturesByTime(qint64 tStart, qint64 tEnd) const {
+    QList<FeatureRecord> out;
+    if (!m_initialized) return out;
+
+    QSqlQuery q(m_db);
+    q.setForwardOnly(true);
+
+    // Sesiones con el formato anterior: todo en un BLOB float16
+    if (!m_legacyFeaturesTable.isEmpty()) {
+        q.prepare(QString(R"(
+            SELECT block_index, timestamp, features
+              FROM %1
+             WHERE timestamp BETWEEN ? AND ?
+             ORDER BY timestamp ASC
+        )").arg(m_legacyFeaturesTable));
+        q.addBindValue(tStart);
+        q.addBindValue(tEnd);
+
+        if (!q.exec()) {
+            qWarning() << "Error leyendo descriptores por tiempo:" << q.lastError().text();
+            return out;
+        }
+        while (q.next()) {
+            FeatureRecord rec;
+            rec.blockIndex = q.value(0).toLongLong();
+            rec.timestamp  = q.value(1).toLongLong();
+            rec.features   = unpackLegacyFeatures(q.value(2).toByteArray());
+            out.append(rec);
+        }
+        if (m_legacyFeaturesTable == "audio_features") {
+            return out;
+        }
+    }
+
+    const qsizetype legacyRows = out.size();
+    q.prepare(R"(
+        SELECT block_index, timestamp, centroid_hz, rolloff_hz, flatness, zero_crossing_rate, mfcc
+          FROM audio_features
+         WHERE timestamp BETWEEN ? AND ?
+         ORDER BY timestamp ASC
+    )");
+    q.addBindValue(tStart);
+    q.addBindValue(tEnd);
+
+    if (!q.exec()) {
+        qWarning() << "Error leyendo descriptores por tiempo:" << q.lastError().text();
+        return out;
+    }
+
+    QVector<qsizetype> chunkedScalars;   // Filas cuyos escalares están en ts_chunks
+    while (q.next()) {
+        FeatureRecord rec;
+        rec.blockIndex = q.value(0).toLongLong();
+        rec.timestamp  = q.value(1).toLongLong();
+        if (q.value(2).isNull()) {
+            chunkedScalars.append(out.size());
+        } else {
+            rec.features.centroidHz       = q.value(2).toFloat();
+            rec.features.rolloffHz        = q.value(3).toFloat();
+            rec.features.flatness         = q.value(4).toFloat();
+            rec.features.zeroCrossingRate = q.value(5).toFloat();
+        }
+        rec.features.mfcc = unpackMfcc(q.value(6).toByteArray());
+        out.append(rec);
+    }
+
+    if (!chunkedScalars.isEmpty()) {
+        QHash<qint64, AudioFeatures> scalars;
+        for (const FeatureRecord& r : getFeatureScalarsByTime(tStart, tEnd)) {
+            scalars.insert(r.blockIndex, r.features);
+        }
+        for (qsizetype i : chunkedScalars) {
+            const auto it = scalars.constFind(out[i].blockIndex);
+            if (it == scalars.cend()) continue;
+            AudioFeatures& f = out[i].features;
+            f.centroidHz       = it->centroidHz;
+            f.rolloffHz        = it->rolloffHz;
+            f.flatness         = it->flatness;
+            f.zeroCrossingRate = it->zeroCrossingRate;
+        }
+    }
+
+    if (legacyRows > 0 && out.size() > legacyRows) {
+        std::stable_sort(out.begin(), out.end(),
+                         [](const FeatureRecord& a, const FeatureRecord& b) { return a.timestamp < b.timestamp; });
+    }
+    return out;
+}
+
+QList<FeatureRecord> AudioDb::getFeatureScalarsByTime(qint64 tStart, qint64 tEnd) const {
+    QList<FeatureRecord> out;
+    if (!m_initialized) return out;
+
+    const QVector<GorillaColumns> chunks =
+        readTimeSeries(TimeSeries::FeatureScalars, "chunk_start > ? AND chunk_start <= ?",
+                       tStart - kChunkDurationNs, tEnd);
+    for (const GorillaColumns& c : chunks) {
+        for (int i = 0; i < c.rows; ++i) {
+            const qint64 ts = c.ints[0][i];
+            if (ts < tStart || ts > tEnd) {
+                continue;
+            }
+            FeatureRecord rec;
+            rec.timestamp  = ts;
+            rec.blockIndex = c.ints[1][i];
+            rec.features.centroidHz       = c.floats[0][i];
+            rec.features.rolloffHz        = c.floats[1][i];
+            rec.features.flatness         = c.floats[2][i];
+            rec.features.zeroCrossingRate = c.floats[3][i];
+            out.append(rec);
+        }
+    }
+    return out;
+}
+
+bool AudioDb::insertFingerprints(const QVector<FingerprintHash>& hashes) {
+    if (!m_initialized || hashes.isEmpty()) {
+        return false;
+    }
+
+    m_db.transaction();
+
+    QSqlQuery query(m_db);
+    query.prepare("INSERT OR IGNORE INTO fingerprints (hash, block_index) VALUES (?, ?)");
+
+    for (const FingerprintHash& h : hashes) {
+        query.bindValue(0, qint64(h.hash));
+        query.bindValue(1, h.anchorFrame);
+        if (!query.exec()) {
+            logError("insertar huella", query.lastError());
+            m_db.rollback();
+            return false;
+        }
+    }
+
+    return m_db.commit();
+}
+
+QList<FingerprintMatch> AudioDb::findFingerprintMatches(const QVector<FingerprintHash>& query,
+                                                        int maxResults,
+                                                        int minVotes) const {
+    QList<FingerprintMatch> out;
+    if (!m_initialized || query.isEmpty()) return out;
+
+    // hash -> frames del clip en los que aparece
+    QMultiHash<quint32, qint64> queryFrames;
+    for (const FingerprintHash& h : query) {
+        queryFrames.insert(h.hash, h.anchorFrame);
+    }
+    const QList<quint32> uniqueHashes = queryFrames.uniqueKeys();
+
+    // Histograma de desplazamientos (bloque almacenado - frame del clip)
+    QHash<qint64, int> votes;
+
+    // SQLite limita los parámetros por sentencia: consultas por trozos
+    constexpr int chunkSize = 500;
+    for (qsizetype start = 0; start < uniqueHashes.size(); start += chunkSize) {
+        const qsizetype n = std::min<qsizetype>(chunkSize, uniqueHashes.size() - start);
+
+        QStringList placeholders;
+        for (qsizetype i = 0; i < n; ++i) placeholders << "?";
+
+        QSqlQuery q(m_db);
+        q.setForwardOnly(true);
+        q.prepare(QString("SELECT hash, block_index FROM fingerprints WHERE hash IN (%1)")
+                      .arg(placeholders.join(',')));
+        for (qsizetype i = 0; i < n; ++i) {
+            q.addBindValue(qint64(uniqueHashes[start + i]));
+        }
+
+        if (!q.exec()) {
+            qWarning() << "Error buscando huellas:" << q.lastError().text();
+            return out;
+        }
+
+        while (q.next()) {
+            const quint32 hash = quint32(q.value(0).toLongLong());
+            const qint64 block = q.value(1).toLongLong();
+            for (auto it = queryFrames.constFind(hash); it != queryFrames.constEnd() && it.key() == hash; ++it) {
+                ++votes[block - it.value()];
+            }
+        }
+    }
+
+    for (auto it = votes.constBegin(); it != votes.constEnd(); ++it) {
+        if (it.value() >= minVotes && it.key() >= 0) {
+            out.append({it.key(), 0, it.value()});
+        }
+    }
+
+    std::sort(out.begin(), out.end(), [](const FingerprintMatch& a, const FingerprintMatch& b) {
+        return a.votes > b.votes;
+    });
+    if (maxResults > 0 && out.size() > maxResults) {
+        out.resize(maxResults);
+    }
+
+    for (FingerprintMatch& m : out) {
+        m.timestamp = getBlockTimestamp(m.blockIndex);
+    }
+    return out;
+}
+
 QList<QByteArray> AudioDb::getAllAudioBlocks() const {
     QList<QByteArray> blocks;
 
@@ -156,7 +841,7 @@ QList<QByteArray> AudioDb::getAllAudioBlocks() const {
         blocks.append(audioData);
     }
 
-    qDebug() << "Cargados" << blocks.size() << "bloques de audio desde la BD";
+    TFT_DEBUG(lcDb) << "Cargados" << blocks.size() << "bloques de audio desde la BD";
     return blocks;
 }
 
@@ -202,6 +887,21 @@ QList<QPair<float, float>> AudioDb::getAllPeaks() const {
         peaks.append(qMakePair(minVal, maxVal));
     }
 
+    QList<PeakRecord> compressed;
+    appendPeakRows(readTimeSeries(TimeSeries::Peaks, "chunk_start BETWEEN ? AND ?",
+                                  std::numeric_limits<qint64>::min(),
+                                  std::numeric_limits<qint64>::max()),
+                   [](const PeakRecord&) { return true; }, compressed);
+    if (compressed.isEmpty()) {
+        return peaks;
+    }
+
+    // Los chunks van por ventana de tiempo; el orden de la API es por bloque
+    std::stable_sort(compressed.begin(), compressed.end(),
+                     [](const PeakRecord& a, const PeakRecord& b) { return a.blockIndex < b.blockIndex; });
+    for (const PeakRecord& rec : compressed) {
+        peaks.append(qMakePair(rec.minValue, rec.maxValue));
+    }
     return peaks;
 }
 
@@ -219,6 +919,12 @@ QString AudioDb::getStatistics() const {
     if (query.next()) {
         totalPeaks = query.value(0).toInt();
     }
+    query.prepare("SELECT SUM(row_count) FROM ts_chunks WHERE series = ?");
+    query.addBindValue(int(TimeSeries::Peaks));
+    if (query.exec() && query.next()) {
+        totalPeaks += query.value(0).toInt();
+    }
+    totalPeaks += m_peakChunk.unsavedRows;
 
     float sizeMB = totalSize / (1024.0f * 1024.0f);
     float durationSeconds = 0.0f;
@@ -270,6 +976,19 @@ qint64 AudioDb::getTotalAudioSize() const {
     return 0;
 }
 
+qint64 AudioDb::getSampleExtent() const {
+    if (!m_initialized) {
+        return 0;
+    }
+
+    QSqlQuery query(m_db);
+    if (!query.exec("SELECT sample_offset, data_size FROM audio_blocks ORDER BY sample_offset DESC LIMIT 1") ||
+        !query.next()) {
+        return 0;
+    }
+    return query.value(0).toLongLong() + query.value(1).toLongLong() / qint64(sizeof(float));
+}
+
 bool AudioDb::createTables() {
     // Tabla para bloques de audio
     QString createBlocksTable = R"(
@@ -292,23 +1011,166 @@ bool AudioDb::createTables() {
             sample_offset INTEGER NOT NULL,
             min_value REAL NOT NULL,
             max_value REAL NOT NULL,
+            rms_value REAL NOT NULL DEFAULT 0,
             timestamp INTEGER NOT NULL,
             UNIQUE(block_index)
         )
     )";
 
-    // Crear índices para mejor rendimiento
-    QString createBlocksIndex = "CREATE INDEX IF NOT EXISTS idx_blocks_index ON audio_blocks(block_index)";
-    QString createPeaksIndex = "CREATE INDEX IF NOT EXISTS idx_peaks_index ON audio_peaks(block_index)";
+    // Tabla de descriptores: escalares en REAL (float16 pierde Hz por encima de 2 kHz), MFCC en float16
+    QString createFeaturesTable = R"(
+        CREATE TABLE IF NOT EXISTS audio_features (
+            block_index INTEGER PRIMARY KEY,
+            timestamp INTEGER NOT NULL,
+            centroid_hz REAL,
+            rolloff_hz REAL,
+            flatness REAL,
+            zero_crossing_rate REAL,
+            mfcc BLOB NOT NULL
+        )
+    )";
 
-    if (!executeQuery(createBlocksTable, "crear tabla audio_blocks")) {
-        return false;
-    }
+    // Espectros por bloque en su formato compacto (float16 / uint16 / uint8)
+    QString createSpectraTable = R"(
+        CREATE TABLE IF NOT EXISTS audio_spectra (
+            block_index INTEGER PRIMARY KEY,
+            timestamp INTEGER NOT NULL,
+            format INTEGER NOT NULL,
+            bins INTEGER NOT NULL,
+            min_db REAL NOT NULL,
+            max_db REAL NOT NULL,
+            data BLOB NOT NULL
+        )
+    )";
+
+    // Pirámide de espectrograma: teselas uint8 por (nivel, índice)
+    QString createTilesTable = R"(
+        CREATE TABLE IF NOT EXISTS spectrogram_tiles (
+            level INTEGER NOT NULL,
+            tile_index INTEGER NOT NULL,
+            first_ts INTEGER NOT NULL,
+            last_ts INTEGER NOT NULL,
+            columns INTEGER NOT NULL,
+            bins INTEGER NOT NULL,
+            min_db REAL NOT NULL,
+            max_db REAL NOT NULL,
+            data BLOB NOT NULL,
+            PRIMARY KEY (level, tile_index)
+        ) WITHOUT ROWID
+    )";
+
+    // Índice invertido de huellas, agrupado por hash
+    QString createFingerprintsTable = R"(
+        CREATE TABLE IF NOT EXISTS fingerprints (
+            hash INTEGER NOT NULL,
+            block_index INTEGER NOT NULL,
+            PRIMARY KEY(hash, block_index)
+        ) WITHOUT ROWID
+    )";
+
+    // Índice disperso de audio_blocks serializado (una sola fila)
+    QString createSeekIndexTable = R"(
+        CREATE TABLE IF NOT EXISTS block_seek_index (
+            id INTEGER PRIMARY KEY CHECK (id = 0),
+            data BLOB NOT NULL
+        )
+    )";
+
+    // Series temporales comprimidas (GorillaEncoder), un chunk por ventana de 10 s
+    QString createTimeSeriesTable = R"(
+        CREATE TABLE IF NOT EXISTS ts_chunks (
+            series INTEGER NOT NULL,
+            chunk_start INTEGER NOT NULL,
+            first_block INTEGER NOT NULL,
+            last_block INTEGER NOT NULL,
+            first_ts INTEGER NOT NULL,
+            last_ts INTEGER NOT NULL,
+            first_offset INTEGER NOT NULL,
+            last_offset INTEGER NOT NULL,
+            row_count INTEGER NOT NULL,
+            data BLOB NOT NULL,
+            PRIMARY KEY (series, chunk_start, first_block)
+        ) WITHOUT ROWID
+    )";
+
+    // Rollups por nivel (0 = 1 s, 1 = 1 min, 2 = 1 h); RMS y Leq se derivan de sum_squares
+    QString createRollupsTable = R"(
+        CREATE TABLE IF NOT EXISTS rollups (
+            level INTEGER NOT NULL,
+            bucket_start INTEGER NOT NULL,
+            last_ts INTEGER NOT NULL,
+            block_count INTEGER NOT NULL,
+            min_value REAL NOT NULL,
+            max_value REAL NOT NULL,
+            sum_squares REAL NOT NULL,
+            peak_count INTEGER NOT NULL,
+            event_count INTEGER NOT NULL,
+            PRIMARY KEY (level, bucket_start)
+        ) WITHOUT ROWID
+    )";
+
+    // Crear índices para mejor rendimiento
+    QString createBlocksIndex = "CREATE INDEX IF NOT EXISTS idx_blocks_index ON audio_blocks(block_index)";
+    QString createPeaksIndex = "CREATE INDEX IF NOT EXISTS idx_peaks_index ON audio_peaks(block_index)";
+    QString createBlocksOffsetIndex = "CREATE INDEX IF NOT EXISTS idx_blocks_offset ON audio_blocks(sample_offset)";
+    QString createPeaksOffsetIndex = "CREATE INDEX IF NOT EXISTS idx_peaks_offset ON audio_peaks(sample_offset)";
+    QString createFeaturesIndex = "CREATE INDEX IF NOT EXISTS idx_features_time ON audio_features(timestamp)";
+    QString createSpectraIndex = "CREATE INDEX IF NOT EXISTS idx_spectra_time ON audio_spectra(timestamp)";
+    QString createTilesIndex = "CREATE INDEX IF NOT EXISTS idx_tiles_time ON spectrogram_tiles(level, first_ts)";
+    QString createChunksOffsetIndex = "CREATE INDEX IF NOT EXISTS idx_ts_chunks_offset ON ts_chunks(series, first_offset)";
+
+    if (!executeQuery(createBlocksTable, "crear tabla audio_blocks")) {
+        return false;
+    }
 
     if (!executeQuery(createPeaksTable, "crear tabla audio_peaks")) {
         return false;
     }
 
+    // Sesiones anteriores sin RMS por bloque: las filas existentes quedan a 0
+    if (!tableHasColumn("audio_peaks", "rms_value") &&
+        !executeQuery("ALTER TABLE audio_peaks ADD COLUMN rms_value REAL NOT NULL DEFAULT 0",
+                      "añadir rms_value a audio_peaks")) {
+        return false;
+    }
+
+    // Formato anterior (un BLOB float16 con escalares y MFCC): se conserva aparte para leerlo
+    if (featuresTableIsLegacy("audio_features")) {
+        if (!executeQuery("ALTER TABLE audio_features RENAME TO audio_features_f16",
+                          "conservar audio_features anterior") ||
+            !executeQuery("DROP INDEX IF EXISTS idx_features_time", "conservar audio_features anterior")) {
+            return false;
+        }
+    }
+
+    if (!executeQuery(createFeaturesTable, "crear tabla audio_features")) {
+        return false;
+    }
+
+    if (!executeQuery(createSpectraTable, "crear tabla audio_spectra")) {
+        return false;
+    }
+
+    if (!executeQuery(createTilesTable, "crear tabla spectrogram_tiles")) {
+        return false;
+    }
+
+    if (!executeQuery(createFingerprintsTable, "crear tabla fingerprints")) {
+        return false;
+    }
+
+    if (!executeQuery(createSeekIndexTable, "crear tabla block_seek_index")) {
+        return false;
+    }
+
+    if (!executeQuery(createTimeSeriesTable, "crear tabla ts_chunks")) {
+        return false;
+    }
+
+    if (!executeQuery(createRollupsTable, "crear tabla rollups")) {
+        return false;
+    }
+
     if (!executeQuery(createBlocksIndex, "crear índice bloques")) {
         return false;
     }
@@ -317,10 +1179,62 @@ bool AudioDb::createTables() {
         return false;
     }
 
+    if (!executeQuery(createBlocksOffsetIndex, "crear índice bloques por offset")) {
+        return false;
+    }
+
+    if (!executeQuery(createPeaksOffsetIndex, "crear índice picos por offset")) {
+        return false;
+    }
+
+    if (!executeQuery(createFeaturesIndex, "crear índice descriptores")) {
+        return false;
+    }
+
+    if (!executeQuery(createSpectraIndex, "crear índice espectros")) {
+        return false;
+    }
+
+    if (!executeQuery(createTilesIndex, "crear índice teselas")) {
+        return false;
+    }
+
+    if (!executeQuery(createChunksOffsetIndex, "crear índice chunks por offset")) {
+        return false;
+    }
+
     qDebug() << "Tablas de base de datos creadas correctamente";
     return true;
 }
 
+bool AudioDb::featuresTableIsLegacy(const QString& table) const {
+    return tableHasColumn(table, "feature_count");
+}
+
+bool AudioDb::tableHasColumn(const QString& table, const QString& column) const {
+    QSqlQuery q(m_db);
+    if (!q.exec(QString("PRAGMA table_info(%1)").arg(table))) {
+        return false;
+    }
+    while (q.next()) {
+        if (q.value(1).toString() == column) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void AudioDb::detectLegacyFeatures() {
+    // Lector de una sesión antigua: la tabla no se renombra (sólo lectura)
+    if (featuresTableIsLegacy("audio_features")) {
+        m_legacyFeaturesTable = "audio_features";
+    } else if (featuresTableIsLegacy("audio_features_f16")) {
+        m_legacyFeaturesTable = "audio_features_f16";
+    } else {
+        m_legacyFeaturesTable.clear();
+    }
+}
+
 bool AudioDb::executeQuery(const QString& queryStr, const QString& operation) {
     QSqlQuery query(m_db);
 
@@ -344,12 +1258,12 @@ QList<PeakRecord> AudioDb::getPeaksByTime(qint64 tStart, qint64 tEnd) const
     if (!m_initialized) return out;
 
     QSqlQuery q(m_db);
-    q.prepare(R"(
-        SELECT block_index, sample_offset, timestamp, min_value, max_value
+    q.prepare(QString(R"(
+        SELECT block_index, sample_offset, timestamp, min_value, max_value, %1
           FROM audio_peaks
          WHERE timestamp BETWEEN ? AND ?
          ORDER BY timestamp ASC
-    )");
+    )").arg(m_peaksHaveRms ? "rms_value" : "0.0"));
     q.addBindValue(tStart);
     q.addBindValue(tEnd);
 
@@ -365,11 +1279,174 @@ QList<PeakRecord> AudioDb::getPeaksByTime(qint64 tStart, qint64 tEnd) const
         rec.timestamp    = q.value(2).toLongLong();
         rec.minValue     = q.value(3).toFloat();
         rec.maxValue     = q.value(4).toFloat();
+        rec.rmsValue     = q.value(5).toFloat();
         out.append(rec);
     }
+
+    const qsizetype legacyRows = out.size();
+    appendPeakRows(readTimeSeries(TimeSeries::Peaks, "chunk_start > ? AND chunk_start <= ?",
+                                  tStart - kChunkDurationNs, tEnd),
+                   [tStart, tEnd](const PeakRecord& r) { return r.timestamp >= tStart && r.timestamp <= tEnd; },
+                   out);
+    if (legacyRows > 0 && out.size() > legacyRows) {
+        std::stable_sort(out.begin(), out.end(),
+                         [](const PeakRecord& a, const PeakRecord& b) { return a.timestamp < b.timestamp; });
+    }
+    return out;
+}
+
+bool AudioDb::updateRollups(quint64 timestampNs, float minValue, float maxValue, float rmsValue) {
+    if (!m_initialized) {
+        return false;
+    }
+
+    QVector<RollupBucket> changed;
+    m_rollups.addBlock(static_cast<qint64>(timestampNs), minValue, maxValue, rmsValue, &changed);
+    return changed.isEmpty() || writeRollups(changed);
+}
+
+bool AudioDb::writeRollups(const QVector<RollupBucket>& buckets) {
+    if (buckets.isEmpty()) {
+        return true;
+    }
+
+    m_db.transaction();
+    QSqlQuery q(m_db);
+    q.prepare(R"(
+        INSERT OR REPLACE INTO rollups
+            (level, bucket_start, last_ts, block_count, min_value, max_value,
+             sum_squares, peak_count, event_count)
+        VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?)
+    )");
+    for (const RollupBucket& bucket : buckets) {
+        const RollupBucket b = bucket.startNs <= m_persistedRollupsEndNs
+            ? mergedRollup(persistedRollup(bucket.level, bucket.startNs), bucket)
+            : bucket;
+        q.addBindValue(b.level);
+        q.addBindValue(b.startNs);
+        q.addBindValue(b.lastNs);
+        q.addBindValue(b.blockCount);
+        q.addBindValue(b.minValue);
+        q.addBindValue(b.maxValue);
+        q.addBindValue(b.sumSquares);
+        q.addBindValue(b.peakCount);
+        q.addBindValue(b.eventCount);
+        if (!q.exec()) {
+            logError("guardar rollups", q.lastError());
+            m_db.rollback();
+            return false;
+        }
+    }
+    m_db.commit();
+    return true;
+}
+
+RollupBucket AudioDb::persistedRollup(int level, qint64 startNs) {
+    const QPair<int, qint64> key(level, startNs);
+    const auto it = m_persistedRollups.constFind(key);
+    if (it != m_persistedRollups.cend()) {
+        return *it;
+    }
+
+    // Primera vez que este escritor toca el bucket: la fila aún es la previa
+    RollupBucket row;
+    QSqlQuery q(m_db);
+    q.prepare(QString("SELECT %1 FROM rollups WHERE level = ? AND bucket_start = ?").arg(kRollupColumns));
+    q.addBindValue(level);
+    q.addBindValue(startNs);
+    if (!q.exec()) {
+        qWarning() << "Error leyendo rollup previo:" << q.lastError().text();
+    } else if (q.next()) {
+        row = rollupFromQuery(q, level);
+    }
+    m_persistedRollups.insert(key, row);
+    return row;
+}
+
+QList<RollupBucket> AudioDb::getRollups(int level, qint64 tStart, qint64 tEnd) const {
+    QList<RollupBucket> out;
+    if (!m_initialized || level < 0 || level >= RollupAggregator::LevelCount) return out;
+
+    QSqlQuery q(m_db);
+    q.setForwardOnly(true);
+    q.prepare(QString(R"(
+        SELECT %1
+          FROM rollups
+         WHERE level = ? AND bucket_start BETWEEN ? AND ?
+         ORDER BY bucket_start ASC
+    )").arg(kRollupColumns));
+    q.addBindValue(level);
+    q.addBindValue(RollupAggregator::bucketStart(level, tStart));
+    q.addBindValue(tEnd);
+
+    if (!q.exec()) {
+        qWarning() << "Error leyendo rollups:" << q.lastError().text();
+        return out;
+    }
+
+    while (q.next()) {
+        out.append(rollupFromQuery(q, level));
+    }
+
+    // En el escritor el bucket en curso está en memoria (la tabla va hasta 1 s por detrás)
+    if (!m_readOnly) {
+        RollupBucket open = m_rollups.current(level);
+        if (!open.isEmpty() && open.startNs <= tEnd && open.startNs + RollupAggregator::levelWidthNs(level) > tStart) {
+            const bool haveRow = !out.isEmpty() && out.last().startNs == open.startNs;
+
+            // Si el bucket ya existía al abrir, la memoria sólo tiene lo de este escritor;
+            // mientras no lo haya reescrito, la fila de la tabla es la previa
+            if (open.startNs <= m_persistedRollupsEndNs) {
+                const auto it = m_persistedRollups.constFind(qMakePair(level, open.startNs));
+                const RollupBucket base = it != m_persistedRollups.cend() ? *it
+                                        : haveRow                         ? out.last()
+                                                                          : RollupBucket();
+                open = mergedRollup(base, open);
+            }
+            if (haveRow) {
+                out.last() = open;
+            } else if (out.isEmpty() || out.last().startNs < open.startNs) {
+                out.append(open);
+            }
+        }
+    }
     return out;
 }
 
+QList<RollupBucket> AudioDb::getTrend(qint64 tStart, qint64 tEnd, int maxPoints) const {
+    if (!m_initialized || tEnd < tStart || maxPoints <= 0) return {};
+
+    // Anchura por punto, redondeada hacia arriba para no pasar de maxPoints
+    const qint64 span = tEnd - tStart + 1;
+    const qint64 pointNs = std::max<qint64>(1, (span + maxPoints - 1) / maxPoints);
+
+    const int level = RollupAggregator::levelForResolution(pointNs);
+    if (level >= 0) {
+        const QList<RollupBucket> buckets = getRollups(level, tStart, tEnd);
+        if (!buckets.isEmpty()) {
+            const qint64 width = RollupAggregator::levelWidthNs(level);
+            return groupBuckets(buckets, ((pointNs + width - 1) / width) * width);
+        }
+    }
+
+    // Resolución por debajo de 1 s o sesión sin rollups: picos por bloque
+    QList<RollupBucket> blocks;
+    const float threshold = m_rollups.peakThreshold();
+    for (const PeakRecord& p : getPeaksByTime(tStart, tEnd)) {
+        RollupBucket b;
+        b.level = -1;
+        b.startNs = p.timestamp;
+        b.lastNs = p.timestamp;
+        b.blockCount = 1;
+        b.minValue = p.minValue;
+        b.maxValue = p.maxValue;
+        b.sumSquares = double(p.rmsValue) * p.rmsValue;
+        b.peakCount = std::max(std::abs(p.minValue), std::abs(p.maxValue)) >= threshold ? 1 : 0;
+        blocks.append(b);
+    }
+    return groupBuckets(blocks, pointNs);
+}
+
 QByteArray AudioDb::getRawBlock(qint64 blockIndex) const {
     QSqlQuery q(m_db);
     q.prepare("SELECT audio_data FROM audio_blocks WHERE block_index = ?");
@@ -382,6 +1459,30 @@ QByteArray AudioDb::getRawBlock(qint64 blockIndex) const {
 QList<QByteArray> AudioDb::getBlocksByOffset(qint64 offsetStart, int nBlocks) const {
     QList<QByteArray> blocks;
     if (!m_initialized) return blocks;
+
+    BlockLocation first = m_blockIndex.firstAtOrAfterSampleOffset(offsetStart);
+    if (!first.isValid() || first.blockIndex + nBlocks > m_blockIndex.endBlock()) {
+        ensureBlockIndexed(first.isValid() ? first.blockIndex + nBlocks : m_blockIndex.endBlock() + 1);
+        first = m_blockIndex.firstAtOrAfterSampleOffset(offsetStart);
+    }
+
+    if (first.isValid()) {
+        // Las filas se insertan en orden: los n siguientes por rowid, sin ordenar
+        QSqlQuery q(m_db);
+        q.prepare("SELECT audio_data FROM audio_blocks WHERE id >= ? ORDER BY id LIMIT ?");
+        q.addBindValue(first.location);
+        q.addBindValue(nBlocks);
+
+        if (!q.exec()) {
+            qWarning() << "Error leyendo bloques por offset:" << q.lastError().text();
+            return blocks;
+        }
+        while (q.next()) {
+            blocks.append(q.value(0).toByteArray());
+        }
+        return blocks;
+    }
+
     QSqlQuery q(m_db);
     q.prepare(R"(
         SELECT audio_data
@@ -404,9 +1505,126 @@ QList<QByteArray> AudioDb::getBlocksByOffset(qint64 offsetStart, int nBlocks) co
     return blocks;
 }
 
+QList<RawBlockRecord> AudioDb::getBlocksInRange(qint64 offsetStart, qint64 offsetEnd) const {
+    QList<RawBlockRecord> blocks;
+    if (!m_initialized || offsetEnd <= offsetStart) return blocks;
+
+    BlockLocation last = m_blockIndex.locateSampleOffset(offsetEnd - 1);
+    if (!last.isValid() || last.blockIndex + 1 >= m_blockIndex.endBlock()) {
+        ensureBlockIndexed(m_blockIndex.endBlock() + 1);
+        last = m_blockIndex.locateSampleOffset(offsetEnd - 1);
+    }
+
+    if (last.isValid()) {
+        // Del bloque que contiene offsetStart al que contiene offsetEnd - 1, por rowid
+        const BlockLocation first = m_blockIndex.locateSampleOffset(offsetStart);
+        const qint64 firstRow = first.isValid() ? first.location : 0;
+
+        QSqlQuery q(m_db);
+        q.prepare(R"(
+            SELECT block_index, sample_offset, audio_data
+              FROM audio_blocks
+             WHERE id >= ? AND id <= ?
+             ORDER BY id ASC
+        )");
+        q.addBindValue(firstRow);
+        q.addBindValue(last.location);
+
+        if (!q.exec()) {
+            qWarning() << "Error leyendo bloques por rango:" << q.lastError().text();
+            return blocks;
+        }
+        while (q.next()) {
+            RawBlockRecord rec;
+            rec.blockIndex   = q.value(0).toLongLong();
+            rec.sampleOffset = q.value(1).toLongLong();
+            rec.data         = q.value(2).toByteArray();
+            blocks.append(rec);
+        }
+        return blocks;
+    }
+
+    // Incluye el bloque que contiene offsetStart aunque empiece antes
+    QSqlQuery q(m_db);
+    q.prepare(R"(
+        SELECT block_index, sample_offset, audio_data
+          FROM audio_blocks
+         WHERE sample_offset >= COALESCE((SELECT MAX(sample_offset) FROM audio_blocks
+                                           WHERE sample_offset <= ?), 0)
+           AND sample_offset < ?
+         ORDER BY sample_offset ASC
+    )");
+    q.addBindValue(offsetStart);
+    q.addBindValue(offsetEnd);
+
+    if (!q.exec()) {
+        qWarning() << "Error leyendo bloques por rango:" << q.lastError().text();
+        return blocks;
+    }
+
+    while (q.next()) {
+        RawBlockRecord rec;
+        rec.blockIndex   = q.value(0).toLongLong();
+        rec.sampleOffset = q.value(1).toLongLong();
+        rec.data         = q.value(2).toByteArray();
+        blocks.append(rec);
+    }
+    return blocks;
+}
+
+QList<PeakRecord> AudioDb::getPeaksByOffset(qint64 offsetStart, qint64 offsetEnd) const {
+    QList<PeakRecord> out;
+    if (!m_initialized) return out;
+
+    QSqlQuery q(m_db);
+    q.prepare(QString(R"(
+        SELECT block_index, sample_offset, timestamp, min_value, max_value, %1
+          FROM audio_peaks
+         WHERE sample_offset >= ? AND sample_offset < ?
+         ORDER BY sample_offset ASC
+    )").arg(m_peaksHaveRms ? "rms_value" : "0.0"));
+    q.addBindValue(offsetStart);
+    q.addBindValue(offsetEnd);
+
+    if (!q.exec()) {
+        qWarning() << "Error leyendo picos por offset:" << q.lastError().text();
+        return out;
+    }
+
+    while (q.next()) {
+        PeakRecord rec;
+        rec.blockIndex   = q.value(0).toLongLong();
+        rec.sampleOffset = q.value(1).toLongLong();
+        rec.timestamp    = q.value(2).toLongLong();
+        rec.minValue     = q.value(3).toFloat();
+        rec.maxValue     = q.value(4).toFloat();
+        rec.rmsValue     = q.value(5).toFloat();
+        out.append(rec);
+    }
+
+    const qsizetype legacyRows = out.size();
+    appendPeakRows(readTimeSeries(TimeSeries::Peaks, "last_offset >= ? AND first_offset < ?",
+                                  offsetStart, offsetEnd),
+                   [offsetStart, offsetEnd](const PeakRecord& r) {
+                       return r.sampleOffset >= offsetStart && r.sampleOffset < offsetEnd;
+                   },
+                   out);
+    if (legacyRows > 0 && out.size() > legacyRows) {
+        std::stable_sort(out.begin(), out.end(),
+                         [](const PeakRecord& a, const PeakRecord& b) { return a.sampleOffset < b.sampleOffset; });
+    }
+    return out;
+}
+
 quint64 AudioDb::getBlockTimestamp(qint64 blockIndex) const {
     if (!m_initialized) return 0;
 
+    ensureBlockIndexed(blockIndex + 1);
+    const BlockLocation loc = m_blockIndex.locate(blockIndex);
+    if (loc.isValid()) {
+        return static_cast<quint64>(loc.timestampNs);
+    }
+
     QSqlQuery q(m_db);
     q.prepare(R"(
         SELECT timestamp
@@ -424,6 +1642,12 @@ quint64 AudioDb::getBlockTimestamp(qint64 blockIndex) const {
 qint64 AudioDb::getBlockSampleOffset(qint64 blockIndex) const {
     if (!m_initialized) return 0;
 
+    ensureBlockIndexed(blockIndex + 1);
+    const BlockLocation loc = m_blockIndex.locate(blockIndex);
+    if (loc.isValid()) {
+        return loc.sampleOffset;
+    }
+
     QSqlQuery q(m_db);
     q.prepare(R"(
         SELECT sample_offset
@@ -442,10 +1666,235 @@ qint64 AudioDb::getBlockSampleOffset(qint64 blockIndex) const {
     return q.value(0).toLongLong();
 }
 
+qint64 AudioDb::getBlockAtTimestamp(qint64 timestampNs) const {
+    if (!m_initialized) return -1;
+
+    BlockLocation loc = m_blockIndex.locateTimestamp(timestampNs);
+    if (!loc.isValid() || loc.blockIndex + 1 >= m_blockIndex.endBlock()) {
+        ensureBlockIndexed(m_blockIndex.endBlock() + 1);
+        loc = m_blockIndex.locateTimestamp(timestampNs);
+    }
+    return loc.blockIndex;
+}
+
+qint64 AudioDb::getBlockAtSampleOffset(qint64 sampleOffset) const {
+    if (!m_initialized) return -1;
+
+    BlockLocation loc = m_blockIndex.locateSampleOffset(sampleOffset);
+    if (!loc.isValid() || loc.blockIndex + 1 >= m_blockIndex.endBlock()) {
+        ensureBlockIndexed(m_blockIndex.endBlock() + 1);
+        loc = m_blockIndex.locateSampleOffset(sampleOffset);
+    }
+    return loc.blockIndex;
+}
+
+void AudioDb::loadBlockIndex() {
+    m_blockIndex.clear();
+
+    QSqlQuery q(m_db);
+    // Sesiones antiguas no tienen la tabla: se reconstruye recorriendo audio_blocks
+    if (q.exec("SELECT data FROM block_seek_index WHERE id = 0") && q.next()) {
+        if (!m_blockIndex.fromByteArray(q.value(0).toByteArray())) {
+            qWarning() << "AudioDb: índice de bloques dañado, se reconstruye";
+        }
+    }
+
+    // Un índice que apunta más allá de la tabla no es de este contenido
+    if (!m_blockIndex.isEmpty() && q.exec("SELECT MAX(id) FROM audio_blocks") && q.next() &&
+        q.value(0).toLongLong() < m_blockIndex.lastLocation()) {
+        m_blockIndex.clear();
+    }
+
+    catchUpBlockIndex();
+
+    TFT_DEBUG(lcDb) << "AudioDb: índice de bloques" << m_blockIndex.blockCount() << "bloques,"
+                    << m_blockIndex.entryCount() << "entradas," << m_blockIndex.gapCount() << "huecos";
+}
+
+void AudioDb::catchUpBlockIndex() const {
+    QSqlQuery q(m_db);
+    q.setForwardOnly(true);
+    q.prepare(R"(
+        SELECT id, block_index, sample_offset, timestamp
+          FROM audio_blocks
+         WHERE id > ?
+         ORDER BY id ASC
+    )");
+    q.addBindValue(m_blockIndex.isEmpty() ? qint64(0) : m_blockIndex.lastLocation());
+    if (!q.exec()) {
+        qWarning() << "Error indexando bloques:" << q.lastError().text();
+        return;
+    }
+
+    while (q.next()) {
+        m_blockIndex.append(q.value(1).toLongLong(), q.value(2).toLongLong(),
+                            q.value(3).toLongLong(), q.value(0).toLongLong());
+    }
+}
+
+void AudioDb::ensureBlockIndexed(qint64 endBlock) const {
+    // El escritor indexa al insertar; sólo un lector puede quedarse atrás
+    if (m_readOnly && endBlock > m_blockIndex.endBlock()) {
+        catchUpBlockIndex();
+    }
+}
+
+void AudioDb::saveBlockIndex() {
+    if (!m_initialized || m_readOnly) {
+        return;
+    }
+
+    QSqlQuery q(m_db);
+    q.prepare("INSERT OR REPLACE INTO block_seek_index (id, data) VALUES (0, ?)");
+    q.addBindValue(m_blockIndex.toByteArray());
+    if (!q.exec()) {
+        logError("guardar índice de bloques", q.lastError());
+    }
+}
+
+AudioDb::OpenChunk& AudioDb::openChunk(TimeSeries series) {
+    return series == TimeSeries::Peaks ? m_peakChunk : m_featureChunk;
+}
+
+const AudioDb::OpenChunk& AudioDb::openChunk(TimeSeries series) const {
+    return series == TimeSeries::Peaks ? m_peakChunk : m_featureChunk;
+}
+
+bool AudioDb::appendTimeSeries(TimeSeries series, const qint64* ints, const float* floats,
+                               qint64 sampleOffset) {
+    OpenChunk& chunk = openChunk(series);
+    const qint64 ts = ints[0];
+    const qint64 window = ts - ts % kChunkDurationNs;
+
+    bool ok = true;
+    if (chunk.encoder.rowCount() > 0 &&
+        (window != chunk.chunkStart || chunk.encoder.rowCount() >= kChunkMaxRows)) {
+        // Ventana cerrada: versión final del chunk y se empieza otro
+        ok = chunk.unsavedRows == 0 || writeChunk(series, chunk);
+        chunk.encoder.clear();
+        chunk.unsavedRows = 0;
+    }
+
+    if (chunk.encoder.rowCount() == 0) {
+        chunk.chunkStart = window;
+        chunk.firstBlock = ints[1];
+        chunk.firstTimestamp = ts;
+        chunk.firstOffset = sampleOffset;
+    }
+    chunk.encoder.append(ints, floats);
+    chunk.lastBlock = ints[1];
+    chunk.lastTimestamp = ts;
+    chunk.lastOffset = sampleOffset;
+    ++chunk.unsavedRows;
+
+    if (chunk.unsavedRows >= kChunkSaveRows) {
+        ok = writeChunk(series, chunk) && ok;
+    }
+    return ok;
+}
+
+bool AudioDb::writeChunk(TimeSeries series, OpenChunk& chunk) {
+    QSqlQuery q(m_db);
+    q.prepare(R"(
+        INSERT OR REPLACE INTO ts_chunks
+            (series, chunk_start, first_block, last_block, first_ts, last_ts,
+             first_offset, last_offset, row_count, data)
+        VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?)
+    )");
+    q.addBindValue(int(series));
+    q.addBindValue(chunk.chunkStart);
+    q.addBindValue(chunk.firstBlock);
+    q.addBindValue(chunk.lastBlock);
+    q.addBindValue(chunk.firstTimestamp);
+    q.addBindValue(chunk.lastTimestamp);
+    q.addBindValue(chunk.firstOffset);
+    q.addBindValue(chunk.lastOffset);
+    q.addBindValue(chunk.encoder.rowCount());
+    q.addBindValue(chunk.encoder.data());
+
+    if (!q.exec()) {
+        logError("guardar chunk de serie temporal", q.lastError());
+        return false;
+    }
+    chunk.unsavedRows = 0;
+    return true;
+}
+
+bool AudioDb::flushTimeSeries() {
+    if (!m_initialized || m_readOnly) {
+        return false;
+    }
+
+    bool ok = true;
+    for (TimeSeries series : { TimeSeries::Peaks, TimeSeries::FeatureScalars }) {
+        OpenChunk& chunk = openChunk(series);
+        if (chunk.unsavedRows > 0) {
+            ok = writeChunk(series, chunk) && ok;
+        }
+    }
+    return ok;
+}
+
+QVector<GorillaColumns> AudioDb::readTimeSeries(TimeSeries series, const QString& range,
+                                                qint64 lo, qint64 hi) const {
+    QVector<GorillaColumns> out;
+    const OpenChunk& open = openChunk(series);
+    const bool haveOpen = !m_readOnly && open.encoder.rowCount() > 0;
+
+    QSqlQuery q(m_db);
+    q.setForwardOnly(true);
+    q.prepare(QString(R"(
+        SELECT chunk_start, first_block, data
+          FROM ts_chunks
+         WHERE series = ? AND %1
+         ORDER BY chunk_start ASC, first_block ASC
+    )").arg(range));
+    q.addBindValue(int(series));
+    q.addBindValue(lo);
+    q.addBindValue(hi);
+
+    if (!q.exec()) {
+        qWarning() << "Error leyendo series temporales:" << q.lastError().text();
+        return out;
+    }
+
+    // Los chunks de picos anteriores a la columna RMS sólo traen min/max
+    const int minFloats = series == TimeSeries::Peaks ? int(PeakRms) : open.encoder.floatColumns();
+    auto decode = [&out, &open, minFloats](const QByteArray& data) {
+        GorillaColumns cols;
+        if (!GorillaDecoder::decode(data, cols) || cols.ints.size() != open.encoder.intColumns() ||
+            cols.floats.size() < minFloats || cols.floats.size() > open.encoder.floatColumns()) {
+            qWarning() << "AudioDb: chunk de serie temporal dañado, se omite";
+            return;
+        }
+        out.append(cols);
+    };
+
+    while (q.next()) {
+        // La copia en disco del chunk abierto puede ir atrasada: se usa la de memoria
+        if (haveOpen && q.value(0).toLongLong() == open.chunkStart &&
+            q.value(1).toLongLong() == open.firstBlock) {
+            continue;
+        }
+        decode(q.value(2).toByteArray());
+    }
+
+    if (haveOpen) {
+        decode(open.encoder.data());
+    }
+    return out;
+}
+
 void AudioDb::shutdown() {
     if (!m_db.isValid())
         return;
 
+    flushTimeSeries();
+    if (m_initialized && !m_readOnly) {
+        writeRollups(m_rollups.currentBuckets());
+    }
+    saveBlockIndex();
+
     if (m_db.isOpen())
         m_db.close();
 
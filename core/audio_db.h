@@ -8,7 +8,16 @@
 #include <QSqlQuery>
 #include <QSqlError>
 #include <QList>
+#include <QHash>
+#include <QPair>
 #include <QtTypes>
+#include <limits>
+#include "core/analysis_types.h"
+#include "core/compact_spectrum.h"
+#include "core/spectrogram_pyramid.h"
+#include "core/sparse_block_index.h"
+#include "core/gorilla_codec.h"
+#include "core/rollup_aggregator.h"
 
 /**
  * @brief Registro de pico (min/max) con metadatos
@@ -19,6 +28,43 @@ struct PeakRecord {
     qint64 sampleOffset;
     float   minValue;
     float   maxValue;
+    float   rmsValue = 0.0f;   ///< 0 en sesiones anteriores a la columna rms_value
+};
+
+/**
+ * @brief Bloque crudo con su posición en la sesión
+ */
+struct RawBlockRecord {
+    qint64 blockIndex;
+    qint64 sampleOffset;
+    QByteArray data;     ///< float32 intercalado, tal como se guardó
+};
+
+/**
+ * @brief Descriptores de un bloque con su posición temporal
+ */
+struct FeatureRecord {
+    qint64 timestamp;
+    qint64 blockIndex;
+    AudioFeatures features;
+};
+
+/**
+ * @brief Espectro de un bloque tal como se almacenó
+ */
+struct SpectrumRecord {
+    qint64 timestamp;
+    qint64 blockIndex;
+    CompactSpectrum spectrum;
+};
+
+/**
+ * @brief Coincidencia de una consulta de huellas con la sesión
+ */
+struct FingerprintMatch {
+    qint64 blockIndex;   ///< Bloque de la sesión donde empieza el clip
+    quint64 timestamp;   ///< Timestamp (ns) de ese bloque
+    int votes;           ///< Hashes alineados con ese desplazamiento
 };
 
 /**
@@ -35,24 +81,138 @@ public:
     /** Inicializa la base de datos y crea las tablas necesarias */
     bool initialize();
 
+    bool isInitialized() const { return m_initialized; }
+
+    /** Abrir en sólo lectura (antes de initialize): sin esquema ni PRAGMAs de escritura */
+    void setReadOnly(bool readOnly) { m_readOnly = readOnly; }
+
     void shutdown();
 
-    /** Borra todos los datos y reinicia contadores */
+    /**
+     * @brief Borra todos los datos y reinicia contadores
+     *
+     * No compacta: las páginas liberadas se reutilizan en las siguientes
+     * inserciones. Para devolver el espacio al sistema usar vacuum().
+     */
     bool clearDatabase();
 
+    /** Compacta el fichero (VACUUM); coste proporcional al tamaño */
+    bool vacuum();
+
+    /**
+     * @brief Reserva espacio en el fichero
+     *
+     * Inserta y borra un BLOB de ceros: con auto_vacuum desactivado las
+     * páginas quedan en la lista libre y las inserciones posteriores no
+     * necesitan hacer crecer el fichero.
+     */
+    bool preallocate(qint64 bytes);
+
     /** Inserta un bloque de audio (raw) */
     bool insertBlock(qint64 blockIndex,
                      qint64 sampleOffset,
                      const QByteArray& audioData,
                      quint64 timestampNs);
 
-    /** Inserta un registro de pico (min/max) */
+    /**
+     * @brief Inserta un registro de pico (min/max/RMS)
+     *
+     * Con compresión (por defecto) se añade al chunk abierto de la serie de
+     * picos en ts_chunks; si no, es una fila de audio_peaks.
+     */
     bool insertPeak(qint64 blockIndex,
                     qint64 sampleOffset,
                     float minValue,
                     float maxValue,
+                    float rmsValue,
                     quint64 timestampNs);
 
+    /**
+     * @brief Inserta los descriptores de un bloque
+     *
+     * Los escalares (centroide, rolloff, planitud, ZCR) van en columnas
+     * REAL y los MFCC en un BLOB float16, indexados por timestamp. Con
+     * compresión los escalares van sólo a su serie en ts_chunks y las
+     * columnas REAL quedan NULL (getFeaturesByTime los recompone).
+     */
+    bool insertFeatures(qint64 blockIndex,
+                        quint64 timestampNs,
+                        const AudioFeatures& features);
+
+    /** Devuelve los descriptores entre dos timestamps */
+    QList<FeatureRecord> getFeaturesByTime(qint64 tStart, qint64 tEnd) const;
+
+    /** Descriptores escalares (sin MFCC) entre dos timestamps, de ts_chunks */
+    QList<FeatureRecord> getFeatureScalarsByTime(qint64 tStart, qint64 tEnd) const;
+
+    /**
+     * @brief Guarda picos y escalares en chunks comprimidos (ts_chunks)
+     *
+     * Cada serie se parte en chunks de 10 s codificados con GorillaEncoder
+     * (delta-of-delta para timestamps/bloques/offsets, XOR para los floats).
+     * Las sesiones con filas en audio_peaks se siguen leyendo: las consultas
+     * combinan ambas fuentes. Activado por defecto.
+     */
+    void setCompressTimeSeries(bool enabled) { m_compressTimeSeries = enabled; }
+    bool compressTimeSeries() const { return m_compressTimeSeries; }
+
+    /**
+     * @brief Escribe los chunks abiertos en ts_chunks
+     *
+     * El chunk en curso se reescribe cada 64 filas para que los lectores
+     * concurrentes lo vean; shutdown() vuelca el resto.
+     */
+    bool flushTimeSeries();
+
+    /**
+     * @brief Inserta el espectro de un bloque sin reconvertirlo
+     *
+     * Se guarda con su formato y rango, de modo que float16/uint8 ocupan
+     * 2-4 veces menos que float32.
+     */
+    bool insertSpectrum(qint64 blockIndex,
+                        quint64 timestampNs,
+                        const CompactSpectrum& spectrum);
+
+    /** Devuelve los espectros entre dos timestamps */
+    QList<SpectrumRecord> getSpectraByTime(qint64 tStart, qint64 tEnd) const;
+
+    /** Guarda (o reemplaza, si era parcial) una tesela de la pirámide */
+    bool insertTile(const SpectrogramTile& tile);
+
+    /** Primer tile_index libre de cada nivel (0 si el nivel está vacío) */
+    QVector<qint64> nextTileIndices(int levels) const;
+
+    /** Intervalo cubierto por las teselas de nivel 0; false si no hay */
+    bool getTileTimeSpan(qint64& firstTs, qint64& lastTs) const;
+
+    /**
+     * @brief Teselas para dibujar [tStart, tEnd] con a lo sumo maxColumns columnas
+     *
+     * Estima el periodo de columna con una tesela de nivel 0, elige el nivel
+     * con SpectrogramPyramid::levelForSpan y lee sólo las teselas de ese
+     * nivel que solapan el intervalo (~maxColumns/tileColumns + 2 filas).
+     */
+    QList<SpectrogramTile> getTilesForSpan(qint64 tStart, qint64 tEnd, int maxColumns) const;
+
+    /**
+     * @brief Añade hashes al índice invertido de huellas
+     *
+     * Se insertan en una única transacción; la tabla está agrupada por
+     * hash (WITHOUT ROWID) para que las búsquedas sean un recorrido de índice.
+     */
+    bool insertFingerprints(const QVector<FingerprintHash>& hashes);
+
+    /**
+     * @brief Busca un clip en la sesión
+     *
+     * Cada hash coincidente vota por el desplazamiento bloque almacenado -
+     * frame del clip; los desplazamientos más votados son las apariciones.
+     */
+    QList<FingerprintMatch> findFingerprintMatches(const QVector<FingerprintHash>& query,
+                                                   int maxResults = 10,
+                                                   int minVotes = 5) const;
+
     /** Obtiene todos los bloques de audio en orden */
     QList<QByteArray> getAllAudioBlocks() const;
 
@@ -71,21 +231,72 @@ public:
     /** Tamaño total en bytes de todos los bloques */
     qint64 getTotalAudioSize() const;
 
+    /** Offset (en muestras) del final del último bloque; 0 si no hay bloques */
+    qint64 getSampleExtent() const;
+
     /** Devuelve los picos entre dos timestamps */
     QList<PeakRecord> getPeaksByTime(qint64 tStart, qint64 tEnd) const;
 
+    /**
+     * @brief Acumula un bloque en los rollups de 1 s / 1 min / 1 h
+     *
+     * Se llama por bloque durante la captura (junto a insertPeak). Cada
+     * segundo cerrado se escribe en `rollups` con el estado parcial del
+     * minuto y la hora en curso, así que los lectores van como mucho 1 s
+     * por detrás. shutdown() vuelca los buckets abiertos. Al reabrir una
+     * sesión los buckets que ya estaban en la tabla se continúan.
+     */
+    bool updateRollups(quint64 timestampNs, float minValue, float maxValue, float rmsValue);
+
+    /** |pico| lineal que cuenta como pico/evento en los rollups (por defecto ≈ -1 dBFS) */
+    void setRollupPeakThreshold(float threshold) { m_rollups.setPeakThreshold(threshold); }
+
+    /** Buckets de un nivel de rollup que solapan [tStart, tEnd], en orden */
+    QList<RollupBucket> getRollups(int level, qint64 tStart, qint64 tEnd) const;
+
+    /**
+     * @brief Tendencia de [tStart, tEnd] con a lo sumo ~maxPoints puntos
+     *
+     * Lee el nivel de rollup más grueso cuya anchura cabe en el intervalo
+     * por punto y agrupa sus buckets (la mezcla es exacta) hasta no pasar
+     * de maxPoints: una semana en 2000 puntos lee ~10 000 filas de 1 min y
+     * las agrupa de 6 en 6. Por debajo de 1 s por punto, o en sesiones sin
+     * rollups, agrupa los picos por bloque (sin RMS, Leq ni eventos).
+     */
+    QList<RollupBucket> getTrend(qint64 tStart, qint64 tEnd, int maxPoints) const;
+
     /** Obtiene el blob crudo de un bloque */
     QByteArray getRawBlock(qint64 blockIndex) const;
 
-    /** Obtiene n bloques a partir de un sampleOffset */
+    /**
+     * @brief Obtiene n bloques a partir de un sampleOffset
+     *
+     * Con el índice disperso, el offset se resuelve en memoria y la lectura
+     * es un recorrido por rowid; sin él, consulta por sample_offset.
+     */
     QList<QByteArray> getBlocksByOffset(qint64 offsetStart, int nBlocks) const;
 
-    /** Devuelve el timestamp (ns) de un bloque dado */
+    /** Bloques que solapan [offsetStart, offsetEnd) en orden de sample_offset */
+    QList<RawBlockRecord> getBlocksInRange(qint64 offsetStart, qint64 offsetEnd) const;
+
+    /** Picos de los bloques con sample_offset en [offsetStart, offsetEnd) */
+    QList<PeakRecord> getPeaksByOffset(qint64 offsetStart, qint64 offsetEnd) const;
+
+    /** Devuelve el timestamp (ns) de un bloque dado (del índice, ±1 µs) */
     quint64 getBlockTimestamp(qint64 blockIndex) const;
 
     /** Devuelve el sampleOffset de un bloque dado */
     qint64  getBlockSampleOffset(qint64 blockIndex) const;
 
+    /** Bloque que contiene un instante (ns); -1 si no hay bloques o es anterior */
+    qint64  getBlockAtTimestamp(qint64 timestampNs) const;
+
+    /** Bloque que contiene un sampleOffset; -1 si no hay bloques o es anterior */
+    qint64  getBlockAtSampleOffset(qint64 sampleOffset) const;
+
+    /** Índice disperso de audio_blocks (se construye al insertar y al abrir) */
+    const SparseBlockIndex& blockIndex() const { return m_blockIndex; }
+
 signals:
     /** Emitido al ocurrir un error en la base de datos */
     void errorOccurred(const QString& error) const;
@@ -95,9 +306,93 @@ private:
     bool executeQuery(const QString& query, const QString& operation = "");
     void logError(const QString& operation, const QSqlError& error) const;
 
+    /** La tabla tiene el formato anterior de descriptores (BLOB float16 completo) */
+    bool featuresTableIsLegacy(const QString& table) const;
+
+    bool tableHasColumn(const QString& table, const QString& column) const;
+
+    /** Localiza filas de descriptores en el formato anterior */
+    void detectLegacyFeatures();
+
+    /** Carga el índice persistido y le añade las filas posteriores */
+    void loadBlockIndex();
+
+    /** Añade al índice las filas de audio_blocks aún no indexadas */
+    void catchUpBlockIndex() const;
+
+    /** Sesión abierta por otro escritor: pone el índice al día si no llega a `endBlock` */
+    void ensureBlockIndexed(qint64 endBlock) const;
+
+    /** Guarda el índice para abrir la sesión sin recorrer audio_blocks */
+    void saveBlockIndex();
+
+    enum class TimeSeries {
+        Peaks = 0,           ///< ints {timestamp, bloque, offset}, floats {min, max, rms} (antes sin rms)
+        FeatureScalars = 1   ///< ints {timestamp, bloque}, floats {centroide, rolloff, planitud, zcr}
+    };
+
+    /** Chunk en construcción de una serie */
+    struct OpenChunk {
+        OpenChunk(int intColumns, int floatColumns) : encoder(intColumns, floatColumns) {}
+
+        GorillaEncoder encoder;
+        qint64 chunkStart = 0;       ///< Inicio de la ventana de 10 s
+        qint64 firstBlock = 0;
+        qint64 lastBlock = 0;
+        qint64 firstTimestamp = 0;
+        qint64 lastTimestamp = 0;
+        qint64 firstOffset = 0;
+        qint64 lastOffset = 0;
+        int unsavedRows = 0;
+    };
+
+    OpenChunk& openChunk(TimeSeries series);
+    const OpenChunk& openChunk(TimeSeries series) const;
+
+    /** Añade una fila (ints[0] = timestamp, ints[1] = bloque) a la serie */
+    bool appendTimeSeries(TimeSeries series, const qint64* ints, const float* floats, qint64 sampleOffset);
+    bool writeChunk(TimeSeries series, OpenChunk& chunk);
+
+    /**
+     * @brief Decodifica los chunks de la serie que cumplen `range`
+     *
+     * `range` es una condición SQL sobre ts_chunks con dos parámetros (lo, hi).
+     * En el escritor el chunk abierto se lee de memoria (las filas se filtran
+     * después), así que sus filas aún no guardadas también aparecen.
+     */
+    QVector<GorillaColumns> readTimeSeries(TimeSeries series, const QString& range,
+                                           qint64 lo, qint64 hi) const;
+
+    /**
+     * @brief Escribe buckets de rollup sumando lo que ya había en la tabla
+     *
+     * Un escritor que reabre una sesión continúa sus buckets en vez de
+     * pisarlos: la fila previa se lee la primera vez que se toca el bucket
+     * y cada reescritura guarda esa fila más el estado de este escritor.
+     */
+    bool writeRollups(const QVector<RollupBucket>& buckets);
+
+    /** Fila del bucket anterior a este escritor (vacía si no había) */
+    RollupBucket persistedRollup(int level, qint64 startNs);
+
     QString      m_dbPath;
     QSqlDatabase m_db;
     bool         m_initialized = false;
+    bool         m_readOnly = false;
+    QString      m_legacyFeaturesTable;   ///< Tabla con descriptores float16 completos (vacío = ninguna)
+    bool         m_peaksHaveRms = false;  ///< audio_peaks tiene rms_value (lectores de sesiones antiguas)
+
+    // Mutable: los lectores lo ponen al día desde métodos const
+    mutable SparseBlockIndex m_blockIndex;
+
+    RollupAggregator m_rollups;
+    /// Último last_ts de la tabla al abrir: sólo los buckets que empiezan antes pueden tener fila previa
+    qint64 m_persistedRollupsEndNs = std::numeric_limits<qint64>::min();
+    QHash<QPair<int, qint64>, RollupBucket> m_persistedRollups;   ///< Filas previas ya leídas
+
+    bool      m_compressTimeSeries = true;
+    OpenChunk m_peakChunk { 3, 3 };
+    OpenChunk m_featureChunk { 2, AudioFeatures::ScalarCount };
 };
 
 #endif // AUDIO_DB_H
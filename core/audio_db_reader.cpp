@@ -0,0 +1,190 @@
+#include "audio_db_reader.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutex>
+#include <QSharedPointer>
+#include <QTextStream>
+#include <QThreadStorage>
+#include <stdexcept>
+
+namespace {
+struct ThreadConnection {
+    QSharedPointer<AudioDb> db;
+    quint64 epoch = 0;
+};
+
+// Una conexión por (hilo, fichero); se cierra al terminar el hilo del pool
+QThreadStorage<QHash<QString, ThreadConnection>> threadConnections;
+
+// Época por ruta: invalidate() la sube cuando el fichero de esa ruta cambia
+QMutex epochMutex;
+QHash<QString, quint64> pathEpochs;
+
+quint64 currentEpoch(const QString& dbPath) {
+    QMutexLocker lock(&epochMutex);
+    return pathEpochs.value(dbPath, 0);
+}
+
+AudioDb* requireConnection(const QString& dbPath) {
+    AudioDb* db = AudioDbReader::connectionForCurrentThread(dbPath);
+    if (!db) {
+        throw std::runtime_error(QString("No se pudo abrir %1 para lectura").arg(dbPath).toStdString());
+    }
+    return db;
+}
+}
+
+void AudioDbReader::invalidate(const QString& dbPath) {
+    QMutexLocker lock(&epochMutex);
+    ++pathEpochs[dbPath];
+}
+
+AudioDb* AudioDbReader::connectionForCurrentThread(const QString& dbPath) {
+    auto& connections = threadConnections.localData();
+    const quint64 epoch = currentEpoch(dbPath);
+    if (auto it = connections.constFind(dbPath); it != connections.constEnd()) {
+        if (it.value().epoch == epoch) {
+            return it.value().db.data();
+        }
+        // La ruta se renombró o borró desde que se abrió: la conexión apunta
+        // al fichero anterior (o a otro que ocupa ahora su nombre)
+        connections.erase(it);
+    }
+
+    QSharedPointer<AudioDb> db(new AudioDb(dbPath), [](AudioDb* d) {
+        d->shutdown();
+        delete d;
+    });
+    db->setReadOnly(true);
+    if (!db->initialize()) {
+        return nullptr;
+    }
+
+    connections.insert(dbPath, ThreadConnection{db, epoch});
+    return db.data();
+}
+
+Task<QList<PeakRecord>> AudioDbReader::peaksByTime(QObject* context, CancellationToken token,
+                                                   qint64 tStart, qint64 tEnd) const {
+    const QString path = m_path;
+    co_return co_await AsyncTask::run(context, token, [path, tStart, tEnd]() {
+        return requireConnection(path)->getPeaksByTime(tStart, tEnd);
+    });
+}
+
+Task<QList<QByteArray>> AudioDbReader::blocksByOffset(QObject* context, CancellationToken token,
+                                                      qint64 offsetStart, int nBlocks) const {
+    const QString path = m_path;
+    co_return co_await AsyncTask::run(context, token, [path, offsetStart, nBlocks]() {
+        return requireConnection(path)->getBlocksByOffset(offsetStart, nBlocks);
+    });
+}
+
+Task<QList<RawBlockRecord>> AudioDbReader::blocksInRange(QObject* context, CancellationToken token,
+                                                         qint64 offsetStart, qint64 offsetEnd) const {
+    const QString path = m_path;
+    co_return co_await AsyncTask::run(context, token, [path, offsetStart, offsetEnd]() {
+        return requireConnection(path)->getBlocksInRange(offsetStart, offsetEnd);
+    });
+}
+
+Task<QList<PeakRecord>> AudioDbReader::peaksByOffset(QObject* context, CancellationToken token,
+                                                     qint64 offsetStart, qint64 offsetEnd) const {
+    const QString path = m_path;
+    co_return co_await AsyncTask::run(context, token, [path, offsetStart, offsetEnd]() {
+        return requireConnection(path)->getPeaksByOffset(offsetStart, offsetEnd);
+    });
+}
+
+Task<QList<SpectrumRecord>> AudioDbReader::spectraByTime(QObject* context, CancellationToken token,
+                                                         qint64 tStart, qint64 tEnd) const {
+    const QString path = m_path;
+    co_return co_await AsyncTask::run(context, token, [path, tStart, tEnd]() {
+        return requireConnection(path)->getSpectraByTime(tStart, tEnd);
+    });
+}
+
+Task<QList<SpectrogramTile>> AudioDbReader::tilesForSpan(QObject* context, CancellationToken token,
+                                                         qint64 tStart, qint64 tEnd, int maxColumns) const {
+    const QString path = m_path;
+    co_return co_await AsyncTask::run(context, token, [path, tStart, tEnd, maxColumns]() {
+        return requireConnection(path)->getTilesForSpan(tStart, tEnd, maxColumns);
+    });
+}
+
+Task<QPair<qint64, qint64>> AudioDbReader::tileTimeSpan(QObject* context, CancellationToken token) const {
+    const QString path = m_path;
+    co_return co_await AsyncTask::run(context, token, [path]() {
+        qint64 first = 0, last = 0;
+        if (!requireConnection(path)->getTileTimeSpan(first, last)) {
+            first = last = 0;
+        }
+        return qMakePair(first, last);
+    });
+}
+
+Task<qint64> AudioDbReader::sampleExtent(QObject* context, CancellationToken token) const {
+    const QString path = m_path;
+    co_return co_await AsyncTask::run(context, token, [path]() {
+        return requireConnection(path)->getSampleExtent();
+    });
+}
+
+Task<QList<RollupBucket>> AudioDbReader::trend(QObject* context, CancellationToken token,
+                                               qint64 tStart, qint64 tEnd, int maxPoints) const {
+    const QString path = m_path;
+    co_return co_await AsyncTask::run(context, token, [path, tStart, tEnd, maxPoints]() {
+        return requireConnection(path)->getTrend(tStart, tEnd, maxPoints);
+    });
+}
+
+Task<qint64> AudioDbReader::exportPeaks(QObject* context, CancellationToken token,
+                                        QString filePath, qint64 tStart, qint64 tEnd) const {
+    const QString path = m_path;
+
+    // 1) Lectura en el pool
+    const QList<PeakRecord> peaks = co_await AsyncTask::run(context, token, [path, tStart, tEnd]() {
+        return requireConnection(path)->getPeaksByTime(tStart, tEnd);
+    });
+
+    // 2) Escritura en el pool; se comprueba la cancelación por lotes
+    co_return co_await AsyncTask::run(context, token, [peaks, filePath, token]() -> qint64 {
+        QFile file(filePath);
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            throw std::runtime_error(QString("No se pudo escribir %1").arg(filePath).toStdString());
+        }
+
+        const bool json = QFileInfo(filePath).suffix().compare("json", Qt::CaseInsensitive) == 0;
+        qint64 written = 0;
+
+        if (json) {
+            QJsonArray rows;
+            for (const PeakRecord& p : peaks) {
+                if ((written & 0xFFF) == 0 && token.isCancelled()) throw TaskCancelled();
+                rows.append(QJsonObject{
+                    {"timestamp", p.timestamp},
+                    {"blockIndex", p.blockIndex},
+                    {"sampleOffset", p.sampleOffset},
+                    {"min", p.minValue},
+                    {"max", p.maxValue}
+                });
+                ++written;
+            }
+            file.write(QJsonDocument(rows).toJson(QJsonDocument::Indented));
+        } else {
+            QTextStream out(&file);
+            out << "timestamp_ns,block_index,sample_offset,min,max\n";
+            for (const PeakRecord& p : peaks) {
+                if ((written & 0xFFF) == 0 && token.isCancelled()) throw TaskCancelled();
+                out << p.timestamp << ',' << p.blockIndex << ',' << p.sampleOffset << ','
+                    << p.minValue << ',' << p.maxValue << '\n';
+                ++written;
+            }
+        }
+        return written;
+    });
+}
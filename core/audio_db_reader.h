@@ -0,0 +1,80 @@
+#ifndef AUDIO_DB_READER_H
+#define AUDIO_DB_READER_H
+
+#include "core/async_task.h"
+#include "core/audio_db.h"
+#include <QByteArray>
+#include <QList>
+#include <QPair>
+#include <QString>
+
+/**
+ * @brief Lecturas asíncronas de una sesión sin pasar por el hilo DSP
+ *
+ * Cada hilo del pool de E/S abre su propia conexión de sólo lectura al
+ * fichero (QSqlDatabase no se comparte entre hilos), que se reutiliza
+ * mientras el hilo vive. Las consultas devuelven Task<> y se reanudan en
+ * el hilo de `context`, así que ni la GUI ni el DSP esperan a la DB.
+ *
+ * El lector puede destruirse con tareas en curso: cada tarea copia la
+ * ruta antes de suspenderse.
+ */
+class AudioDbReader
+{
+public:
+    explicit AudioDbReader(const QString& dbPath) : m_path(dbPath) {}
+
+    QString path() const { return m_path; }
+
+    Task<QList<PeakRecord>> peaksByTime(QObject* context, CancellationToken token,
+                                        qint64 tStart, qint64 tEnd) const;
+
+    Task<QList<QByteArray>> blocksByOffset(QObject* context, CancellationToken token,
+                                           qint64 offsetStart, int nBlocks) const;
+
+    Task<QList<RawBlockRecord>> blocksInRange(QObject* context, CancellationToken token,
+                                              qint64 offsetStart, qint64 offsetEnd) const;
+
+    Task<QList<PeakRecord>> peaksByOffset(QObject* context, CancellationToken token,
+                                          qint64 offsetStart, qint64 offsetEnd) const;
+
+    Task<QList<SpectrumRecord>> spectraByTime(QObject* context, CancellationToken token,
+                                              qint64 tStart, qint64 tEnd) const;
+
+    /** Teselas de la pirámide que cubren el intervalo con <= maxColumns columnas */
+    Task<QList<SpectrogramTile>> tilesForSpan(QObject* context, CancellationToken token,
+                                              qint64 tStart, qint64 tEnd, int maxColumns) const;
+
+    /** Primer y último timestamp con teselas de nivel 0 ({0, 0} si no hay) */
+    Task<QPair<qint64, qint64>> tileTimeSpan(QObject* context, CancellationToken token) const;
+
+    /** Muestras guardadas en audio_blocks (fin del último bloque) */
+    Task<qint64> sampleExtent(QObject* context, CancellationToken token) const;
+
+    /** Tendencia del intervalo desde los rollups, con <= maxPoints puntos */
+    Task<QList<RollupBucket>> trend(QObject* context, CancellationToken token,
+                                    qint64 tStart, qint64 tEnd, int maxPoints) const;
+
+    /**
+     * @brief Exporta los picos entre dos timestamps a CSV o JSON (por extensión)
+     * @return Filas escritas
+     */
+    Task<qint64> exportPeaks(QObject* context, CancellationToken token,
+                             QString filePath, qint64 tStart, qint64 tEnd) const;
+
+    /** Conexión de sólo lectura del hilo actual (nullptr si no se pudo abrir) */
+    static AudioDb* connectionForCurrentThread(const QString& dbPath);
+
+    /**
+     * @brief Marca como obsoletas las conexiones abiertas a dbPath
+     *
+     * Llamar al renombrar, reciclar o borrar el fichero: cada hilo vuelve a
+     * abrir la ruta en su siguiente lectura. Thread-safe.
+     */
+    static void invalidate(const QString& dbPath);
+
+private:
+    QString m_path;
+};
+
+#endif // AUDIO_DB_READER_H
@@ -0,0 +1,125 @@
+#include "compact_spectrum.h"
+#include <QFloat16>
+#include <algorithm>
+#include <cstring>
+
+int CompactSpectrum::bytesPerBin(SpectrumFormat format) {
+    switch (format) {
+    case SpectrumFormat::Float16:
+    case SpectrumFormat::UInt16:
+        return 2;
+    case SpectrumFormat::UInt8:
+        return 1;
+    case SpectrumFormat::Float32:
+    default:
+        return 4;
+    }
+}
+
+quint32 CompactSpectrum::maxCode(SpectrumFormat format) {
+    switch (format) {
+    case SpectrumFormat::UInt16: return 0xFFFF;
+    case SpectrumFormat::UInt8:  return 0xFF;
+    default:                     return 0;
+    }
+}
+
+CompactSpectrum CompactSpectrum::allocate(int count, SpectrumFormat format, float minDb, float maxDb) {
+    CompactSpectrum out;
+    out.format = format;
+    out.minDb = minDb;
+    out.maxDb = (maxDb > minDb) ? maxDb : minDb + 1.0f;
+    out.bins = std::max(0, count);
+    out.data.resize(qsizetype(out.bins) * bytesPerBin(format));
+    return out;
+}
+
+CompactSpectrum CompactSpectrum::encode(const float* db, int count, SpectrumFormat format,
+                                        float minDb, float maxDb) {
+    CompactSpectrum out = allocate(count, format, minDb, maxDb);
+    if (out.bins == 0) {
+        return out;
+    }
+
+    switch (format) {
+    case SpectrumFormat::Float32:
+        std::memcpy(out.data.data(), db, size_t(count) * sizeof(float));
+        break;
+    case SpectrumFormat::Float16:
+        qFloatToFloat16(reinterpret_cast<qfloat16*>(out.data.data()), db, count);
+        break;
+    case SpectrumFormat::UInt16: {
+        const float scale = 65535.0f / (out.maxDb - out.minDb);
+        quint16* dst = reinterpret_cast<quint16*>(out.data.data());
+        for (int i = 0; i < count; ++i) {
+            dst[i] = quint16(quantize(db[i], out.minDb, scale, 0xFFFF));
+        }
+        break;
+    }
+    case SpectrumFormat::UInt8: {
+        const float scale = 255.0f / (out.maxDb - out.minDb);
+        uchar* dst = reinterpret_cast<uchar*>(out.data.data());
+        for (int i = 0; i < count; ++i) {
+            dst[i] = uchar(quantize(db[i], out.minDb, scale, 0xFF));
+        }
+        break;
+    }
+    }
+    return out;
+}
+
+void CompactSpectrum::decode(float* out) const {
+    if (bins == 0 || data.size() < qsizetype(bins) * bytesPerBin(format)) {
+        return;
+    }
+
+    switch (format) {
+    case SpectrumFormat::Float32:
+        std::memcpy(out, data.constData(), size_t(bins) * sizeof(float));
+        break;
+    case SpectrumFormat::Float16:
+        qFloatFromFloat16(out, reinterpret_cast<const qfloat16*>(data.constData()), bins);
+        break;
+    case SpectrumFormat::UInt16: {
+        const float step = (maxDb - minDb) / 65535.0f;
+        const quint16* src = reinterpret_cast<const quint16*>(data.constData());
+        for (int i = 0; i < bins; ++i) {
+            out[i] = minDb + src[i] * step;
+        }
+        break;
+    }
+    case SpectrumFormat::UInt8: {
+        const float step = (maxDb - minDb) / 255.0f;
+        const uchar* src = reinterpret_cast<const uchar*>(data.constData());
+        for (int i = 0; i < bins; ++i) {
+            out[i] = minDb + src[i] * step;
+        }
+        break;
+    }
+    }
+}
+
+QVector<float> CompactSpectrum::toFloat() const {
+    QVector<float> out(bins);
+    decode(out.data());
+    return out;
+}
+
+float CompactSpectrum::valueAt(int bin) const {
+    if (bin < 0 || bin >= bins) {
+        return minDb;
+    }
+
+    const char* p = data.constData();
+    switch (format) {
+    case SpectrumFormat::Float32:
+        return reinterpret_cast<const float*>(p)[bin];
+    case SpectrumFormat::Float16:
+        return float(reinterpret_cast<const qfloat16*>(p)[bin]);
+    case SpectrumFormat::UInt16:
+        return minDb + reinterpret_cast<const quint16*>(p)[bin] * ((maxDb - minDb) / 65535.0f);
+    case SpectrumFormat::UInt8:
+        return minDb + reinterpret_cast<const uchar*>(p)[bin] * ((maxDb - minDb) / 255.0f);
+    }
+    return minDb;
+}
@@ -0,0 +1,66 @@
+#ifndef COMPACT_SPECTRUM_H
+#define COMPACT_SPECTRUM_H
+
+#include <QByteArray>
+#include <QVector>
+#include <QtTypes>
+
+/**
+ * @brief Formato de almacenamiento de un espectro en dB
+ *
+ * Float16 conserva ~0.06 dB cerca de -100 dB; UInt16 cuantifica el rango
+ * [minDb, maxDb] en pasos de ~0.002 dB para 120 dB; UInt8 en pasos de
+ * ~0.5 dB, suficiente para visualizar (la paleta tiene 256 colores).
+ */
+enum class SpectrumFormat : quint8 {
+    Float32 = 0,
+    Float16 = 1,
+    UInt16  = 2,
+    UInt8   = 3
+};
+
+/**
+ * @brief Espectro en dB empaquetado en 1, 2 o 4 bytes por bin
+ *
+ * Los datos viajan en un QByteArray (compartido implícitamente), así que
+ * copiar un CompactSpectrum entre hilos o vistas no copia los bins.
+ */
+struct CompactSpectrum {
+    SpectrumFormat format = SpectrumFormat::Float32;
+    float minDb = -100.0f;        ///< dB del código 0 (formatos enteros)
+    float maxDb = 0.0f;           ///< dB del código máximo (formatos enteros)
+    int bins = 0;
+    QByteArray data;
+
+    bool isEmpty() const { return bins == 0; }
+
+    static int bytesPerBin(SpectrumFormat format);
+    static quint32 maxCode(SpectrumFormat format);
+
+    /** Empaqueta count valores en dB */
+    static CompactSpectrum encode(const float* db, int count, SpectrumFormat format,
+                                  float minDb, float maxDb);
+    static CompactSpectrum encode(const QVector<float>& db, SpectrumFormat format,
+                                  float minDb, float maxDb) {
+        return encode(db.constData(), db.size(), format, minDb, maxDb);
+    }
+
+    /** Reserva bins sin inicializar, para que un kernel escriba directamente */
+    static CompactSpectrum allocate(int count, SpectrumFormat format, float minDb, float maxDb);
+
+    /** Desempaqueta en out (bins valores) */
+    void decode(float* out) const;
+    QVector<float> toFloat() const;
+
+    /** Valor en dB de un bin */
+    float valueAt(int bin) const;
+
+    /** Código entero de un dB en [minDb, maxDb] (formatos enteros) */
+    static inline quint32 quantize(float db, float minDb, float scale, quint32 maxCode) {
+        const float q = (db - minDb) * scale + 0.5f;
+        if (!(q > 0.0f)) return 0;   // incluye NaN
+        return q >= float(maxCode) ? maxCode : quint32(q);
+    }
+};
+
+#endif // COMPACT_SPECTRUM_H
@@ -5,8 +5,15 @@
 #include "receivers/network_receiver.h"
 #include <QThread>
 #include <QMetaObject>
+#include <QMetaMethod>
+#include <QDeadlineTimer>
 #include "core/audio_db.h"
+#include "core/async_logger.h"
+#include "core/startup_profiler.h"
+#include "core/session_store_pool.h"
 #include <QDir>
+#include <QFile>
+#include <QFileInfo>
 #include <QUuid>
 #include <QCoreApplication>
 #include "views/waveform_render.h"
@@ -14,12 +21,32 @@
 
 Controller::Controller(QObject *parent)
     : QObject(parent)
+    , m_frameBus(new FrameBus(this))
+    , m_spectrumStore(new SpectrumStore(SpectrumStoreConfig(), this))
 {
+    // Reserva de sesiones en un hilo de baja prioridad: el arranque no espera
+    m_poolThread = new QThread(this);
+    m_poolThread->setObjectName("SessionStorePool");
+    m_sessionPool = new SessionStorePool(QCoreApplication::applicationDirPath() + "/tmp");
+    m_sessionPool->moveToThread(m_poolThread);
+    connect(m_poolThread, &QThread::finished, m_sessionPool, &QObject::deleteLater);
+    m_poolThread->start(QThread::LowPriority);
+    QMetaObject::invokeMethod(m_sessionPool, &SessionStorePool::replenish, Qt::QueuedConnection);
 }
 
 Controller::~Controller()
 {
     stopCapture();
+
+    // Acotar el cierre: una sesión atascada no debe bloquear la salida
+    if (!waitForRetiredSessions(3000)) {
+        qWarning() << "Controller: sesiones sin cerrar al destruir el controlador:"
+                   << retiringSessionCount();
+    }
+
+    // Los ficheros de reserva no usados se adoptan en la siguiente ejecución
+    m_poolThread->quit();
+    m_poolThread->wait();
 }
 
 void Controller::setAudioSource(AudioSource src)
@@ -104,8 +131,8 @@ void Controller::startCapture()
     // 2) Rotar/crear DB (no inicializar aquí)
     setupDatabase();  // esto aplicará la lógica m_rotateDbPerSession y emitirá databaseChanged(path)
 
-    // 3) Crear DSPWorker + mover DB al hilo DSP + initialize() en SU hilo
-    if (!createDspWorker()) {       // haz que devuelva bool: false si initialize() falla
+    // 3) Crear DSPWorker + mover DB al hilo DSP + initialize() encolado en SU hilo
+    if (!createDspWorker()) {
         cleanupReceiver();
         emit errorOccurred("No se pudo inicializar el DSP/DB");
         return;
@@ -126,7 +153,10 @@ void Controller::startCapture()
     connect(m_receiver, &IReceiver::finished,
             this, &Controller::finished, Qt::QueuedConnection);
 
-    // 6) Arrancar captura en el hilo del receiver
+    // 6) Planificación de los hilos antes de que llegue audio
+    applyThreadScheduling();
+
+    // 7) Arrancar captura en el hilo del receiver
     QMetaObject::invokeMethod(m_receiver, "start", Qt::QueuedConnection);
 
     m_capturing = true;
@@ -134,6 +164,65 @@ void Controller::startCapture()
 }
 
 
+void Controller::setCaptureThreadScheduling(const ThreadSchedulingConfig& cfg)
+{
+    m_captureScheduling = cfg;
+    if (m_capturing)
+        applyThreadScheduling();
+}
+
+void Controller::setDspThreadScheduling(const ThreadSchedulingConfig& cfg)
+{
+    m_dspScheduling = cfg;
+    if (m_capturing)
+        applyThreadScheduling();
+}
+
+void Controller::applyThreadScheduling()
+{
+    // DSP: el worker aplica la planificación y bloquea sus propios buffers
+    if (m_dspWorker) {
+        QMetaObject::invokeMethod(m_dspWorker, [w = m_dspWorker, cfg = m_dspScheduling]() {
+            w->applyScheduling(cfg);
+        }, Qt::QueuedConnection);
+    }
+
+    // Captura: se ejecuta en el hilo del receiver y vuelve con el informe
+    if (m_receiver) {
+        QPointer<Controller> self(this);
+        QMetaObject::invokeMethod(m_receiver, [self, cfg = m_captureScheduling]() {
+            const ThreadSchedulingReport report = ThreadTuning::applyToCurrentThread("capture", cfg);
+            if (self) {
+                QMetaObject::invokeMethod(self.data(), [self, report]() {
+                    if (self) self->onSchedulingReport(report);
+                }, Qt::QueuedConnection);
+            }
+        }, Qt::QueuedConnection);
+    }
+}
+
+void Controller::onSchedulingReport(const ThreadSchedulingReport& report)
+{
+    m_schedulingReports.insert(report.threadName, report);
+
+    if (!report.fallbacks.isEmpty()) {
+        TFT_WARNING(lcUi) << "Planificación degradada:" << report.toString();
+    } else {
+        TFT_INFO(lcUi) << "Planificación:" << report.toString();
+    }
+
+    emit threadSchedulingReported(report);
+}
+
+QString Controller::schedulingSummary() const
+{
+    QStringList lines;
+    for (const auto& report : m_schedulingReports) {
+        lines << report.toString();
+    }
+    return lines.join('\n');
+}
+
 void Controller::stopCapture()
 {
     if (!m_capturing)
@@ -143,12 +232,13 @@ void Controller::stopCapture()
     disconnect(m_receiver, &IReceiver::floatChunkReady,
                m_dspWorker, &DSPWorker::processChunk);
 
-    // 2) Limpiar DSPWorker
+    // 2) Retirar el DSPWorker: vacía su cola con plazo y cierra la DB en su hilo
     cleanupDspWorker();
 
-    // 3) Limpiar Receiver
+    // 3) Retirar el Receiver: se detiene en su hilo
     cleanupReceiver();
 
+    // Ninguna espera: una nueva captura puede arrancar ya con hilos y buffers nuevos
     m_capturing = false;
     emit capturingChanged(false);
 }
@@ -206,19 +296,63 @@ void Controller::cleanupReceiver()
     if (!m_receiver)
         return;
 
-    // Llamada bloqueante para asegurar que stop() finaliza
-    QMetaObject::invokeMethod(m_receiver, "stop", Qt::BlockingQueuedConnection);
-
     m_receiver->disconnect(this);
 
-    m_captureThread->quit();
-    m_captureThread->wait();
-    m_captureThread->deleteLater();
+    // stop() y quit() en el hilo del receiver; el receiver se borra al terminar el hilo
+    IReceiver* receiver = m_receiver;
+    QMetaObject::invokeMethod(receiver, [receiver]() {
+        receiver->stop();
+        QThread::currentThread()->quit();
+    }, Qt::QueuedConnection);
+
+    retireThread(m_captureThread);
 
     m_receiver = nullptr;
     m_captureThread = nullptr;
 }
 
+void Controller::retireThread(QThread* thread)
+{
+    if (!thread)
+        return;
+
+    // Sin padre: el Controller puede destruirse antes de que el hilo termine
+    thread->setParent(nullptr);
+    m_retiringThreads.append(thread);
+
+    connect(thread, &QThread::finished, this, [this, thread]() {
+        m_retiringThreads.removeAll(thread);
+        thread->deleteLater();
+    });
+}
+
+int Controller::retiringSessionCount() const
+{
+    int count = 0;
+    for (const auto& t : m_retiringThreads) {
+        if (t && !t->isFinished()) ++count;
+    }
+    return count;
+}
+
+bool Controller::waitForRetiredSessions(int timeoutMs)
+{
+    QDeadlineTimer deadline(timeoutMs);
+    bool allFinished = true;
+
+    const auto threads = m_retiringThreads;
+    for (const auto& t : threads) {
+        if (!t) continue;
+        if (t->wait(deadline)) {
+            m_retiringThreads.removeAll(t);
+            delete t.data();
+        } else {
+            allFinished = false;
+        }
+    }
+    return allFinished;
+}
+
 void Controller::setupDatabase()
 {
     if (m_rotateDbPerSession) {
@@ -227,7 +361,11 @@ void Controller::setupDatabase()
             m_db->deleteLater();
             m_db = nullptr;
         }
-        m_currentDbPath = makeRandomDbPath();
+        // Fichero precreado si la reserva tiene; si no, uno nuevo como antes
+        m_currentDbPath = m_sessionPool->acquire();
+        if (m_currentDbPath.isEmpty()) {
+            m_currentDbPath = makeRandomDbPath();
+        }
         m_db = new AudioDb(m_currentDbPath); // sin parent: la moveremos de hilo
         emit databaseChanged(m_currentDbPath);
 
@@ -259,7 +397,14 @@ bool Controller::createDspWorker()
     }
     m_db->moveToThread(m_dspThread);
 
-    m_dspWorker = new DSPWorker(m_dspConfig, m_db);
+    DSPConfig workerConfig = m_dspConfig;
+    // Con DB persistente todas las capturas comparten ruta: el .session de
+    // cada una truncaría el de la anterior, así que sólo se escribe por sesión
+    if (m_writeSessionFile && m_rotateDbPerSession) {
+        workerConfig.sessionFilePath = sessionFilePathFor(m_currentDbPath);
+    }
+
+    m_dspWorker = new DSPWorker(workerConfig, m_db);
     if (!m_dspWorker) {
         qCritical() << "Controller: No se pudo crear el DSPWorker";
         m_db->moveToThread(QCoreApplication::instance()->thread()); // devolver DB al hilo principal
@@ -270,98 +415,145 @@ bool Controller::createDspWorker()
     connect(m_dspThread, &QThread::finished, m_dspWorker, &QObject::deleteLater);
     connect(m_dspThread, &QThread::finished, m_db,        &QObject::deleteLater);
 
-    // señales DSP -> Controller
+    // frames DSP -> bus: una sola publicación por lote, en el hilo DSP
     connect(m_dspWorker, &DSPWorker::framesReady,
-            this, &Controller::onDspFramesReady, Qt::QueuedConnection);
-
+            m_frameBus, &FrameBus::publish, Qt::DirectConnection);
     connect(m_dspWorker, &DSPWorker::framesReady,
-            this, &Controller::framesReady, Qt::QueuedConnection);
+            m_spectrumStore, &SpectrumStore::append, Qt::DirectConnection);
+
+    // Re-emisión sólo si alguien escucha: evita encolar cada lote en el hilo GUI.
+    // connectNotify()/disconnectNotify() la ajustan si los oyentes cambian luego.
+    updateFramesRelay();
+
+    // Fin de la medición de arranque: primer lote de frames en el hilo GUI
+    if (!StartupProfiler::instance().isFinished()) {
+        connect(m_dspWorker, &DSPWorker::framesReady, this, []() {
+            StartupProfiler::instance().finish("first frame");
+        }, static_cast<Qt::ConnectionType>(Qt::QueuedConnection | Qt::SingleShotConnection));
+    }
 
     connect(m_dspWorker, &DSPWorker::statsUpdated, this, &Controller::statsUpdated, Qt::QueuedConnection);
+    connect(m_dspWorker, &DSPWorker::schedulingApplied, this, &Controller::onSchedulingReport, Qt::QueuedConnection);
     connect(m_dspWorker, &DSPWorker::errorOccurred,this, &Controller::errorOccurred,Qt::QueuedConnection);
 
+    connect(m_db, &AudioDb::errorOccurred, this, &Controller::errorOccurred, Qt::QueuedConnection);
+
     m_dspThread->start();
 
-    bool ok = false;
-    QMetaObject::invokeMethod(m_db, [&](){
-        ok = m_db->initialize();
-    }, Qt::BlockingQueuedConnection);
+    // initialize() (apertura + esquema) en el hilo DSP sin bloquear la GUI.
+    // Se encola antes que cualquier chunk, así que el primer bloque ya
+    // encuentra la DB abierta. Si falla, la captura se detiene en el hilo GUI.
+    QPointer<Controller> self(this);
+    QMetaObject::invokeMethod(m_db, [db = m_db, self, path = m_currentDbPath]() {
+        if (db->initialize())
+            return;
+        QMetaObject::invokeMethod(self.data(), [self, path]() {
+            if (self) self->onDatabaseOpenFailed(path);
+        }, Qt::QueuedConnection);
+    }, Qt::QueuedConnection);
 
-    if (!ok) {
-        qCritical() << "Controller: No se pudo abrir la base de datos";
-        m_dspThread->quit();
-        m_dspThread->wait();
-        m_dspThread->deleteLater();
-        m_dspThread = nullptr;
+    return true;
+}
 
-        m_dspWorker->deleteLater();
-        m_dspWorker = nullptr;
 
-        m_db->deleteLater();
-        m_db = nullptr;
-        return false;
+void Controller::updateFramesRelay()
+{
+    const bool wanted = m_dspWorker
+        && isSignalConnected(QMetaMethod::fromSignal(&Controller::framesReady));
+    if (wanted && !m_framesRelay) {
+        m_framesRelay = connect(m_dspWorker, &DSPWorker::framesReady,
+                                this, &Controller::framesReady, Qt::QueuedConnection);
+    } else if (!wanted && m_framesRelay) {
+        disconnect(m_framesRelay);
+        m_framesRelay = QMetaObject::Connection();
     }
-
-    return true;
 }
 
+void Controller::connectNotify(const QMetaMethod& signal)
+{
+    if (signal != QMetaMethod::fromSignal(&Controller::framesReady))
+        return;
+    // connect() puede llamarse desde otro hilo; el worker sólo se toca en el nuestro
+    if (QThread::currentThread() == thread())
+        updateFramesRelay();
+    else
+        QMetaObject::invokeMethod(this, &Controller::updateFramesRelay, Qt::QueuedConnection);
+}
 
-void Controller::cleanupDspWorker()
+void Controller::disconnectNotify(const QMetaMethod& signal)
 {
-    if (!m_dspWorker)
+    // signal inválido = disconnect() global
+    if (signal.isValid() && signal != QMetaMethod::fromSignal(&Controller::framesReady))
         return;
+    if (QThread::currentThread() == thread())
+        updateFramesRelay();
+    else
+        QMetaObject::invokeMethod(this, &Controller::updateFramesRelay, Qt::QueuedConnection);
+}
 
-    // Flush y reset bloqueante
-    QMetaObject::invokeMethod(m_dspWorker, "flushResidual", Qt::BlockingQueuedConnection);
-    QMetaObject::invokeMethod(m_dspWorker, "reset",         Qt::BlockingQueuedConnection);
+void Controller::onDatabaseOpenFailed(const QString& dbPath)
+{
+    // Sólo afecta a la captura que abrió esa DB
+    if (!m_capturing || dbPath != m_currentDbPath)
+        return;
 
-    // Cerrar conexión SQLite EN SU HILO
-    if (m_db) {
-        QMetaObject::invokeMethod(m_db, "shutdown", Qt::BlockingQueuedConnection);
-    }
+    qWarning() << "Controller: no se pudo abrir" << dbPath << "- captura detenida";
+    stopCapture();
+    emit errorOccurred(QString("No se pudo abrir la base de datos %1; captura detenida").arg(dbPath));
+}
 
-    m_dspWorker->disconnect(this);
+void Controller::cleanupDspWorker()
+{
+    if (!m_dspWorker)
+        return;
 
-    m_dspThread->quit();
-    m_dspThread->wait();
+    DSPWorker* worker = m_dspWorker;
+    QThread* thread = m_dspThread;
+    const QString dbPath = m_currentDbPath;
+
+    // Las vistas pasan a la sesión siguiente; el backlog sólo se guarda en DB
+    worker->disconnect(this);
+    m_framesRelay = QMetaObject::Connection();
+    worker->disconnect(m_frameBus);
+    worker->disconnect(m_spectrumStore);
+
+    // 1) Plazo de vaciado (thread-safe, sin esperar al hilo DSP)
+    worker->beginDrain(m_stopDeadlineMs);
+
+    // 2) Al finalizar: notificar y terminar el hilo. worker y DB se borran con
+    //    QThread::finished (conectado en createDspWorker)
+    m_retiringDbPaths.append(dbPath);
+    connect(worker, &DSPWorker::finalized, this,
+            [this, dbPath](qint64 blocks, qint64 samples, qint64) {
+                m_retiringDbPaths.removeOne(dbPath);
+                m_lastSessionPath = dbPath;
+                emit sessionFinalized(dbPath, blocks, samples);
+
+                // Borrado pedido mientras este escritor aún cerraba
+                if (m_pendingClear && !m_retiringDbPaths.contains(dbPath)) {
+                    m_pendingClear = false;
+                    clearSession();
+                }
+            }, Qt::QueuedConnection);
+    connect(worker, &DSPWorker::finalized, thread, &QThread::quit, Qt::DirectConnection);
+
+    // 3) finalize() se encola detrás del backlog pendiente
+    QMetaObject::invokeMethod(worker, &DSPWorker::finalize, Qt::QueuedConnection);
+
+    retireThread(thread);
 
-    // destruir objetos que viven en el hilo DSP
-    if (m_db)        { m_db->deleteLater();        m_db = nullptr; }
-    if (m_dspThread) { m_dspThread->deleteLater(); m_dspThread = nullptr; }
     m_dspWorker = nullptr;
+    m_dspThread = nullptr;
+    m_db = nullptr;   // la sesión anterior es dueña de su DB hasta cerrarla
 
     // limpiar estado de sesión y notificar a la UI
     m_currentDbPath.clear();
     emit databaseChanged(QString());
 }
 
-void Controller::onDspFramesReady(const QVector<FrameData>& frames)
-{
-    if (!m_waveView) return;
-    QVector<FrameData> copy = frames;
-
-    QMetaObject::invokeMethod(
-        m_waveView.data(),
-        [vw = m_waveView.data(), copy]() {
-            if (!vw) return;
-            vw->processFrames(copy);
-        },
-        Qt::QueuedConnection
-        );
-
-    if (m_specView) {
-        QVector<FrameData> copy2 = frames;
-        QMetaObject::invokeMethod(
-            m_specView.data(),
-            [specView = m_specView.data(), copy2]() {
-                if (specView) specView->processFrames(copy2);
-            },
-            Qt::QueuedConnection);
-    }
-}
-
 void Controller::clearWaveform()
 {
+    m_spectrumStore->clearPeaks();
     if (!m_waveView) return;
     QMetaObject::invokeMethod(
         m_waveView.data(),
@@ -410,9 +602,43 @@ void Controller::setWaveformConfig(const WaveformConfig& cfg)
 
 void Controller::setWaveformView(WaveformRenderer* view)
 {
+    if (m_waveView && m_waveView != view) {
+        m_waveView->attachStore(nullptr);
+    }
     m_waveView = view;
-    // (Opcional) conecta una señal para enviar frames sin invokeMethod manual:
-    // connect(this, &Controller::framesReady, m_waveView, &WaveformRenderer::processFrames, Qt::QueuedConnection);
+
+    // La forma de onda lee la pirámide de picos del almacén compartido
+    if (m_waveView) {
+        m_waveView->attachStore(m_spectrumStore);
+    }
+}
+
+void Controller::setSpectrogramView(SpectrogramRenderer* view)
+{
+    if (m_specView && m_specView != view) {
+        m_specView->attachStore(nullptr);
+    }
+    m_specView = view;
+
+    // Columnas del almacén compartido, pintadas en teselas comunes a todas las vistas
+    if (m_specView) {
+        m_specView->attachStore(m_spectrumStore, &m_tileCache);
+    }
+}
+
+void Controller::setSpectrumAnalyzerView(SpectrumAnalyzerView* view)
+{
+    if (m_analyzerView && m_analyzerView != view) {
+        m_analyzerView->attachFrameBus(nullptr, FrameSubscription());
+    }
+    m_analyzerView = view;
+
+    // Espectro completo de cada frame: la media y el peak-hold no deben saltarse ninguno
+    if (m_analyzerView) {
+        FrameSubscription sub;
+        sub.detail = FrameDetail::Full;
+        m_analyzerView->attachFrameBus(m_frameBus, sub);
+    }
 }
 
 bool Controller::currentPhysicalConfig(PhysicalInputConfig& out) const {
@@ -429,6 +655,7 @@ bool Controller::currentNetworkConfig(NetworkInputConfig& out) const {
 
 void Controller::clearSpectrogram()
 {
+    m_spectrumStore->clearSpectra();
     if (!m_specView) return;
     QMetaObject::invokeMethod(
         m_specView.data(),
@@ -451,6 +678,8 @@ void Controller::pauseSpectrogram(bool paused)
 
 void Controller::setSpectrogramConfig(const SpectrogramConfig& cfg)
 {
+    // Los espectros Float32 se cuantifican en el almacén con el rango de la vista
+    m_spectrumStore->setDbRange(cfg.minDb, cfg.maxDb);
     if (!m_specView) return;
     QMetaObject::invokeMethod(
         m_specView.data(),
@@ -474,6 +703,67 @@ QString Controller::makeRandomDbPath()
     return fullPath;
 }
 
+void Controller::clearSession()
+{
+    if (m_capturing) {
+        emit errorOccurred("Detén la captura antes de borrar la sesión");
+        emit sessionCleared(QString(), false);
+        return;
+    }
+    if (m_lastSessionPath.isEmpty()) {
+        emit sessionCleared(QString(), false);
+        return;
+    }
+
+    const QString path = m_lastSessionPath;
+    m_lastSessionPath.clear();
+
+    if (m_rotateDbPerSession) {
+        discardSession(path);
+    } else if (m_retiringDbPaths.contains(path)) {
+        // Otra sesión sobre la misma DB sigue escribiendo: se vacía al terminar
+        m_lastSessionPath = path;
+        m_pendingClear = true;
+    } else {
+        // DB persistente: se vacía en su sitio, sin VACUUM
+        QPointer<Controller> self(this);
+        QMetaObject::invokeMethod(m_sessionPool, [pool = m_sessionPool, self, path]() {
+            const bool ok = pool->clearStore(path);
+            // Un .session de cuando la DB rotaba describiría datos ya borrados
+            QFile::remove(sessionFilePathFor(path));
+            QMetaObject::invokeMethod(self.data(), [self, path, ok]() {
+                if (self) emit self->sessionCleared(path, ok);
+            }, Qt::QueuedConnection);
+        }, Qt::QueuedConnection);
+    }
+}
+
+void Controller::discardSession(const QString& dbPath)
+{
+    if (dbPath.isEmpty() || dbPath == m_currentDbPath) {
+        emit sessionCleared(dbPath, false);
+        return;
+    }
+
+    QPointer<Controller> self(this);
+    QMetaObject::invokeMethod(m_sessionPool, [pool = m_sessionPool, self, dbPath]() {
+        const bool ok = pool->reclaim(dbPath);
+        QFile::remove(sessionFilePathFor(dbPath));
+        QMetaObject::invokeMethod(self.data(), [self, dbPath, ok]() {
+            if (self) emit self->sessionCleared(dbPath, ok);
+        }, Qt::QueuedConnection);
+    }, Qt::QueuedConnection);
+}
+
+QString Controller::sessionFilePathFor(const QString& dbPath)
+{
+    if (dbPath.isEmpty())
+        return QString();
+
+    const QFileInfo info(dbPath);
+    return info.dir().filePath(info.completeBaseName() + ".session");
+}
+
 void Controller::setRotateDbPerSession(bool on) {
     m_rotateDbPerSession = on;
 }
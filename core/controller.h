@@ -7,9 +7,15 @@
 #include <QObject>
 #include "views/waveform_render.h"
 #include "views/spectrogram_renderer.h"
+#include "views/spectrum_analyzer_view.h"
+#include "core/frame_bus.h"
+#include "core/spectrum_store.h"
+#include "views/rendered_tile_cache.h"
 #include <QPointer>
+#include <QMap>
 
 class AudioDb;
+class SessionStorePool;
 class Controller : public QObject
 {
     Q_OBJECT
@@ -30,7 +36,41 @@ public:
     ~Controller() override;
 
     void setWaveformView(WaveformRenderer* view);
-    void setSpectrogramView(SpectrogramRenderer* v){ m_specView = v; }
+    void setSpectrogramView(SpectrogramRenderer* view);
+    void setSpectrumAnalyzerView(SpectrumAnalyzerView* view);
+
+    /** Planificación de los hilos de captura y DSP (al arrancar, o en caliente si se está capturando) */
+    void setCaptureThreadScheduling(const ThreadSchedulingConfig& cfg);
+    void setDspThreadScheduling(const ThreadSchedulingConfig& cfg);
+
+    /** Plazo para vaciar la cola DSP al parar; el resto se descarta */
+    void setStopDeadlineMs(int ms) { m_stopDeadlineMs = qMax(0, ms); }
+
+    /** Sesiones anteriores que aún se están cerrando en segundo plano */
+    int retiringSessionCount() const;
+
+    /**
+     * @brief Espera (acotada) a que terminen las sesiones en cierre
+     * @return true si terminaron todas dentro del plazo
+     */
+    bool waitForRetiredSessions(int timeoutMs);
+
+    /** Planificación efectiva de cada hilo, una línea por hilo */
+    QString schedulingSummary() const;
+
+    /** Bus por el que se difunden los frames DSP a las vistas y demás consumidores */
+    FrameBus* frameBus() const { return m_frameBus; }
+
+    /**
+     * @brief Datos del stream en vivo compartidos por las vistas
+     *
+     * Forma de onda y espectrograma leen de aquí en lugar de copiar cada
+     * lote; se pueden añadir más vistas con attachStore() sin coste por lote.
+     */
+    SpectrumStore* spectrumStore() const { return m_spectrumStore; }
+
+    /** Teselas de espectrograma ya pintadas, compartidas entre vistas (hilo GUI) */
+    RenderedTileCache* tileCache() { return &m_tileCache; }
 
     // getters
     AudioSource audioSource() const { return m_source; }
@@ -38,6 +78,25 @@ public:
     void setRotateDbPerSession(bool on);
     bool rotateDbPerSession() const { return m_rotateDbPerSession; }
 
+    /** Sesión en curso o, si no hay captura, la última cerrada */
+    QString currentSessionPath() const { return m_currentDbPath.isEmpty() ? m_lastSessionPath : m_currentDbPath; }
+
+    /** Última captura parada que aún vacía su cola y cierra sus ficheros (vacío si ninguna) */
+    QString finalizingSessionPath() const { return m_retiringDbPaths.isEmpty() ? QString() : m_retiringDbPaths.last(); }
+
+    /** Fichero de sesión columnar que acompaña a una DB (misma ruta, extensión .session) */
+    static QString sessionFilePathFor(const QString& dbPath);
+
+    /**
+     * Escribir también el fichero .session de cada captura (a partir de la
+     * siguiente). Sólo con una DB por sesión; en modo persistente no se escribe.
+     */
+    void setWriteSessionFile(bool on) { m_writeSessionFile = on; }
+    bool writeSessionFile() const { return m_writeSessionFile; }
+
+    /** Reserva de ficheros de sesión precreados (hilo propio) */
+    SessionStorePool* sessionPool() const { return m_sessionPool; }
+
 public slots:
     void setAudioSource(AudioSource src);
 
@@ -49,6 +108,12 @@ public slots:
     void startCapture();
     void stopCapture();
 
+    // sesiones
+    /** Descarta la última sesión cerrada (sin VACUUM, en segundo plano); el resultado llega en sessionCleared */
+    void clearSession();
+    /** Devuelve una sesión cerrada a la reserva para reciclarla o borrarla */
+    void discardSession(const QString& dbPath);
+
     // waveform render
     void clearWaveform();
     void pauseWaveform(bool paused);
@@ -61,9 +126,6 @@ public slots:
     void setSpectrogramConfig(const SpectrogramConfig& cfg);
 
 
-private slots:
-    void onDspFramesReady(const QVector<FrameData>& frames);
-
 signals:
     void audioSourceChanged(AudioSource);
     void capturingChanged(bool);
@@ -82,6 +144,19 @@ signals:
 
     void databaseChanged(const QString& path);
 
+    /** Resultado de clearSession()/discardSession(); dbPath vacío si no había nada que borrar */
+    void sessionCleared(const QString& dbPath, bool ok);
+
+    /** Una sesión anterior terminó de cerrarse (residual procesado y DB cerrada) */
+    void sessionFinalized(const QString& dbPath, qint64 blocksProcessed, qint64 samplesProcessed);
+
+    /** Planificación efectiva aplicada a un hilo del pipeline */
+    void threadSchedulingReported(const ThreadSchedulingReport& report);
+
+protected:
+    void connectNotify(const QMetaMethod& signal) override;
+    void disconnectNotify(const QMetaMethod& signal) override;
+
 private:
     AudioDb*   m_db        = nullptr;
 
@@ -104,15 +179,43 @@ private:
     // Control del DSPWorker
     bool createDspWorker();
     void cleanupDspWorker();
+    void onDatabaseOpenFailed(const QString& dbPath);
+
+    // Cierre asíncrono de sesiones
+    void retireThread(QThread* thread);
+    int m_stopDeadlineMs = 500;
+    QList<QPointer<QThread>> m_retiringThreads;
+    QStringList m_retiringDbPaths;     ///< DB de las sesiones que aún se cierran
+    bool m_pendingClear = false;       ///< clearSession() a la espera del cierre
+
+    // Planificación de hilos
+    void applyThreadScheduling();
+    void onSchedulingReport(const ThreadSchedulingReport& report);
+    ThreadSchedulingConfig m_captureScheduling;
+    ThreadSchedulingConfig m_dspScheduling;
+    QMap<QString, ThreadSchedulingReport> m_schedulingReports;
 
     DSPWorker*   m_dspWorker    = nullptr;
     DSPConfig    m_dspConfig;
 
+    // worker -> Controller::framesReady, sólo mientras haya oyentes
+    void updateFramesRelay();
+    QMetaObject::Connection m_framesRelay;
+
     bool    m_rotateDbPerSession = true;
+    bool    m_writeSessionFile = true;
     QString m_currentDbPath;
+    QString m_lastSessionPath;
+
+    SessionStorePool* m_sessionPool = nullptr;
+    QThread*          m_poolThread  = nullptr;
 
     QPointer<WaveformRenderer> m_waveView;
     QPointer<SpectrogramRenderer> m_specView;
+    QPointer<SpectrumAnalyzerView> m_analyzerView;
+    FrameBus* m_frameBus = nullptr;
+    SpectrumStore* m_spectrumStore = nullptr;
+    RenderedTileCache m_tileCache;
 
     bool currentPhysicalConfig(PhysicalInputConfig& out) const;
     bool currentNetworkConfig(NetworkInputConfig& out) const;
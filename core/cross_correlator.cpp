@@ -0,0 +1,146 @@
+#include "cross_correlator.h"
+#include "fft_plan_cache.h"
+#include <QDebug>
+#include <algorithm>
+#include <cmath>
+
+CrossCorrelator::CrossCorrelator(const CrossCorrelatorConfig& config)
+{
+    setConfig(config);
+}
+
+void CrossCorrelator::setConfig(const CrossCorrelatorConfig& config) {
+    m_config = config;
+
+    if (m_config.fftSize <= 0) {
+        qWarning() << "CrossCorrelator: fftSize inválido, usando 1024";
+        m_config.fftSize = 1024;
+    }
+    if (m_config.sampleRate <= 0) {
+        qWarning() << "CrossCorrelator: sampleRate inválido, usando 44100";
+        m_config.sampleRate = 44100;
+    }
+
+    // Lag máximo: limitado por la configuración y por la mitad de la FFT
+    const int halfN = m_config.fftSize / 2;
+    m_maxLag = halfN;
+    if (m_config.maxDelaySec > 0.0) {
+        m_maxLag = std::min(halfN, int(std::ceil(m_config.maxDelaySec * m_config.sampleRate)));
+    }
+
+    rebuildPairs();
+}
+
+QVector<QPair<int, int>> CrossCorrelator::allPairs(int channelCount) {
+    QVector<QPair<int, int>> out;
+    for (int a = 0; a < channelCount; ++a)
+        for (int b = a + 1; b < channelCount; ++b)
+            out.append(qMakePair(a, b));
+    return out;
+}
+
+void CrossCorrelator::rebuildPairs() {
+    const QVector<QPair<int, int>> requested =
+        m_config.pairs.isEmpty() ? allPairs(m_config.channelCount) : m_config.pairs;
+
+    m_pairs.clear();
+    for (const auto& p : requested) {
+        if (p.first < 0 || p.second < 0 ||
+            p.first >= m_config.channelCount || p.second >= m_config.channelCount ||
+            p.first == p.second) {
+            qWarning() << "CrossCorrelator: par inválido ignorado" << p.first << p.second;
+            continue;
+        }
+        m_pairs.append(p);
+    }
+
+    const int N = m_config.fftSize;
+    const int bins = N / 2 + 1;
+    m_cross.resize(m_pairs.size() * bins * 2);
+    m_correlation.resize(m_pairs.size() * N);
+}
+
+QVector<TdoaEstimate> CrossCorrelator::process(const QVector<ComplexSpectrum>& spectra) {
+    QVector<TdoaEstimate> out;
+    if (m_pairs.isEmpty())
+        return out;
+
+    const int N = m_config.fftSize;
+    const int bins = N / 2 + 1;
+
+    for (const auto& s : spectra) {
+        if (s.bins() != bins) {
+            qWarning() << "CrossCorrelator: espectro con" << s.bins()
+                       << "bins, se esperaban" << bins;
+            return out;
+        }
+    }
+
+    // 1) Espectros cruzados PHAT de todos los pares en un único buffer.
+    //    Entradas en formato separado y punteros sin alias para que el
+    //    compilador vectorice el producto complejo.
+    constexpr float eps = 1e-20f;
+    for (int p = 0; p < m_pairs.size(); ++p) {
+        const ComplexSpectrum& A = spectra[m_pairs[p].first];
+        const ComplexSpectrum& B = spectra[m_pairs[p].second];
+        const float* __restrict ar = A.re.constData();
+        const float* __restrict ai = A.im.constData();
+        const float* __restrict br = B.re.constData();
+        const float* __restrict bi = B.im.constData();
+        float* __restrict dst = m_cross.data() + size_t(p) * bins * 2;
+
+        for (int k = 0; k < bins; ++k) {
+            // conj(A) · B
+            const float re = ar[k] * br[k] + ai[k] * bi[k];
+            const float im = ar[k] * bi[k] - ai[k] * br[k];
+            const float inv = 1.0f / (std::sqrt(re * re + im * im) + eps);
+            dst[2 * k]     = re * inv;
+            dst[2 * k + 1] = im * inv;
+        }
+    }
+
+    // 2) IFFT por lotes: una ejecución para todos los pares
+    fftwf_plan plan = FftPlanCache::instance().c2rBatch(N, m_pairs.size());
+    if (!plan) {
+        qWarning() << "CrossCorrelator: no hay plan IFFT disponible";
+        return out;
+    }
+    fftwf_execute_dft_c2r(plan,
+                          reinterpret_cast<fftwf_complex*>(m_cross.data()),
+                          m_correlation.data());
+
+    // 3) Pico de cada correlación dentro de ±maxLag
+    out.reserve(m_pairs.size());
+    const float norm = 1.0f / N;
+    for (int p = 0; p < m_pairs.size(); ++p) {
+        const float* r = m_correlation.constData() + size_t(p) * N;
+        auto at = [&](int lag) { return r[(lag + N) % N]; };
+
+        int bestLag = 0;
+        float bestVal = at(0);
+        for (int lag = 1; lag <= m_maxLag; ++lag) {
+            if (at(lag) > bestVal)  { bestVal = at(lag);  bestLag = lag; }
+            if (at(-lag) > bestVal) { bestVal = at(-lag); bestLag = -lag; }
+        }
+
+        // Interpolación parabólica sub-muestra
+        float frac = 0.0f;
+        const float ym1 = at(bestLag - 1);
+        const float yp1 = at(bestLag + 1);
+        const float denom = ym1 - 2.0f * bestVal + yp1;
+        if (std::abs(denom) > 1e-12f) {
+            frac = 0.5f * (ym1 - yp1) / denom;
+            frac = std::clamp(frac, -0.5f, 0.5f);
+        }
+
+        TdoaEstimate est;
+        est.channelA = m_pairs[p].first;
+        est.channelB = m_pairs[p].second;
+        est.delaySamples = float(bestLag) + frac;
+        est.delaySeconds = est.delaySamples / float(m_config.sampleRate);
+        est.peak = std::clamp(bestVal * norm, 0.0f, 1.0f);
+        out.append(est);
+    }
+
+    return out;
+}
@@ -0,0 +1,60 @@
+#ifndef CROSS_CORRELATOR_H
+#define CROSS_CORRELATOR_H
+
+#include "core/analysis_types.h"
+#include <QVector>
+#include <QPair>
+#include <QtTypes>
+
+/**
+ * @brief Configuración del correlador cruzado GCC-PHAT
+ */
+struct CrossCorrelatorConfig {
+    int    fftSize = 1024;               ///< Debe coincidir con el de los espectros de entrada
+    int    sampleRate = 44100;           ///< Frecuencia de muestreo
+    int    channelCount = 2;             ///< Canales disponibles
+    QVector<QPair<int, int>> pairs;      ///< Pares a correlar (vacío = todos)
+    double maxDelaySec = 0.0;            ///< Retardo máximo buscado (0 = fftSize/2)
+};
+
+/**
+ * @brief Correlación cruzada generalizada con ponderación PHAT
+ *
+ * Reutiliza los espectros complejos por canal ya calculados para el
+ * espectrograma. Para cada hop calcula, para todos los pares pedidos,
+ * el espectro cruzado blanqueado conj(Xa)·Xb / |conj(Xa)·Xb| en un único
+ * buffer contiguo y aplica una IFFT por lotes con un solo plan. El pico
+ * de cada correlación se refina con interpolación parabólica.
+ */
+class CrossCorrelator
+{
+public:
+    explicit CrossCorrelator(const CrossCorrelatorConfig& config);
+
+    CrossCorrelatorConfig getConfig() const { return m_config; }
+    void setConfig(const CrossCorrelatorConfig& config);
+
+    /** Pares efectivamente correlados */
+    const QVector<QPair<int, int>>& pairs() const { return m_pairs; }
+
+    /**
+     * @brief Calcula el retardo de cada par a partir de los espectros
+     *        complejos de un hop (uno por canal)
+     */
+    QVector<TdoaEstimate> process(const QVector<ComplexSpectrum>& spectra);
+
+    /** Todos los pares (i, j) con i < j */
+    static QVector<QPair<int, int>> allPairs(int channelCount);
+
+private:
+    void rebuildPairs();
+
+    CrossCorrelatorConfig m_config;
+    QVector<QPair<int, int>> m_pairs;
+    int m_maxLag = 0;
+
+    QVector<float> m_cross;        ///< Espectros cruzados intercalados (pares × bins × 2)
+    QVector<float> m_correlation;  ///< Correlaciones en el tiempo (pares × fftSize)
+};
+
+#endif // CROSS_CORRELATOR_H
@@ -1,7 +1,16 @@
 #include "dsp_worker.h"
 #include "spectrogram_calculator.h"
+#include "cross_correlator.h"
+#include "transfer_function.h"
+#include "envelope_analyzer.h"
+#include "feature_extractor.h"
+#include "fingerprinter.h"
+#include "spectrogram_pyramid.h"
+#include "session_file.h"
+#include "async_logger.h"
 #include "audio_db.h"
 #include <QDateTime>
+#include <QDeadlineTimer>
 #include <QDebug>
 #include <algorithm>
 #include <cmath>
@@ -37,8 +46,19 @@ DSPWorker::DSPWorker(const DSPConfig& cfg, AudioDb* db, QObject* parent)
         m_cfg.hopSize = m_cfg.fftSize / 2;
     }
 
+    if (m_cfg.channelCount <= 0) {
+        qWarning() << "DSPWorker: channelCount inválido, usando 1";
+        m_cfg.channelCount = 1;
+    }
+
     // Inicializar calculador de espectrograma
     initializeSpectrogramCalculator();
+    initializeMultichannelStages();
+    initializeEnvelopeStage();
+    initializeFeatureExtractor();
+    initializeFingerprinter();
+    initializePyramid();
+    initializeSessionFile();
 
     qDebug() << "DSPWorker inicializado:"
              << "blockSize=" << m_cfg.blockSize
@@ -52,7 +72,15 @@ DSPWorker::~DSPWorker() {
     // Limpiar recursos
     m_accumBuffer.clear();
     m_hanningWindow.clear();
+    m_crossCorrelator.reset();
+    m_transferEstimator.reset();
+    m_envelopeAnalyzers.clear();
+    m_featureExtractor.reset();
+    m_fingerprinter.reset();
+    m_pyramid.reset();
+    m_sessionFile.reset();   // Escribe el índice si no se llamó a finalize()
     m_spectrogramCalc.reset();
+    unlockHotBuffers();
 }
 
 DSPConfig DSPWorker::getConfig() const {
@@ -68,15 +96,118 @@ void DSPWorker::setConfig(const DSPConfig& cfg) {
         cfg.kaiserBeta != m_cfg.kaiserBeta ||
         cfg.gaussianSigma != m_cfg.gaussianSigma ||
         cfg.logScale != m_cfg.logScale ||
+        cfg.noiseFloor != m_cfg.noiseFloor ||
+        cfg.spectrumFormat != m_cfg.spectrumFormat ||
+        cfg.spectrumMaxDb != m_cfg.spectrumMaxDb
+        );
+
+    bool needsMultichannelUpdate = (
+        cfg.fftSize != m_cfg.fftSize ||
+        cfg.sampleRate != m_cfg.sampleRate ||
+        cfg.channelCount != m_cfg.channelCount ||
+        cfg.enableTdoa != m_cfg.enableTdoa ||
+        cfg.tdoaPairs != m_cfg.tdoaPairs ||
+        cfg.tdoaMaxDelaySec != m_cfg.tdoaMaxDelaySec ||
+        cfg.enableTransferFunction != m_cfg.enableTransferFunction ||
+        cfg.tfReferenceChannel != m_cfg.tfReferenceChannel ||
+        cfg.tfResponseChannel != m_cfg.tfResponseChannel ||
+        cfg.tfAverages != m_cfg.tfAverages
+        );
+
+    bool needsEnvelopeUpdate = (
+        cfg.fftSize != m_cfg.fftSize ||
+        cfg.sampleRate != m_cfg.sampleRate ||
+        cfg.channelCount != m_cfg.channelCount ||
+        cfg.enableEnvelope != m_cfg.enableEnvelope ||
+        cfg.envBandLowHz != m_cfg.envBandLowHz ||
+        cfg.envBandHighHz != m_cfg.envBandHighHz ||
+        cfg.envSegmentSize != m_cfg.envSegmentSize ||
+        cfg.envDecimation != m_cfg.envDecimation ||
+        cfg.envSpectrumSize != m_cfg.envSpectrumSize ||
         cfg.noiseFloor != m_cfg.noiseFloor
         );
 
+    bool needsFeatureUpdate = (
+        cfg.fftSize != m_cfg.fftSize ||
+        cfg.sampleRate != m_cfg.sampleRate ||
+        cfg.enableFeatures != m_cfg.enableFeatures ||
+        cfg.melBands != m_cfg.melBands ||
+        cfg.mfccCount != m_cfg.mfccCount
+        );
+
+    bool needsFingerprintUpdate = (
+        cfg.fftSize != m_cfg.fftSize ||
+        cfg.sampleRate != m_cfg.sampleRate ||
+        cfg.blockSize != m_cfg.blockSize ||
+        cfg.channelCount != m_cfg.channelCount ||
+        cfg.windowType != m_cfg.windowType ||
+        cfg.kaiserBeta != m_cfg.kaiserBeta ||
+        cfg.gaussianSigma != m_cfg.gaussianSigma ||
+        cfg.enableFingerprint != m_cfg.enableFingerprint ||
+        cfg.fingerprintMinHz != m_cfg.fingerprintMinHz ||
+        cfg.fingerprintMaxHz != m_cfg.fingerprintMaxHz
+        );
+
+    bool needsPyramidUpdate = (
+        cfg.fftSize != m_cfg.fftSize ||
+        cfg.enablePyramid != m_cfg.enablePyramid ||
+        cfg.pyramidTileColumns != m_cfg.pyramidTileColumns ||
+        cfg.pyramidLevels != m_cfg.pyramidLevels ||
+        cfg.pyramidFreqDecimation != m_cfg.pyramidFreqDecimation ||
+        cfg.pyramidUseMax != m_cfg.pyramidUseMax ||
+        cfg.noiseFloor != m_cfg.noiseFloor ||
+        cfg.spectrumMaxDb != m_cfg.spectrumMaxDb
+        );
+
+    bool needsSessionFileUpdate = (
+        cfg.sessionFilePath != m_cfg.sessionFilePath ||
+        cfg.sessionChunkBlocks != m_cfg.sessionChunkBlocks
+        );
+
+    // Los buffers bloqueados se dimensionan con blockSize/canales
+    bool needsRelock = m_scheduling.lockMemory && (
+        cfg.blockSize != m_cfg.blockSize ||
+        cfg.channelCount != m_cfg.channelCount
+        );
+
     m_cfg = cfg;
+    if (m_cfg.channelCount <= 0) {
+        m_cfg.channelCount = 1;
+    }
 
     if (needsSpectrogramUpdate) {
         updateSpectrogramConfig();
     }
 
+    if (needsMultichannelUpdate) {
+        initializeMultichannelStages();
+    }
+
+    if (needsEnvelopeUpdate) {
+        initializeEnvelopeStage();
+    }
+
+    if (needsFeatureUpdate) {
+        initializeFeatureExtractor();
+    }
+
+    if (needsFingerprintUpdate) {
+        initializeFingerprinter();
+    }
+
+    if (needsPyramidUpdate) {
+        initializePyramid();
+    }
+
+    if (needsSessionFileUpdate) {
+        initializeSessionFile();
+    }
+
+    if (needsRelock) {
+        relockHotBuffers();
+        emit schedulingApplied(m_schedulingReport);
+    }
+
     // Limpiar ventana legacy si cambia el tamaño
     if (cfg.fftSize != m_cfg.fftSize) {
         m_windowCalculated = false;
@@ -128,7 +259,14 @@ QString DSPWorker::getSpectrogramInfo() const {
 }
 
 void DSPWorker::processChunk(const QVector<float>& samples, quint64 timestampNs) {
-    qDebug() << "processChunk: offsetNs recibido =" << timestampNs;
+    TFT_DEBUG(lcDsp) << "processChunk: offsetNs recibido =" << timestampNs;
+
+    // Vaciado con plazo vencido: descartar sin procesar
+    if (m_draining.load(std::memory_order_acquire) &&
+        QDeadlineTimer::current().deadline() > m_drainDeadline.load(std::memory_order_relaxed)) {
+        m_discardedChunks.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
 
     if (samples.isEmpty()) {
         emit errorOccurred("Chunk de muestras vacío");
@@ -142,7 +280,8 @@ void DSPWorker::processChunk(const QVector<float>& samples, quint64 timestampNs)
     // 1) Guardar el offset inicial si aún no lo hemos hecho
     if (m_startTimestampNs < 0) {
         m_startTimestampNs = timestampNs;
-        qDebug() << "DSPWorker: offset inicial establecido a" << m_startTimestampNs << "ns";
+        TFT_DEBUG(lcDsp) << "DSPWorker: offset inicial establecido a" << m_startTimestampNs << "ns";
+        openSessionFile();
     }
 
     // 2) Acumular muestras
@@ -167,7 +306,7 @@ void DSPWorker::processChunk(const QVector<float>& samples, quint64 timestampNs)
 
         // Debug: sólo los primeros 5 bloques
         if (m_blockIndex < 5) {
-            qDebug() << "Bloque" << m_blockIndex
+            TFT_DEBUG(lcDsp) << "Bloque" << m_blockIndex
                      << "- offsetStart:" << m_startTimestampNs
                      << "deltaNs:" << deltaNs
                      << "blockOffsetNs:" << blockTsNs;
@@ -179,6 +318,7 @@ void DSPWorker::processChunk(const QVector<float>& samples, quint64 timestampNs)
 
         // 4.4) Guardar en la base de datos usando este offset
         saveFrameToDb(frame, m_blockIndex);
+        saveFrameToSessionFile(frame, m_blockIndex);
 
         // 4.5) Actualizar contadores
         m_totalSamples += m_cfg.blockSize;
@@ -227,6 +367,7 @@ void DSPWorker::flushResidual() {
 
         // Guardamos en la base de datos
         saveFrameToDb(frame, m_blockIndex);
+        saveFrameToSessionFile(frame, m_blockIndex);
 
         // Emitimos como batch de un solo frame
         QVector<FrameData> batch;
@@ -258,9 +399,127 @@ void DSPWorker::reset() {
     // Reinicializar calculador de espectrograma
     initializeSpectrogramCalculator();
 
+    // Descartar promedios de la sesión anterior
+    if (m_transferEstimator) {
+        m_transferEstimator->reset();
+    }
+    for (auto& analyzer : m_envelopeAnalyzers) {
+        analyzer->reset();
+    }
+    m_lastEnvelope = EnvelopeSpectrum();
+    if (m_fingerprinter) {
+        m_fingerprinter->reset();
+    }
+    if (m_pyramid) {
+        m_pyramid->reset();
+        m_pyramidIndicesSynced = false;
+    }
+
+    // Cierra el fichero actual; el siguiente chunk lo vuelve a empezar
+    initializeSessionFile();
+
     emit statsUpdated(0, 0, 0);
 }
 
+void DSPWorker::beginDrain(int deadlineMs) {
+    m_drainDeadline.store(QDeadlineTimer(qMax(0, deadlineMs)).deadline(), std::memory_order_relaxed);
+    m_draining.store(true, std::memory_order_release);
+}
+
+void DSPWorker::finalize() {
+    flushResidual();
+
+    // Teselas parciales: el final de la sesión también debe poder verse
+    const QVector<SpectrogramTile> pendingTiles =
+        m_pyramid ? m_pyramid->pendingTiles() : QVector<SpectrogramTile>();
+
+    if (m_db) {
+        for (const SpectrogramTile& tile : pendingTiles) {
+            m_db->insertTile(tile);
+        }
+        m_db->shutdown();
+    }
+
+    if (m_sessionFile) {
+        for (const SpectrogramTile& tile : pendingTiles) {
+            m_sessionFile->appendTile(tile);
+        }
+        // Índice + pie: a partir de aquí se abre sin recorrer los chunks
+        if (m_sessionFile->isOpen() && !m_sessionFile->close()) {
+            emit errorOccurred(QString("Error cerrando el fichero de sesión: %1")
+                                   .arg(m_sessionFile->errorString()));
+        }
+        m_sessionFile.reset();
+    }
+
+    const qint64 discarded = m_discardedChunks.load();
+    if (discarded > 0) {
+        qWarning() << "DSPWorker: plazo de vaciado vencido," << discarded << "chunks descartados";
+    }
+
+    emit finalized(m_blockIndex, m_totalSamples, discarded);
+}
+
+void DSPWorker::applyScheduling(const ThreadSchedulingConfig& config) {
+    ThreadSchedulingReport report = ThreadTuning::applyToCurrentThread("dsp", config);
+    m_scheduling = config;
+    m_schedulingReport = report;
+
+    unlockHotBuffers();
+    if (config.lockMemory) {
+        relockHotBuffers();
+    }
+
+    emit schedulingApplied(m_schedulingReport);
+}
+
+void DSPWorker::relockHotBuffers() {
+    unlockHotBuffers();
+
+    QStringList lockErrors;
+    m_schedulingReport.lockedBytes = lockHotBuffers(lockErrors);
+
+    // Los fallbacks de planificación se conservan; los de mlock se sustituyen
+    m_schedulingReport.fallbacks.removeIf([](const QString& f) {
+        return f.startsWith(QLatin1String("mlock"));
+    });
+    m_schedulingReport.fallbacks << lockErrors;
+}
+
+qint64 DSPWorker::lockHotBuffers(QStringList& errors) {
+    // Capacidad fija: mientras no se supere, los buffers no se realojan
+    const int channels = qMax(1, m_cfg.channelCount);
+    m_accumBuffer.reserve(m_cfg.blockSize * 8);
+    m_channelBuffers.resize(channels);
+    for (auto& buf : m_channelBuffers) {
+        buf.reserve(m_cfg.blockSize / channels + 1);
+    }
+
+    auto lock = [&](const void* ptr, size_t bytes) -> qint64 {
+        QString error;
+        if (!ThreadTuning::lockMemory(ptr, bytes, &error)) {
+            errors << QString("mlock rechazado (%1)").arg(error);
+            return 0;
+        }
+        m_lockedRegions.append(qMakePair(ptr, bytes));
+        return qint64(bytes);
+    };
+
+    // Se intenta cada región: un buffer rechazado no impide bloquear el resto
+    qint64 locked = lock(m_accumBuffer.constData(), size_t(m_accumBuffer.capacity()) * sizeof(float));
+    for (const auto& buf : std::as_const(m_channelBuffers)) {
+        locked += lock(buf.constData(), size_t(buf.capacity()) * sizeof(float));
+    }
+    return locked;
+}
+
+void DSPWorker::unlockHotBuffers() {
+    for (const auto& region : std::as_const(m_lockedRegions)) {
+        ThreadTuning::unlockMemory(region.first, region.second);
+    }
+    m_lockedRegions.clear();
+}
+
 FrameData DSPWorker::processBlock(const QVector<float>& block,
                                   quint64 timestamp,
                                   qint64 sampleOffset) {
@@ -284,18 +543,51 @@ FrameData DSPWorker::processBlock(const QVector<float>& block,
                 int idx = qMin(N - 1, (i * N) / W);
                 frame.waveform[i] = block[idx];
             }
+
+            // Extremos y RMS exactos del bloque completo (la decimación puede saltarse picos)
+            const auto [lo, hi] = std::minmax_element(block.cbegin(), block.cend());
+            double energy = 0.0;
+            for (float v : block) energy += double(v) * v;
+            frame.peakMin = *lo;
+            frame.peakMax = *hi;
+            frame.peakRms = float(std::sqrt(energy / N));
         } else {
             // Si no necesitamos peaks, guardamos solo la primera muestra
             frame.waveform.resize(1);
             frame.waveform[0] = block[0];
         }
 
+        // --- Separar canales una sola vez para todas las etapas ---
+        if (m_cfg.channelCount > 1) {
+            deinterleaveChannels(block);
+        }
+
         // --- Espectrograma usando SpectrogramCalculator ---
         if (m_cfg.enableSpectrum && m_spectrogramCalc) {
-            auto spectrogramFrame = m_spectrogramCalc->calculateFrame(block, timestamp, sampleOffset);
-            frame.spectrum = spectrogramFrame.magnitudes;
-            frame.frequencies = spectrogramFrame.frequencies;
-            frame.windowGain = spectrogramFrame.windowGain;
+            computeChannelSpectra(block, timestamp, sampleOffset, frame);
+
+            // --- TDOA entre canales sobre las FFT ya calculadas ---
+            if (m_crossCorrelator) {
+                frame.tdoa = m_crossCorrelator->process(m_channelSpectra);
+            }
+
+            // --- Función de transferencia / coherencia (promedio incremental) ---
+            if (m_transferEstimator) {
+                frame.transfer = m_transferEstimator->process(m_channelSpectra);
+            }
+
+            // --- Descriptores del canal 0 sobre la FFT ya calculada ---
+            if (m_featureExtractor) {
+                const QVector<float>& timeSamples = (m_cfg.channelCount > 1) ? m_channelBuffers[0] : block;
+                frame.features = m_featureExtractor->process(m_channelSpectra[0],
+                                                             timeSamples.constData(),
+                                                             timeSamples.size());
+            }
+
+            // --- Huella: pares de picos del canal 0, indexados por bloque ---
+            if (m_fingerprinter) {
+                frame.fingerprints = m_fingerprinter->process(m_channelSpectra[0], m_blockIndex);
+            }
         } else if (m_cfg.enableSpectrum) {
             // Fallback al método legacy
             frame.spectrum = calculateSpectrum(block);
@@ -303,6 +595,20 @@ FrameData DSPWorker::processBlock(const QVector<float>& block,
             frame.windowGain = 1.0f;
         }
 
+        // --- Envolvente (streaming, todas las muestras del bloque) ---
+        if (!m_envelopeAnalyzers.empty()) {
+            processEnvelope(block, frame);
+        }
+
+        // Pirámide con la magnitud del bloque, antes de sustituirla por la vista elegida
+        if (m_pyramid) {
+            updatePyramid(frame);
+        }
+
+        if (m_cfg.enableSpectrum && m_spectrogramCalc) {
+            applySpectrumView(frame);
+        }
+
         // --- Guardar bloque raw en la base de datos ---
         if (m_db) {
             QByteArray blob(reinterpret_cast<const char*>(block.constData()),
@@ -313,6 +619,12 @@ FrameData DSPWorker::processBlock(const QVector<float>& block,
                               frame.timestamp);
         }
 
+        // --- Y en el fichero de sesión (sin copia intermedia) ---
+        if (m_sessionFile && m_sessionFile->isOpen()) {
+            m_sessionFile->appendRawBlock(m_blockIndex, frame.sampleOffset, qint64(frame.timestamp),
+                                          block.constData(), block.size());
+        }
+
     } catch (const std::exception& e) {
         emit errorOccurred(QString("Error procesando bloque: %1").arg(e.what()));
     }
@@ -332,7 +644,30 @@ void DSPWorker::saveFrameToDb(const FrameData& frame, qint64 blockIndex) {
 
         // Guardar picos si están habilitados
         if (m_cfg.enablePeaks && frame.waveform.size() >= 2) {
-            m_db->insertPeak(blockIndex, frame.sampleOffset, frame.waveform[0], frame.waveform[1], frame.timestamp);
+            m_db->insertPeak(blockIndex, frame.sampleOffset, frame.peakMin, frame.peakMax, frame.peakRms,
+                             frame.timestamp);
+            m_db->updateRollups(frame.timestamp, frame.peakMin, frame.peakMax, frame.peakRms);
+        }
+
+        // Guardar descriptores si se calcularon
+        if (!frame.features.isEmpty()) {
+            m_db->insertFeatures(blockIndex, frame.timestamp, frame.features);
+        }
+
+        // Espectro del bloque en su formato (compacto o float32)
+        if (m_cfg.storeSpectrum) {
+            if (!frame.compactSpectrum.isEmpty()) {
+                m_db->insertSpectrum(blockIndex, frame.timestamp, frame.compactSpectrum);
+            } else if (!frame.spectrum.isEmpty()) {
+                m_db->insertSpectrum(blockIndex, frame.timestamp,
+                                     CompactSpectrum::encode(frame.spectrum, SpectrumFormat::Float32,
+                                                             m_cfg.noiseFloor, m_cfg.spectrumMaxDb));
+            }
+        }
+
+        // Actualizar el índice de huellas de forma incremental
+        if (!frame.fingerprints.isEmpty()) {
+            m_db->insertFingerprints(frame.fingerprints);
         }
 
         // Nota: El bloque raw ya se guardó en processBlock()
@@ -343,6 +678,31 @@ void DSPWorker::saveFrameToDb(const FrameData& frame, qint64 blockIndex) {
     }
 }
 
+void DSPWorker::saveFrameToSessionFile(const FrameData& frame, qint64 blockIndex) {
+    if (!m_sessionFile || !m_sessionFile->isOpen()) return;
+
+    if (m_cfg.enablePeaks && frame.waveform.size() >= 2) {
+        SessionPeak peak;
+        peak.blockIndex = blockIndex;
+        peak.sampleOffset = frame.sampleOffset;
+        peak.timestampNs = qint64(frame.timestamp);
+        peak.minValue = frame.peakMin;
+        peak.maxValue = frame.peakMax;
+        peak.rmsValue = frame.peakRms;
+        m_sessionFile->appendPeak(peak);
+    }
+
+    if (m_cfg.storeSpectrum) {
+        if (!frame.compactSpectrum.isEmpty()) {
+            m_sessionFile->appendSpectrum(blockIndex, qint64(frame.timestamp), frame.compactSpectrum);
+        } else if (!frame.spectrum.isEmpty()) {
+            m_sessionFile->appendSpectrum(blockIndex, qint64(frame.timestamp),
+                                          CompactSpectrum::encode(frame.spectrum, SpectrumFormat::Float32,
+                                                                  m_cfg.noiseFloor, m_cfg.spectrumMaxDb));
+        }
+    }
+}
+
 quint64 DSPWorker::validateTimestamp(quint64 timestampNs) {
     // Verificar si el timestamp es válido
     if (timestampNs == 0 || timestampNs == static_cast<quint64>(-1)) {
@@ -379,6 +739,8 @@ void DSPWorker::initializeSpectrogramCalculator() {
         spectrogramConfig.gaussianSigma = m_cfg.gaussianSigma;
         spectrogramConfig.logScale = m_cfg.logScale;
         spectrogramConfig.noiseFloor = m_cfg.noiseFloor;
+        spectrogramConfig.outputFormat = static_cast<SpectrumFormat>(m_cfg.spectrumFormat);
+        spectrogramConfig.maxDb = m_cfg.spectrumMaxDb;
 
         m_spectrogramCalc = std::make_unique<SpectrogramCalculator>(spectrogramConfig, this);
 
@@ -409,6 +771,8 @@ void DSPWorker::updateSpectrogramConfig() {
         spectrogramConfig.gaussianSigma = m_cfg.gaussianSigma;
         spectrogramConfig.logScale = m_cfg.logScale;
         spectrogramConfig.noiseFloor = m_cfg.noiseFloor;
+        spectrogramConfig.outputFormat = static_cast<SpectrumFormat>(m_cfg.spectrumFormat);
+        spectrogramConfig.maxDb = m_cfg.spectrumMaxDb;
 
         m_spectrogramCalc->setConfig(spectrogramConfig);
 
@@ -419,6 +783,349 @@ void DSPWorker::updateSpectrogramConfig() {
     }
 }
 
+void DSPWorker::deinterleaveChannels(const QVector<float>& block) {
+    const int channels = qMax(1, m_cfg.channelCount);
+    const int framesPerChannel = block.size() / channels;
+    if (m_channelBuffers.size() != channels) {
+        m_channelBuffers.resize(channels);
+    }
+    for (auto& buf : m_channelBuffers) {
+        buf.resize(framesPerChannel);
+    }
+
+    const float* src = block.constData();
+    for (int c = 0; c < channels; ++c) {
+        float* dst = m_channelBuffers[c].data();
+        for (int i = 0; i < framesPerChannel; ++i) {
+            dst[i] = src[i * channels + c];
+        }
+    }
+}
+
+void DSPWorker::computeChannelSpectra(const QVector<float>& block,
+                                      quint64 timestampNs,
+                                      qint64 sampleOffset,
+                                      FrameData& frame) {
+    const int channels = qMax(1, m_cfg.channelCount);
+    if (m_channelSpectra.size() != channels) {
+        m_channelSpectra.resize(channels);
+    }
+
+    // Mono: el bloque se analiza tal cual
+    if (channels == 1) {
+        auto spectrogramFrame = m_spectrogramCalc->calculateFrame(block, timestampNs, sampleOffset,
+                                                                  &m_channelSpectra[0]);
+        frame.spectrum = spectrogramFrame.magnitudes;
+        frame.compactSpectrum = spectrogramFrame.compact;
+        frame.frequencies = spectrogramFrame.frequencies;
+        frame.windowGain = spectrogramFrame.windowGain;
+        return;
+    }
+
+    // Multicanal: una FFT por canal sobre los buffers ya desintercalados
+    for (int c = 0; c < channels; ++c) {
+        auto spectrogramFrame = m_spectrogramCalc->calculateFrame(m_channelBuffers[c], timestampNs,
+                                                                  sampleOffset, &m_channelSpectra[c]);
+        // El espectro visible es el del canal de referencia (0)
+        if (c == 0) {
+            frame.spectrum = spectrogramFrame.magnitudes;
+            frame.compactSpectrum = spectrogramFrame.compact;
+            frame.frequencies = spectrogramFrame.frequencies;
+            frame.windowGain = spectrogramFrame.windowGain;
+        }
+    }
+}
+
+void DSPWorker::initializeMultichannelStages() {
+    m_crossCorrelator.reset();
+    m_transferEstimator.reset();
+    m_channelSpectra.clear();
+    // m_channelBuffers se conserva: puede estar bloqueado con mlock y
+    // deinterleave() lo redimensiona cuando cambia el número de canales
+
+    const bool wantsMultichannel = m_cfg.enableTdoa || m_cfg.enableTransferFunction;
+    if (wantsMultichannel && m_cfg.channelCount < 2) {
+        qWarning() << "DSPWorker: TDOA/función de transferencia requieren channelCount >= 2,"
+                   << "etapas deshabilitadas";
+        return;
+    }
+
+    if (m_cfg.enableTdoa) {
+        CrossCorrelatorConfig ccConfig;
+        ccConfig.fftSize = m_cfg.fftSize;
+        ccConfig.sampleRate = m_cfg.sampleRate;
+        ccConfig.channelCount = m_cfg.channelCount;
+        ccConfig.pairs = m_cfg.tdoaPairs;
+        ccConfig.maxDelaySec = m_cfg.tdoaMaxDelaySec;
+
+        m_crossCorrelator = std::make_unique<CrossCorrelator>(ccConfig);
+
+        qDebug() << "CrossCorrelator inicializado:"
+                 << m_crossCorrelator->pairs().size() << "pares,"
+                 << "canales=" << m_cfg.channelCount;
+    }
+
+    if (m_cfg.enableTransferFunction) {
+        if (m_cfg.tfReferenceChannel < 0 || m_cfg.tfReferenceChannel >= m_cfg.channelCount ||
+            m_cfg.tfResponseChannel < 0 || m_cfg.tfResponseChannel >= m_cfg.channelCount ||
+            m_cfg.tfReferenceChannel == m_cfg.tfResponseChannel) {
+            qWarning() << "DSPWorker: canales de función de transferencia inválidos"
+                       << m_cfg.tfReferenceChannel << m_cfg.tfResponseChannel;
+        } else {
+            TransferFunctionConfig tfConfig;
+            tfConfig.fftSize = m_cfg.fftSize;
+            tfConfig.referenceChannel = m_cfg.tfReferenceChannel;
+            tfConfig.responseChannel = m_cfg.tfResponseChannel;
+            tfConfig.averages = m_cfg.tfAverages;
+            tfConfig.floorDb = m_cfg.noiseFloor;
+
+            m_transferEstimator = std::make_unique<TransferFunctionEstimator>(tfConfig);
+
+            qDebug() << "TransferFunctionEstimator inicializado:"
+                     << "ref=" << tfConfig.referenceChannel
+                     << "resp=" << tfConfig.responseChannel
+                     << "promedios=" << tfConfig.averages;
+        }
+    }
+}
+
+void DSPWorker::initializeEnvelopeStage() {
+    m_envelopeAnalyzers.clear();
+    m_lastEnvelope = EnvelopeSpectrum();
+
+    if (!m_cfg.enableEnvelope) {
+        return;
+    }
+
+    EnvelopeConfig envConfig;
+    envConfig.sampleRate = m_cfg.sampleRate;
+    envConfig.bandLowHz = m_cfg.envBandLowHz;
+    envConfig.bandHighHz = m_cfg.envBandHighHz;
+    envConfig.segmentSize = m_cfg.envSegmentSize;
+    envConfig.decimation = m_cfg.envDecimation;
+    // Mismo número de bins que el espectrograma para poder mostrarlo (spectrumView = 4)
+    envConfig.spectrumSize = m_cfg.envSpectrumSize > 0 ? m_cfg.envSpectrumSize : m_cfg.fftSize;
+    envConfig.floorDb = m_cfg.noiseFloor;
+
+    const int channels = qMax(1, m_cfg.channelCount);
+    m_envelopeAnalyzers.reserve(channels);
+    for (int c = 0; c < channels; ++c) {
+        m_envelopeAnalyzers.push_back(std::make_unique<EnvelopeAnalyzer>(envConfig, c));
+    }
+
+    const EnvelopeAnalyzer& first = *m_envelopeAnalyzers.front();
+    qDebug() << "EnvelopeAnalyzer inicializado:"
+             << "banda=" << first.getConfig().bandLowHz << "-" << first.getConfig().bandHighHz << "Hz"
+             << "decimación=" << first.decimation()
+             << "canales=" << channels;
+}
+
+void DSPWorker::initializeFeatureExtractor() {
+    m_featureExtractor.reset();
+
+    if (!m_cfg.enableFeatures) {
+        return;
+    }
+
+    FeatureConfig featureConfig;
+    featureConfig.fftSize = m_cfg.fftSize;
+    featureConfig.sampleRate = m_cfg.sampleRate;
+    featureConfig.melBands = m_cfg.melBands;
+    featureConfig.mfccCount = m_cfg.mfccCount;
+
+    m_featureExtractor = std::make_unique<FeatureExtractor>(featureConfig);
+
+    qDebug() << "FeatureExtractor inicializado:"
+             << "bandas mel=" << m_featureExtractor->getConfig().melBands
+             << "mfcc=" << m_featureExtractor->getConfig().mfccCount;
+}
+
+void DSPWorker::initializeFingerprinter() {
+    m_fingerprinter.reset();
+
+    if (!m_cfg.enableFingerprint) {
+        return;
+    }
+
+    FingerprintConfig fpConfig;
+    fpConfig.fftSize = m_cfg.fftSize;
+    fpConfig.sampleRate = m_cfg.sampleRate;
+    // Un espectro por bloque: las consultas deben usar el mismo hop
+    fpConfig.hopSize = m_cfg.blockSize / qMax(1, m_cfg.channelCount);
+    fpConfig.windowType = m_cfg.windowType;
+    fpConfig.kaiserBeta = m_cfg.kaiserBeta;
+    fpConfig.gaussianSigma = m_cfg.gaussianSigma;
+    fpConfig.minFreqHz = m_cfg.fingerprintMinHz;
+    fpConfig.maxFreqHz = m_cfg.fingerprintMaxHz;
+
+    m_fingerprinter = std::make_unique<Fingerprinter>(fpConfig);
+
+    qDebug() << "Fingerprinter inicializado:"
+             << "banda=" << fpConfig.minFreqHz << "-" << fpConfig.maxFreqHz << "Hz"
+             << "hop=" << fpConfig.hopSize;
+}
+
+void DSPWorker::initializePyramid() {
+    m_pyramid.reset();
+    m_pyramidColumn.clear();
+    m_pyramidIndicesSynced = false;
+
+    if (!m_cfg.enablePyramid) {
+        return;
+    }
+
+    PyramidConfig pyramidConfig;
+    pyramidConfig.bins = m_cfg.fftSize / 2 + 1;
+    pyramidConfig.tileColumns = m_cfg.pyramidTileColumns;
+    pyramidConfig.levels = m_cfg.pyramidLevels;
+    pyramidConfig.freqDecimation = m_cfg.pyramidFreqDecimation;
+    pyramidConfig.useMax = m_cfg.pyramidUseMax;
+    pyramidConfig.minDb = m_cfg.noiseFloor;
+    pyramidConfig.maxDb = m_cfg.spectrumMaxDb;
+
+    m_pyramid = std::make_unique<SpectrogramPyramid>(pyramidConfig);
+
+    qDebug() << "SpectrogramPyramid inicializada:"
+             << "niveles=" << m_pyramid->config().levels
+             << "columnas/tesela=" << m_pyramid->config().tileColumns
+             << "bins=" << m_pyramid->outputBins();
+}
+
+void DSPWorker::updatePyramid(const FrameData& frame) {
+    const float* column = nullptr;
+    int bins = 0;
+
+    if (!frame.compactSpectrum.isEmpty()) {
+        m_pyramidColumn.resize(frame.compactSpectrum.bins);
+        frame.compactSpectrum.decode(m_pyramidColumn.data());
+        column = m_pyramidColumn.constData();
+        bins = m_pyramidColumn.size();
+    } else if (!frame.spectrum.isEmpty()) {
+        column = frame.spectrum.constData();
+        bins = frame.spectrum.size();
+    }
+
+    if (!column) {
+        return;
+    }
+
+    // Una DB que ya tiene teselas (persistente, o tras setConfig/reset) se
+    // continúa: los índices nuevos empiezan tras los guardados
+    if (!m_pyramidIndicesSynced && m_db && m_db->isInitialized()) {
+        m_pyramid->continueTileIndices(m_db->nextTileIndices(m_pyramid->config().levels));
+        m_pyramidIndicesSynced = true;
+    }
+
+    const QVector<SpectrogramTile> completed =
+        m_pyramid->append(column, bins, qint64(frame.timestamp));
+    for (const SpectrogramTile& tile : completed) {
+        if (m_db) {
+            m_db->insertTile(tile);
+        }
+        if (m_sessionFile) {
+            m_sessionFile->appendTile(tile);
+        }
+    }
+}
+
+void DSPWorker::initializeSessionFile() {
+    m_sessionFile.reset();
+
+    if (m_cfg.sessionFilePath.isEmpty()) {
+        return;
+    }
+
+    m_sessionFile = std::make_unique<SessionFileWriter>(m_cfg.sessionChunkBlocks);
+
+    // Cambio de configuración a mitad de sesión: se abre ya
+    if (m_startTimestampNs >= 0) {
+        openSessionFile();
+    }
+}
+
+void DSPWorker::openSessionFile() {
+    if (!m_sessionFile || m_sessionFile->isOpen()) {
+        return;
+    }
+
+    SessionFileHeader header;
+    header.sampleRate = m_cfg.sampleRate;
+    header.channels = m_cfg.channelCount;
+    header.blockSize = m_cfg.blockSize;
+    header.startTimestampNs = m_startTimestampNs;
+
+    if (!m_sessionFile->open(m_cfg.sessionFilePath, header)) {
+        emit errorOccurred(QString("No se pudo crear el fichero de sesión: %1")
+                               .arg(m_sessionFile->errorString()));
+        m_sessionFile.reset();
+        return;
+    }
+
+    qDebug() << "DSPWorker: fichero de sesión" << m_cfg.sessionFilePath
+             << "chunk=" << m_cfg.sessionChunkBlocks << "bloques";
+}
+
+void DSPWorker::processEnvelope(const QVector<float>& block, FrameData& frame) {
+    const int channels = int(m_envelopeAnalyzers.size());
+
+    for (int c = 0; c < channels; ++c) {
+        const float* samples = (channels == 1) ? block.constData() : m_channelBuffers[c].constData();
+        const int count = (channels == 1) ? block.size() : m_channelBuffers[c].size();
+
+        EnvelopeSpectrum spectrum;
+        if (m_envelopeAnalyzers[c]->process(samples, count, &spectrum)) {
+            if (c == 0) {
+                m_lastEnvelope = spectrum;
+            }
+            frame.envelope.append(std::move(spectrum));
+        }
+    }
+}
+
+void DSPWorker::applySpectrumView(FrameData& frame) const {
+    const TransferFunctionFrame& tf = frame.transfer;
+
+    switch (m_cfg.spectrumView) {
+    case 1:
+        if (!tf.isEmpty()) frame.spectrum = tf.h1MagDb;
+        break;
+    case 2:
+        if (!tf.isEmpty()) frame.spectrum = tf.h2MagDb;
+        break;
+    case 3:
+        if (!tf.isEmpty()) {
+            // Coherencia en dB (0 dB = coherencia total) para la escala de los renderers
+            frame.spectrum.resize(tf.coherence.size());
+            for (int k = 0; k < tf.coherence.size(); ++k) {
+                const float c = tf.coherence[k];
+                frame.spectrum[k] = (c > 0.0f) ? 10.0f * std::log10(c) : m_cfg.noiseFloor;
+            }
+        }
+        break;
+    case 4:
+        // Se mantiene el último espectro hasta que haya suficiente envolvente para otro
+        if (!m_lastEnvelope.magnitudesDb.isEmpty()) {
+            const int bins = m_lastEnvelope.magnitudesDb.size();
+            frame.spectrum = m_lastEnvelope.magnitudesDb;
+            frame.frequencies.resize(bins);
+            for (int k = 0; k < bins; ++k) {
+                frame.frequencies[k] = k * m_lastEnvelope.binHz;
+            }
+        }
+        break;
+    default:
+        break;
+    }
+
+    // Formato compacto: las vistas alternativas se empaquetan como la magnitud
+    if (m_cfg.spectrumFormat != 0 && m_cfg.logScale && !frame.spectrum.isEmpty()) {
+        frame.compactSpectrum = CompactSpectrum::encode(frame.spectrum,
+                                                        static_cast<SpectrumFormat>(m_cfg.spectrumFormat),
+                                                        m_cfg.noiseFloor, m_cfg.spectrumMaxDb);
+        frame.spectrum.clear();
+    }
+}
+
 
 QVector<float> DSPWorker::calculateSpectrum(const QVector<float>& block) {
     // Método legacy para compatibilidad
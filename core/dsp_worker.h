@@ -2,14 +2,26 @@
 #define DSP_WORKER_H
 
 #include "config/audio_configs.h"
+#include "core/analysis_types.h"
+#include "core/compact_spectrum.h"
+#include "core/thread_tuning.h"
 #include <QObject>
 #include <QVector>
 #include <QtTypes>
+#include <atomic>
 #include <memory>
+#include <vector>
 
 // Forward declarations
 class AudioDb;
 class SpectrogramCalculator;
+class CrossCorrelator;
+class TransferFunctionEstimator;
+class EnvelopeAnalyzer;
+class FeatureExtractor;
+class Fingerprinter;
+class SpectrogramPyramid;
+class SessionFileWriter;
 
 /**
  * @brief Datos de un frame procesado
@@ -18,9 +30,18 @@ struct FrameData {
     quint64 timestamp;              ///< Timestamp en nanosegundos
     qint64 sampleOffset;            ///< Offset de muestra desde el inicio
     QVector<float> waveform;        ///< Datos de forma de onda
-    QVector<float> spectrum;        ///< Espectro de frecuencias
+    float peakMin = 0.0f;           ///< Mínimo exacto del bloque (si enablePeaks)
+    float peakMax = 0.0f;           ///< Máximo exacto del bloque
+    float peakRms = 0.0f;           ///< RMS del bloque
+    QVector<float> spectrum;        ///< Espectro de frecuencias (vacío con formato compacto)
+    CompactSpectrum compactSpectrum; ///< Espectro empaquetado (si spectrumFormat != 0)
     QVector<float> frequencies;     ///< Frecuencias correspondientes a cada bin
     float windowGain = 1.0f;        ///< Ganancia de la ventana aplicada
+    QVector<TdoaEstimate> tdoa;     ///< Retardos entre canales (si enableTdoa)
+    TransferFunctionFrame transfer; ///< H1/H2 y coherencia (si enableTransferFunction)
+    QVector<EnvelopeSpectrum> envelope; ///< Espectros de envolvente nuevos en este bloque (si enableEnvelope)
+    AudioFeatures features;         ///< MFCC y descriptores espectrales (si enableFeatures)
+    QVector<FingerprintHash> fingerprints; ///< Hashes nuevos de la huella (si enableFingerprint)
 };
 
 /**
@@ -63,6 +84,17 @@ public:
     /** Obtiene información sobre la configuración del espectrograma */
     QString getSpectrogramInfo() const;
 
+    /**
+     * @brief Inicia el vaciado de la cola con un plazo (thread-safe)
+     *
+     * Los chunks que se procesen después del plazo se descartan sin
+     * análisis, de modo que finalize() llega pronto aunque haya backlog.
+     */
+    void beginDrain(int deadlineMs);
+
+    /** Chunks descartados por superar el plazo de vaciado */
+    qint64 discardedChunks() const { return m_discardedChunks.load(); }
+
 public slots:
     /** Procesa un chunk de muestras de audio con timestamp en nanosegundos */
     void processChunk(const QVector<float>& samples, quint64 timestampNs);
@@ -73,6 +105,21 @@ public slots:
     /** Reinicia el estado interno del worker */
     void reset();
 
+    /**
+     * @brief Aplica la planificación al hilo del worker (debe ejecutarse en él)
+     *
+     * Con lockMemory reserva los buffers calientes a capacidad fija y los
+     * bloquea en RAM. Emite schedulingApplied con el resultado efectivo.
+     */
+    void applyScheduling(const ThreadSchedulingConfig& config);
+
+    /**
+     * @brief Cierra la sesión: procesa el residual y cierra la base de datos
+     *
+     * Pensado para encolarse tras beginDrain(); al terminar emite finalized().
+     */
+    void finalize();
+
 signals:
     /** Emitido cuando hay nuevos frames listos */
     void framesReady(const QVector<FrameData>& batch);
@@ -80,6 +127,12 @@ signals:
     /** Emitido al producirse un error */
     void errorOccurred(const QString& error);
 
+    /** Emitido al terminar finalize() */
+    void finalized(qint64 blocksProcessed, qint64 samplesProcessed, qint64 discardedChunks);
+
+    /** Emitido tras applyScheduling con la planificación efectiva */
+    void schedulingApplied(const ThreadSchedulingReport& report);
+
     /** Emitido periódicamente con estadísticas de procesamiento */
     void statsUpdated(qint64 blocksProcessed, qint64 samplesProcessed, int bufferSize);
 
@@ -90,12 +143,61 @@ private:
     /** Guarda un frame en la base de datos */
     void saveFrameToDb(const FrameData& frame, qint64 blockIndex);
 
+    /** Añade los picos y el espectro del frame al fichero de sesión */
+    void saveFrameToSessionFile(const FrameData& frame, qint64 blockIndex);
+
     /** Inicializa el calculador de espectrograma */
     void initializeSpectrogramCalculator();
 
     /** Actualiza la configuración del calculador de espectrograma */
     void updateSpectrogramConfig();
 
+    /** Separa las muestras intercaladas del bloque en m_channelBuffers */
+    void deinterleaveChannels(const QVector<float>& block);
+
+    /** Calcula el espectro de cada canal (una FFT por canal) */
+    void computeChannelSpectra(const QVector<float>& block, quint64 timestampNs,
+                               qint64 sampleOffset, FrameData& frame);
+
+    /** (Re)crea las etapas de análisis multicanal según la configuración */
+    void initializeMultichannelStages();
+
+    /** (Re)crea un analizador de envolvente por canal según la configuración */
+    void initializeEnvelopeStage();
+
+    /** (Re)crea el extractor de descriptores según la configuración */
+    void initializeFeatureExtractor();
+
+    /** (Re)crea el generador de huellas según la configuración */
+    void initializeFingerprinter();
+
+    /** (Re)crea la pirámide de teselas del espectrograma según la configuración */
+    void initializePyramid();
+
+    /** Añade el espectro del frame a la pirámide y guarda las teselas completas */
+    void updatePyramid(const FrameData& frame);
+
+    /** (Re)crea el escritor del fichero de sesión; se abre con el primer chunk */
+    void initializeSessionFile();
+
+    /** Abre el fichero de sesión con el timestamp inicial ya conocido */
+    void openSessionFile();
+
+    /** Alimenta los analizadores de envolvente con las muestras del bloque */
+    void processEnvelope(const QVector<float>& block, FrameData& frame);
+
+    /** Sustituye FrameData::spectrum por el resultado elegido en spectrumView */
+    void applySpectrumView(FrameData& frame) const;
+
+    /** Reserva y bloquea en RAM los buffers del camino caliente */
+    qint64 lockHotBuffers(QStringList& errors);
+
+    /** Desbloquea las regiones bloqueadas con lockHotBuffers */
+    void unlockHotBuffers();
+
+    /** Vuelve a reservar y bloquear los buffers; actualiza m_schedulingReport */
+    void relockHotBuffers();
+
     /** Valida y corrige timestamps inválidos */
     quint64 validateTimestamp(quint64 timestampNs);
 
@@ -121,6 +223,40 @@ private:
     // Calculador de espectrograma
     std::unique_ptr<SpectrogramCalculator> m_spectrogramCalc;
 
+    // Análisis multicanal
+    std::unique_ptr<CrossCorrelator> m_crossCorrelator;
+    std::unique_ptr<TransferFunctionEstimator> m_transferEstimator;
+    QVector<QVector<float>> m_channelBuffers;   ///< Muestras desintercaladas por canal
+    QVector<ComplexSpectrum> m_channelSpectra;  ///< Espectro complejo por canal del hop actual
+
+    // Análisis de envolvente
+    std::vector<std::unique_ptr<EnvelopeAnalyzer>> m_envelopeAnalyzers; ///< Uno por canal
+    EnvelopeSpectrum m_lastEnvelope;            ///< Último espectro del canal 0 (spectrumView = 4)
+
+    // Descriptores de audio
+    std::unique_ptr<FeatureExtractor> m_featureExtractor;
+
+    // Huella de audio
+    std::unique_ptr<Fingerprinter> m_fingerprinter;
+
+    // Pirámide de teselas del espectrograma
+    std::unique_ptr<SpectrogramPyramid> m_pyramid;
+    QVector<float> m_pyramidColumn;             ///< Columna decodificada del espectro compacto
+    bool m_pyramidIndicesSynced = false;        ///< Índices de tesela ya alineados con la DB
+
+    // Fichero de sesión columnar (append-only)
+    std::unique_ptr<SessionFileWriter> m_sessionFile;
+
+    // Vaciado con plazo al parar la captura
+    std::atomic<bool>   m_draining { false };
+    std::atomic<qint64> m_drainDeadline { 0 };   ///< QDeadlineTimer::deadline() en ms
+    std::atomic<qint64> m_discardedChunks { 0 };
+
+    // Regiones bloqueadas con mlock (dirección, bytes)
+    QVector<QPair<const void*, size_t>> m_lockedRegions;
+    ThreadSchedulingConfig m_scheduling;      ///< Última planificación aplicada
+    ThreadSchedulingReport m_schedulingReport;
+
     // Métodos legacy (mantenidos para compatibilidad)
     QVector<float> m_hanningWindow;     ///< Ventana de Hanning (legacy)
     bool m_windowCalculated = false;    ///< Flag ventana calculada (legacy)
@@ -0,0 +1,187 @@
+#include "envelope_analyzer.h"
+#include "fft_plan_cache.h"
+#include <QDebug>
+#include <algorithm>
+#include <cmath>
+
+EnvelopeAnalyzer::EnvelopeAnalyzer(const EnvelopeConfig& config, int channel)
+    : m_channel(channel)
+{
+    setConfig(config);
+}
+
+void EnvelopeAnalyzer::setConfig(const EnvelopeConfig& config) {
+    m_config = config;
+
+    if (m_config.sampleRate <= 0) {
+        qWarning() << "EnvelopeAnalyzer: sampleRate inválido, usando 44100";
+        m_config.sampleRate = 44100;
+    }
+    if (m_config.segmentSize < 256) {
+        qWarning() << "EnvelopeAnalyzer: segmentSize demasiado pequeño, usando 4096";
+        m_config.segmentSize = 4096;
+    }
+    if (m_config.spectrumSize < 64) {
+        qWarning() << "EnvelopeAnalyzer: spectrumSize demasiado pequeño, usando 1024";
+        m_config.spectrumSize = 1024;
+    }
+
+    const float nyquist = m_config.sampleRate / 2.0f;
+    m_config.bandLowHz = std::clamp(m_config.bandLowHz, 0.0f, nyquist);
+    m_config.bandHighHz = std::clamp(m_config.bandHighHz, 0.0f, nyquist);
+    if (m_config.bandHighHz <= m_config.bandLowHz) {
+        qWarning() << "EnvelopeAnalyzer: banda inválida, usando banda completa";
+        m_config.bandLowHz = 0.0f;
+        m_config.bandHighHz = nyquist;
+    }
+
+    // La envolvente de una señal de ancho de banda B ocupa como mucho B Hz
+    if (m_config.decimation > 0) {
+        m_decimation = m_config.decimation;
+    } else {
+        const float bandwidth = m_config.bandHighHz - m_config.bandLowHz;
+        m_decimation = std::max(1, int(m_config.sampleRate / (2.5f * bandwidth)));
+    }
+
+    m_guard = m_config.segmentSize / 8;
+    m_step = m_config.segmentSize - 2 * m_guard;
+
+    rebuildBandMask();
+
+    // Ventana Hann para el espectro de envolvente
+    const int M = m_config.spectrumSize;
+    m_window.resize(M);
+    double sum = 0.0;
+    for (int i = 0; i < M; ++i) {
+        m_window[i] = 0.5f * (1.0f - std::cos(2.0 * M_PI * i / (M - 1)));
+        sum += m_window[i];
+    }
+    m_windowGain = float(sum / M);
+    m_specInput.resize(M);
+    m_specOut.resize(M / 2 + 1);
+
+    m_spectrum.resize(m_config.segmentSize);
+    m_analytic.resize(m_config.segmentSize);
+
+    reset();
+}
+
+void EnvelopeAnalyzer::reset() {
+    // Relleno inicial de ceros para que la primera zona válida empiece en la muestra 0
+    m_input.fill(0.0f, m_guard);
+    m_envelope.clear();
+    m_decimSum = 0.0f;
+    m_decimCount = 0;
+}
+
+void EnvelopeAnalyzer::rebuildBandMask() {
+    const int N = m_config.segmentSize;
+    const int half = N / 2;
+    const float binHz = float(m_config.sampleRate) / N;
+
+    const int lo = int(std::floor(m_config.bandLowHz / binHz));
+    const int hi = std::min(half, int(std::ceil(m_config.bandHighHz / binHz)));
+    const int taper = std::max(2, (hi - lo) / 10);
+
+    m_bandMask.fill(0.0f, half + 1);
+    for (int k = std::max(0, lo); k <= hi; ++k) {
+        // Bordes en coseno alzado para limitar el rizado temporal
+        float g = 1.0f;
+        if (k - lo < taper)
+            g = 0.5f * (1.0f - std::cos(M_PI * (k - lo + 0.5f) / taper));
+        else if (hi - k < taper)
+            g = 0.5f * (1.0f - std::cos(M_PI * (hi - k + 0.5f) / taper));
+
+        // Señal analítica: bins positivos duplicados, DC y Nyquist sin duplicar
+        const float analytic = (k == 0 || k == half) ? 1.0f : 2.0f;
+        m_bandMask[k] = g * analytic;
+    }
+}
+
+bool EnvelopeAnalyzer::process(const float* samples, int count, EnvelopeSpectrum* out) {
+    if (!samples || count <= 0)
+        return false;
+
+    m_input.append(samples, count);
+
+    const int N = m_config.segmentSize;
+    while (m_input.size() >= N) {
+        processSegment();
+        m_input.remove(0, m_step);
+    }
+
+    bool produced = false;
+    const int M = m_config.spectrumSize;
+    while (m_envelope.size() >= M) {
+        computeSpectrum(out);
+        m_envelope.remove(0, M / 2);
+        produced = true;
+    }
+    return produced;
+}
+
+void EnvelopeAnalyzer::processSegment() {
+    const int N = m_config.segmentSize;
+    const int half = N / 2;
+
+    FftPlanCache& plans = FftPlanCache::instance();
+    fftwf_plan forward = plans.r2c(N);
+    fftwf_plan backward = plans.c2c(N, FFTW_BACKWARD);
+    if (!forward || !backward)
+        return;
+
+    auto* spec = reinterpret_cast<fftwf_complex*>(m_spectrum.data());
+    fftwf_execute_dft_r2c(forward, m_input.data(), spec);
+
+    // Pasa-banda + Hilbert: bins negativos a cero
+    const float* mask = m_bandMask.constData();
+    for (int k = 0; k <= half; ++k) {
+        m_spectrum[k] *= mask[k];
+    }
+    std::fill(m_spectrum.begin() + half + 1, m_spectrum.end(), std::complex<float>(0.0f, 0.0f));
+
+    fftwf_execute_dft(backward, spec, reinterpret_cast<fftwf_complex*>(m_analytic.data()));
+
+    // Módulo de la zona válida y decimación por promediado
+    const float scale = 1.0f / N;
+    const std::complex<float>* z = m_analytic.constData();
+    for (int n = m_guard; n < m_guard + m_step; ++n) {
+        m_decimSum += std::abs(z[n]) * scale;
+        if (++m_decimCount == m_decimation) {
+            m_envelope.append(m_decimSum / m_decimation);
+            m_decimSum = 0.0f;
+            m_decimCount = 0;
+        }
+    }
+}
+
+void EnvelopeAnalyzer::computeSpectrum(EnvelopeSpectrum* out) {
+    const int M = m_config.spectrumSize;
+    const int bins = M / 2 + 1;
+
+    fftwf_plan plan = FftPlanCache::instance().r2c(M);
+    if (!plan || !out)
+        return;
+
+    // Quitar la componente continua de la envolvente antes de ventanear
+    double mean = 0.0;
+    for (int i = 0; i < M; ++i) mean += m_envelope[i];
+    const float dc = float(mean / M);
+    for (int i = 0; i < M; ++i) {
+        m_specInput[i] = (m_envelope[i] - dc) * m_window[i];
+    }
+
+    fftwf_execute_dft_r2c(plan, m_specInput.data(),
+                          reinterpret_cast<fftwf_complex*>(m_specOut.data()));
+
+    out->channel = m_channel;
+    out->envelopeRate = envelopeRate();
+    out->binHz = out->envelopeRate / M;
+    out->magnitudesDb.resize(bins);
+
+    const float norm = 1.0f / (M * m_windowGain);
+    for (int k = 0; k < bins; ++k) {
+        const float mag = std::abs(m_specOut[k]) * norm;
+        out->magnitudesDb[k] = (mag > 0.0f) ? 20.0f * std::log10(mag) : m_config.floorDb;
+    }
+}
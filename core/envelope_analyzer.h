@@ -0,0 +1,84 @@
+#ifndef ENVELOPE_ANALYZER_H
+#define ENVELOPE_ANALYZER_H
+
+#include "core/analysis_types.h"
+#include <QVector>
+#include <complex>
+
+/**
+ * @brief Configuración del análisis de envolvente
+ */
+struct EnvelopeConfig {
+    int   sampleRate = 44100;      ///< Frecuencia de muestreo de entrada
+    float bandLowHz = 1000.0f;     ///< Límite inferior del pasa-banda
+    float bandHighHz = 5000.0f;    ///< Límite superior del pasa-banda
+    int   segmentSize = 4096;      ///< Longitud FFT de la señal analítica (potencia de 2)
+    int   decimation = 0;          ///< Factor de decimación de la envolvente (0 = automático)
+    int   spectrumSize = 1024;     ///< Longitud FFT del espectro de envolvente
+    float floorDb = -100.0f;       ///< Valor para magnitudes nulas
+};
+
+/**
+ * @brief Análisis de envolvente en streaming para un canal
+ *
+ * Cadena: pasa-banda + transformada de Hilbert en el dominio de la
+ * frecuencia (una FFT r2c y una IFFT c2c por segmento), módulo de la
+ * señal analítica, decimación de la envolvente y FFT de la envolvente.
+ *
+ * Los segmentos se solapan (overlap-save): de cada segmento sólo se
+ * conservan las muestras centrales y se descartan `guard` muestras en
+ * cada extremo, donde la convolución circular introduce artefactos.
+ * El espectro de envolvente se calcula con 50 % de solape.
+ *
+ * Todos los planes FFT provienen de FftPlanCache.
+ */
+class EnvelopeAnalyzer
+{
+public:
+    explicit EnvelopeAnalyzer(const EnvelopeConfig& config, int channel = 0);
+
+    EnvelopeConfig getConfig() const { return m_config; }
+    void setConfig(const EnvelopeConfig& config);
+
+    /** Descarta el estado acumulado */
+    void reset();
+
+    /** Factor de decimación efectivo */
+    int decimation() const { return m_decimation; }
+
+    /** Frecuencia de muestreo de la envolvente decimada */
+    float envelopeRate() const { return float(m_config.sampleRate) / m_decimation; }
+
+    /**
+     * @brief Añade muestras del canal
+     * @return true si se produjo al menos un espectro nuevo (el último queda en out)
+     */
+    bool process(const float* samples, int count, EnvelopeSpectrum* out);
+
+private:
+    void rebuildBandMask();
+    void processSegment();
+    void computeSpectrum(EnvelopeSpectrum* out);
+
+    EnvelopeConfig m_config;
+    int m_channel;
+    int m_decimation = 1;
+    int m_guard = 0;                         ///< Muestras descartadas en cada extremo
+    int m_step = 0;                          ///< Avance entre segmentos
+
+    QVector<float> m_input;                  ///< Muestras pendientes (incluye solape)
+    QVector<float> m_bandMask;               ///< Ganancia por bin (pasa-banda × factor analítico)
+    QVector<std::complex<float>> m_spectrum; ///< FFT del segmento / señal analítica
+    QVector<std::complex<float>> m_analytic; ///< Señal analítica en el tiempo
+
+    float m_decimSum = 0.0f;                 ///< Acumulador del promediado de decimación
+    int   m_decimCount = 0;
+    QVector<float> m_envelope;               ///< Envolvente decimada pendiente
+
+    QVector<float> m_window;                 ///< Ventana Hann del espectro de envolvente
+    float m_windowGain = 1.0f;
+    QVector<float> m_specInput;
+    QVector<std::complex<float>> m_specOut;
+};
+
+#endif // ENVELOPE_ANALYZER_H
@@ -0,0 +1,192 @@
+#include "feature_extractor.h"
+#include <QDebug>
+#include <algorithm>
+#include <cmath>
+
+FeatureExtractor::FeatureExtractor(const FeatureConfig& config)
+{
+    setConfig(config);
+}
+
+void FeatureExtractor::setConfig(const FeatureConfig& config) {
+    m_config = config;
+
+    if (m_config.fftSize <= 0) {
+        qWarning() << "FeatureExtractor: fftSize inválido, usando 1024";
+        m_config.fftSize = 1024;
+    }
+    if (m_config.sampleRate <= 0) {
+        qWarning() << "FeatureExtractor: sampleRate inválido, usando 44100";
+        m_config.sampleRate = 44100;
+    }
+    if (m_config.melBands <= 0) {
+        m_config.melBands = 26;
+    }
+    m_config.mfccCount = std::clamp(m_config.mfccCount, 1, m_config.melBands);
+
+    const float nyquist = m_config.sampleRate / 2.0f;
+    if (m_config.maxHz <= 0.0f || m_config.maxHz > nyquist) {
+        m_config.maxHz = nyquist;
+    }
+    m_config.minHz = std::clamp(m_config.minHz, 0.0f, m_config.maxHz);
+    m_config.rolloffFraction = std::clamp(m_config.rolloffFraction, 0.0f, 1.0f);
+
+    const int bins = m_config.fftSize / 2 + 1;
+    const float binHz = float(m_config.sampleRate) / m_config.fftSize;
+    m_frequencies.resize(bins);
+    for (int k = 0; k < bins; ++k) {
+        m_frequencies[k] = k * binHz;
+    }
+    m_power.resize(bins);
+    m_melEnergies.resize(m_config.melBands);
+
+    buildMelBank();
+    buildDct();
+}
+
+float FeatureExtractor::hzToMel(float hz) {
+    return 2595.0f * std::log10(1.0f + hz / 700.0f);
+}
+
+float FeatureExtractor::melToHz(float mel) {
+    return 700.0f * (std::pow(10.0f, mel / 2595.0f) - 1.0f);
+}
+
+void FeatureExtractor::buildMelBank() {
+    const int bands = m_config.melBands;
+    const int bins = m_config.fftSize / 2 + 1;
+    const float binHz = float(m_config.sampleRate) / m_config.fftSize;
+
+    // bands + 2 puntos equiespaciados en mel: bordes y centros de los triángulos
+    const float melLo = hzToMel(m_config.minHz);
+    const float melHi = hzToMel(m_config.maxHz);
+    QVector<float> edges(bands + 2);
+    for (int i = 0; i < edges.size(); ++i) {
+        edges[i] = melToHz(melLo + (melHi - melLo) * i / (bands + 1));
+    }
+
+    m_melBank.resize(bands);
+    for (int b = 0; b < bands; ++b) {
+        const float left = edges[b];
+        const float center = edges[b + 1];
+        const float right = edges[b + 2];
+
+        const int first = std::clamp(int(std::ceil(left / binHz)), 0, bins - 1);
+        const int last = std::clamp(int(std::floor(right / binHz)), 0, bins - 1);
+
+        MelFilter& filter = m_melBank[b];
+        filter.firstBin = first;
+        filter.weights.clear();
+        for (int k = first; k <= last; ++k) {
+            const float f = k * binHz;
+            float w = 0.0f;
+            if (f <= center && center > left)
+                w = (f - left) / (center - left);
+            else if (f > center && right > center)
+                w = (right - f) / (right - center);
+            filter.weights.append(std::max(0.0f, w));
+        }
+    }
+}
+
+void FeatureExtractor::buildDct() {
+    const int bands = m_config.melBands;
+    const int coeffs = m_config.mfccCount;
+
+    // DCT-II ortonormal
+    m_dct.resize(coeffs * bands);
+    const float scale0 = std::sqrt(1.0f / bands);
+    const float scale = std::sqrt(2.0f / bands);
+    for (int c = 0; c < coeffs; ++c) {
+        for (int b = 0; b < bands; ++b) {
+            m_dct[c * bands + b] = (c == 0 ? scale0 : scale) *
+                std::cos(float(M_PI) * c * (b + 0.5f) / bands);
+        }
+    }
+}
+
+AudioFeatures FeatureExtractor::process(const ComplexSpectrum& spectrum,
+                                        const float* samples, int count) {
+    AudioFeatures out;
+
+    const int bins = m_power.size();
+    if (spectrum.bins() != bins) {
+        qWarning() << "FeatureExtractor: espectro con" << spectrum.bins()
+                   << "bins, se esperaban" << bins;
+        return out;
+    }
+
+    // 1) Potencia por bin y momentos espectrales en un único recorrido
+    const float* __restrict re = spectrum.re.constData();
+    const float* __restrict im = spectrum.im.constData();
+    const float* __restrict freq = m_frequencies.constData();
+    float* __restrict power = m_power.data();
+
+    constexpr float eps = 1e-12f;
+    double total = 0.0;
+    double weighted = 0.0;
+    double logSum = 0.0;
+    for (int k = 0; k < bins; ++k) {
+        const float p = re[k] * re[k] + im[k] * im[k];
+        power[k] = p;
+        total += p;
+        weighted += double(p) * freq[k];
+        logSum += std::log(p + eps);
+    }
+
+    if (total > 0.0) {
+        out.centroidHz = float(weighted / total);
+
+        // Media geométrica / media aritmética
+        const double geo = std::exp(logSum / bins);
+        out.flatness = float(std::clamp(geo / (total / bins), 0.0, 1.0));
+
+        const double threshold = total * m_config.rolloffFraction;
+        double cumulative = 0.0;
+        for (int k = 0; k < bins; ++k) {
+            cumulative += power[k];
+            if (cumulative >= threshold) {
+                out.rolloffHz = freq[k];
+                break;
+            }
+        }
+    }
+
+    // 2) Banco mel disperso + logaritmo
+    const int bands = m_config.melBands;
+    for (int b = 0; b < bands; ++b) {
+        const MelFilter& filter = m_melBank[b];
+        const float* __restrict w = filter.weights.constData();
+        const float* __restrict p = power + filter.firstBin;
+        const int n = filter.weights.size();
+        float e = 0.0f;
+        for (int i = 0; i < n; ++i) {
+            e += w[i] * p[i];
+        }
+        m_melEnergies[b] = std::log(e + eps);
+    }
+
+    // 3) DCT-II -> MFCC
+    const int coeffs = m_config.mfccCount;
+    out.mfcc.resize(coeffs);
+    const float* __restrict mel = m_melEnergies.constData();
+    for (int c = 0; c < coeffs; ++c) {
+        const float* __restrict row = m_dct.constData() + c * bands;
+        float acc = 0.0f;
+        for (int b = 0; b < bands; ++b) {
+            acc += row[b] * mel[b];
+        }
+        out.mfcc[c] = acc;
+    }
+
+    // 4) Tasa de cruces por cero en el dominio del tiempo
+    if (samples && count > 1) {
+        int crossings = 0;
+        for (int i = 1; i < count; ++i) {
+            crossings += (samples[i - 1] >= 0.0f) != (samples[i] >= 0.0f);
+        }
+        out.zeroCrossingRate = float(crossings) / float(count - 1);
+    }
+
+    return out;
+}
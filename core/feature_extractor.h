@@ -0,0 +1,66 @@
+#ifndef FEATURE_EXTRACTOR_H
+#define FEATURE_EXTRACTOR_H
+
+#include "core/analysis_types.h"
+#include <QVector>
+
+/**
+ * @brief Configuración del extractor de descriptores
+ */
+struct FeatureConfig {
+    int   fftSize = 1024;          ///< Debe coincidir con el de los espectros de entrada
+    int   sampleRate = 44100;      ///< Frecuencia de muestreo
+    int   melBands = 26;           ///< Filtros triangulares del banco mel
+    int   mfccCount = 13;          ///< Coeficientes cepstrales de salida
+    float minHz = 20.0f;           ///< Frecuencia inferior del banco mel
+    float maxHz = 0.0f;            ///< Frecuencia superior (0 = Nyquist)
+    float rolloffFraction = 0.85f; ///< Fracción de energía para el rolloff
+};
+
+/**
+ * @brief Extrae MFCC, centroide, rolloff, planitud y ZCR
+ *
+ * Parte del espectro complejo que el DSPWorker ya calculó para el
+ * espectrograma, así que no añade ninguna FFT. El banco mel se guarda
+ * de forma dispersa (bin inicial + pesos de cada triángulo) y la DCT-II
+ * como matriz precalculada; todos los bucles recorren arrays contiguos
+ * con punteros sin alias para que el compilador los vectorice.
+ */
+class FeatureExtractor
+{
+public:
+    explicit FeatureExtractor(const FeatureConfig& config);
+
+    FeatureConfig getConfig() const { return m_config; }
+    void setConfig(const FeatureConfig& config);
+
+    /**
+     * @brief Calcula los descriptores de un frame
+     * @param spectrum Espectro complejo del frame
+     * @param samples  Muestras en el tiempo (para la tasa de cruces por cero)
+     * @param count    Número de muestras
+     */
+    AudioFeatures process(const ComplexSpectrum& spectrum, const float* samples, int count);
+
+private:
+    struct MelFilter {
+        int firstBin = 0;
+        QVector<float> weights;
+    };
+
+    void buildMelBank();
+    void buildDct();
+
+    static float hzToMel(float hz);
+    static float melToHz(float mel);
+
+    FeatureConfig m_config;
+    QVector<MelFilter> m_melBank;
+    QVector<float> m_dct;          ///< Matriz DCT-II (mfccCount × melBands)
+    QVector<float> m_frequencies;  ///< Frecuencia de cada bin
+
+    QVector<float> m_power;        ///< Potencia por bin del frame actual
+    QVector<float> m_melEnergies;  ///< Log-energía por banda mel
+};
+
+#endif // FEATURE_EXTRACTOR_H
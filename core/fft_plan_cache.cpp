@@ -0,0 +1,122 @@
+#include "fft_plan_cache.h"
+#include <QDebug>
+#include <QMutex>
+
+namespace {
+// El planificador de FFTW es global y no reentrante
+QMutex& plannerMutex() {
+    static QMutex mutex;
+    return mutex;
+}
+}
+
+FftPlanCache& FftPlanCache::instance() {
+    thread_local FftPlanCache cache;
+    return cache;
+}
+
+FftPlanCache::~FftPlanCache() {
+    clear();
+}
+
+void FftPlanCache::clear() {
+    QMutexLocker lock(&plannerMutex());
+    for (fftwf_plan plan : std::as_const(m_plans)) {
+        if (plan) fftwf_destroy_plan(plan);
+    }
+    m_plans.clear();
+}
+
+fftwf_plan FftPlanCache::r2c(int n) {
+    const quint64 key = makeKey(R2C, n);
+    if (auto it = m_plans.constFind(key); it != m_plans.constEnd())
+        return it.value();
+    fftwf_plan plan = createPlan(R2C, n, 1);
+    if (plan) m_plans.insert(key, plan);
+    return plan;
+}
+
+fftwf_plan FftPlanCache::c2r(int n) {
+    const quint64 key = makeKey(C2R, n);
+    if (auto it = m_plans.constFind(key); it != m_plans.constEnd())
+        return it.value();
+    fftwf_plan plan = createPlan(C2R, n, 1);
+    if (plan) m_plans.insert(key, plan);
+    return plan;
+}
+
+fftwf_plan FftPlanCache::c2c(int n, int sign) {
+    const PlanKind kind = (sign == FFTW_FORWARD) ? C2CForward : C2CBackward;
+    const quint64 key = makeKey(kind, n);
+    if (auto it = m_plans.constFind(key); it != m_plans.constEnd())
+        return it.value();
+    fftwf_plan plan = createPlan(kind, n, 1);
+    if (plan) m_plans.insert(key, plan);
+    return plan;
+}
+
+fftwf_plan FftPlanCache::c2rBatch(int n, int howMany) {
+    if (howMany <= 1)
+        return c2r(n);
+    const quint64 key = makeKey(C2RBatch, n, howMany);
+    if (auto it = m_plans.constFind(key); it != m_plans.constEnd())
+        return it.value();
+    fftwf_plan plan = createPlan(C2RBatch, n, howMany);
+    if (plan) m_plans.insert(key, plan);
+    return plan;
+}
+
+quint64 FftPlanCache::makeKey(PlanKind kind, int n, int howMany) {
+    return (quint64(kind) << 56) | (quint64(quint32(howMany) & 0xFFFFFF) << 32) | quint32(n);
+}
+
+fftwf_plan FftPlanCache::createPlan(PlanKind kind, int n, int howMany) {
+    if (n <= 0 || howMany <= 0) {
+        qWarning() << "FftPlanCache: tamaño de plan inválido" << n << "x" << howMany;
+        return nullptr;
+    }
+
+    const int bins = n / 2 + 1;
+    const unsigned flags = FFTW_ESTIMATE | FFTW_UNALIGNED;
+
+    // Buffers temporales sólo para planificar (FFTW_ESTIMATE no los toca)
+    float* real = fftwf_alloc_real(size_t(n) * howMany);
+    fftwf_complex* cplx = fftwf_alloc_complex(size_t(kind == C2CForward || kind == C2CBackward ? n : bins) * howMany);
+    fftwf_complex* cplx2 = (kind == C2CForward || kind == C2CBackward) ? fftwf_alloc_complex(size_t(n)) : nullptr;
+
+    fftwf_plan plan = nullptr;
+    {
+        QMutexLocker lock(&plannerMutex());
+        switch (kind) {
+        case R2C:
+            plan = fftwf_plan_dft_r2c_1d(n, real, cplx, flags);
+            break;
+        case C2R:
+            plan = fftwf_plan_dft_c2r_1d(n, cplx, real, flags);
+            break;
+        case C2CForward:
+            plan = fftwf_plan_dft_1d(n, cplx, cplx2, FFTW_FORWARD, flags);
+            break;
+        case C2CBackward:
+            plan = fftwf_plan_dft_1d(n, cplx, cplx2, FFTW_BACKWARD, flags);
+            break;
+        case C2RBatch: {
+            int dims[1] = { n };
+            plan = fftwf_plan_many_dft_c2r(1, dims, howMany,
+                                           cplx, nullptr, 1, bins,
+                                           real, nullptr, 1, n,
+                                           flags);
+            break;
+        }
+        }
+    }
+
+    fftwf_free(real);
+    fftwf_free(cplx);
+    if (cplx2) fftwf_free(cplx2);
+
+    if (!plan) {
+        qWarning() << "FftPlanCache: no se pudo crear el plan" << int(kind) << "n=" << n;
+    }
+    return plan;
+}
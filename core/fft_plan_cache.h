@@ -0,0 +1,61 @@
+#ifndef FFT_PLAN_CACHE_H
+#define FFT_PLAN_CACHE_H
+
+#include <QHash>
+#include <QtTypes>
+#include <fftw3.h>
+
+/**
+ * @brief Caché de planes FFTW compartida por las etapas DSP de un hilo
+ *
+ * Los planes se crean una sola vez por (tipo, tamaño, lote) con
+ * FFTW_UNALIGNED, de modo que pueden ejecutarse sobre cualquier buffer
+ * mediante la API "new-array" (fftwf_execute_dft_r2c, etc.).
+ *
+ * El planificador de FFTW no es thread-safe: la creación y destrucción
+ * de planes se serializa con un mutex global. La ejecución sí lo es, y
+ * cada hilo obtiene su propia instancia con instance().
+ */
+class FftPlanCache
+{
+public:
+    /** Instancia asociada al hilo actual */
+    static FftPlanCache& instance();
+
+    ~FftPlanCache();
+
+    /** Plan real -> complejo (n muestras -> n/2+1 bins) */
+    fftwf_plan r2c(int n);
+
+    /** Plan complejo -> real (n/2+1 bins -> n muestras, sin normalizar) */
+    fftwf_plan c2r(int n);
+
+    /** Plan complejo -> complejo (sign = FFTW_FORWARD o FFTW_BACKWARD) */
+    fftwf_plan c2c(int n, int sign);
+
+    /**
+     * @brief Plan c2r por lotes: howMany espectros contiguos de n/2+1 bins
+     *        a howMany señales contiguas de n muestras
+     */
+    fftwf_plan c2rBatch(int n, int howMany);
+
+    /** Número de planes almacenados */
+    int planCount() const { return m_plans.size(); }
+
+    /** Libera todos los planes del hilo actual */
+    void clear();
+
+private:
+    FftPlanCache() = default;
+    FftPlanCache(const FftPlanCache&) = delete;
+    FftPlanCache& operator=(const FftPlanCache&) = delete;
+
+    enum PlanKind : quint8 { R2C, C2R, C2CForward, C2CBackward, C2RBatch };
+
+    static quint64 makeKey(PlanKind kind, int n, int howMany = 1);
+    fftwf_plan createPlan(PlanKind kind, int n, int howMany);
+
+    QHash<quint64, fftwf_plan> m_plans;
+};
+
+#endif // FFT_PLAN_CACHE_H
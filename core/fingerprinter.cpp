@@ -0,0 +1,178 @@
+#include "fingerprinter.h"
+#include "spectrogram_calculator.h"
+#include <QDebug>
+#include <algorithm>
+#include <cmath>
+
+Fingerprinter::Fingerprinter(const FingerprintConfig& config)
+{
+    setConfig(config);
+}
+
+void Fingerprinter::setConfig(const FingerprintConfig& config) {
+    m_config = config;
+
+    if (m_config.fftSize <= 0) {
+        qWarning() << "Fingerprinter: fftSize inválido, usando 1024";
+        m_config.fftSize = 1024;
+    }
+    if (m_config.sampleRate <= 0) {
+        qWarning() << "Fingerprinter: sampleRate inválido, usando 44100";
+        m_config.sampleRate = 44100;
+    }
+    if (m_config.hopSize <= 0) {
+        m_config.hopSize = m_config.fftSize;
+    }
+    m_config.peaksPerFrame = std::max(1, m_config.peaksPerFrame);
+    m_config.neighborhoodBins = std::max(1, m_config.neighborhoodBins);
+    m_config.minDeltaFrames = std::max(1, m_config.minDeltaFrames);
+    // Δt ocupa 12 bits en el hash
+    m_config.maxDeltaFrames = std::clamp(m_config.maxDeltaFrames, m_config.minDeltaFrames, 4095);
+    m_config.fanOut = std::max(1, m_config.fanOut);
+
+    const int bins = m_config.fftSize / 2 + 1;
+    const float binHz = float(m_config.sampleRate) / m_config.fftSize;
+    m_minBin = std::clamp(int(m_config.minFreqHz / binHz), 1, bins - 1);
+    m_maxBin = std::clamp(int(m_config.maxFreqHz / binHz), m_minBin, bins - 1);
+
+    m_binShift = 0;
+    while ((m_maxBin >> m_binShift) > 0x3FF) {
+        ++m_binShift;
+    }
+
+    m_magnitudesDb.resize(bins);
+    reset();
+}
+
+void Fingerprinter::reset() {
+    m_history.clear();
+}
+
+QVector<FingerprintHash> Fingerprinter::process(const ComplexSpectrum& spectrum, qint64 frameIndex) {
+    const int bins = m_magnitudesDb.size();
+    if (spectrum.bins() != bins) {
+        qWarning() << "Fingerprinter: espectro con" << spectrum.bins()
+                   << "bins, se esperaban" << bins;
+        return {};
+    }
+
+    const float* __restrict re = spectrum.re.constData();
+    const float* __restrict im = spectrum.im.constData();
+    float* __restrict db = m_magnitudesDb.data();
+    for (int k = 0; k < bins; ++k) {
+        db[k] = 10.0f * std::log10(re[k] * re[k] + im[k] * im[k] + 1e-20f);
+    }
+
+    return processMagnitudes(frameIndex);
+}
+
+QVector<FingerprintHash> Fingerprinter::fingerprintClip(const QVector<float>& samples) {
+    QVector<FingerprintHash> out;
+
+    const int hop = m_config.hopSize;
+    if (samples.size() < hop) {
+        return out;
+    }
+
+    // Mismo cálculo que DSPWorker::computeChannelSpectra: un frame por bloque
+    SpectrogramConfig spectrogramConfig;
+    spectrogramConfig.fftSize = m_config.fftSize;
+    spectrogramConfig.hopSize = hop;
+    spectrogramConfig.sampleRate = m_config.sampleRate;
+    spectrogramConfig.windowType = static_cast<WindowType>(m_config.windowType);
+    spectrogramConfig.kaiserBeta = m_config.kaiserBeta;
+    spectrogramConfig.gaussianSigma = m_config.gaussianSigma;
+    SpectrogramCalculator calculator(spectrogramConfig);
+
+    // El historial de la captura en curso no debe mezclarse con el clip
+    const QList<PeakFrame> savedHistory = m_history;
+    m_history.clear();
+
+    QVector<float> block(hop);
+    ComplexSpectrum spectrum;
+    qint64 frameIndex = 0;
+    for (qsizetype start = 0; start + hop <= samples.size(); start += hop, ++frameIndex) {
+        std::copy_n(samples.constData() + start, hop, block.data());
+        calculator.calculateFrame(block, 0, start, &spectrum);
+        out += process(spectrum, frameIndex);
+    }
+
+    m_history = savedHistory;
+    return out;
+}
+
+void Fingerprinter::pickPeaks(QVector<Peak>& out) const {
+    out.clear();
+
+    const float* db = m_magnitudesDb.constData();
+    const int nb = m_config.neighborhoodBins;
+    const int bins = m_magnitudesDb.size();
+
+    double mean = 0.0;
+    for (int k = m_minBin; k <= m_maxBin; ++k) mean += db[k];
+    mean /= (m_maxBin - m_minBin + 1);
+    const float threshold = float(mean) + m_config.thresholdDb;
+
+    for (int k = m_minBin; k <= m_maxBin; ++k) {
+        const float v = db[k];
+        if (v < threshold) continue;
+
+        const int lo = std::max(0, k - nb);
+        const int hi = std::min(bins - 1, k + nb);
+        bool isMax = true;
+        for (int j = lo; j <= hi && isMax; ++j) {
+            // Desempate por índice para no duplicar mesetas
+            if (db[j] > v || (db[j] == v && j < k)) isMax = false;
+        }
+        if (isMax) {
+            out.append({k, v, 0});
+        }
+    }
+
+    if (out.size() > m_config.peaksPerFrame) {
+        std::partial_sort(out.begin(), out.begin() + m_config.peaksPerFrame, out.end(),
+                          [](const Peak& a, const Peak& b) { return a.db > b.db; });
+        out.resize(m_config.peaksPerFrame);
+    }
+}
+
+quint32 Fingerprinter::makeHash(int anchorBin, int targetBin, int deltaFrames) const {
+    const quint32 f1 = quint32(anchorBin >> m_binShift) & 0x3FF;
+    const quint32 f2 = quint32(targetBin >> m_binShift) & 0x3FF;
+    const quint32 dt = quint32(deltaFrames) & 0xFFF;
+    return (f1 << 22) | (f2 << 12) | dt;
+}
+
+QVector<FingerprintHash> Fingerprinter::processMagnitudes(qint64 frameIndex) {
+    QVector<FingerprintHash> out;
+
+    PeakFrame current;
+    current.index = frameIndex;
+    pickPeaks(current.peaks);
+
+    // Descartar anclas fuera de la ventana temporal
+    while (!m_history.isEmpty() && frameIndex - m_history.first().index > m_config.maxDeltaFrames) {
+        m_history.removeFirst();
+    }
+
+    // Emparejar los picos nuevos (destinos) con las anclas anteriores
+    for (const Peak& target : std::as_const(current.peaks)) {
+        for (PeakFrame& anchorFrame : m_history) {
+            const qint64 dt = frameIndex - anchorFrame.index;
+            if (dt < m_config.minDeltaFrames) continue;
+
+            for (Peak& anchor : anchorFrame.peaks) {
+                if (anchor.pairs >= m_config.fanOut) continue;
+                if (std::abs(target.bin - anchor.bin) > m_config.maxDeltaBins) continue;
+
+                out.append({makeHash(anchor.bin, target.bin, int(dt)), anchorFrame.index});
+                ++anchor.pairs;
+            }
+        }
+    }
+
+    if (!current.peaks.isEmpty()) {
+        m_history.append(std::move(current));
+    }
+    return out;
+}
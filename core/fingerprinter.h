@@ -0,0 +1,90 @@
+#ifndef FINGERPRINTER_H
+#define FINGERPRINTER_H
+
+#include "core/analysis_types.h"
+#include <QList>
+#include <QVector>
+
+/**
+ * @brief Configuración de la huella de audio por constelación
+ */
+struct FingerprintConfig {
+    int   fftSize = 1024;          ///< Debe coincidir con el de los espectros de entrada
+    int   sampleRate = 44100;      ///< Frecuencia de muestreo
+    int   hopSize = 1024;          ///< Muestras por frame (blockSize / canales en el DSPWorker)
+    int   windowType = 1;          ///< Ventana de la captura (WindowType, como DSPConfig::windowType)
+    double kaiserBeta = 8.0;
+    double gaussianSigma = 0.4;
+    float minFreqHz = 250.0f;      ///< Banda en la que se buscan picos
+    float maxFreqHz = 5000.0f;
+    int   peaksPerFrame = 5;       ///< Picos más fuertes conservados por frame
+    int   neighborhoodBins = 8;    ///< Radio del máximo local en frecuencia
+    float thresholdDb = 10.0f;     ///< Margen sobre la media de la banda
+    int   minDeltaFrames = 1;      ///< Ventana de emparejamiento ancla -> destino
+    int   maxDeltaFrames = 32;
+    int   maxDeltaBins = 128;      ///< Separación máxima en frecuencia del par
+    int   fanOut = 5;              ///< Pares máximos por ancla
+};
+
+/**
+ * @brief Huella de audio por constelación de picos (landmarks)
+ *
+ * Para cada frame elige los máximos locales más fuertes del espectro y
+ * los empareja con los picos de los frames anteriores dentro de una
+ * ventana temporal. Cada par se codifica en un hash de 32 bits:
+ * 10 bits de bin del ancla, 10 bits de bin del destino y 12 bits de Δt.
+ *
+ * Funciona en streaming (un frame por llamada a process) y también
+ * sobre un clip completo con fingerprintClip(), que lo trocea como la
+ * captura (bloques de hopSize, ventana de la configuración, relleno con
+ * ceros hasta fftSize), de modo que los hashes de una consulta son
+ * comparables con los almacenados durante la captura.
+ */
+class Fingerprinter
+{
+public:
+    explicit Fingerprinter(const FingerprintConfig& config);
+
+    FingerprintConfig getConfig() const { return m_config; }
+    void setConfig(const FingerprintConfig& config);
+
+    /** Descarta los picos pendientes de emparejar */
+    void reset();
+
+    /** Procesa el espectro de un frame y devuelve los hashes nuevos */
+    QVector<FingerprintHash> process(const ComplexSpectrum& spectrum, qint64 frameIndex);
+
+    /**
+     * @brief Calcula las huellas de un clip completo (frames desde 0)
+     *
+     * Cada bloque completo de hopSize muestras pasa por SpectrogramCalculator
+     * con la misma ventana y FFT que en DSPWorker; el resto final se descarta.
+     */
+    QVector<FingerprintHash> fingerprintClip(const QVector<float>& samples);
+
+private:
+    struct Peak {
+        int bin = 0;
+        float db = 0.0f;
+        int pairs = 0;
+    };
+
+    struct PeakFrame {
+        qint64 index = 0;
+        QVector<Peak> peaks;
+    };
+
+    QVector<FingerprintHash> processMagnitudes(qint64 frameIndex);
+    void pickPeaks(QVector<Peak>& out) const;
+    quint32 makeHash(int anchorBin, int targetBin, int deltaFrames) const;
+
+    FingerprintConfig m_config;
+    int m_minBin = 0;
+    int m_maxBin = 0;
+    int m_binShift = 0;            ///< Desplazamiento para que el bin quepa en 10 bits
+
+    QVector<float> m_magnitudesDb; ///< Espectro en dB del frame actual
+    QList<PeakFrame> m_history;    ///< Frames recientes con picos ancla
+};
+
+#endif // FINGERPRINTER_H
@@ -0,0 +1,132 @@
+#include "frame_bus.h"
+#include <QDebug>
+#include <algorithm>
+#include <utility>
+
+FrameBus::FrameBus(QObject* parent)
+    : QObject(parent)
+{
+}
+
+FrameBus::SubscriberId FrameBus::subscribe(const FrameSubscription& subscription) {
+    QMutexLocker lock(&m_mutex);
+
+    Mailbox box;
+    box.subscription = subscription;
+    box.subscription.decimation = std::max(1, subscription.decimation);
+    box.subscription.maxQueuedFrames = std::max(1, subscription.maxQueuedFrames);
+
+    const SubscriberId id = m_nextId++;
+    m_mailboxes.insert(id, box);
+    return id;
+}
+
+void FrameBus::unsubscribe(SubscriberId id) {
+    QMutexLocker lock(&m_mutex);
+    m_mailboxes.remove(id);
+}
+
+QVector<FrameData> FrameBus::take(SubscriberId id) {
+    QMutexLocker lock(&m_mutex);
+    auto it = m_mailboxes.find(id);
+    if (it == m_mailboxes.end()) {
+        return {};
+    }
+    return std::exchange(it->frames, QVector<FrameData>());
+}
+
+quint64 FrameBus::droppedFrames(SubscriberId id) const {
+    QMutexLocker lock(&m_mutex);
+    auto it = m_mailboxes.constFind(id);
+    return (it != m_mailboxes.constEnd()) ? it->dropped : 0;
+}
+
+int FrameBus::subscriberCount() const {
+    QMutexLocker lock(&m_mutex);
+    return m_mailboxes.size();
+}
+
+void FrameBus::clear() {
+    QMutexLocker lock(&m_mutex);
+    for (Mailbox& box : m_mailboxes) {
+        box.frames.clear();
+        box.hasLast = false;
+    }
+}
+
+void FrameBus::publish(const QVector<FrameData>& batch) {
+    if (batch.isEmpty()) {
+        return;
+    }
+
+    QMutexLocker lock(&m_mutex);
+
+    for (Mailbox& box : m_mailboxes) {
+        const FrameSubscription& sub = box.subscription;
+        const quint64 intervalNs = quint64(sub.minIntervalMs) * 1000000ULL;
+
+        for (const FrameData& frame : batch) {
+            // Limitar la tasa según el tiempo de audio, no el de reloj
+            if (intervalNs > 0 && box.hasLast &&
+                frame.timestamp >= box.lastTimestamp &&
+                frame.timestamp - box.lastTimestamp < intervalNs) {
+                continue;
+            }
+            box.lastTimestamp = frame.timestamp;
+            box.hasLast = true;
+
+            box.frames.append(sub.detail == FrameDetail::Full ? frame : reduce(frame, sub));
+        }
+
+        // Consumidor lento: conservar lo más reciente
+        const int overflow = box.frames.size() - sub.maxQueuedFrames;
+        if (overflow > 0) {
+            box.frames.remove(0, overflow);
+            box.dropped += overflow;
+        }
+    }
+}
+
+FrameData FrameBus::reduce(const FrameData& frame, const FrameSubscription& subscription) {
+    FrameData out;
+    out.timestamp = frame.timestamp;
+    out.sampleOffset = frame.sampleOffset;
+    out.waveform = frame.waveform;
+    out.peakMin = frame.peakMin;
+    out.peakMax = frame.peakMax;
+    out.peakRms = frame.peakRms;
+    out.windowGain = frame.windowGain;
+
+    if (subscription.detail == FrameDetail::PeaksOnly) {
+        return out;
+    }
+
+    // Decimated: máximo por grupo de bins para no perder picos estrechos.
+    // Un espectro compacto se reduce en float y se vuelve a empaquetar igual.
+    const CompactSpectrum& compact = frame.compactSpectrum;
+    const QVector<float> decoded = compact.isEmpty() ? QVector<float>() : compact.toFloat();
+    const QVector<float>& full = compact.isEmpty() ? frame.spectrum : decoded;
+
+    const int d = subscription.decimation;
+    const int bins = full.size();
+    const int outBins = (bins + d - 1) / d;
+    QVector<float> reduced(outBins);
+    out.frequencies.resize(std::min<int>(outBins, (frame.frequencies.size() + d - 1) / d));
+
+    const float* src = full.constData();
+    for (int i = 0; i < outBins; ++i) {
+        const int start = i * d;
+        const int end = std::min(bins, start + d);
+        reduced[i] = *std::max_element(src + start, src + end);
+    }
+
+    if (compact.isEmpty()) {
+        out.spectrum = std::move(reduced);
+    } else {
+        out.compactSpectrum = CompactSpectrum::encode(reduced, compact.format, compact.minDb, compact.maxDb);
+    }
+    for (int i = 0; i < out.frequencies.size(); ++i) {
+        out.frequencies[i] = frame.frequencies[i * d];
+    }
+    return out;
+}
@@ -0,0 +1,89 @@
+#ifndef FRAME_BUS_H
+#define FRAME_BUS_H
+
+#include "core/dsp_worker.h"
+#include <QHash>
+#include <QMutex>
+#include <QObject>
+#include <QVector>
+#include <QtTypes>
+
+/**
+ * @brief Nivel de detalle que recibe un suscriptor
+ */
+enum class FrameDetail {
+    Full,       ///< FrameData completo (espectro y resultados de análisis)
+    Decimated,  ///< Espectro reducido por máximo cada `decimation` bins
+    PeaksOnly   ///< Sólo forma de onda y metadatos temporales
+};
+
+/**
+ * @brief Preferencias de un consumidor del bus
+ */
+struct FrameSubscription {
+    FrameDetail detail = FrameDetail::Full;
+    int minIntervalMs = 0;         ///< Separación mínima entre frames entregados (0 = todos)
+    int decimation = 4;            ///< Bins fusionados en modo Decimated
+    int maxQueuedFrames = 2048;    ///< Capacidad del buzón; se descartan los más antiguos
+};
+
+/**
+ * @brief Bus de difusión de frames DSP a varios consumidores
+ *
+ * Sustituye a las copias y lambdas encoladas por vista: el DSPWorker
+ * publica cada lote una sola vez (conexión directa, en el hilo DSP) y el
+ * bus deja en el buzón de cada suscriptor únicamente lo que pidió. Cada
+ * consumidor vacía su buzón en su propio tick con take(), por lo que la
+ * cola de eventos del hilo GUI no recibe nada por lote.
+ *
+ * Los FrameData se comparten implícitamente: en modo Full no hay copia
+ * profunda de los vectores. Todas las operaciones son thread-safe.
+ */
+class FrameBus : public QObject
+{
+    Q_OBJECT
+
+public:
+    using SubscriberId = int;
+
+    explicit FrameBus(QObject* parent = nullptr);
+
+    /** Registra un consumidor y devuelve su identificador */
+    SubscriberId subscribe(const FrameSubscription& subscription);
+
+    /** Elimina un consumidor y su buzón */
+    void unsubscribe(SubscriberId id);
+
+    /** Vacía y devuelve el buzón del consumidor (llamar desde su tick) */
+    QVector<FrameData> take(SubscriberId id);
+
+    /** Frames descartados por buzón lleno */
+    quint64 droppedFrames(SubscriberId id) const;
+
+    /** Número de consumidores registrados */
+    int subscriberCount() const;
+
+public slots:
+    /** Publica un lote; puede llamarse desde cualquier hilo */
+    void publish(const QVector<FrameData>& batch);
+
+    /** Vacía todos los buzones (p. ej. al reiniciar la captura) */
+    void clear();
+
+private:
+    struct Mailbox {
+        FrameSubscription subscription;
+        QVector<FrameData> frames;
+        quint64 lastTimestamp = 0;
+        bool hasLast = false;
+        quint64 dropped = 0;
+    };
+
+    static FrameData reduce(const FrameData& frame, const FrameSubscription& subscription);
+
+    mutable QMutex m_mutex;
+    QHash<SubscriberId, Mailbox> m_mailboxes;
+    SubscriberId m_nextId = 1;
+};
+
+#endif // FRAME_BUS_H
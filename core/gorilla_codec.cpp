@@ -0,0 +1,309 @@
+#include "gorilla_codec.h"
+#include <QtAlgorithms>
+#include <QtEndian>
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+constexpr int kHeaderSize = 8;
+
+/** Lector MSB primero que recarga de 64 en 64 bits */
+class BitReader
+{
+public:
+    BitReader(const uchar* data, qsizetype size) : m_p(data), m_end(data + size) {}
+
+    bool overrun() const { return m_overrun; }
+
+    bool readBit() {
+        if (m_avail == 0) refill();
+        const bool bit = (m_buf >> 63) != 0;
+        m_buf <<= 1;
+        --m_avail;
+        return bit;
+    }
+
+    quint64 read(int count) {
+        quint64 value = 0;
+        while (count > 0) {
+            if (m_avail == 0) refill();
+            const int take = std::min(count, m_avail);
+            const quint64 bits = m_buf >> (64 - take);
+            m_buf = take == 64 ? 0 : m_buf << take;
+            m_avail -= take;
+            value = take == 64 ? bits : (value << take) | bits;
+            count -= take;
+        }
+        return value;
+    }
+
+private:
+    void refill() {
+        if (m_end - m_p >= 8) {
+            m_buf = qFromBigEndian<quint64>(m_p);
+            m_p += 8;
+            m_avail = 64;
+            return;
+        }
+        m_buf = 0;
+        int loaded = 0;
+        while (m_p < m_end) {
+            m_buf |= quint64(*m_p++) << (56 - loaded);
+            loaded += 8;
+        }
+        if (loaded == 0) {
+            // Fin del flujo: ceros, y el chunk se rechaza al terminar
+            m_overrun = true;
+            loaded = 64;
+        }
+        m_avail = loaded;
+    }
+
+    const uchar* m_p;
+    const uchar* m_end;
+    quint64 m_buf = 0;
+    int m_avail = 0;
+    bool m_overrun = false;
+};
+
+qint64 readDelta(BitReader& in) {
+    if (!in.readBit()) return 0;
+    if (!in.readBit()) return qint64(in.read(7)) - 63;
+    if (!in.readBit()) return qint64(in.read(9)) - 255;
+    if (!in.readBit()) return qint64(in.read(12)) - 2047;
+    return qint64(in.read(64));
+}
+
+// Aritmética modular: cualquier secuencia de qint64 ida y vuelta sin UB
+inline qint64 wrapSub(qint64 a, qint64 b) { return qint64(quint64(a) - quint64(b)); }
+inline qint64 wrapAdd(qint64 a, qint64 b) { return qint64(quint64(a) + quint64(b)); }
+
+} // namespace
+
+// ============================================================================
+// GorillaEncoder
+// ============================================================================
+
+GorillaEncoder::GorillaEncoder(int intColumns, int floatColumns)
+    : m_prevInt(std::max(0, intColumns))
+    , m_prevDelta(std::max(0, intColumns))
+    , m_prevFloat(std::max(0, floatColumns))
+    , m_prevLeading(std::max(0, floatColumns), -1)
+    , m_prevTrailing(std::max(0, floatColumns), 0)
+{
+}
+
+void GorillaEncoder::clear() {
+    m_bytes.clear();
+    m_acc = 0;
+    m_accBits = 0;
+    m_bits = 0;
+    m_rows = 0;
+    m_prevInt.fill(0);
+    m_prevDelta.fill(0);
+    m_prevFloat.fill(0);
+    m_prevLeading.fill(-1);
+    m_prevTrailing.fill(0);
+}
+
+void GorillaEncoder::writeBits(quint64 value, int count) {
+    m_bits += count;
+    while (count > 0) {
+        const int take = std::min(64 - m_accBits, count);
+        const quint64 mask = take == 64 ? ~quint64(0) : (quint64(1) << take) - 1;
+        const quint64 bits = (value >> (count - take)) & mask;
+        m_acc = take == 64 ? bits : (m_acc << take) | bits;
+        m_accBits += take;
+        count -= take;
+
+        if (m_accBits == 64) {
+            const qsizetype at = m_bytes.size();
+            m_bytes.resize(at + 8);
+            qToBigEndian<quint64>(m_acc, m_bytes.data() + at);
+            m_acc = 0;
+            m_accBits = 0;
+        }
+    }
+}
+
+void GorillaEncoder::writeDelta(qint64 dod) {
+    if (dod == 0) {
+        writeBits(0b0, 1);
+    } else if (dod >= -63 && dod <= 64) {
+        writeBits(0b10, 2);
+        writeBits(quint64(dod + 63), 7);
+    } else if (dod >= -255 && dod <= 256) {
+        writeBits(0b110, 3);
+        writeBits(quint64(dod + 255), 9);
+    } else if (dod >= -2047 && dod <= 2048) {
+        writeBits(0b1110, 4);
+        writeBits(quint64(dod + 2047), 12);
+    } else {
+        writeBits(0b1111, 4);
+        writeBits(quint64(dod), 64);
+    }
+}
+
+void GorillaEncoder::writeFloat(int column, quint32 bits) {
+    const quint32 x = bits ^ m_prevFloat[column];
+    m_prevFloat[column] = bits;
+
+    if (x == 0) {
+        writeBits(0b0, 1);
+        return;
+    }
+
+    const int leading = int(qCountLeadingZeroBits(x));
+    const int trailing = int(qCountTrailingZeroBits(x));
+    const int prevLeading = m_prevLeading[column];
+    const int prevTrailing = m_prevTrailing[column];
+
+    if (prevLeading >= 0 && leading >= prevLeading && trailing >= prevTrailing) {
+        // Cabe en la ventana anterior: sólo los bits significativos
+        writeBits(0b10, 2);
+        writeBits(x >> prevTrailing, 32 - prevLeading - prevTrailing);
+    } else {
+        const int length = 32 - leading - trailing;
+        writeBits(0b11, 2);
+        writeBits(quint64(leading), 5);
+        writeBits(quint64(length - 1), 5);
+        writeBits(x >> trailing, length);
+        m_prevLeading[column] = leading;
+        m_prevTrailing[column] = trailing;
+    }
+}
+
+void GorillaEncoder::append(const qint64* ints, const float* floats) {
+    const int ic = m_prevInt.size();
+    const int fc = m_prevFloat.size();
+
+    if (m_rows == 0) {
+        for (int c = 0; c < ic; ++c) {
+            writeBits(quint64(ints[c]), 64);
+            m_prevInt[c] = ints[c];
+            m_prevDelta[c] = 0;
+        }
+        for (int c = 0; c < fc; ++c) {
+            quint32 bits;
+            std::memcpy(&bits, &floats[c], sizeof(bits));
+            writeBits(bits, 32);
+            m_prevFloat[c] = bits;
+        }
+    } else {
+        for (int c = 0; c < ic; ++c) {
+            const qint64 delta = wrapSub(ints[c], m_prevInt[c]);
+            writeDelta(wrapSub(delta, m_prevDelta[c]));
+            m_prevDelta[c] = delta;
+            m_prevInt[c] = ints[c];
+        }
+        for (int c = 0; c < fc; ++c) {
+            quint32 bits;
+            std::memcpy(&bits, &floats[c], sizeof(bits));
+            writeFloat(c, bits);
+        }
+    }
+    ++m_rows;
+}
+
+QByteArray GorillaEncoder::data() const {
+    const int pendingBytes = (m_accBits + 7) / 8;
+
+    QByteArray out(kHeaderSize + m_bytes.size() + pendingBytes, Qt::Uninitialized);
+    char* p = out.data();
+    qToLittleEndian<quint16>(quint16(m_prevInt.size()), p);
+    qToLittleEndian<quint16>(quint16(m_prevFloat.size()), p + 2);
+    qToLittleEndian<quint32>(quint32(m_rows), p + 4);
+    std::memcpy(p + kHeaderSize, m_bytes.constData(), size_t(m_bytes.size()));
+
+    // Bits pendientes alineados a la izquierda, sin cerrar el encoder
+    if (m_accBits > 0) {
+        const quint64 aligned = m_acc << (64 - m_accBits);
+        char* tail = p + kHeaderSize + m_bytes.size();
+        for (int i = 0; i < pendingBytes; ++i) {
+            tail[i] = char(aligned >> (56 - 8 * i));
+        }
+    }
+    return out;
+}
+
+// ============================================================================
+// GorillaDecoder
+// ============================================================================
+
+int GorillaDecoder::rowCount(const QByteArray& chunk) {
+    if (chunk.size() < kHeaderSize) return 0;
+    return int(qFromLittleEndian<quint32>(chunk.constData() + 4));
+}
+
+bool GorillaDecoder::decode(const QByteArray& chunk, GorillaColumns& out) {
+    out = GorillaColumns();
+    if (chunk.size() < kHeaderSize) return false;
+
+    const char* p = chunk.constData();
+    const int ic = qFromLittleEndian<quint16>(p);
+    const int fc = qFromLittleEndian<quint16>(p + 2);
+    const qint64 rows = qFromLittleEndian<quint32>(p + 4);
+
+    // Cada fila ocupa al menos un bit por columna: descarta cabeceras absurdas
+    const qint64 streamBits = qint64(chunk.size() - kHeaderSize) * 8;
+    if (rows > 0 && (ic + fc == 0 || rows * (ic + fc) > streamBits + 64 * ic + 32 * fc)) {
+        return false;
+    }
+
+    out.rows = int(rows);
+    out.ints = QVector<QVector<qint64>>(ic, QVector<qint64>(out.rows));
+    out.floats = QVector<QVector<float>>(fc, QVector<float>(out.rows));
+
+    QVector<qint64> prevInt(ic), prevDelta(ic);
+    QVector<quint32> prevFloat(fc);
+    QVector<int> prevLeading(fc, -1), prevTrailing(fc, 0);
+
+    BitReader in(reinterpret_cast<const uchar*>(p + kHeaderSize), chunk.size() - kHeaderSize);
+    auto fail = [&out]() {
+        out = GorillaColumns();
+        return false;
+    };
+
+    for (int r = 0; r < out.rows; ++r) {
+        for (int c = 0; c < ic; ++c) {
+            qint64 v;
+            if (r == 0) {
+                v = qint64(in.read(64));
+            } else {
+                prevDelta[c] = wrapAdd(prevDelta[c], readDelta(in));
+                v = wrapAdd(prevInt[c], prevDelta[c]);
+            }
+            prevInt[c] = v;
+            out.ints[c][r] = v;
+        }
+
+        for (int c = 0; c < fc; ++c) {
+            quint32 bits;
+            if (r == 0) {
+                bits = quint32(in.read(32));
+            } else if (!in.readBit()) {
+                bits = prevFloat[c];
+            } else if (!in.readBit()) {
+                if (prevLeading[c] < 0) return fail();
+                const int length = 32 - prevLeading[c] - prevTrailing[c];
+                bits = prevFloat[c] ^ (quint32(in.read(length)) << prevTrailing[c]);
+            } else {
+                const int leading = int(in.read(5));
+                const int length = int(in.read(5)) + 1;
+                const int trailing = 32 - leading - length;
+                if (trailing < 0) return fail();
+                bits = prevFloat[c] ^ (quint32(in.read(length)) << trailing);
+                prevLeading[c] = leading;
+                prevTrailing[c] = trailing;
+            }
+            prevFloat[c] = bits;
+            std::memcpy(&out.floats[c][r], &bits, sizeof(bits));
+        }
+
+        if (in.overrun()) {
+            return fail();
+        }
+    }
+    return true;
+}
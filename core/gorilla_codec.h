@@ -0,0 +1,92 @@
+#ifndef GORILLA_CODEC_H
+#define GORILLA_CODEC_H
+
+#include <QByteArray>
+#include <QVector>
+#include <QtTypes>
+
+/**
+ * @brief Compresión de series temporales al estilo Gorilla
+ *
+ * Cada fila tiene `intColumns` enteros de 64 bits (timestamp, bloque,
+ * offset...) y `floatColumns` floats de 32 bits (min, max, descriptores).
+ * Los enteros se codifican por delta-of-delta: con paso constante, cada
+ * valor ocupa 1 bit, y un jitter de ±63 ocupa 9. Los floats se codifican
+ * por XOR con el valor anterior de su columna. Si la ventana de bits
+ * significativos cabe en la anterior se reutiliza; si no, se escribe con
+ * 5+5 bits de cabecera. Las filas se escriben seguidas, así que el
+ * flujo se puede cortar en cualquier fila.
+ *
+ * Formato: u16 intColumns | u16 floatColumns | u32 filas | flujo de bits
+ * (MSB primero). Los valores ordenados casi periódicos, como los
+ * timestamps del DSP o los picos de bloques consecutivos, ocupan entre
+ * 5 y 10 veces menos que en filas SQL.
+ */
+class GorillaEncoder
+{
+public:
+    GorillaEncoder(int intColumns, int floatColumns);
+
+    void clear();
+
+    /** Añade una fila: `ints` con intColumns valores y `floats` con floatColumns */
+    void append(const qint64* ints, const float* floats);
+
+    int rowCount() const { return m_rows; }
+    int intColumns() const { return m_prevInt.size(); }
+    int floatColumns() const { return m_prevFloat.size(); }
+
+    /** Último valor de una columna entera (p. ej. el último timestamp) */
+    qint64 lastInt(int column) const { return m_prevInt[column]; }
+
+    /** Chunk codificado con las filas añadidas hasta ahora (no lo cierra) */
+    QByteArray data() const;
+
+    /** Bytes ocupados hasta ahora */
+    int sizeBytes() const { return 8 + int((m_bits + 7) / 8); }
+
+private:
+    void writeBits(quint64 value, int count);
+    void writeDelta(qint64 dod);
+    void writeFloat(int column, quint32 bits);
+
+    QByteArray m_bytes;          ///< Bytes completos del flujo
+    quint64 m_acc = 0;           ///< Bits pendientes (alineados a la derecha)
+    int m_accBits = 0;
+    qint64 m_bits = 0;
+    int m_rows = 0;
+
+    QVector<qint64> m_prevInt;
+    QVector<qint64> m_prevDelta;
+    QVector<quint32> m_prevFloat;
+    QVector<int> m_prevLeading;  ///< -1 = sin ventana todavía
+    QVector<int> m_prevTrailing;
+};
+
+/**
+ * @brief Columnas decodificadas de un chunk
+ *
+ * `ints[c][i]` y `floats[c][i]` son el valor de la fila i en la columna c.
+ */
+struct GorillaColumns {
+    int rows = 0;
+    QVector<QVector<qint64>> ints;
+    QVector<QVector<float>> floats;
+};
+
+namespace GorillaDecoder {
+
+/**
+ * @brief Decodifica un chunk de GorillaEncoder::data()
+ *
+ * Decodificador escalar en una pasada que lee el flujo de 64 en 64 bits.
+ * Devuelve false si el chunk está truncado o dañado.
+ */
+bool decode(const QByteArray& chunk, GorillaColumns& out);
+
+/** Filas de un chunk sin decodificarlo */
+int rowCount(const QByteArray& chunk);
+
+} // namespace GorillaDecoder
+
+#endif // GORILLA_CODEC_H
@@ -0,0 +1,67 @@
+#include "metrics_registry.h"
+#include <QStringList>
+
+MetricsRegistry& MetricsRegistry::instance() {
+    static MetricsRegistry registry;
+    return registry;
+}
+
+void MetricsRegistry::setValue(const QString& name, double value) {
+    QMutexLocker lock(&m_mutex);
+    m_values.insert(name, value);
+}
+
+void MetricsRegistry::addToCounter(const QString& name, double delta) {
+    QMutexLocker lock(&m_mutex);
+    m_values[name] += delta;
+}
+
+double MetricsRegistry::value(const QString& name, double defaultValue) const {
+    QMutexLocker lock(&m_mutex);
+    return m_values.value(name, defaultValue);
+}
+
+bool MetricsRegistry::contains(const QString& name) const {
+    QMutexLocker lock(&m_mutex);
+    return m_values.contains(name);
+}
+
+QMap<QString, double> MetricsRegistry::snapshot(const QString& prefix) const {
+    QMutexLocker lock(&m_mutex);
+    if (prefix.isEmpty()) {
+        return m_values;
+    }
+
+    // QMap está ordenado: las claves con el prefijo son contiguas
+    QMap<QString, double> result;
+    for (auto it = m_values.lowerBound(prefix); it != m_values.cend() && it.key().startsWith(prefix); ++it) {
+        result.insert(it.key(), it.value());
+    }
+    return result;
+}
+
+void MetricsRegistry::removePrefix(const QString& prefix) {
+    QMutexLocker lock(&m_mutex);
+    auto it = m_values.lowerBound(prefix);
+    while (it != m_values.end() && it.key().startsWith(prefix)) {
+        it = m_values.erase(it);
+    }
+}
+
+void MetricsRegistry::remove(const QStringList& names) {
+    QMutexLocker lock(&m_mutex);
+    for (const QString& name : names) {
+        m_values.remove(name);
+    }
+}
+
+QString MetricsRegistry::report(const QString& prefix) const {
+    const QMap<QString, double> values = snapshot(prefix);
+
+    QStringList lines;
+    lines << "Métricas:";
+    for (auto it = values.cbegin(); it != values.cend(); ++it) {
+        lines << QString("  %1 %2").arg(it.key(), -40).arg(it.value(), 0, 'g', 6);
+    }
+    return lines.join('\n');
+}
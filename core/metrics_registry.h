@@ -0,0 +1,51 @@
+#ifndef METRICS_REGISTRY_H
+#define METRICS_REGISTRY_H
+
+#include <QMap>
+#include <QMutex>
+#include <QString>
+#include <QStringList>
+
+/**
+ * @brief Registro global de métricas con nombre (valores double)
+ *
+ * Los componentes publican aquí sus medidas con nombres jerárquicos
+ * separados por puntos ("render.waveform.paint.p99_ms") para poder
+ * consultarlas en campo sin perfilador: snapshot() por prefijo o report()
+ * como texto. Thread-safe; pensado para publicaciones de baja frecuencia
+ * (del orden de una por segundo y componente), no para cada muestra.
+ */
+class MetricsRegistry
+{
+public:
+    static MetricsRegistry& instance();
+
+    /** Fija el valor actual de una métrica */
+    void setValue(const QString& name, double value);
+
+    /** Suma `delta` a un contador (se crea a 0 si no existe) */
+    void addToCounter(const QString& name, double delta = 1.0);
+
+    double value(const QString& name, double defaultValue = 0.0) const;
+    bool contains(const QString& name) const;
+
+    /** Métricas cuyo nombre empieza por `prefix` (vacío = todas) */
+    QMap<QString, double> snapshot(const QString& prefix = QString()) const;
+
+    /** Elimina las métricas con ese prefijo (p. ej. al destruir una vista) */
+    void removePrefix(const QString& prefix);
+
+    /** Elimina exactamente esas métricas (no toca las que sólo comparten prefijo) */
+    void remove(const QStringList& names);
+
+    /** Informe legible: una métrica por línea, ordenadas por nombre */
+    QString report(const QString& prefix = QString()) const;
+
+private:
+    MetricsRegistry() = default;
+
+    mutable QMutex m_mutex;
+    QMap<QString, double> m_values;
+};
+
+#endif // METRICS_REGISTRY_H
@@ -0,0 +1,149 @@
+#include "render_timing_stats.h"
+#include "metrics_registry.h"
+#include <algorithm>
+#include <cmath>
+
+RenderTimingStats::RenderTimingStats(const QString& name, int window)
+    : m_name(name)
+    , m_window(std::max(1, window))
+{
+    for (Ring& ring : m_stages) {
+        ring.samples.resize(m_window);
+    }
+}
+
+RenderTimingStats::~RenderTimingStats() {
+    MetricsRegistry::instance().remove(metricNames());
+}
+
+void RenderTimingStats::setName(const QString& name) {
+    if (name == m_name) {
+        return;
+    }
+    MetricsRegistry::instance().remove(metricNames());
+    m_name = name;
+    m_publishTimer.invalidate();
+}
+
+const char* RenderTimingStats::stageName(Stage stage) {
+    switch (stage) {
+    case ProcessFrames: return "process_frames";
+    case ImageUpdate:   return "image_update";
+    case Paint:         return "paint";
+    default:            return "unknown";
+    }
+}
+
+void RenderTimingStats::record(Stage stage, qint64 nanoseconds) {
+    if (stage < 0 || stage >= StageCount) {
+        return;
+    }
+    Ring& ring = m_stages[stage];
+    ring.samples[ring.next] = nanoseconds;
+    ring.next = (ring.next + 1) % m_window;
+    ring.count = std::min(ring.count + 1, m_window);
+    ring.last = nanoseconds;
+}
+
+void RenderTimingStats::recordTick(int framesTaken, quint64 droppedTotal) {
+    if (framesTaken > 1) {
+        m_coalesced += quint64(framesTaken - 1);
+    }
+    // Tras reset() o un cambio de suscripción el acumulado del bus no vuelve a 0
+    if (droppedTotal < m_droppedBase) {
+        m_droppedBase = 0;
+    }
+    m_droppedRaw = droppedTotal;
+    m_dropped = droppedTotal - m_droppedBase;
+}
+
+RenderTimingStats::Summary RenderTimingStats::summary(Stage stage) const {
+    Summary s;
+    if (stage < 0 || stage >= StageCount) {
+        return s;
+    }
+    const Ring& ring = m_stages[stage];
+    if (ring.count == 0) {
+        return s;
+    }
+
+    // Con el anillo lleno todas las posiciones son válidas; si no, las primeras count
+    m_scratch.resize(ring.count);
+    std::copy(ring.samples.cbegin(), ring.samples.cbegin() + ring.count, m_scratch.begin());
+
+    qint64 total = 0;
+    for (qint64 v : m_scratch) {
+        total += v;
+    }
+
+    // Percentil 99 por rango más cercano
+    const int rank = std::max(0, int(std::ceil(0.99 * ring.count)) - 1);
+    std::nth_element(m_scratch.begin(), m_scratch.begin() + rank, m_scratch.end());
+
+    s.lastMs = ring.last / 1.0e6;
+    s.avgMs = double(total) / ring.count / 1.0e6;
+    s.p99Ms = m_scratch[rank] / 1.0e6;
+    s.samples = ring.count;
+    return s;
+}
+
+QStringList RenderTimingStats::hudLines() const {
+    QStringList lines;
+    for (int i = 0; i < StageCount; ++i) {
+        const Stage stage = Stage(i);
+        const Summary s = summary(stage);
+        lines << QString("%1 %2 / %3 / %4 ms")
+                     .arg(QLatin1String(stageName(stage)), -15)
+                     .arg(s.lastMs, 0, 'f', 2)
+                     .arg(s.avgMs, 0, 'f', 2)
+                     .arg(s.p99Ms, 0, 'f', 2);
+    }
+    lines << QString("descartados %1 | fusionados %2").arg(m_dropped).arg(m_coalesced);
+    return lines;
+}
+
+void RenderTimingStats::publishIfDue(qint64 intervalMs) {
+    if (m_publishTimer.isValid() && m_publishTimer.elapsed() < intervalMs) {
+        return;
+    }
+    publish();
+    m_publishTimer.start();
+}
+
+QStringList RenderTimingStats::metricNames() const {
+    const QString prefix = metricPrefix();
+    QStringList names;
+    for (int i = 0; i < StageCount; ++i) {
+        const QString base = prefix + QLatin1String(stageName(Stage(i)));
+        names << base + ".last_ms" << base + ".avg_ms" << base + ".p99_ms";
+    }
+    names << prefix + "dropped_frames" << prefix + "coalesced_frames";
+    return names;
+}
+
+void RenderTimingStats::publish() {
+    MetricsRegistry& registry = MetricsRegistry::instance();
+    const QString prefix = metricPrefix();
+
+    for (int i = 0; i < StageCount; ++i) {
+        const Stage stage = Stage(i);
+        const Summary s = summary(stage);
+        const QString base = prefix + QLatin1String(stageName(stage));
+        registry.setValue(base + ".last_ms", s.lastMs);
+        registry.setValue(base + ".avg_ms", s.avgMs);
+        registry.setValue(base + ".p99_ms", s.p99Ms);
+    }
+    registry.setValue(prefix + "dropped_frames", double(m_dropped));
+    registry.setValue(prefix + "coalesced_frames", double(m_coalesced));
+}
+
+void RenderTimingStats::reset() {
+    for (Ring& ring : m_stages) {
+        ring.next = 0;
+        ring.count = 0;
+        ring.last = 0;
+    }
+    m_coalesced = 0;
+    m_dropped = 0;
+    m_droppedBase = m_droppedRaw;
+}
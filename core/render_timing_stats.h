@@ -0,0 +1,115 @@
+#ifndef RENDER_TIMING_STATS_H
+#define RENDER_TIMING_STATS_H
+
+#include <QElapsedTimer>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QtTypes>
+#include <array>
+
+/**
+ * @brief Tiempos de renderizado de una vista (último, media y p99)
+ *
+ * Cada etapa guarda las últimas `window` duraciones en un anillo; la media
+ * y el percentil 99 se calculan sobre esa ventana sólo al consultarlos
+ * (HUD o publicación), así que record() es O(1). También lleva la cuenta
+ * de frames descartados por el FrameBus y de frames fusionados en un
+ * mismo repintado. publishIfDue() vuelca los valores al MetricsRegistry
+ * bajo "render.<nombre>." como mucho una vez por intervalo.
+ *
+ * No es thread-safe: se usa desde el hilo GUI de la vista.
+ */
+class RenderTimingStats
+{
+public:
+    enum Stage {
+        ProcessFrames,   ///< Vaciado del buzón y procesado de frames
+        ImageUpdate,     ///< Regeneración de la imagen o capa de datos
+        Paint,           ///< paintEvent completo
+        StageCount
+    };
+
+    struct Summary {
+        double lastMs = 0.0;
+        double avgMs = 0.0;
+        double p99Ms = 0.0;
+        int samples = 0;
+    };
+
+    /** Mide una etapa desde la construcción hasta la destrucción */
+    class Scope {
+    public:
+        Scope(RenderTimingStats& stats, Stage stage) : m_stats(stats), m_stage(stage) { m_timer.start(); }
+        ~Scope() { m_stats.record(m_stage, m_timer.nsecsElapsed()); }
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        RenderTimingStats& m_stats;
+        Stage m_stage;
+        QElapsedTimer m_timer;
+    };
+
+    explicit RenderTimingStats(const QString& name, int window = 256);
+    ~RenderTimingStats();
+
+    /** Cambia el nombre bajo el que se publica (retira el anterior del registro) */
+    void setName(const QString& name);
+    QString name() const { return m_name; }
+
+    void record(Stage stage, qint64 nanoseconds);
+
+    /**
+     * @brief Registra un tick de la vista
+     * @param framesTaken Frames sacados del buzón en este tick; todos salvo
+     *        uno se fusionan en el mismo repintado
+     * @param droppedTotal Acumulado de FrameBus::droppedFrames()
+     */
+    void recordTick(int framesTaken, quint64 droppedTotal);
+
+    Summary summary(Stage stage) const;
+    quint64 droppedFrames() const { return m_dropped; }
+    quint64 coalescedFrames() const { return m_coalesced; }
+
+    /** Texto del HUD: una línea por etapa y otra con los contadores */
+    QStringList hudLines() const;
+
+    /** Publica en el MetricsRegistry si ha pasado `intervalMs` desde la última vez */
+    void publishIfDue(qint64 intervalMs = 1000);
+    void publish();
+
+    void reset();
+
+    static const char* stageName(Stage stage);
+
+private:
+    struct Ring {
+        QVector<qint64> samples;   ///< Duraciones en ns
+        int next = 0;
+        int count = 0;
+        qint64 last = 0;
+    };
+
+    QString metricPrefix() const { return QStringLiteral("render.%1.").arg(m_name); }
+
+    /**
+     * @brief Nombres exactos publicados por esta instancia
+     *
+     * Al retirarlos no se usa el prefijo: "render.waveform." también
+     * cubriría las vistas "waveform.overviewN".
+     */
+    QStringList metricNames() const;
+
+    QString m_name;
+    int m_window;
+    std::array<Ring, StageCount> m_stages;
+    quint64 m_dropped = 0;
+    quint64 m_droppedRaw = 0;    ///< Último acumulado recibido del bus
+    quint64 m_droppedBase = 0;   ///< Acumulado en el último reset()
+    quint64 m_coalesced = 0;
+    QElapsedTimer m_publishTimer;
+    mutable QVector<qint64> m_scratch;   ///< Copia para nth_element del p99
+};
+
+#endif // RENDER_TIMING_STATS_H
@@ -0,0 +1,180 @@
+#include "rollup_aggregator.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+constexpr qint64 kLevelWidthNs[RollupAggregator::LevelCount] = {
+    1'000'000'000LL,        // 1 s
+    60'000'000'000LL,       // 1 min
+    3'600'000'000'000LL     // 1 h
+};
+constexpr double kSilenceDb = -200.0;
+}
+
+// ============================================================================
+// RollupBucket
+// ============================================================================
+
+double RollupBucket::rms() const {
+    return blockCount > 0 ? std::sqrt(sumSquares / double(blockCount)) : 0.0;
+}
+
+double RollupBucket::leqDb() const {
+    const double meanSquare = blockCount > 0 ? sumSquares / double(blockCount) : 0.0;
+    return meanSquare > 0.0 ? std::max(kSilenceDb, 10.0 * std::log10(meanSquare)) : kSilenceDb;
+}
+
+void RollupBucket::merge(const RollupBucket& other) {
+    if (other.isEmpty()) {
+        return;
+    }
+    if (isEmpty()) {
+        minValue = other.minValue;
+        maxValue = other.maxValue;
+        lastNs = other.lastNs;
+    } else {
+        minValue = std::min(minValue, other.minValue);
+        maxValue = std::max(maxValue, other.maxValue);
+        lastNs = std::max(lastNs, other.lastNs);
+    }
+    blockCount += other.blockCount;
+    sumSquares += other.sumSquares;
+    peakCount += other.peakCount;
+    eventCount += other.eventCount;
+}
+
+// ============================================================================
+// RollupAggregator
+// ============================================================================
+
+qint64 RollupAggregator::levelWidthNs(int level) {
+    return kLevelWidthNs[std::clamp(level, 0, LevelCount - 1)];
+}
+
+int RollupAggregator::levelForResolution(qint64 resolutionNs) {
+    for (int level = LevelCount - 1; level >= 0; --level) {
+        if (kLevelWidthNs[level] <= resolutionNs) {
+            return level;
+        }
+    }
+    return -1;
+}
+
+qint64 RollupAggregator::bucketStart(int level, qint64 timestampNs) {
+    const qint64 width = levelWidthNs(level);
+    const qint64 rem = timestampNs % width;
+    return timestampNs - (rem < 0 ? rem + width : rem);
+}
+
+RollupAggregator::RollupAggregator(float peakThreshold)
+    : m_peakThreshold(peakThreshold)
+{
+}
+
+void RollupAggregator::clear() {
+    m_aboveThreshold = false;
+    for (RollupBucket& b : m_open) {
+        b = RollupBucket();
+    }
+}
+
+void RollupAggregator::addBlock(qint64 timestampNs, float minValue, float maxValue, float rmsValue,
+                                QVector<RollupBucket>* changed) {
+    RollupBucket& second = m_open[0];
+    const qint64 start = bucketStart(0, timestampNs);
+
+    if (!second.isEmpty() && second.startNs != start) {
+        const qsizetype firstChanged = changed ? changed->size() : 0;
+        const RollupBucket closed = second;
+        if (changed) changed->append(closed);
+        fold(1, closed, changed);
+        second = RollupBucket();
+
+        // La hora en curso también se publica cada segundo, con el minuto
+        // abierto sin plegar; si el pliegue ya la añadió se sustituye
+        if (changed) {
+            const RollupBucket top = current(LevelCount - 1);
+            auto it = std::find_if(changed->begin() + firstChanged, changed->end(),
+                                   [&top](const RollupBucket& b) {
+                                       return b.level == top.level && b.startNs == top.startNs;
+                                   });
+            if (it != changed->end()) {
+                *it = top;
+            } else {
+                changed->append(top);
+            }
+        }
+    }
+    if (second.isEmpty()) {
+        second.level = 0;
+        second.startNs = start;
+    }
+
+    // Un evento es la entrada en un tramo de bloques por encima del umbral
+    const bool above = std::max(std::abs(minValue), std::abs(maxValue)) >= m_peakThreshold;
+
+    RollupBucket block;
+    block.lastNs = timestampNs;
+    block.blockCount = 1;
+    block.minValue = minValue;
+    block.maxValue = maxValue;
+    block.sumSquares = double(rmsValue) * rmsValue;
+    block.peakCount = above ? 1 : 0;
+    block.eventCount = above && !m_aboveThreshold ? 1 : 0;
+    second.merge(block);
+    m_aboveThreshold = above;
+}
+
+void RollupAggregator::fold(int level, const RollupBucket& closed, QVector<RollupBucket>* changed) {
+    if (level >= LevelCount) {
+        return;
+    }
+
+    RollupBucket& open = m_open[level];
+    const qint64 start = bucketStart(level, closed.startNs);
+
+    // El estado final de `open` ya se publicó como parcial en el pliegue anterior
+    if (!open.isEmpty() && open.startNs != start) {
+        fold(level + 1, open, changed);
+        open = RollupBucket();
+    }
+    if (open.isEmpty()) {
+        open.level = level;
+        open.startNs = start;
+    }
+    open.merge(closed);
+    if (changed) changed->append(open);
+}
+
+RollupBucket RollupAggregator::current(int level) const {
+    level = std::clamp(level, 0, LevelCount - 1);
+
+    // La ventana la marca el bloque más reciente (el nivel fino no vacío);
+    // un bucket grueso de una ventana anterior ya está completo en la tabla
+    RollupBucket b;
+    for (int l = 0; l <= level; ++l) {
+        if (!m_open[l].isEmpty()) {
+            b.level = level;
+            b.startNs = bucketStart(level, m_open[l].startNs);
+            break;
+        }
+    }
+
+    for (int l = 0; l <= level; ++l) {
+        if (!m_open[l].isEmpty() && bucketStart(level, m_open[l].startNs) == b.startNs) {
+            b.merge(m_open[l]);
+        }
+    }
+    return b;
+}
+
+QVector<RollupBucket> RollupAggregator::currentBuckets() const {
+    QVector<RollupBucket> out;
+    for (int level = 0; level < LevelCount; ++level) {
+        const RollupBucket b = current(level);
+        if (!b.isEmpty()) {
+            out.append(b);
+        }
+    }
+    return out;
+}
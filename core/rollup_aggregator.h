@@ -0,0 +1,90 @@
+#ifndef ROLLUP_AGGREGATOR_H
+#define ROLLUP_AGGREGATOR_H
+
+#include <QVector>
+#include <QtTypes>
+
+/**
+ * @brief Estadísticas de un intervalo de la sesión (bucket de rollup)
+ *
+ * Todos los campos son acumulables, así que un bucket de 1 min es la
+ * mezcla exacta de sus buckets de 1 s. El RMS y el Leq se derivan de la
+ * suma de rms² por bloque (bloques de igual duración).
+ */
+struct RollupBucket {
+    int level = 0;              ///< 0 = 1 s, 1 = 1 min, 2 = 1 h (-1 = un bloque, sin rollup)
+    qint64 startNs = 0;         ///< Inicio del intervalo (múltiplo de su anchura)
+    qint64 lastNs = 0;          ///< Timestamp del último bloque incluido
+    qint64 blockCount = 0;
+    float minValue = 0.0f;
+    float maxValue = 0.0f;
+    double sumSquares = 0.0;    ///< Σ rms² de los bloques
+    qint64 peakCount = 0;       ///< Bloques con |pico| >= umbral
+    qint64 eventCount = 0;      ///< Veces que la señal cruza el umbral hacia arriba
+
+    bool isEmpty() const { return blockCount == 0; }
+
+    /** RMS del intervalo (0 si no hay bloques) */
+    double rms() const;
+
+    /** Nivel equivalente en dBFS, 10·log10(media de rms²); -200 en silencio */
+    double leqDb() const;
+
+    /** Acumula otro bucket (de un intervalo contenido en este) */
+    void merge(const RollupBucket& other);
+};
+
+/**
+ * @brief Rollups de 1 s / 1 min / 1 h mantenidos bloque a bloque
+ *
+ * addBlock() acumula en el bucket abierto de 1 s; al cambiar de segundo el
+ * bucket se cierra y se pliega en el de 1 min, que a su vez se pliega en
+ * el de 1 h al cambiar de minuto. Cada llamada devuelve en `changed` los
+ * buckets que hay que guardar: el segundo recién cerrado y el estado
+ * parcial del minuto y de la hora en curso (ésta con el minuto abierto
+ * sumado). Así la tabla va como mucho 1 s por detrás en todos los niveles
+ * con tres escrituras por segundo.
+ *
+ * Los timestamps deben llegar en orden. No es thread-safe.
+ */
+class RollupAggregator
+{
+public:
+    static constexpr int LevelCount = 3;
+
+    /** Anchura de un nivel en ns */
+    static qint64 levelWidthNs(int level);
+
+    /** Nivel más grueso cuyos buckets no superan `resolutionNs`; -1 si ninguno */
+    static int levelForResolution(qint64 resolutionNs);
+
+    /** Inicio del bucket de `level` que contiene `timestampNs` */
+    static qint64 bucketStart(int level, qint64 timestampNs);
+
+    /** `peakThreshold`: |pico| lineal que cuenta como pico (0.891 ≈ -1 dBFS) */
+    explicit RollupAggregator(float peakThreshold = 0.891f);
+
+    void clear();
+
+    void setPeakThreshold(float threshold) { m_peakThreshold = threshold; }
+    float peakThreshold() const { return m_peakThreshold; }
+
+    /** Añade un bloque; añade a `changed` los buckets modificados que ya se pueden guardar */
+    void addBlock(qint64 timestampNs, float minValue, float maxValue, float rmsValue,
+                  QVector<RollupBucket>* changed = nullptr);
+
+    /** Bucket en curso de un nivel (ventana del último bloque), con los niveles finos sin plegar */
+    RollupBucket current(int level) const;
+
+    /** current() de todos los niveles no vacíos (para volcar al cerrar) */
+    QVector<RollupBucket> currentBuckets() const;
+
+private:
+    void fold(int level, const RollupBucket& closed, QVector<RollupBucket>* changed);
+
+    float m_peakThreshold;
+    bool m_aboveThreshold = false;
+    RollupBucket m_open[LevelCount];
+};
+
+#endif // ROLLUP_AGGREGATOR_H
@@ -0,0 +1,774 @@
+#include "session_file.h"
+#include <QDebug>
+#include <QtEndian>
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+// El formato es little-endian y se lee/escribe copiando la memoria tal cual
+static_assert(Q_BYTE_ORDER == Q_LITTLE_ENDIAN, "session_file: formato little-endian");
+
+namespace {
+
+constexpr char kFileMagic[8]  = { 'T', 'F', 'T', 'S', 'E', 'S', 'S', '1' };
+constexpr char kIndexMagic[8] = { 'T', 'F', 'T', 'S', 'I', 'D', 'X', '1' };
+constexpr char kChunkMagic[4] = { 'C', 'H', 'N', 'K' };
+
+constexpr quint32 kVersion = 1;
+constexpr qint64 kHeaderSize = 64;
+constexpr qint64 kChunkHeaderSize = 48;
+constexpr qint64 kIndexEntrySize = 48;
+constexpr qint64 kTrailerSize = 32;
+constexpr int kTypeSlots = int(SessionChunkType::Events) + 1;
+
+template <typename T>
+void put(QByteArray& out, const T& value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename T>
+void putArray(QByteArray& out, const QVector<T>& values) {
+    out.append(reinterpret_cast<const char*>(values.constData()), values.size() * qsizetype(sizeof(T)));
+}
+
+template <typename T>
+T get(const uchar* p) {
+    T value;
+    std::memcpy(&value, p, sizeof(T));
+    return value;
+}
+
+constexpr qint64 align8(qint64 n) {
+    return (n + 7) & ~qint64(7);
+}
+
+void pad8(QByteArray& out) {
+    out.append(QByteArray(int(align8(out.size()) - out.size()), '\0'));
+}
+
+} // namespace
+
+quint32 sessionCrc32(const char* data, qsizetype size, quint32 crc) {
+    static const std::array<quint32, 256> table = [] {
+        std::array<quint32, 256> t{};
+        for (quint32 i = 0; i < 256; ++i) {
+            quint32 c = i;
+            for (int k = 0; k < 8; ++k) {
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            }
+            t[i] = c;
+        }
+        return t;
+    }();
+
+    crc = ~crc;
+    const auto* p = reinterpret_cast<const uchar*>(data);
+    for (qsizetype i = 0; i < size; ++i) {
+        crc = table[(crc ^ p[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+// ============================================================================
+// SessionFileWriter
+// ============================================================================
+
+SessionFileWriter::SessionFileWriter(int blocksPerChunk)
+    : m_blocksPerChunk(std::max(1, blocksPerChunk))
+{
+}
+
+SessionFileWriter::~SessionFileWriter() {
+    if (isOpen()) {
+        close();
+    }
+}
+
+bool SessionFileWriter::open(const QString& path, const SessionFileHeader& header) {
+    if (isOpen()) {
+        close();
+    }
+
+    m_error.clear();
+    m_index.clear();
+    m_raw = RawPending();
+    m_peaks = PeakPending();
+    m_spectra = SpectrumPending();
+    m_events.clear();
+
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        m_error = m_file.errorString();
+        qWarning() << "SessionFileWriter: no se pudo crear" << path << ":" << m_error;
+        return false;
+    }
+
+    QByteArray bytes;
+    bytes.reserve(kHeaderSize);
+    bytes.append(kFileMagic, sizeof(kFileMagic));
+    put<quint32>(bytes, kVersion);
+    put<quint32>(bytes, quint32(header.sampleRate));
+    put<quint32>(bytes, quint32(header.channels));
+    put<quint32>(bytes, quint32(header.blockSize));
+    put<qint64>(bytes, header.startTimestampNs);
+    bytes.append(QByteArray(int(kHeaderSize - bytes.size()), '\0'));
+
+    if (m_file.write(bytes) != bytes.size()) {
+        fail(m_file.errorString());
+        return false;
+    }
+    return true;
+}
+
+void SessionFileWriter::appendRawBlock(qint64 blockIndex, qint64 sampleOffset, qint64 timestampNs,
+                                       const float* samples, int count) {
+    if (!isOpen() || count <= 0) return;
+
+    // Un chunk sólo contiene bloques consecutivos
+    if (!m_raw.offsets.isEmpty() && blockIndex != m_raw.firstBlock + m_raw.offsets.size()) {
+        flushRaw();
+    }
+    if (m_raw.offsets.isEmpty()) {
+        m_raw.firstBlock = blockIndex;
+    }
+
+    m_raw.offsets.append(sampleOffset);
+    m_raw.timestamps.append(timestampNs);
+    m_raw.counts.append(quint32(count));
+    const qsizetype start = m_raw.samples.size();
+    m_raw.samples.resize(start + count);
+    std::memcpy(m_raw.samples.data() + start, samples, size_t(count) * sizeof(float));
+
+    if (m_raw.offsets.size() >= m_blocksPerChunk) {
+        flushRaw();
+    }
+}
+
+void SessionFileWriter::appendPeak(const SessionPeak& peak) {
+    if (!isOpen()) return;
+
+    if (!m_peaks.offsets.isEmpty() && peak.blockIndex != m_peaks.firstBlock + m_peaks.offsets.size()) {
+        flushPeaks();
+    }
+    if (m_peaks.offsets.isEmpty()) {
+        m_peaks.firstBlock = peak.blockIndex;
+    }
+
+    m_peaks.offsets.append(peak.sampleOffset);
+    m_peaks.timestamps.append(peak.timestampNs);
+    m_peaks.mins.append(peak.minValue);
+    m_peaks.maxs.append(peak.maxValue);
+    m_peaks.rms.append(peak.rmsValue);
+
+    if (m_peaks.offsets.size() >= m_blocksPerChunk) {
+        flushPeaks();
+    }
+}
+
+void SessionFileWriter::appendSpectrum(qint64 blockIndex, qint64 timestampNs, const CompactSpectrum& spectrum) {
+    if (!isOpen() || spectrum.isEmpty()) return;
+
+    // Todas las columnas de un chunk comparten formato, bins y rango
+    SpectrumPending& s = m_spectra;
+    if (!s.timestamps.isEmpty() &&
+        (blockIndex != s.firstBlock + s.timestamps.size() ||
+         spectrum.format != s.format || spectrum.bins != s.bins ||
+         spectrum.minDb != s.minDb || spectrum.maxDb != s.maxDb)) {
+        flushSpectra();
+    }
+    if (s.timestamps.isEmpty()) {
+        s.firstBlock = blockIndex;
+        s.format = spectrum.format;
+        s.bins = spectrum.bins;
+        s.minDb = spectrum.minDb;
+        s.maxDb = spectrum.maxDb;
+    }
+
+    s.timestamps.append(timestampNs);
+    s.data.append(spectrum.data);
+
+    if (s.timestamps.size() >= m_blocksPerChunk) {
+        flushSpectra();
+    }
+}
+
+void SessionFileWriter::appendTile(const SpectrogramTile& tile) {
+    if (!isOpen() || tile.isEmpty()) return;
+
+    QByteArray payload;
+    payload.reserve(16 + tile.data.size());
+    put<qint32>(payload, tile.bins);
+    put<float>(payload, tile.minDb);
+    put<float>(payload, tile.maxDb);
+    put<quint32>(payload, 0);
+    payload.append(tile.data);
+
+    writeChunk(SessionChunkType::Tile, quint16(tile.level), tile.tileIndex, quint32(tile.columns),
+               tile.firstTimestamp, tile.lastTimestamp, payload);
+}
+
+void SessionFileWriter::appendEvent(const SessionEvent& event) {
+    if (!isOpen()) return;
+
+    m_events.append(event);
+    if (m_events.size() >= m_blocksPerChunk) {
+        flushEvents();
+    }
+}
+
+void SessionFileWriter::flushRaw() {
+    RawPending& r = m_raw;
+    const int n = r.offsets.size();
+    if (n == 0) return;
+
+    QByteArray payload;
+    payload.reserve(int(align8(20 * qint64(n)) + r.samples.size() * qint64(sizeof(float))));
+    putArray(payload, r.offsets);
+    putArray(payload, r.timestamps);
+    putArray(payload, r.counts);
+    pad8(payload);
+    putArray(payload, r.samples);
+
+    writeChunk(SessionChunkType::RawAudio, 0, r.firstBlock, quint32(n),
+               r.timestamps.first(), r.timestamps.last(), payload);
+
+    r.offsets.clear();
+    r.timestamps.clear();
+    r.counts.clear();
+    r.samples.clear();
+}
+
+void SessionFileWriter::flushPeaks() {
+    PeakPending& p = m_peaks;
+    const int n = p.offsets.size();
+    if (n == 0) return;
+
+    QByteArray payload;
+    payload.reserve(28 * n);
+    putArray(payload, p.offsets);
+    putArray(payload, p.timestamps);
+    putArray(payload, p.mins);
+    putArray(payload, p.maxs);
+    putArray(payload, p.rms);
+
+    writeChunk(SessionChunkType::Peaks, 0, p.firstBlock, quint32(n),
+               p.timestamps.first(), p.timestamps.last(), payload);
+
+    p.offsets.clear();
+    p.timestamps.clear();
+    p.mins.clear();
+    p.maxs.clear();
+    p.rms.clear();
+}
+
+void SessionFileWriter::flushSpectra() {
+    SpectrumPending& s = m_spectra;
+    const int n = s.timestamps.size();
+    if (n == 0) return;
+
+    QByteArray payload;
+    payload.reserve(16 + 8 * n + s.data.size());
+    put<quint8>(payload, quint8(s.format));
+    payload.append(3, '\0');
+    put<qint32>(payload, s.bins);
+    put<float>(payload, s.minDb);
+    put<float>(payload, s.maxDb);
+    putArray(payload, s.timestamps);
+    payload.append(s.data);
+
+    writeChunk(SessionChunkType::Spectra, 0, s.firstBlock, quint32(n),
+               s.timestamps.first(), s.timestamps.last(), payload);
+
+    s.timestamps.clear();
+    s.data.clear();
+}
+
+void SessionFileWriter::flushEvents() {
+    const int n = m_events.size();
+    if (n == 0) return;
+
+    QByteArray payload;
+    payload.reserve(24 * n);
+    for (const SessionEvent& e : m_events) put<qint64>(payload, e.timestampNs);
+    for (const SessionEvent& e : m_events) put<qint64>(payload, e.blockIndex);
+    for (const SessionEvent& e : m_events) put<quint32>(payload, e.code);
+    for (const SessionEvent& e : m_events) put<float>(payload, e.value);
+
+    writeChunk(SessionChunkType::Events, 0, m_events.first().blockIndex, quint32(n),
+               m_events.first().timestampNs, m_events.last().timestampNs, payload);
+    m_events.clear();
+}
+
+bool SessionFileWriter::writeChunk(SessionChunkType type, quint16 flags, qint64 firstBlock, quint32 blockCount,
+                                   qint64 firstTs, qint64 lastTs, const QByteArray& payload) {
+    if (!isOpen()) return false;
+
+    SessionChunkInfo info;
+    info.type = type;
+    info.flags = flags;
+    info.firstBlock = firstBlock;
+    info.blockCount = blockCount;
+    info.firstTimestampNs = firstTs;
+    info.lastTimestampNs = lastTs;
+    info.offset = quint64(m_file.pos() + kChunkHeaderSize);
+    info.payloadSize = quint32(payload.size());
+    info.crc = sessionCrc32(payload.constData(), payload.size());
+
+    QByteArray header;
+    header.reserve(kChunkHeaderSize);
+    header.append(kChunkMagic, sizeof(kChunkMagic));
+    put<quint16>(header, quint16(type));
+    put<quint16>(header, flags);
+    put<qint64>(header, firstBlock);
+    put<quint32>(header, blockCount);
+    put<quint32>(header, info.payloadSize);
+    put<qint64>(header, firstTs);
+    put<qint64>(header, lastTs);
+    put<quint32>(header, info.crc);
+    put<quint32>(header, 0);
+
+    const QByteArray padding(int(align8(payload.size()) - payload.size()), '\0');
+    if (m_file.write(header) != header.size() ||
+        m_file.write(payload) != payload.size() ||
+        m_file.write(padding) != padding.size()) {
+        fail(m_file.errorString());
+        return false;
+    }
+
+    m_index.append(info);
+    return true;
+}
+
+void SessionFileWriter::flush() {
+    flushRaw();
+    flushPeaks();
+    flushSpectra();
+    flushEvents();
+    if (isOpen()) {
+        m_file.flush();
+    }
+}
+
+bool SessionFileWriter::close() {
+    if (!isOpen()) return false;
+
+    flushRaw();
+    flushPeaks();
+    flushSpectra();
+    flushEvents();
+    if (!isOpen()) return false;   // Falló una escritura
+
+    const quint64 indexOffset = quint64(m_file.pos());
+    QByteArray index;
+    index.reserve(int(m_index.size() * kIndexEntrySize));
+    for (const SessionChunkInfo& c : m_index) {
+        put<quint16>(index, quint16(c.type));
+        put<quint16>(index, c.flags);
+        put<quint32>(index, c.blockCount);
+        put<qint64>(index, c.firstBlock);
+        put<qint64>(index, c.firstTimestampNs);
+        put<qint64>(index, c.lastTimestampNs);
+        put<quint64>(index, c.offset);
+        put<quint32>(index, c.payloadSize);
+        put<quint32>(index, c.crc);
+    }
+
+    QByteArray trailer;
+    trailer.reserve(kTrailerSize);
+    trailer.append(kIndexMagic, sizeof(kIndexMagic));
+    put<quint64>(trailer, indexOffset);
+    put<quint32>(trailer, quint32(m_index.size()));
+    put<quint32>(trailer, sessionCrc32(index.constData(), index.size()));
+    put<quint64>(trailer, indexOffset + quint64(index.size()) + quint64(kTrailerSize));
+
+    if (m_file.write(index) != index.size() || m_file.write(trailer) != trailer.size()) {
+        fail(m_file.errorString());
+        return false;
+    }
+
+    m_file.close();
+    return true;
+}
+
+void SessionFileWriter::fail(const QString& message) {
+    // Tras un error de escritura el fichero queda como sesión interrumpida
+    m_error = message;
+    qWarning() << "SessionFileWriter: error de escritura en" << m_file.fileName() << ":" << message;
+    m_file.close();
+}
+
+// ============================================================================
+// SessionFileReader
+// ============================================================================
+
+SessionFileReader::~SessionFileReader() {
+    close();
+}
+
+bool SessionFileReader::open(const QString& path) {
+    close();
+    m_error.clear();
+
+    auto failOpen = [this](const QString& message) {
+        m_error = message;
+        close();
+        return false;
+    };
+
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        return failOpen(m_file.errorString());
+    }
+
+    m_size = m_file.size();
+    if (m_size < kHeaderSize) {
+        return failOpen(QStringLiteral("fichero demasiado corto"));
+    }
+
+    m_map = m_file.map(0, m_size);
+    if (!m_map) {
+        return failOpen(QStringLiteral("no se pudo mapear: %1").arg(m_file.errorString()));
+    }
+
+    if (std::memcmp(m_map, kFileMagic, sizeof(kFileMagic)) != 0) {
+        return failOpen(QStringLiteral("no es un fichero de sesión"));
+    }
+    const quint32 version = get<quint32>(m_map + 8);
+    if (version != kVersion) {
+        return failOpen(QStringLiteral("versión %1 no soportada").arg(version));
+    }
+
+    m_header.sampleRate = int(get<quint32>(m_map + 12));
+    m_header.channels = int(get<quint32>(m_map + 16));
+    m_header.blockSize = int(get<quint32>(m_map + 20));
+    m_header.startTimestampNs = get<qint64>(m_map + 24);
+
+    if (!readIndexFromFooter()) {
+        // Captura interrumpida: índice a partir de las cabeceras de chunk
+        m_recovered = true;
+        rebuildIndex();
+        qWarning() << "SessionFileReader:" << path << "sin índice válido;"
+                   << m_index.size() << "chunks recuperados";
+    }
+
+    buildTypeIndex();
+    return true;
+}
+
+void SessionFileReader::close() {
+    if (m_map) {
+        m_file.unmap(m_map);
+        m_map = nullptr;
+    }
+    m_file.close();
+    m_size = 0;
+    m_header = SessionFileHeader();
+    m_recovered = false;
+    m_index.clear();
+    m_byType.clear();
+}
+
+bool SessionFileReader::readIndexFromFooter() {
+    if (m_size < kHeaderSize + kTrailerSize) return false;
+
+    const uchar* t = m_map + m_size - kTrailerSize;
+    if (std::memcmp(t, kIndexMagic, sizeof(kIndexMagic)) != 0) return false;
+
+    const quint64 indexOffset = get<quint64>(t + 8);
+    const quint32 count = get<quint32>(t + 16);
+    const quint32 crc = get<quint32>(t + 20);
+    const quint64 fileSize = get<quint64>(t + 24);
+
+    const quint64 indexBytes = quint64(count) * quint64(kIndexEntrySize);
+    if (fileSize != quint64(m_size) || indexOffset < quint64(kHeaderSize) ||
+        indexOffset + indexBytes + quint64(kTrailerSize) != quint64(m_size)) {
+        return false;
+    }
+
+    const uchar* index = m_map + indexOffset;
+    if (sessionCrc32(reinterpret_cast<const char*>(index), qsizetype(indexBytes)) != crc) {
+        return false;
+    }
+
+    QVector<SessionChunkInfo> entries;
+    entries.reserve(int(count));
+    for (quint32 i = 0; i < count; ++i) {
+        const uchar* e = index + i * kIndexEntrySize;
+        SessionChunkInfo c;
+        c.type = SessionChunkType(get<quint16>(e));
+        c.flags = get<quint16>(e + 2);
+        c.blockCount = get<quint32>(e + 4);
+        c.firstBlock = get<qint64>(e + 8);
+        c.firstTimestampNs = get<qint64>(e + 16);
+        c.lastTimestampNs = get<qint64>(e + 24);
+        c.offset = get<quint64>(e + 32);
+        c.payloadSize = get<quint32>(e + 40);
+        c.crc = get<quint32>(e + 44);
+        if (c.offset + c.payloadSize > indexOffset) {
+            return false;
+        }
+        entries.append(c);
+    }
+
+    m_index = entries;
+    return true;
+}
+
+bool SessionFileReader::rebuildIndex() {
+    m_index.clear();
+
+    qint64 pos = kHeaderSize;
+    while (pos + kChunkHeaderSize <= m_size) {
+        const uchar* h = m_map + pos;
+        if (std::memcmp(h, kChunkMagic, sizeof(kChunkMagic)) != 0) {
+            break;
+        }
+
+        SessionChunkInfo c;
+        c.type = SessionChunkType(get<quint16>(h + 4));
+        c.flags = get<quint16>(h + 6);
+        c.firstBlock = get<qint64>(h + 8);
+        c.blockCount = get<quint32>(h + 16);
+        c.payloadSize = get<quint32>(h + 20);
+        c.firstTimestampNs = get<qint64>(h + 24);
+        c.lastTimestampNs = get<qint64>(h + 32);
+        c.crc = get<quint32>(h + 40);
+        c.offset = quint64(pos + kChunkHeaderSize);
+
+        if (qint64(c.offset) + qint64(c.payloadSize) > m_size) {
+            break;   // Último chunk truncado
+        }
+        m_index.append(c);
+        pos = align8(qint64(c.offset) + c.payloadSize);
+    }
+
+    // El último chunk completo pudo quedar a medio escribir
+    if (!m_index.isEmpty() && !verify(m_index.last())) {
+        m_index.removeLast();
+    }
+    return !m_index.isEmpty();
+}
+
+void SessionFileReader::buildTypeIndex() {
+    m_byType = QVector<QVector<int>>(kTypeSlots);
+    for (int i = 0; i < m_index.size(); ++i) {
+        const int t = int(m_index[i].type);
+        if (t > 0 && t < kTypeSlots) {
+            m_byType[t].append(i);
+        }
+    }
+    for (QVector<int>& positions : m_byType) {
+        std::stable_sort(positions.begin(), positions.end(), [this](int a, int b) {
+            return m_index[a].firstBlock < m_index[b].firstBlock;
+        });
+    }
+}
+
+QVector<SessionChunkInfo> SessionFileReader::chunksForBlocks(SessionChunkType type,
+                                                             qint64 firstBlock, qint64 endBlock) const {
+    QVector<SessionChunkInfo> result;
+    const int t = int(type);
+    if (t <= 0 || t >= m_byType.size() || firstBlock >= endBlock) {
+        return result;
+    }
+
+    // Chunks del mismo tipo sin solapes: los finales también están ordenados
+    const QVector<int>& positions = m_byType[t];
+    auto it = std::partition_point(positions.begin(), positions.end(), [&](int i) {
+        return m_index[i].firstBlock + qint64(m_index[i].blockCount) <= firstBlock;
+    });
+    for (; it != positions.end() && m_index[*it].firstBlock < endBlock; ++it) {
+        result.append(m_index[*it]);
+    }
+    return result;
+}
+
+qint64 SessionFileReader::blockCount() const {
+    qint64 end = 0;
+    for (SessionChunkType type : { SessionChunkType::RawAudio, SessionChunkType::Peaks }) {
+        const int t = int(type);
+        if (t < m_byType.size() && !m_byType[t].isEmpty()) {
+            const SessionChunkInfo& last = m_index[m_byType[t].last()];
+            end = std::max(end, last.firstBlock + qint64(last.blockCount));
+        }
+    }
+    return end;
+}
+
+qint64 SessionFileReader::lastTimestampNs() const {
+    qint64 last = m_header.startTimestampNs;
+    for (const SessionChunkInfo& c : m_index) {
+        last = std::max(last, c.lastTimestampNs);
+    }
+    return last;
+}
+
+QByteArray SessionFileReader::payload(const SessionChunkInfo& chunk, bool verifyCrc) const {
+    if (!m_map || qint64(chunk.offset) + qint64(chunk.payloadSize) > m_size) {
+        return QByteArray();
+    }
+    if (verifyCrc && !verify(chunk)) {
+        return QByteArray();
+    }
+    return QByteArray::fromRawData(reinterpret_cast<const char*>(m_map + chunk.offset),
+                                   qsizetype(chunk.payloadSize));
+}
+
+bool SessionFileReader::verify(const SessionChunkInfo& chunk) const {
+    if (!m_map || qint64(chunk.offset) + qint64(chunk.payloadSize) > m_size) {
+        return false;
+    }
+    return sessionCrc32(reinterpret_cast<const char*>(m_map + chunk.offset),
+                        qsizetype(chunk.payloadSize)) == chunk.crc;
+}
+
+QVector<SessionPeak> SessionFileReader::peaks(qint64 firstBlock, qint64 endBlock) const {
+    QVector<SessionPeak> result;
+    for (const SessionChunkInfo& c : chunksForBlocks(SessionChunkType::Peaks, firstBlock, endBlock)) {
+        const qint64 n = c.blockCount;
+        if (qint64(c.payloadSize) < 28 * n) {
+            qWarning() << "SessionFileReader: chunk de picos corrupto en" << c.offset;
+            continue;
+        }
+        const uchar* p = m_map + c.offset;
+        const qint64 i0 = std::max<qint64>(0, firstBlock - c.firstBlock);
+        const qint64 i1 = std::min<qint64>(n, endBlock - c.firstBlock);
+        for (qint64 i = i0; i < i1; ++i) {
+            SessionPeak peak;
+            peak.blockIndex = c.firstBlock + i;
+            peak.sampleOffset = get<qint64>(p + 8 * i);
+            peak.timestampNs = get<qint64>(p + 8 * n + 8 * i);
+            peak.minValue = get<float>(p + 16 * n + 4 * i);
+            peak.maxValue = get<float>(p + 20 * n + 4 * i);
+            peak.rmsValue = get<float>(p + 24 * n + 4 * i);
+            result.append(peak);
+        }
+    }
+    return result;
+}
+
+QVector<SessionRawBlock> SessionFileReader::rawBlocks(qint64 firstBlock, qint64 endBlock) const {
+    QVector<SessionRawBlock> result;
+    for (const SessionChunkInfo& c : chunksForBlocks(SessionChunkType::RawAudio, firstBlock, endBlock)) {
+        const qint64 n = c.blockCount;
+        const qint64 samplesStart = align8(20 * n);
+        if (qint64(c.payloadSize) < samplesStart) {
+            qWarning() << "SessionFileReader: chunk de audio corrupto en" << c.offset;
+            continue;
+        }
+        const uchar* p = m_map + c.offset;
+        const qint64 i0 = std::max<qint64>(0, firstBlock - c.firstBlock);
+        const qint64 i1 = std::min<qint64>(n, endBlock - c.firstBlock);
+
+        // Las muestras van concatenadas: se salta lo anterior a i0
+        qint64 sampleStart = 0;
+        for (qint64 i = 0; i < i0; ++i) {
+            sampleStart += get<quint32>(p + 16 * n + 4 * i);
+        }
+
+        for (qint64 i = i0; i < i1; ++i) {
+            const quint32 count = get<quint32>(p + 16 * n + 4 * i);
+            const qint64 byteOffset = samplesStart + sampleStart * qint64(sizeof(float));
+            if (byteOffset + qint64(count) * qint64(sizeof(float)) > qint64(c.payloadSize)) {
+                qWarning() << "SessionFileReader: chunk de audio corrupto en" << c.offset;
+                break;
+            }
+
+            SessionRawBlock block;
+            block.blockIndex = c.firstBlock + i;
+            block.sampleOffset = get<qint64>(p + 8 * i);
+            block.timestampNs = get<qint64>(p + 8 * n + 8 * i);
+            block.samples.resize(int(count));
+            std::memcpy(block.samples.data(), p + byteOffset, count * sizeof(float));
+            result.append(block);
+
+            sampleStart += count;
+        }
+    }
+    return result;
+}
+
+QVector<SpectrogramTile> SessionFileReader::tiles(int level) const {
+    QVector<SpectrogramTile> result;
+    const int t = int(SessionChunkType::Tile);
+    if (t >= m_byType.size()) return result;
+
+    for (int i : m_byType[t]) {
+        const SessionChunkInfo& c = m_index[i];
+        if (c.flags != quint16(level) || c.payloadSize < 16) continue;
+        result.append(tileAt(c));
+    }
+    return result;
+}
+
+QVector<SpectrogramTile> SessionFileReader::tilesForSpan(qint64 tStart, qint64 tEnd, int maxColumns) const {
+    QVector<SpectrogramTile> result;
+    const int t = int(SessionChunkType::Tile);
+    if (t >= m_byType.size() || tEnd <= tStart || maxColumns <= 0) return result;
+
+    // Periodo de columna (primera tesela de nivel 0 con >1 columna) y niveles presentes
+    int levels = 0;
+    const SessionChunkInfo* first = nullptr;
+    for (int i : m_byType[t]) {
+        const SessionChunkInfo& c = m_index[i];
+        levels = std::max(levels, int(c.flags) + 1);
+        if (c.flags == 0 && c.blockCount > 1 && (!first || c.firstBlock < first->firstBlock)) {
+            first = &c;
+        }
+    }
+    if (!first) return result;
+
+    const double periodNs = double(first->lastTimestampNs - first->firstTimestampNs) / double(first->blockCount - 1);
+    if (periodNs <= 0.0) return result;
+
+    const qint64 level0Columns = qint64(double(tEnd - tStart) / periodNs) + 1;
+    const int level = SpectrogramPyramid::levelForSpan(level0Columns, maxColumns, levels);
+
+    // m_byType está ordenado por firstBlock (= índice de tesela)
+    for (int i : m_byType[t]) {
+        const SessionChunkInfo& c = m_index[i];
+        if (c.flags != quint16(level) || c.payloadSize < 16) continue;
+        if (c.lastTimestampNs < tStart || c.firstTimestampNs > tEnd) continue;
+        result.append(tileAt(c));
+    }
+    return result;
+}
+
+SpectrogramTile SessionFileReader::tileAt(const SessionChunkInfo& c) const {
+    const uchar* p = m_map + c.offset;
+    SpectrogramTile tile;
+    tile.level = int(c.flags);
+    tile.tileIndex = c.firstBlock;
+    tile.columns = int(c.blockCount);
+    tile.bins = get<qint32>(p);
+    tile.minDb = get<float>(p + 4);
+    tile.maxDb = get<float>(p + 8);
+    tile.firstTimestamp = c.firstTimestampNs;
+    tile.lastTimestamp = c.lastTimestampNs;
+    // Copia: la tesela puede vivir más que el mapeo
+    tile.data = QByteArray(reinterpret_cast<const char*>(p + 16), qsizetype(c.payloadSize) - 16);
+    return tile;
+}
+
+QVector<SessionEvent> SessionFileReader::events() const {
+    QVector<SessionEvent> result;
+    const int t = int(SessionChunkType::Events);
+    if (t >= m_byType.size()) return result;
+
+    for (int i : m_byType[t]) {
+        const SessionChunkInfo& c = m_index[i];
+        const qint64 n = c.blockCount;
+        if (qint64(c.payloadSize) < 24 * n) continue;
+
+        const uchar* p = m_map + c.offset;
+        for (qint64 k = 0; k < n; ++k) {
+            SessionEvent e;
+            e.timestampNs = get<qint64>(p + 8 * k);
+            e.blockIndex = get<qint64>(p + 8 * n + 8 * k);
+            e.code = get<quint32>(p + 16 * n + 4 * k);
+            e.value = get<float>(p + 20 * n + 4 * k);
+            result.append(e);
+        }
+    }
+    return result;
+}
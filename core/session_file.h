@@ -0,0 +1,261 @@
+#ifndef SESSION_FILE_H
+#define SESSION_FILE_H
+
+#include "core/compact_spectrum.h"
+#include "core/spectrogram_pyramid.h"
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+#include <QVector>
+#include <QtTypes>
+
+/*
+ * Formato de sesión .session (versión 1, little-endian)
+ * ----------------------------------------------------------------------
+ * Fichero autocontenido que se escribe sólo añadiendo al final durante la
+ * captura y se abre con mmap leyendo únicamente la cabecera y el índice.
+ *
+ *  Cabecera (64 bytes, offset 0)
+ *     0  char[8]  "TFTSESS1"
+ *     8  u32      versión (1)
+ *    12  u32      sampleRate
+ *    16  u32      channels
+ *    20  u32      blockSize (muestras intercaladas por bloque)
+ *    24  i64      startTimestampNs
+ *    32  u8[32]   reservado (0)
+ *
+ *  Chunks (a continuación, alineados a 8 bytes)
+ *     0  char[4]  "CHNK"
+ *     4  u16      tipo (SessionChunkType)
+ *     6  u16      flags (en Tile: nivel de la pirámide)
+ *     8  i64      firstBlock (en Tile: índice de tesela; en Events: bloque del primero)
+ *    16  u32      blockCount (en Tile: columnas; en Events: eventos)
+ *    20  u32      payloadSize
+ *    24  i64      firstTimestampNs
+ *    32  i64      lastTimestampNs
+ *    40  u32      CRC-32 (IEEE) del payload
+ *    44  u32      reservado
+ *    48  payload, relleno con ceros hasta múltiplo de 8
+ *
+ *  Payloads (columnares: cada campo en un array contiguo de n valores)
+ *    RawAudio  i64 sampleOffset[n] | i64 timestampNs[n] | u32 sampleCount[n]
+ *              | relleno a 8 | f32 muestras (concatenadas, intercaladas)
+ *    Peaks     i64 sampleOffset[n] | i64 timestampNs[n] | f32 min[n] | f32 max[n] | f32 rms[n]
+ *    Spectra   u8 formato | u8[3] 0 | i32 bins | f32 minDb | f32 maxDb
+ *              | i64 timestampNs[n] | datos n × bins × bytesPorBin
+ *    Tile      i32 bins | f32 minDb | f32 maxDb | u32 0 | datos uint8 (columnas × bins)
+ *    Events    i64 timestampNs[n] | i64 blockIndex[n] | u32 code[n] | f32 value[n]
+ *
+ *  Índice (al cerrar): una entrada de 48 bytes por chunk, en orden de escritura
+ *     0  u16 tipo | u16 flags | u32 blockCount
+ *     8  i64 firstBlock | 16 i64 firstTimestampNs | 24 i64 lastTimestampNs
+ *    32  u64 offset del payload | 40 u32 payloadSize | 44 u32 CRC-32
+ *
+ *  Pie (32 bytes, al final del fichero)
+ *     0  char[8] "TFTSIDX1" | 8 u64 offset del índice | 16 u32 entradas
+ *    20  u32 CRC-32 del índice | 24 u64 tamaño total del fichero
+ *
+ * Si la captura se interrumpe no hay pie: el lector reconstruye el índice
+ * recorriendo las cabeceras de chunk y descarta el último si está truncado.
+ */
+
+enum class SessionChunkType : quint16 {
+    RawAudio = 1,
+    Peaks    = 2,
+    Spectra  = 3,
+    Tile     = 4,
+    Events   = 5
+};
+
+struct SessionFileHeader {
+    int sampleRate = 44100;
+    int channels = 1;
+    int blockSize = 1024;
+    qint64 startTimestampNs = 0;
+};
+
+/** Entrada del índice de chunks */
+struct SessionChunkInfo {
+    SessionChunkType type = SessionChunkType::RawAudio;
+    quint16 flags = 0;
+    qint64 firstBlock = 0;
+    quint32 blockCount = 0;
+    qint64 firstTimestampNs = 0;
+    qint64 lastTimestampNs = 0;
+    quint64 offset = 0;          ///< Inicio del payload en el fichero
+    quint32 payloadSize = 0;
+    quint32 crc = 0;
+};
+
+struct SessionPeak {
+    qint64 blockIndex = 0;
+    qint64 sampleOffset = 0;
+    qint64 timestampNs = 0;
+    float minValue = 0.0f;
+    float maxValue = 0.0f;
+    float rmsValue = 0.0f;
+};
+
+struct SessionRawBlock {
+    qint64 blockIndex = 0;
+    qint64 sampleOffset = 0;
+    qint64 timestampNs = 0;
+    QVector<float> samples;      ///< float32 intercalado
+};
+
+struct SessionEvent {
+    qint64 timestampNs = 0;
+    qint64 blockIndex = 0;
+    quint32 code = 0;
+    float value = 0.0f;
+};
+
+/** CRC-32 IEEE 802.3 (el de zlib) */
+quint32 sessionCrc32(const char* data, qsizetype size, quint32 crc = 0);
+
+/**
+ * @brief Escritor append-only del formato de sesión
+ *
+ * Las filas se acumulan por tipo y se escriben como un chunk cada
+ * blocksPerChunk bloques (o al romperse la continuidad, o si cambia el
+ * formato del espectro); flush() vacía todo y sincroniza el QFile, así
+ * que una caída pierde como mucho un chunk por tipo. close() escribe el
+ * índice y el pie. No es thread-safe: vive en el hilo DSP.
+ */
+class SessionFileWriter
+{
+public:
+    explicit SessionFileWriter(int blocksPerChunk = 64);
+    ~SessionFileWriter();
+
+    bool open(const QString& path, const SessionFileHeader& header);
+    bool isOpen() const { return m_file.isOpen(); }
+    QString errorString() const { return m_error; }
+    QString path() const { return m_file.fileName(); }
+
+    void appendRawBlock(qint64 blockIndex, qint64 sampleOffset, qint64 timestampNs,
+                        const float* samples, int count);
+    void appendPeak(const SessionPeak& peak);
+    void appendSpectrum(qint64 blockIndex, qint64 timestampNs, const CompactSpectrum& spectrum);
+    void appendTile(const SpectrogramTile& tile);
+    void appendEvent(const SessionEvent& event);
+
+    /** Escribe los chunks pendientes */
+    void flush();
+
+    /** Chunks pendientes + índice + pie; el fichero queda completo */
+    bool close();
+
+    int chunkCount() const { return m_index.size(); }
+
+private:
+    struct RawPending {
+        QVector<qint64> offsets, timestamps;
+        QVector<quint32> counts;
+        QVector<float> samples;
+        qint64 firstBlock = 0;
+    };
+    struct PeakPending {
+        QVector<qint64> offsets, timestamps;
+        QVector<float> mins, maxs, rms;
+        qint64 firstBlock = 0;
+    };
+    struct SpectrumPending {
+        QVector<qint64> timestamps;
+        QByteArray data;
+        SpectrumFormat format = SpectrumFormat::Float32;
+        int bins = 0;
+        float minDb = 0.0f;
+        float maxDb = 0.0f;
+        qint64 firstBlock = 0;
+    };
+
+    void flushRaw();
+    void flushPeaks();
+    void flushSpectra();
+    void flushEvents();
+    bool writeChunk(SessionChunkType type, quint16 flags, qint64 firstBlock, quint32 blockCount,
+                    qint64 firstTs, qint64 lastTs, const QByteArray& payload);
+    void fail(const QString& message);
+
+    QFile m_file;
+    QString m_error;
+    int m_blocksPerChunk;
+    QVector<SessionChunkInfo> m_index;
+
+    RawPending m_raw;
+    PeakPending m_peaks;
+    SpectrumPending m_spectra;
+    QVector<SessionEvent> m_events;
+};
+
+/**
+ * @brief Lector del formato de sesión sobre un mapeo en memoria
+ *
+ * open() mapea el fichero y lee sólo la cabecera, el pie y el índice (o
+ * recorre las cabeceras de chunk si falta el pie), así que el coste no
+ * depende del tamaño de la sesión. Los payloads se devuelven sin copia
+ * (QByteArray::fromRawData sobre el mapeo) y el CRC sólo se comprueba si
+ * se pide. Los decodificadores copian a estructuras propias. Sólo lectura;
+ * varias instancias pueden leer el mismo fichero.
+ */
+class SessionFileReader
+{
+public:
+    SessionFileReader() = default;
+    ~SessionFileReader();
+
+    bool open(const QString& path);
+    void close();
+    bool isOpen() const { return m_map != nullptr; }
+    QString errorString() const { return m_error; }
+
+    const SessionFileHeader& header() const { return m_header; }
+
+    /** true si el fichero no tenía pie y el índice se reconstruyó */
+    bool isRecovered() const { return m_recovered; }
+
+    qint64 fileSize() const { return m_size; }
+    const QVector<SessionChunkInfo>& chunks() const { return m_index; }
+
+    /** Chunks de un tipo que tocan [firstBlock, endBlock), por búsqueda binaria */
+    QVector<SessionChunkInfo> chunksForBlocks(SessionChunkType type, qint64 firstBlock, qint64 endBlock) const;
+
+    /** Bloques [0, blockCount()) según los chunks de audio o de picos */
+    qint64 blockCount() const;
+    qint64 lastTimestampNs() const;
+
+    /** Payload sin copia; vacío si `verifyCrc` y el CRC no coincide */
+    QByteArray payload(const SessionChunkInfo& chunk, bool verifyCrc = false) const;
+    bool verify(const SessionChunkInfo& chunk) const;
+
+    QVector<SessionPeak> peaks(qint64 firstBlock, qint64 endBlock) const;
+    QVector<SessionRawBlock> rawBlocks(qint64 firstBlock, qint64 endBlock) const;
+    QVector<SpectrogramTile> tiles(int level) const;
+
+    /**
+     * @brief Teselas del nivel que cubre [tStart, tEnd] con <= maxColumns columnas
+     *
+     * Mismo criterio que AudioDb::getTilesForSpan; el nivel y las teselas
+     * se eligen sobre el índice y sólo se copian las que solapan.
+     */
+    QVector<SpectrogramTile> tilesForSpan(qint64 tStart, qint64 tEnd, int maxColumns) const;
+    QVector<SessionEvent> events() const;
+
+private:
+    bool readIndexFromFooter();
+    bool rebuildIndex();
+    void buildTypeIndex();
+    SpectrogramTile tileAt(const SessionChunkInfo& chunk) const;
+
+    QFile m_file;
+    uchar* m_map = nullptr;
+    qint64 m_size = 0;
+    QString m_error;
+    SessionFileHeader m_header;
+    bool m_recovered = false;
+    QVector<SessionChunkInfo> m_index;
+    QVector<QVector<int>> m_byType;   ///< Posiciones en m_index por tipo, ordenadas por firstBlock
+};
+
+#endif // SESSION_FILE_H
@@ -0,0 +1,189 @@
+#include "session_store_pool.h"
+#include "audio_db.h"
+#include "audio_db_reader.h"
+#include "async_logger.h"
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QUuid>
+
+namespace {
+const QString kPoolPrefix = QStringLiteral("pool-");
+}
+
+SessionStorePool::SessionStorePool(const QString& directory, QObject* parent)
+    : QObject(parent)
+    , m_directory(directory)
+{
+    QDir().mkpath(m_directory);
+}
+
+void SessionStorePool::setTargetSize(int count) {
+    QMutexLocker lock(&m_mutex);
+    m_targetSize = qMax(0, count);
+}
+
+int SessionStorePool::targetSize() const {
+    QMutexLocker lock(&m_mutex);
+    return m_targetSize;
+}
+
+void SessionStorePool::setPreallocateBytes(qint64 bytes) {
+    QMutexLocker lock(&m_mutex);
+    m_preallocateBytes = qMax<qint64>(0, bytes);
+}
+
+int SessionStorePool::readyCount() const {
+    QMutexLocker lock(&m_mutex);
+    return m_ready.size();
+}
+
+QString SessionStorePool::acquire() {
+    QString pooled;
+    {
+        QMutexLocker lock(&m_mutex);
+        if (m_ready.isEmpty()) {
+            return QString();
+        }
+        pooled = m_ready.takeFirst();
+    }
+
+    // Renombrar a nombre de sesión: el fichero está cerrado, es instantáneo
+    QString sessionPath = makeSessionPath();
+    if (!QFile::rename(pooled, sessionPath)) {
+        qWarning() << "SessionStorePool: no se pudo renombrar" << pooled;
+        sessionPath = pooled;
+    }
+    AudioDbReader::invalidate(pooled);
+    AudioDbReader::invalidate(sessionPath);
+
+    QMetaObject::invokeMethod(this, &SessionStorePool::replenish, Qt::QueuedConnection);
+    return sessionPath;
+}
+
+void SessionStorePool::replenish() {
+    // Primera vez: adoptar ficheros de reserva que dejó una ejecución anterior
+    // (el esquema se completa/migra y se vacía; si no abre, se borra)
+    if (!m_adopted) {
+        m_adopted = true;
+        const QStringList leftovers = QDir(m_directory).entryList({kPoolPrefix + "*.db"}, QDir::Files);
+        for (const QString& name : leftovers) {
+            const QString path = QDir(m_directory).filePath(name);
+            AudioDb db(path);
+            const bool valid = db.initialize() && db.clearDatabase();
+            db.shutdown();
+            if (!valid) {
+                qWarning() << "SessionStorePool: fichero de reserva inválido, se borra:" << path;
+                removeStoreFiles(path);
+                continue;
+            }
+            QMutexLocker lock(&m_mutex);
+            m_ready.append(path);
+        }
+    }
+
+    for (;;) {
+        qint64 preallocate = 0;
+        {
+            QMutexLocker lock(&m_mutex);
+            if (m_ready.size() >= m_targetSize) {
+                break;
+            }
+            preallocate = m_preallocateBytes;
+        }
+
+        const QString path = makePoolPath();
+        if (!prepareStore(path, preallocate)) {
+            removeStoreFiles(path);
+            break;   // disco lleno o sin permisos: no insistir en bucle
+        }
+
+        int ready = 0;
+        {
+            QMutexLocker lock(&m_mutex);
+            m_ready.append(path);
+            ready = m_ready.size();
+        }
+        emit storeReady(ready);
+    }
+}
+
+bool SessionStorePool::reclaim(const QString& path) {
+    if (path.isEmpty() || !QFileInfo::exists(path)) {
+        return false;
+    }
+
+    bool recycle = false;
+    {
+        QMutexLocker lock(&m_mutex);
+        recycle = m_ready.size() < m_targetSize;
+    }
+
+    if (recycle) {
+        // DELETE sin VACUUM: las páginas quedan libres dentro del fichero,
+        // que conserva el tamaño para la siguiente sesión
+        AudioDb db(path);
+        const bool cleared = db.initialize() && db.clearDatabase();
+        db.shutdown();
+
+        const QString poolPath = makePoolPath();
+        if (cleared && QFile::rename(path, poolPath)) {
+            // Tras el rename: la ruta ya no es esta sesión para los lectores
+            AudioDbReader::invalidate(path);
+            int ready = 0;
+            {
+                QMutexLocker lock(&m_mutex);
+                m_ready.append(poolPath);
+                ready = m_ready.size();
+            }
+            emit sessionReclaimed(path);
+            emit storeReady(ready);
+            return true;
+        }
+    }
+
+    const bool removed = removeStoreFiles(path);
+    AudioDbReader::invalidate(path);
+    if (!removed) {
+        qWarning() << "SessionStorePool: no se pudo borrar" << path;
+        return false;
+    }
+    emit sessionReclaimed(path);
+    return true;
+}
+
+bool SessionStorePool::clearStore(const QString& path) {
+    AudioDb db(path);
+    const bool cleared = db.initialize() && db.clearDatabase();
+    db.shutdown();
+    if (!cleared) {
+        qWarning() << "SessionStorePool: no se pudo vaciar" << path;
+    }
+    return cleared;
+}
+
+bool SessionStorePool::prepareStore(const QString& path, qint64 preallocateBytes) {
+    AudioDb db(path);
+    bool ok = db.initialize();
+    if (ok && preallocateBytes > 0) {
+        ok = db.preallocate(preallocateBytes);
+    }
+    db.shutdown();
+    return ok;
+}
+
+QString SessionStorePool::makePoolPath() const {
+    return QDir(m_directory).filePath(kPoolPrefix + QUuid::createUuid().toString(QUuid::WithoutBraces) + ".db");
+}
+
+QString SessionStorePool::makeSessionPath() const {
+    return QDir(m_directory).filePath(QUuid::createUuid().toString(QUuid::WithoutBraces) + ".db");
+}
+
+bool SessionStorePool::removeStoreFiles(const QString& path) {
+    QFile::remove(path + "-journal");
+    QFile::remove(path + "-wal");
+    QFile::remove(path + "-shm");
+    return QFile::remove(path) || !QFileInfo::exists(path);
+}
@@ -0,0 +1,73 @@
+#ifndef SESSION_STORE_POOL_H
+#define SESSION_STORE_POOL_H
+
+#include <QObject>
+#include <QMutex>
+#include <QString>
+#include <QStringList>
+#include <QtTypes>
+
+/**
+ * @brief Reserva de ficheros de sesión SQLite ya creados
+ *
+ * Vive en su propio hilo (prioridad baja). Mantiene `targetSize` ficheros
+ * con el esquema y los índices creados y con espacio ya reservado en el
+ * fichero (páginas libres), de modo que rotar de sesión se reduce a
+ * renombrar un fichero.
+ *
+ * acquire() es thread-safe y no bloquea: devuelve un fichero listo o una
+ * cadena vacía si la reserva está agotada (el llamante crea uno nuevo).
+ * Las sesiones descartadas se reciclan (DELETE sin VACUUM, conservando el
+ * tamaño) o se borran, siempre en el hilo de la reserva.
+ */
+class SessionStorePool : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit SessionStorePool(const QString& directory, QObject* parent = nullptr);
+
+    QString directory() const { return m_directory; }
+
+    void setTargetSize(int count);
+    int targetSize() const;
+
+    /** Bytes reservados en cada fichero nuevo (0 = sin reserva) */
+    void setPreallocateBytes(qint64 bytes);
+
+    /** Ruta de una sesión lista (renombrada como sesión); vacía si no hay */
+    QString acquire();
+
+    int readyCount() const;
+
+    /** Crea esquema e índices y reserva espacio en un fichero */
+    static bool prepareStore(const QString& path, qint64 preallocateBytes);
+
+public slots:
+    /** Completa la reserva hasta targetSize (adopta, ya validados, sobrantes de ejecuciones previas) */
+    void replenish();
+
+    /** Devuelve una sesión ya cerrada: se recicla si falta reserva, si no se borra; false si no se pudo */
+    bool reclaim(const QString& path);
+
+    /** Vacía una sesión en su sitio, sin VACUUM (modo de DB persistente); false si falló */
+    bool clearStore(const QString& path);
+
+signals:
+    void storeReady(int readyCount);
+    void sessionReclaimed(const QString& path);
+
+private:
+    QString makePoolPath() const;
+    QString makeSessionPath() const;
+    static bool removeStoreFiles(const QString& path);
+
+    QString m_directory;
+    mutable QMutex m_mutex;
+    QStringList m_ready;
+    int m_targetSize = 2;
+    qint64 m_preallocateBytes = 64LL * 1024 * 1024;
+    bool m_adopted = false;
+};
+
+#endif // SESSION_STORE_POOL_H
@@ -0,0 +1,240 @@
+#include "sparse_block_index.h"
+#include <QDataStream>
+#include <QIODevice>
+#include <algorithm>
+#include <climits>
+#include <cmath>
+
+namespace {
+constexpr quint32 kIndexMagic = 0x53424931;   // "SBI1"
+// Entry serializado: 4 × i64, 2 × i32, double y bool (1 byte en QDataStream)
+constexpr qint64 kEntryBytes = 4 * 8 + 2 * 4 + 8 + 1;
+}
+
+SparseBlockIndex::SparseBlockIndex(int stride, qint64 toleranceNs)
+    : m_stride(std::max(1, stride))
+    , m_toleranceNs(std::max<qint64>(0, toleranceNs))
+{
+}
+
+void SparseBlockIndex::clear() {
+    m_entries.clear();
+    m_endBlock = 0;
+    m_blockCount = 0;
+    m_lastLocation = 0;
+}
+
+void SparseBlockIndex::startEntry(qint64 blockIndex, qint64 sampleOffset, qint64 timestampNs,
+                                  qint64 location, bool gap, const Entry* inherit) {
+    Entry e;
+    e.blockIndex = blockIndex;
+    e.sampleOffset = sampleOffset;
+    e.timestampNs = timestampNs;
+    e.location = location;
+    e.count = 1;
+    e.gap = gap;
+    if (inherit) {
+        // Mismo tramo continuo: el paso ya es conocido
+        e.samplesPerBlock = inherit->samplesPerBlock;
+        e.nsPerSample = inherit->nsPerSample;
+    }
+    m_entries.append(e);
+}
+
+void SparseBlockIndex::append(qint64 blockIndex, qint64 sampleOffset, qint64 timestampNs, qint64 location) {
+    if (m_entries.isEmpty()) {
+        startEntry(blockIndex, sampleOffset, timestampNs, location, false, nullptr);
+    } else {
+        Entry& e = m_entries.last();
+        const qint64 k = blockIndex - e.blockIndex;
+
+        if (blockIndex != m_endBlock) {
+            startEntry(blockIndex, sampleOffset, timestampNs, location, true, nullptr);
+        } else if (location != e.location + k) {
+            // Bloques seguidos guardados en otro sitio: sólo cambia la ubicación
+            const Entry inherit = e;
+            startEntry(blockIndex, sampleOffset, timestampNs, location, false, &inherit);
+        } else if (e.samplesPerBlock == 0) {
+            // Segundo bloque del tramo: fija el paso en muestras y en tiempo
+            const qint64 step = sampleOffset - e.sampleOffset;
+            if (step <= 0 || step > INT_MAX) {
+                startEntry(blockIndex, sampleOffset, timestampNs, location, true, nullptr);
+            } else {
+                e.samplesPerBlock = qint32(step);
+                e.nsPerSample = double(timestampNs - e.timestampNs) / double(step);
+                ++e.count;
+            }
+        } else if (sampleOffset != e.sampleOffset + k * e.samplesPerBlock) {
+            startEntry(blockIndex, sampleOffset, timestampNs, location, true, nullptr);
+        } else {
+            const qint64 error = timestampNs - predictTimestamp(e, sampleOffset);
+            if (std::abs(error) > m_toleranceNs) {
+                // Deriva pequeña: se resincroniza; más de medio bloque es un hueco
+                const double halfBlockNs = 0.5 * e.nsPerSample * e.samplesPerBlock;
+                startEntry(blockIndex, sampleOffset, timestampNs, location,
+                           std::abs(double(error)) > halfBlockNs, nullptr);
+            } else if (e.count >= m_stride) {
+                const Entry inherit = e;
+                startEntry(blockIndex, sampleOffset, timestampNs, location, false, &inherit);
+            } else {
+                ++e.count;
+            }
+        }
+    }
+
+    m_endBlock = blockIndex + 1;
+    m_lastLocation = location;
+    ++m_blockCount;
+}
+
+int SparseBlockIndex::gapCount() const {
+    return int(std::count_if(m_entries.cbegin(), m_entries.cend(),
+                             [](const Entry& e) { return e.gap; }));
+}
+
+qint64 SparseBlockIndex::predictTimestamp(const Entry& e, qint64 sampleOffset) const {
+    return e.timestampNs + qint64(std::llround(double(sampleOffset - e.sampleOffset) * e.nsPerSample));
+}
+
+BlockLocation SparseBlockIndex::at(const Entry& e, qint64 k) const {
+    BlockLocation loc;
+    loc.blockIndex = e.blockIndex + k;
+    loc.sampleOffset = e.sampleOffset + k * e.samplesPerBlock;
+    loc.timestampNs = k == 0 ? e.timestampNs : predictTimestamp(e, loc.sampleOffset);
+    loc.location = e.location + k;
+    return loc;
+}
+
+int SparseBlockIndex::entryForBlock(qint64 blockIndex) const {
+    if (m_entries.isEmpty() || blockIndex < m_entries.first().blockIndex) {
+        return -1;
+    }
+
+    // Sin huecos las entradas caen cada m_stride bloques: acceso directo
+    const qint64 guess = (blockIndex - m_entries.first().blockIndex) / m_stride;
+    if (guess < m_entries.size()) {
+        const int i = int(guess);
+        if (m_entries[i].blockIndex <= blockIndex &&
+            (i + 1 == m_entries.size() || m_entries[i + 1].blockIndex > blockIndex)) {
+            return i;
+        }
+    }
+
+    auto it = std::upper_bound(m_entries.cbegin(), m_entries.cend(), blockIndex,
+                               [](qint64 b, const Entry& e) { return b < e.blockIndex; });
+    return int(it - m_entries.cbegin()) - 1;
+}
+
+BlockLocation SparseBlockIndex::locate(qint64 blockIndex) const {
+    const int i = entryForBlock(blockIndex);
+    if (i < 0) {
+        return BlockLocation();
+    }
+    const Entry& e = m_entries[i];
+    const qint64 k = blockIndex - e.blockIndex;
+    return k < e.count ? at(e, k) : BlockLocation();
+}
+
+BlockLocation SparseBlockIndex::locateSampleOffset(qint64 sampleOffset) const {
+    auto it = std::upper_bound(m_entries.cbegin(), m_entries.cend(), sampleOffset,
+                               [](qint64 off, const Entry& e) { return off < e.sampleOffset; });
+    if (it == m_entries.cbegin()) {
+        return BlockLocation();
+    }
+    const Entry& e = *(it - 1);
+    qint64 k = e.samplesPerBlock > 0 ? (sampleOffset - e.sampleOffset) / e.samplesPerBlock : 0;
+    k = std::min<qint64>(k, e.count - 1);
+    return at(e, k);
+}
+
+BlockLocation SparseBlockIndex::locateTimestamp(qint64 timestampNs) const {
+    auto it = std::upper_bound(m_entries.cbegin(), m_entries.cend(), timestampNs,
+                               [](qint64 ts, const Entry& e) { return ts < e.timestampNs; });
+    if (it == m_entries.cbegin()) {
+        return BlockLocation();
+    }
+    const Entry& e = *(it - 1);
+    qint64 k = 0;
+    const double nsPerBlock = e.nsPerSample * e.samplesPerBlock;
+    if (nsPerBlock > 0.0) {
+        k = qint64(std::floor(double(timestampNs - e.timestampNs) / nsPerBlock));
+        k = std::clamp<qint64>(k, 0, e.count - 1);
+    }
+    return at(e, k);
+}
+
+BlockLocation SparseBlockIndex::firstAtOrAfterSampleOffset(qint64 sampleOffset) const {
+    if (m_entries.isEmpty()) {
+        return BlockLocation();
+    }
+
+    const BlockLocation loc = locateSampleOffset(sampleOffset);
+    if (!loc.isValid()) {
+        return at(m_entries.first(), 0);
+    }
+    if (loc.sampleOffset >= sampleOffset) {
+        return loc;
+    }
+
+    // El bloque empieza antes: el siguiente, saltando un posible hueco
+    const BlockLocation next = locate(loc.blockIndex + 1);
+    if (next.isValid()) {
+        return next;
+    }
+    const int i = entryForBlock(loc.blockIndex);
+    return i + 1 < m_entries.size() ? at(m_entries[i + 1], 0) : BlockLocation();
+}
+
+QByteArray SparseBlockIndex::toByteArray() const {
+    QByteArray data;
+    QDataStream out(&data, QIODevice::WriteOnly);
+    out.setVersion(QDataStream::Qt_6_0);
+
+    out << kIndexMagic << qint32(m_stride) << m_toleranceNs
+        << m_endBlock << m_blockCount << m_lastLocation << qint32(m_entries.size());
+    for (const Entry& e : m_entries) {
+        out << e.blockIndex << e.sampleOffset << e.timestampNs << e.location
+            << e.count << e.samplesPerBlock << e.nsPerSample << e.gap;
+    }
+    return data;
+}
+
+bool SparseBlockIndex::fromByteArray(const QByteArray& data) {
+    QDataStream in(data);
+    in.setVersion(QDataStream::Qt_6_0);
+
+    quint32 magic = 0;
+    qint32 stride = 0;
+    qint32 count = 0;
+    qint64 tolerance = 0, endBlock = 0, blockCount = 0, lastLocation = 0;
+    in >> magic >> stride >> tolerance >> endBlock >> blockCount >> lastLocation >> count;
+    if (in.status() != QDataStream::Ok || magic != kIndexMagic || stride < 1 || count < 0) {
+        clear();
+        return false;
+    }
+
+    // Un count dañado no debe reservar más entradas de las que caben en los datos
+    const qint64 remaining = qint64(data.size()) - in.device()->pos();
+    if (qint64(count) > remaining / kEntryBytes) {
+        clear();
+        return false;
+    }
+
+    QVector<Entry> entries(count);
+    for (Entry& e : entries) {
+        in >> e.blockIndex >> e.sampleOffset >> e.timestampNs >> e.location
+           >> e.count >> e.samplesPerBlock >> e.nsPerSample >> e.gap;
+    }
+    if (in.status() != QDataStream::Ok) {
+        clear();
+        return false;
+    }
+
+    m_stride = stride;
+    m_toleranceNs = tolerance;
+    m_endBlock = endBlock;
+    m_blockCount = blockCount;
+    m_lastLocation = lastLocation;
+    m_entries = entries;
+    return true;
+}
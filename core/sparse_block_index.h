@@ -0,0 +1,94 @@
+#ifndef SPARSE_BLOCK_INDEX_H
+#define SPARSE_BLOCK_INDEX_H
+
+#include <QByteArray>
+#include <QVector>
+#include <QtTypes>
+
+/**
+ * @brief Posición de un bloque resuelta por SparseBlockIndex
+ */
+struct BlockLocation {
+    qint64 blockIndex = -1;
+    qint64 sampleOffset = 0;
+    qint64 timestampNs = 0;
+    qint64 location = 0;          ///< Posición en el almacenamiento (rowid en AudioDb)
+
+    bool isValid() const { return blockIndex >= 0; }
+};
+
+/**
+ * @brief Índice disperso bloque ↔ sampleOffset ↔ timestamp ↔ ubicación
+ *
+ * Guarda una entrada cada `stride` bloques y otra en cada discontinuidad
+ * (hueco en block_index o en sample_offset, salto de tiempo, ubicación no
+ * consecutiva). Dentro del tramo de una entrada los bloques son
+ * consecutivos y equiespaciados, así que el resto se calcula: una
+ * búsqueda es aritmética sobre el array (con stride regular, acceso
+ * directo) más, como mucho, una búsqueda binaria corta si hubo huecos.
+ *
+ * Los timestamps calculados tienen un error acotado por toleranceNs (por
+ * defecto 1 µs, menos de una muestra a 48 kHz): si un bloque se desvía
+ * más, abre entrada. Se construye con append() al escribir y se persiste
+ * con toByteArray(). No es thread-safe.
+ */
+class SparseBlockIndex
+{
+public:
+    explicit SparseBlockIndex(int stride = 64, qint64 toleranceNs = 1000);
+
+    void clear();
+
+    /** Registra el bloque siguiente; los bloques deben llegar en orden */
+    void append(qint64 blockIndex, qint64 sampleOffset, qint64 timestampNs, qint64 location);
+
+    bool isEmpty() const { return m_entries.isEmpty(); }
+    qint64 blockCount() const { return m_blockCount; }
+    qint64 firstBlock() const { return m_entries.isEmpty() ? 0 : m_entries.first().blockIndex; }
+    qint64 endBlock() const { return m_endBlock; }      ///< Último bloque + 1
+    qint64 lastLocation() const { return m_lastLocation; }
+    int entryCount() const { return m_entries.size(); }
+    int gapCount() const;
+
+    /** Bloque exacto; inválido si no está en el índice (hueco o fuera de rango) */
+    BlockLocation locate(qint64 blockIndex) const;
+
+    /** Bloque que contiene el offset (o el anterior si cae en un hueco) */
+    BlockLocation locateSampleOffset(qint64 sampleOffset) const;
+
+    /** Bloque que contiene el instante (o el anterior si cae en un hueco) */
+    BlockLocation locateTimestamp(qint64 timestampNs) const;
+
+    /** Primer bloque con sampleOffset >= offset (a través de huecos) */
+    BlockLocation firstAtOrAfterSampleOffset(qint64 sampleOffset) const;
+
+    QByteArray toByteArray() const;
+    bool fromByteArray(const QByteArray& data);
+
+private:
+    struct Entry {
+        qint64 blockIndex = 0;
+        qint64 sampleOffset = 0;
+        qint64 timestampNs = 0;
+        qint64 location = 0;
+        qint32 count = 0;              ///< Bloques del tramo
+        qint32 samplesPerBlock = 0;    ///< 0 hasta ver el segundo bloque del tramo
+        double nsPerSample = 0.0;
+        bool gap = false;              ///< El tramo empieza tras una discontinuidad
+    };
+
+    void startEntry(qint64 blockIndex, qint64 sampleOffset, qint64 timestampNs,
+                    qint64 location, bool gap, const Entry* inherit);
+    int entryForBlock(qint64 blockIndex) const;
+    BlockLocation at(const Entry& e, qint64 k) const;
+    qint64 predictTimestamp(const Entry& e, qint64 sampleOffset) const;
+
+    int m_stride;
+    qint64 m_toleranceNs;
+    QVector<Entry> m_entries;
+    qint64 m_endBlock = 0;
+    qint64 m_blockCount = 0;
+    qint64 m_lastLocation = 0;
+};
+
+#endif // SPARSE_BLOCK_INDEX_H
@@ -1,8 +1,10 @@
 #include "spectrogram_calculator.h"
+#include "fft_plan_cache.h"
+#include "spectrum_kernels.h"
 #include <QDebug>
+#include <QFloat16>
 #include <cmath>
 #include <algorithm>
-#include <fftw3.h>
 
 SpectrogramCalculator::SpectrogramCalculator(const SpectrogramConfig& config, QObject* parent)
     : QObject(parent)
@@ -75,6 +77,9 @@ void SpectrogramCalculator::setConfig(const SpectrogramConfig& config) {
     // Usar la configuración validada
     m_config = validatedConfig;
 
+    // El kernel se vuelve a elegir en el siguiente frame
+    m_kernel = nullptr;
+
     if (windowChanged) {
         m_windowNeedsUpdate = true;
     }
@@ -87,6 +92,13 @@ void SpectrogramCalculator::setConfig(const SpectrogramConfig& config) {
 SpectrogramFrame SpectrogramCalculator::calculateFrame(const QVector<float>& samples,
                                                        qint64 timestamp,
                                                        qint64 sampleOffset) {
+    return calculateFrame(samples, timestamp, sampleOffset, nullptr);
+}
+
+SpectrogramFrame SpectrogramCalculator::calculateFrame(const QVector<float>& samples,
+                                                       qint64 timestamp,
+                                                       qint64 sampleOffset,
+                                                       ComplexSpectrum* complexOut) {
     SpectrogramFrame frame;
     frame.timestamp = timestamp;
     frame.sampleOffset = sampleOffset;
@@ -107,6 +119,52 @@ SpectrogramFrame SpectrogramCalculator::calculateFrame(const QVector<float>& sam
             updateFrequencies();
         }
 
+        // Camino rápido (magnitudes float): kernel especializado para la
+        // configuración, sin copias intermedias de las muestras
+        const bool compact = m_config.logScale && m_config.outputFormat != SpectrumFormat::Float32;
+        if (!compact) {
+            if (!m_kernel) {
+                updateKernel();
+            }
+
+            const int N = m_config.fftSize;
+            const int bins = N / 2 + 1;
+            fftwf_plan plan = FftPlanCache::instance().r2c(N);
+            if (!plan) {
+                emit errorOccurred("Error creando plan FFT");
+                return frame;
+            }
+            if (m_fftOut.size() != bins) {
+                m_fftOut.resize(bins);
+            }
+
+            frame.magnitudes.resize(bins);
+            if (complexOut) {
+                complexOut->fftSize = N;
+                complexOut->re.resize(bins);
+                complexOut->im.resize(bins);
+            }
+
+            SpectrumKernelIo io;
+            io.samples = samples.constData();
+            io.count = samples.size();
+            io.fftSize = N;
+            io.window = m_window.constData();
+            io.scratch = m_kernelScratch.data();
+            io.spectrum = reinterpret_cast<fftwf_complex*>(m_fftOut.data());
+            io.plan = plan;
+            io.normDiv = N * m_windowGain;
+            io.noiseFloor = m_config.noiseFloor;
+            io.magnitudes = frame.magnitudes.data();
+            io.re = complexOut ? complexOut->re.data() : nullptr;
+            io.im = complexOut ? complexOut->im.data() : nullptr;
+            m_kernel(io);
+
+            frame.frequencies = m_frequencies;
+            frame.windowGain = m_windowGain;
+            return frame;
+        }
+
         // Preparar datos con zero-padding si es necesario
         QVector<float> data(m_config.fftSize, 0.0f);
         int copySize = std::min(static_cast<int>(samples.size()),
@@ -120,8 +178,8 @@ SpectrogramFrame SpectrogramCalculator::calculateFrame(const QVector<float>& sam
         // Aplicar ventana
         QVector<float> windowedData = applyWindow(data);
 
-        // Calcular FFT
-        frame.magnitudes = applyFFT(windowedData);
+        // Calcular FFT (formato compacto: el bucle de magnitud escribe directamente los códigos)
+        frame.magnitudes = applyFFT(windowedData, complexOut, &frame.compact);
         frame.frequencies = m_frequencies;
         frame.windowGain = m_windowGain;
 
@@ -216,6 +274,15 @@ void SpectrogramCalculator::updateWindow() {
              << "Ganancia:" << m_windowGain;
 }
 
+void SpectrogramCalculator::updateKernel() {
+    const bool windowed = m_config.windowType != WindowType::Rectangular;
+    m_kernel = SpectrumKernels::select(m_config.fftSize, windowed, m_config.logScale);
+    m_kernelScratch.resize(m_config.fftSize);
+
+    qDebug() << "Kernel espectral:" << m_config.fftSize
+             << (SpectrumKernels::isSpecialized(m_config.fftSize) ? "especializado" : "genérico");
+}
+
 void SpectrogramCalculator::updateFrequencies() {
     int bins = m_config.fftSize / 2 + 1;
     m_frequencies.resize(bins);
@@ -229,37 +296,92 @@ void SpectrogramCalculator::updateFrequencies() {
     m_frequenciesNeedUpdate = false;
 }
 
-QVector<float> SpectrogramCalculator::applyFFT(const QVector<float>& windowedData) {
+QVector<float> SpectrogramCalculator::applyFFT(const QVector<float>& windowedData,
+                                               ComplexSpectrum* complexOut,
+                                               CompactSpectrum* compactOut) {
     int N = windowedData.size();
     int bins = N / 2 + 1;
 
-    QVector<float> magnitudes(bins);
+    QVector<float> magnitudes(compactOut ? 0 : bins);
 
-    // Preparar memoria para FFTW
-    fftwf_complex* out = (fftwf_complex*)fftwf_malloc(sizeof(fftwf_complex) * bins);
-    if (!out) {
-        emit errorOccurred("Error allocando memoria para FFT");
-        return magnitudes;
-    }
-
-    // Crear plan FFT
-    fftwf_plan plan = fftwf_plan_dft_r2c_1d(N,
-                                            const_cast<float*>(windowedData.constData()),
-                                            out,
-                                            FFTW_ESTIMATE);
+    // Plan cacheado por hilo: evita planificar en cada frame
+    fftwf_plan plan = FftPlanCache::instance().r2c(N);
     if (!plan) {
-        fftwf_free(out);
         emit errorOccurred("Error creando plan FFT");
         return magnitudes;
     }
 
-    // Ejecutar FFT
-    fftwf_execute(plan);
+    if (m_fftOut.size() != bins) {
+        m_fftOut.resize(bins);
+    }
+    auto* out = reinterpret_cast<fftwf_complex*>(m_fftOut.data());
+
+    // Ejecutar FFT sobre los buffers de este frame
+    fftwf_execute_dft_r2c(plan, const_cast<float*>(windowedData.constData()), out);
+
+    if (complexOut) {
+        complexOut->fftSize = N;
+        complexOut->re.resize(bins);
+        complexOut->im.resize(bins);
+    }
+
+    if (compactOut) {
+        if (complexOut) {
+            for (int i = 0; i < bins; ++i) {
+                complexOut->re[i] = out[i][0];
+                complexOut->im[i] = out[i][1];
+            }
+        }
+
+        const float normDiv = N * m_windowGain;
+        auto magnitudeDb = [&](int i) {
+            const float m = std::sqrt(out[i][0] * out[i][0] + out[i][1] * out[i][1]) / normDiv;
+            return (m > 0.0f) ? 20.0f * std::log10f(m) : m_config.noiseFloor;
+        };
+
+        // Un bucle por formato: sin ramas por bin ni buffer float intermedio
+        const SpectrumFormat format = m_config.outputFormat;
+        *compactOut = CompactSpectrum::allocate(bins, format, m_config.noiseFloor, m_config.maxDb);
+        char* dst = compactOut->data.data();
+        const quint32 maxCode = CompactSpectrum::maxCode(format);
+        const float scale = maxCode / (compactOut->maxDb - compactOut->minDb);
+        const float minDb = compactOut->minDb;
+
+        switch (format) {
+        case SpectrumFormat::Float16: {
+            qfloat16* d = reinterpret_cast<qfloat16*>(dst);
+            for (int i = 0; i < bins; ++i) d[i] = qfloat16(magnitudeDb(i));
+            break;
+        }
+        case SpectrumFormat::UInt16: {
+            quint16* d = reinterpret_cast<quint16*>(dst);
+            for (int i = 0; i < bins; ++i)
+                d[i] = quint16(CompactSpectrum::quantize(magnitudeDb(i), minDb, scale, maxCode));
+            break;
+        }
+        case SpectrumFormat::UInt8: {
+            uchar* d = reinterpret_cast<uchar*>(dst);
+            for (int i = 0; i < bins; ++i)
+                d[i] = uchar(CompactSpectrum::quantize(magnitudeDb(i), minDb, scale, maxCode));
+            break;
+        }
+        case SpectrumFormat::Float32: {
+            float* d = reinterpret_cast<float*>(dst);
+            for (int i = 0; i < bins; ++i) d[i] = magnitudeDb(i);
+            break;
+        }
+        }
+        return magnitudes;
+    }
 
     // Calcular magnitudes
     for (int i = 0; i < bins; ++i) {
         float real = out[i][0];
         float imag = out[i][1];
+        if (complexOut) {
+            complexOut->re[i] = real;
+            complexOut->im[i] = imag;
+        }
         magnitudes[i] = std::sqrt(real * real + imag * imag);
 
         // Normalizar por tamaño FFT y ganancia de ventana
@@ -275,10 +397,6 @@ QVector<float> SpectrogramCalculator::applyFFT(const QVector<float>& windowedDat
         }
     }
 
-    // Limpiar recursos
-    fftwf_destroy_plan(plan);
-    fftwf_free(out);
-
     return magnitudes;
 }
 
@@ -5,6 +5,10 @@
 #include <QVector>
 #include <QtTypes>
 #include <QString>
+#include <complex>
+#include "core/analysis_types.h"
+#include "core/compact_spectrum.h"
+#include "core/spectrum_kernels.h"
 
 /**
  * @brief Tipos de ventana disponibles para el análisis espectral
@@ -32,6 +36,8 @@ struct SpectrogramConfig {
     double gaussianSigma = 0.4;   ///< Parámetro sigma para ventana Gaussiana
     bool logScale = true;         ///< Aplicar escala logarítmica (dB)
     float noiseFloor = -100.0f;   ///< Piso de ruido en dB
+    SpectrumFormat outputFormat = SpectrumFormat::Float32; ///< Formato de salida (compacto sólo con logScale)
+    float maxDb = 20.0f;          ///< Tope del rango cuantificado [noiseFloor, maxDb]
 
     SpectrogramConfig() = default;
     SpectrogramConfig(int fftSz, int hopSz, int sampleRt = 44100)
@@ -44,7 +50,8 @@ struct SpectrogramConfig {
 struct SpectrogramFrame {
     qint64 timestamp;             ///< Timestamp del frame
     qint64 sampleOffset;          ///< Offset en muestras
-    QVector<float> magnitudes;    ///< Magnitudes espectrales
+    QVector<float> magnitudes;    ///< Magnitudes espectrales (vacío si se usa compact)
+    CompactSpectrum compact;      ///< Magnitudes en dB empaquetadas (outputFormat != Float32)
     QVector<float> frequencies;   ///< Frecuencias correspondientes
     float windowGain;             ///< Ganancia de la ventana aplicada
 };
@@ -71,6 +78,15 @@ public:
                                     qint64 timestamp = 0,
                                     qint64 sampleOffset = 0);
 
+    /**
+     * @brief Igual que calculateFrame, pero además copia en complexOut el
+     *        espectro complejo (ventaneado, sin normalizar) de la misma FFT
+     */
+    SpectrogramFrame calculateFrame(const QVector<float>& samples,
+                                    qint64 timestamp,
+                                    qint64 sampleOffset,
+                                    ComplexSpectrum* complexOut);
+
     /** Procesa múltiples bloques con solapamiento */
     QVector<SpectrogramFrame> processOverlapped(const QVector<float>& samples,
                                                 qint64 startTimestamp = 0,
@@ -96,7 +112,10 @@ signals:
 private:
     void updateWindow();
     void updateFrequencies();
-    QVector<float> applyFFT(const QVector<float>& windowedData);
+    void updateKernel();
+    QVector<float> applyFFT(const QVector<float>& windowedData,
+                            ComplexSpectrum* complexOut = nullptr,
+                            CompactSpectrum* compactOut = nullptr);
     QVector<float> applyWindow(const QVector<float>& samples);
     float calculateWindowGain(const QVector<float>& window);
 
@@ -117,6 +136,10 @@ private:
     float m_windowGain;
     bool m_windowNeedsUpdate;
     bool m_frequenciesNeedUpdate;
+    QVector<std::complex<float>> m_fftOut;  ///< Salida FFT reutilizada entre frames
+
+    SpectrumKernelFn m_kernel = nullptr;    ///< Kernel elegido para (fftSize, ventana, logScale)
+    QVector<float> m_kernelScratch;         ///< Frame ventaneado del kernel
 };
 
 #endif // SPECTROGRAM_CALCULATOR_H
@@ -0,0 +1,154 @@
+#include "spectrogram_pyramid.h"
+#include <QDebug>
+#include <algorithm>
+#include <cstring>
+
+CompactSpectrum SpectrogramTile::column(int c) const {
+    CompactSpectrum out;
+    if (c < 0 || c >= columns) {
+        return out;
+    }
+    out.format = SpectrumFormat::UInt8;
+    out.minDb = minDb;
+    out.maxDb = maxDb;
+    out.bins = bins;
+    out.data = data.mid(qsizetype(c) * bins, bins);
+    return out;
+}
+
+SpectrogramPyramid::SpectrogramPyramid(const PyramidConfig& config)
+    : m_config(config)
+{
+    if (m_config.bins <= 0) {
+        qWarning() << "SpectrogramPyramid: bins inválido, usando 513";
+        m_config.bins = 513;
+    }
+    m_config.tileColumns = std::max(1, m_config.tileColumns);
+    m_config.levels = std::clamp(m_config.levels, 1, 40);
+    m_config.freqDecimation = std::max(1, m_config.freqDecimation);
+    if (m_config.maxDb <= m_config.minDb) {
+        m_config.maxDb = m_config.minDb + 1.0f;
+    }
+
+    m_outBins = (m_config.bins + m_config.freqDecimation - 1) / m_config.freqDecimation;
+    reset();
+}
+
+void SpectrogramPyramid::reset() {
+    m_levels = QVector<Level>(m_config.levels);
+    m_combined = QVector<QVector<float>>(m_config.levels, QVector<float>(m_outBins));
+    m_reduced.resize(m_outBins);
+    for (int l = 0; l < m_levels.size(); ++l) {
+        m_levels[l].pending.resize(m_outBins);
+        openTile(m_levels[l], l, 0);
+    }
+}
+
+void SpectrogramPyramid::continueTileIndices(const QVector<qint64>& firstIndex) {
+    const int n = std::min(int(firstIndex.size()), int(m_levels.size()));
+    for (int l = 0; l < n; ++l) {
+        SpectrogramTile& t = m_levels[l].tile;
+        t.tileIndex = std::max(t.tileIndex, firstIndex[l]);
+    }
+}
+
+void SpectrogramPyramid::openTile(Level& level, int index, qint64 tileIndex) {
+    SpectrogramTile& t = level.tile;
+    t.level = index;
+    t.tileIndex = tileIndex;
+    t.columns = 0;
+    t.bins = m_outBins;
+    t.firstTimestamp = 0;
+    t.lastTimestamp = 0;
+    t.minDb = m_config.minDb;
+    t.maxDb = m_config.maxDb;
+    t.data = QByteArray(qsizetype(m_config.tileColumns) * m_outBins, Qt::Uninitialized);
+}
+
+QVector<SpectrogramTile> SpectrogramPyramid::append(const float* db, int bins, qint64 timestampNs) {
+    QVector<SpectrogramTile> completed;
+    if (!db || bins <= 0) {
+        return completed;
+    }
+
+    // Reducción en frecuencia: máximo por grupo, para no perder tonos estrechos
+    const int d = m_config.freqDecimation;
+    const int n = std::min(bins, m_config.bins);
+    for (int k = 0; k < m_outBins; ++k) {
+        const int start = k * d;
+        const int end = std::min(n, start + d);
+        m_reduced[k] = (start < end) ? *std::max_element(db + start, db + end) : m_config.minDb;
+    }
+
+    push(0, m_reduced.constData(), timestampNs, completed);
+    return completed;
+}
+
+void SpectrogramPyramid::push(int levelIndex, const float* column, qint64 timestampNs,
+                              QVector<SpectrogramTile>& completed) {
+    Level& level = m_levels[levelIndex];
+
+    // 1) Escribir la columna en la tesela abierta de este nivel
+    SpectrogramTile& t = level.tile;
+    if (t.columns == 0) {
+        t.firstTimestamp = timestampNs;
+    }
+    t.lastTimestamp = timestampNs;
+
+    uchar* dst = reinterpret_cast<uchar*>(t.data.data()) + qsizetype(t.columns) * m_outBins;
+    const float scale = 255.0f / (m_config.maxDb - m_config.minDb);
+    for (int k = 0; k < m_outBins; ++k) {
+        dst[k] = uchar(CompactSpectrum::quantize(column[k], m_config.minDb, scale, 0xFF));
+    }
+
+    if (++t.columns == m_config.tileColumns) {
+        completed.append(t);
+        openTile(level, levelIndex, t.tileIndex + 1);
+    }
+
+    // 2) Emparejar para el nivel siguiente
+    if (levelIndex + 1 >= m_levels.size()) {
+        return;
+    }
+
+    if (!level.hasPending) {
+        std::memcpy(level.pending.data(), column, size_t(m_outBins) * sizeof(float));
+        level.pendingTimestamp = timestampNs;
+        level.hasPending = true;
+        return;
+    }
+
+    float* __restrict out = m_combined[levelIndex].data();
+    const float* __restrict a = level.pending.constData();
+    if (m_config.useMax) {
+        for (int k = 0; k < m_outBins; ++k) out[k] = std::max(a[k], column[k]);
+    } else {
+        for (int k = 0; k < m_outBins; ++k) out[k] = 0.5f * (a[k] + column[k]);
+    }
+    level.hasPending = false;
+
+    // La columna reducida se fecha con la primera de la pareja
+    push(levelIndex + 1, out, level.pendingTimestamp, completed);
+}
+
+QVector<SpectrogramTile> SpectrogramPyramid::pendingTiles() const {
+    QVector<SpectrogramTile> out;
+    for (const Level& level : m_levels) {
+        if (!level.tile.isEmpty()) {
+            SpectrogramTile t = level.tile;
+            t.data.truncate(qsizetype(t.columns) * t.bins);
+            out.append(t);
+        }
+    }
+    return out;
+}
+
+int SpectrogramPyramid::levelForSpan(qint64 level0Columns, int maxColumns, int levels) {
+    int level = 0;
+    qint64 columns = level0Columns;
+    while (columns > maxColumns && level + 1 < levels) {
+        columns = (columns + 1) / 2;
+        ++level;
+    }
+    return level;
+}
@@ -0,0 +1,102 @@
+#ifndef SPECTROGRAM_PYRAMID_H
+#define SPECTROGRAM_PYRAMID_H
+
+#include "core/compact_spectrum.h"
+#include <QByteArray>
+#include <QVector>
+#include <QtTypes>
+
+/**
+ * @brief Configuración de la pirámide de espectrograma
+ */
+struct PyramidConfig {
+    int bins = 513;               ///< Bins de entrada (fftSize/2+1)
+    int tileColumns = 256;        ///< Columnas por tesela
+    int levels = 12;              ///< Niveles: el nivel k reduce 2^k frames
+    int freqDecimation = 1;       ///< Reducción en frecuencia (máximo por grupo de bins)
+    bool useMax = true;           ///< Reducción temporal por máximo (false = media en dB)
+    float minDb = -100.0f;        ///< Rango de cuantificación uint8
+    float maxDb = 20.0f;
+};
+
+/**
+ * @brief Tesela de tamaño fijo de un nivel de la pirámide
+ *
+ * Columnas contiguas de `bins` códigos uint8 sobre [minDb, maxDb].
+ */
+struct SpectrogramTile {
+    int level = 0;
+    qint64 tileIndex = 0;         ///< Posición de la tesela dentro de su nivel
+    int columns = 0;              ///< Columnas rellenas (< tileColumns sólo en la última)
+    int bins = 0;
+    qint64 firstTimestamp = 0;    ///< Timestamp (ns) de la primera columna
+    qint64 lastTimestamp = 0;     ///< Timestamp (ns) de la última columna
+    float minDb = -100.0f;
+    float maxDb = 0.0f;
+    QByteArray data;
+
+    bool isEmpty() const { return columns == 0; }
+
+    /** Columna c como espectro compacto (copia sólo esa columna) */
+    CompactSpectrum column(int c) const;
+};
+
+/**
+ * @brief Pirámide de espectrograma construida de forma incremental
+ *
+ * Cada columna nueva entra en el nivel 0; cuando un nivel acumula dos
+ * columnas las reduce (máximo o media) y pasa el resultado al nivel
+ * siguiente, así que el coste por frame es O(bins) amortizado. Cada nivel
+ * escribe en su tesela abierta; append() devuelve las teselas que se
+ * completan para persistirlas. Cualquier intervalo se puede dibujar con
+ * ~anchura/tileColumns teselas del nivel adecuado.
+ */
+class SpectrogramPyramid
+{
+public:
+    explicit SpectrogramPyramid(const PyramidConfig& config);
+
+    const PyramidConfig& config() const { return m_config; }
+    int outputBins() const { return m_outBins; }
+
+    /** Añade una columna en dB; devuelve las teselas completadas */
+    QVector<SpectrogramTile> append(const float* db, int bins, qint64 timestampNs);
+
+    /** Teselas abiertas (parciales) de todos los niveles, sin cerrarlas */
+    QVector<SpectrogramTile> pendingTiles() const;
+
+    void reset();
+
+    /**
+     * @brief Numera las teselas abiertas a partir de firstIndex[nivel]
+     *
+     * Para seguir una pirámide ya guardada (DB persistente, cambio de
+     * configuración) sin reemplazar sus teselas. Nunca retrocede.
+     */
+    void continueTileIndices(const QVector<qint64>& firstIndex);
+
+    /**
+     * @brief Nivel cuyo número de columnas en el intervalo cabe en maxColumns
+     * @param level0Columns Columnas de nivel 0 en el intervalo
+     */
+    static int levelForSpan(qint64 level0Columns, int maxColumns, int levels);
+
+private:
+    struct Level {
+        SpectrogramTile tile;               ///< Tesela abierta
+        QVector<float> pending;             ///< Columna a la espera de su pareja
+        qint64 pendingTimestamp = 0;
+        bool hasPending = false;
+    };
+
+    void push(int level, const float* column, qint64 timestampNs, QVector<SpectrogramTile>& completed);
+    void openTile(Level& level, int index, qint64 tileIndex);
+
+    PyramidConfig m_config;
+    int m_outBins = 0;
+    QVector<Level> m_levels;
+    QVector<float> m_reduced;               ///< Columna reducida en frecuencia (nivel 0)
+    QVector<QVector<float>> m_combined;     ///< Columna combinada por nivel
+};
+
+#endif // SPECTROGRAM_PYRAMID_H
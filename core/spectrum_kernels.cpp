@@ -0,0 +1,118 @@
+#include "spectrum_kernels.h"
+#include <QtGlobal>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+// Cuerpo común. Con N constante (instancias fijas) el compilador conoce los
+// límites de todos los bucles; Windowed y LogScale eliminan las ramas.
+template <bool Windowed, bool LogScale>
+Q_ALWAYS_INLINE void frameBody(const SpectrumKernelIo& io, const int N) {
+    const int bins = N / 2 + 1;
+    const int n = io.count < N ? io.count : N;
+
+    float* __restrict x = io.scratch;
+    const float* __restrict s = io.samples;
+
+    if constexpr (Windowed) {
+        const float* __restrict w = io.window;
+        for (int i = 0; i < n; ++i) {
+            x[i] = s[i] * w[i];
+        }
+    } else {
+        std::memcpy(x, s, size_t(n) * sizeof(float));
+    }
+    for (int i = n; i < N; ++i) {
+        x[i] = 0.0f;
+    }
+
+    fftwf_execute_dft_r2c(io.plan, x, io.spectrum);
+
+    const float* __restrict c = reinterpret_cast<const float*>(io.spectrum);
+    if (io.re) {
+        float* __restrict re = io.re;
+        float* __restrict im = io.im;
+        for (int k = 0; k < bins; ++k) {
+            re[k] = c[2 * k];
+            im[k] = c[2 * k + 1];
+        }
+    }
+
+    float* __restrict mag = io.magnitudes;
+    const float normDiv = io.normDiv;
+    for (int k = 0; k < bins; ++k) {
+        const float r = c[2 * k];
+        const float i = c[2 * k + 1];
+        mag[k] = std::sqrt(r * r + i * i) / normDiv;
+    }
+
+    if constexpr (LogScale) {
+        const float floorDb = io.noiseFloor;
+        for (int k = 0; k < bins; ++k) {
+            mag[k] = (mag[k] > 0.0f) ? 20.0f * std::log10(mag[k]) : floorDb;
+        }
+    }
+}
+
+template <int N, bool Windowed, bool LogScale>
+void fixedKernel(const SpectrumKernelIo& io) {
+    frameBody<Windowed, LogScale>(io, N);
+}
+
+template <bool Windowed, bool LogScale>
+void genericKernel(const SpectrumKernelIo& io) {
+    frameBody<Windowed, LogScale>(io, io.fftSize);
+}
+
+struct KernelEntry {
+    int fftSize;
+    SpectrumKernelFn fn[2][2];   ///< [windowed][logScale]
+};
+
+template <int N>
+constexpr KernelEntry entryFor() {
+    return { N, { { &fixedKernel<N, false, false>, &fixedKernel<N, false, true> },
+                  { &fixedKernel<N, true,  false>, &fixedKernel<N, true,  true> } } };
+}
+
+constexpr KernelEntry kKernelTable[] = {
+    entryFor<256>(),
+    entryFor<512>(),
+    entryFor<1024>(),
+    entryFor<2048>(),
+    entryFor<4096>(),
+    entryFor<8192>()
+};
+
+const KernelEntry* findEntry(int fftSize) {
+    for (const KernelEntry& e : kKernelTable) {
+        if (e.fftSize == fftSize) return &e;
+    }
+    return nullptr;
+}
+
+} // namespace
+
+namespace SpectrumKernels {
+
+SpectrumKernelFn generic(bool windowed, bool logScale) {
+    static constexpr SpectrumKernelFn table[2][2] = {
+        { &genericKernel<false, false>, &genericKernel<false, true> },
+        { &genericKernel<true,  false>, &genericKernel<true,  true> }
+    };
+    return table[windowed][logScale];
+}
+
+SpectrumKernelFn select(int fftSize, bool windowed, bool logScale) {
+    if (const KernelEntry* e = findEntry(fftSize)) {
+        return e->fn[windowed][logScale];
+    }
+    return generic(windowed, logScale);
+}
+
+bool isSpecialized(int fftSize) {
+    return findEntry(fftSize) != nullptr;
+}
+
+} // namespace SpectrumKernels
@@ -0,0 +1,51 @@
+#ifndef SPECTRUM_KERNELS_H
+#define SPECTRUM_KERNELS_H
+
+#include <QtTypes>
+#include <fftw3.h>
+
+/**
+ * @brief Entradas y salidas de un kernel de frame espectral
+ *
+ * Todos los buffers son del llamante; el kernel no reserva memoria.
+ */
+struct SpectrumKernelIo {
+    const float* samples = nullptr;   ///< Muestras del frame (count, se rellena con ceros hasta fftSize)
+    int count = 0;
+    int fftSize = 0;
+    const float* window = nullptr;    ///< Ventana (fftSize); ignorada en kernels rectangulares
+    float* scratch = nullptr;         ///< fftSize floats para el frame ventaneado
+    fftwf_complex* spectrum = nullptr; ///< fftSize/2+1 bins de salida de la FFT
+    fftwf_plan plan = nullptr;        ///< Plan r2c de fftSize (FftPlanCache)
+    float normDiv = 1.0f;             ///< fftSize · ganancia de ventana
+    float noiseFloor = -100.0f;       ///< Valor de los bins nulos en escala dB
+    float* magnitudes = nullptr;      ///< fftSize/2+1 magnitudes de salida
+    float* re = nullptr;              ///< Opcional: parte real de cada bin
+    float* im = nullptr;              ///< Opcional: parte imaginaria de cada bin
+};
+
+using SpectrumKernelFn = void (*)(const SpectrumKernelIo& io);
+
+/**
+ * @brief Kernels ventana + FFT + magnitud especializados en compilación
+ *
+ * Para fftSize ∈ {256, 512, ..., 8192} hay una instancia por combinación
+ * (ventana rectangular o tabulada, escala lineal o dB) con el tamaño como
+ * constante: el compilador desenrolla y vectoriza los bucles y no quedan
+ * ramas por muestra ni por bin. El resto de tamaños usa el kernel genérico.
+ * La selección se hace una vez, al configurar.
+ */
+namespace SpectrumKernels {
+
+/** Kernel para la configuración; nunca nulo (cae en el genérico) */
+SpectrumKernelFn select(int fftSize, bool windowed, bool logScale);
+
+/** Kernel genérico (tamaño en tiempo de ejecución) */
+SpectrumKernelFn generic(bool windowed, bool logScale);
+
+/** true si existe una instancia especializada para fftSize */
+bool isSpecialized(int fftSize);
+
+} // namespace SpectrumKernels
+
+#endif // SPECTRUM_KERNELS_H
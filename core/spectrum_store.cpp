@@ -0,0 +1,235 @@
+#include "spectrum_store.h"
+#include <QDebug>
+#include <QMutexLocker>
+#include <algorithm>
+#include <cmath>
+
+SpectrumStore::SpectrumStore(const SpectrumStoreConfig& cfg, QObject* parent)
+    : QObject(parent)
+    , m_cfg(cfg.isValid() ? cfg : SpectrumStoreConfig())
+{
+    resetLocked();
+}
+
+void SpectrumStore::setConfig(const SpectrumStoreConfig& cfg) {
+    if (!cfg.isValid()) {
+        qWarning() << "SpectrumStore: configuración no válida";
+        return;
+    }
+    QMutexLocker lock(&m_mutex);
+    m_cfg = cfg;
+    resetLocked();
+}
+
+SpectrumStoreConfig SpectrumStore::config() const {
+    QMutexLocker lock(&m_mutex);
+    return m_cfg;
+}
+
+void SpectrumStore::setDbRange(float minDb, float maxDb) {
+    if (!(minDb < maxDb)) {
+        return;
+    }
+    QMutexLocker lock(&m_mutex);
+    if (m_cfg.minDb == minDb && m_cfg.maxDb == maxDb) {
+        return;
+    }
+    m_cfg.minDb = minDb;
+    m_cfg.maxDb = maxDb;
+
+    // Las columnas ya cuantificadas quedarían con otro rango: se descartan
+    // (como en SpectrogramRenderer::setConfig); los picos no dependen de él
+    resetSpectraLocked();
+}
+
+quint64 SpectrumStore::generation() const {
+    QMutexLocker lock(&m_mutex);
+    return m_generation;
+}
+
+void SpectrumStore::clear() {
+    QMutexLocker lock(&m_mutex);
+    resetLocked();
+}
+
+void SpectrumStore::clearSpectra() {
+    QMutexLocker lock(&m_mutex);
+    resetSpectraLocked();
+}
+
+void SpectrumStore::clearPeaks() {
+    QMutexLocker lock(&m_mutex);
+    resetPeaksLocked();
+}
+
+void SpectrumStore::resetLocked() {
+    resetSpectraLocked();
+    resetPeaksLocked();
+}
+
+void SpectrumStore::resetSpectraLocked() {
+    m_spectra = QVector<CompactSpectrum>(m_cfg.spectrumCapacity);
+    m_spectrumEnd = 0;
+    ++m_generation;
+}
+
+void SpectrumStore::resetPeaksLocked() {
+    // Cada nivel retiene el mismo intervalo: capacidad >> k entradas
+    m_levels.clear();
+    for (int k = 0; k < m_cfg.peakLevels; ++k) {
+        const int capacity = m_cfg.peakCapacity >> k;
+        if (capacity < 1 || (k > 0 && m_levels.last().ring.size() < 2)) {
+            break;
+        }
+        PeakLevel level;
+        level.ring.resize(capacity);
+        m_levels.append(level);
+    }
+    ++m_generation;
+}
+
+void SpectrumStore::append(const QVector<FrameData>& batch) {
+    if (batch.isEmpty()) {
+        return;
+    }
+
+    QMutexLocker lock(&m_mutex);
+    for (const FrameData& frame : batch) {
+        appendSpectrumLocked(frame);
+        appendPeakLocked(frame);
+    }
+}
+
+void SpectrumStore::appendSpectrumLocked(const FrameData& frame) {
+    CompactSpectrum column;
+    if (!frame.compactSpectrum.isEmpty()) {
+        // Ya empaquetado por el DSP: se comparte el buffer
+        column = frame.compactSpectrum;
+    } else if (!frame.spectrum.isEmpty()) {
+        column = CompactSpectrum::encode(frame.spectrum, SpectrumFormat::UInt8,
+                                         m_cfg.minDb, m_cfg.maxDb);
+    } else {
+        return;
+    }
+
+    m_spectra[int(m_spectrumEnd % m_spectra.size())] = column;
+    ++m_spectrumEnd;
+}
+
+void SpectrumStore::appendPeakLocked(const FrameData& frame) {
+    PeakEntry entry;
+    if (frame.peakMin < frame.peakMax) {
+        // Extremos exactos del bloque completo calculados por el DSP
+        entry.minValue = frame.peakMin;
+        entry.maxValue = frame.peakMax;
+        entry.meanSquare = frame.peakRms * frame.peakRms;
+    } else if (!frame.waveform.isEmpty()) {
+        float lo = frame.waveform[0];
+        float hi = frame.waveform[0];
+        float energy = 0.0f;
+        for (float s : frame.waveform) {
+            lo = std::min(lo, s);
+            hi = std::max(hi, s);
+            energy += s * s;
+        }
+        entry.minValue = lo;
+        entry.maxValue = hi;
+        entry.meanSquare = energy / float(frame.waveform.size());
+    } else {
+        return;
+    }
+
+    // Nivel 0 y, mientras se complete un par, los niveles superiores
+    for (int k = 0; k < m_levels.size(); ++k) {
+        PeakLevel& level = m_levels[k];
+        const qint64 index = level.end;
+        level.ring[int(index % level.ring.size())] = entry;
+        ++level.end;
+
+        if ((index & 1) == 0 || k + 1 >= m_levels.size()) {
+            break;
+        }
+        const PeakEntry& prev = level.ring[int((index - 1) % level.ring.size())];
+        PeakEntry parent;
+        parent.minValue = std::min(prev.minValue, entry.minValue);
+        parent.maxValue = std::max(prev.maxValue, entry.maxValue);
+        parent.meanSquare = 0.5f * (prev.meanSquare + entry.meanSquare);
+        entry = parent;
+    }
+}
+
+qint64 SpectrumStore::firstColumn() const {
+    QMutexLocker lock(&m_mutex);
+    return std::max<qint64>(0, m_spectrumEnd - m_spectra.size());
+}
+
+qint64 SpectrumStore::endColumn() const {
+    QMutexLocker lock(&m_mutex);
+    return m_spectrumEnd;
+}
+
+qint64 SpectrumStore::columns(qint64 first, qint64 end, QVector<CompactSpectrum>& out) const {
+    QMutexLocker lock(&m_mutex);
+    first = std::max(first, std::max<qint64>(0, m_spectrumEnd - m_spectra.size()));
+    end = std::min(end, m_spectrumEnd);
+
+    out.resize(int(std::max<qint64>(0, end - first)));
+    for (qint64 c = first; c < end; ++c) {
+        out[int(c - first)] = m_spectra[int(c % m_spectra.size())];
+    }
+    return first;
+}
+
+qint64 SpectrumStore::firstBlock() const {
+    QMutexLocker lock(&m_mutex);
+    const PeakLevel& base = m_levels.first();
+    return std::max<qint64>(0, base.end - base.ring.size());
+}
+
+qint64 SpectrumStore::endBlock() const {
+    QMutexLocker lock(&m_mutex);
+    return m_levels.first().end;
+}
+
+int SpectrumStore::peakLevels() const {
+    QMutexLocker lock(&m_mutex);
+    return m_levels.size();
+}
+
+int SpectrumStore::peakLevelFor(double blocksPerColumn) const {
+    if (blocksPerColumn < 2.0) {
+        return 0;
+    }
+    const int level = int(std::floor(std::log2(blocksPerColumn)));
+    return std::clamp(level, 0, peakLevels() - 1);
+}
+
+SpectrumStore::PeakRange SpectrumStore::readPeaks(int level, qint64 first, qint64 end,
+                                                  QVector<float>& mins, QVector<float>& maxs,
+                                                  QVector<float>* rms) const {
+    QMutexLocker lock(&m_mutex);
+    PeakRange range;
+    range.level = std::clamp(level, 0, int(m_levels.size()) - 1);
+
+    const PeakLevel& lvl = m_levels[range.level];
+    const qint64 available = std::max<qint64>(0, lvl.end - lvl.ring.size());
+    const qint64 i0 = std::max(first >> range.level, available);
+    const qint64 i1 = std::max(i0, std::min(end >> range.level, lvl.end));
+
+    const int count = int(i1 - i0);
+    mins.resize(count);
+    maxs.resize(count);
+    if (rms) rms->resize(count);
+
+    for (qint64 i = i0; i < i1; ++i) {
+        const PeakEntry& e = lvl.ring[int(i % lvl.ring.size())];
+        const int o = int(i - i0);
+        mins[o] = e.minValue;
+        maxs[o] = e.maxValue;
+        if (rms) (*rms)[o] = std::sqrt(e.meanSquare);
+    }
+
+    range.firstBlock = i0 << range.level;
+    range.endBlock = i1 << range.level;
+    return range;
+}
@@ -0,0 +1,124 @@
+#ifndef SPECTRUM_STORE_H
+#define SPECTRUM_STORE_H
+
+#include "core/compact_spectrum.h"
+#include "core/dsp_worker.h"
+#include <QMutex>
+#include <QObject>
+#include <QVector>
+#include <QtTypes>
+
+/**
+ * @brief Configuración del almacén compartido del stream en vivo
+ */
+struct SpectrumStoreConfig {
+    int   spectrumCapacity = 8192;   ///< Columnas de espectro retenidas
+    int   peakCapacity = 65536;      ///< Bloques de picos retenidos por nivel
+    int   peakLevels = 10;           ///< Niveles de la pirámide (nivel k = 2^k bloques)
+    float minDb = -100.0f;           ///< Rango de cuantificación de espectros Float32
+    float maxDb = 0.0f;
+
+    bool isValid() const {
+        return spectrumCapacity > 0 && peakCapacity > 1 && peakLevels > 0 && minDb < maxDb;
+    }
+};
+
+/**
+ * @brief Datos del stream en vivo independientes de las vistas
+ *
+ * Guarda una sola vez lo que antes copiaba cada vista: un anillo de
+ * columnas de espectro empaquetadas y una pirámide min/max/RMS por bloque
+ * (el nivel k resume 2^k bloques y retiene el mismo intervalo que el
+ * nivel 0). Las posiciones son absolutas desde el último clear(), así
+ * que cualquier número de vistas puede leer intervalos distintos a zooms
+ * distintos sin duplicar datos; el coste por vista queda en sus píxeles.
+ *
+ * append() se conecta directamente a DSPWorker::framesReady (hilo DSP);
+ * las vistas consultan en su tick, sin eventos encolados por lote.
+ * generation() cambia con clear() y con el rango de dB, para invalidar
+ * teselas ya pintadas. Thread-safe.
+ */
+class SpectrumStore : public QObject
+{
+    Q_OBJECT
+
+public:
+    /** Intervalo realmente leído de la pirámide */
+    struct PeakRange {
+        qint64 firstBlock = 0;
+        qint64 endBlock = 0;
+        int level = 0;
+        int count() const { return int((endBlock - firstBlock) >> level); }
+    };
+
+    explicit SpectrumStore(const SpectrumStoreConfig& cfg = SpectrumStoreConfig(), QObject* parent = nullptr);
+
+    void setConfig(const SpectrumStoreConfig& cfg);
+    SpectrumStoreConfig config() const;
+
+    /** Cambia el rango de cuantificación; vacía el anillo de espectros */
+    void setDbRange(float minDb, float maxDb);
+
+    quint64 generation() const;
+
+    // Espectros: columnas [firstColumn(), endColumn())
+    qint64 firstColumn() const;
+    qint64 endColumn() const;
+
+    /** Copia (compartida implícitamente) de las columnas [first, end) disponibles */
+    qint64 columns(qint64 first, qint64 end, QVector<CompactSpectrum>& out) const;
+
+    // Picos: bloques [firstBlock(), endBlock())
+    qint64 firstBlock() const;
+    qint64 endBlock() const;
+    int peakLevels() const;
+
+    /** Nivel más grueso con 2^k <= blocksPerColumn */
+    int peakLevelFor(double blocksPerColumn) const;
+
+    /**
+     * @brief Lee las entradas completas del nivel `level` que cubren [first, end)
+     *
+     * Los vectores se redimensionan a PeakRange::count(); `rms` puede ser null.
+     */
+    PeakRange readPeaks(int level, qint64 first, qint64 end,
+                        QVector<float>& mins, QVector<float>& maxs, QVector<float>* rms) const;
+
+public slots:
+    /** Añade un lote del DSP; puede llamarse desde cualquier hilo */
+    void append(const QVector<FrameData>& batch);
+
+    /** Vacía los datos (p. ej. al reiniciar el análisis) */
+    void clear();
+    void clearSpectra();
+    void clearPeaks();
+
+private:
+    struct PeakEntry {
+        float minValue = 0.0f;
+        float maxValue = 0.0f;
+        float meanSquare = 0.0f;
+    };
+
+    struct PeakLevel {
+        QVector<PeakEntry> ring;
+        qint64 end = 0;              ///< Entradas completas (índice absoluto)
+    };
+
+    void resetLocked();
+    void resetSpectraLocked();
+    void resetPeaksLocked();
+    void appendSpectrumLocked(const FrameData& frame);
+    void appendPeakLocked(const FrameData& frame);
+
+    mutable QMutex m_mutex;
+    SpectrumStoreConfig m_cfg;
+    quint64 m_generation = 1;
+
+    QVector<CompactSpectrum> m_spectra;
+    qint64 m_spectrumEnd = 0;
+
+    QVector<PeakLevel> m_levels;
+};
+
+#endif // SPECTRUM_STORE_H
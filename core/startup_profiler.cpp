@@ -0,0 +1,68 @@
+#include "startup_profiler.h"
+#include "async_logger.h"
+#include <QStringList>
+
+StartupProfiler& StartupProfiler::instance() {
+    static StartupProfiler profiler;
+    return profiler;
+}
+
+void StartupProfiler::start() {
+    QMutexLocker lock(&m_mutex);
+    m_timer.start();
+    m_phases.clear();
+    m_lastMs = 0;
+    m_finished = false;
+}
+
+void StartupProfiler::mark(const QString& phase) {
+    QMutexLocker lock(&m_mutex);
+    if (!m_timer.isValid() || m_finished) {
+        return;
+    }
+
+    const qint64 now = m_timer.elapsed();
+    m_phases.append({phase, now, now - m_lastMs});
+    m_lastMs = now;
+}
+
+void StartupProfiler::finish(const QString& phase) {
+    mark(phase);
+
+    {
+        QMutexLocker lock(&m_mutex);
+        if (m_finished || !m_timer.isValid()) {
+            return;
+        }
+        m_finished = true;
+    }
+
+    TFT_INFO(lcUi).noquote() << report();
+}
+
+bool StartupProfiler::isFinished() const {
+    QMutexLocker lock(&m_mutex);
+    return m_finished;
+}
+
+QVector<StartupProfiler::Phase> StartupProfiler::phases() const {
+    QMutexLocker lock(&m_mutex);
+    return m_phases;
+}
+
+QString StartupProfiler::report() const {
+    const QVector<Phase> phases = this->phases();
+
+    QStringList lines;
+    lines << "Arranque:";
+    for (const Phase& p : phases) {
+        lines << QString("  %1 %2 ms (t=%3 ms)")
+                     .arg(p.name, -24)
+                     .arg(p.durationMs, 5)
+                     .arg(p.sinceStartMs);
+    }
+    if (!phases.isEmpty()) {
+        lines << QString("  total %1 ms").arg(phases.last().sinceStartMs);
+    }
+    return lines.join('\n');
+}
@@ -0,0 +1,50 @@
+#ifndef STARTUP_PROFILER_H
+#define STARTUP_PROFILER_H
+
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QString>
+#include <QVector>
+#include <QtTypes>
+
+/**
+ * @brief Medición de las fases del arranque en frío
+ *
+ * start() se llama al principio de main(); cada mark() registra el
+ * tiempo transcurrido desde la marca anterior. finish() cierra la
+ * medición (normalmente con el primer frame mostrado) y escribe el
+ * informe en el log. Thread-safe: las fases en segundo plano (p. ej.
+ * inicialización de GStreamer) también pueden marcar.
+ */
+class StartupProfiler
+{
+public:
+    struct Phase {
+        QString name;
+        qint64 sinceStartMs = 0;   ///< Tiempo desde start()
+        qint64 durationMs = 0;     ///< Tiempo desde la marca anterior
+    };
+
+    static StartupProfiler& instance();
+
+    void start();
+    void mark(const QString& phase);
+    void finish(const QString& phase);
+
+    bool isFinished() const;
+    QVector<Phase> phases() const;
+
+    /** Informe legible: una fase por línea y total */
+    QString report() const;
+
+private:
+    StartupProfiler() = default;
+
+    mutable QMutex m_mutex;
+    QElapsedTimer m_timer;
+    QVector<Phase> m_phases;
+    qint64 m_lastMs = 0;
+    bool m_finished = false;
+};
+
+#endif // STARTUP_PROFILER_H
@@ -0,0 +1,177 @@
+#include "thread_tuning.h"
+#include <QThread>
+#include <cerrno>
+#include <cstring>
+
+#if defined(Q_OS_LINUX)
+#  include <pthread.h>
+#  include <sched.h>
+#  include <sys/mman.h>
+#  include <sys/resource.h>
+#  include <sys/syscall.h>
+#  include <unistd.h>
+#endif
+
+QString ThreadSchedulingReport::toString() const {
+    QStringList cores;
+    for (int c : affinity) cores << QString::number(c);
+
+    QString s = QString("%1: %2").arg(threadName, policy);
+    if (priority > 0) s += QString(" prio=%1").arg(priority);
+    s += QString(" nice=%1").arg(niceValue);
+    s += QString(" cpus=%1").arg(cores.isEmpty() ? QStringLiteral("*") : cores.join(','));
+    if (lockedBytes > 0) s += QString(" mlock=%1 KiB").arg(lockedBytes / 1024);
+    if (!fallbacks.isEmpty()) s += QString(" [fallback: %1]").arg(fallbacks.join("; "));
+    return s;
+}
+
+namespace ThreadTuning {
+
+#if defined(Q_OS_LINUX)
+
+namespace {
+QString errnoText(int err) {
+    return QString::fromLocal8Bit(std::strerror(err));
+}
+
+pid_t currentTid() {
+    return pid_t(::syscall(SYS_gettid));
+}
+
+void readBack(ThreadSchedulingReport& report) {
+    int policy = SCHED_OTHER;
+    sched_param param {};
+    if (pthread_getschedparam(pthread_self(), &policy, &param) == 0) {
+        switch (policy) {
+        case SCHED_FIFO: report.policy = "SCHED_FIFO"; break;
+        case SCHED_RR:   report.policy = "SCHED_RR";   break;
+        default:         report.policy = "SCHED_OTHER"; break;
+        }
+        report.priority = param.sched_priority;
+    }
+
+    errno = 0;
+    const int nice = ::getpriority(PRIO_PROCESS, id_t(currentTid()));
+    if (errno == 0) report.niceValue = nice;
+
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (pthread_getaffinity_np(pthread_self(), sizeof(set), &set) == 0) {
+        const int total = CPU_COUNT(&set);
+        const int online = int(::sysconf(_SC_NPROCESSORS_ONLN));
+        // Sólo se listan los núcleos si el hilo está restringido
+        if (total < online) {
+            for (int c = 0; c < CPU_SETSIZE; ++c)
+                if (CPU_ISSET(c, &set)) report.affinity.append(c);
+        }
+    }
+}
+}
+
+ThreadSchedulingReport applyToCurrentThread(const QString& threadName,
+                                            const ThreadSchedulingConfig& config) {
+    ThreadSchedulingReport report;
+    report.threadName = threadName;
+
+    // 1) Política de tiempo real
+    bool realtime = false;
+    if (config.policy != ThreadSchedulingConfig::Default) {
+        const int policy = (config.policy == ThreadSchedulingConfig::Fifo) ? SCHED_FIFO : SCHED_RR;
+        sched_param param {};
+        param.sched_priority = qBound(sched_get_priority_min(policy),
+                                      config.realtimePriority,
+                                      sched_get_priority_max(policy));
+        const int err = pthread_setschedparam(pthread_self(), policy, &param);
+        if (err == 0) {
+            realtime = true;
+        } else {
+            report.fallbacks << QString("%1 no disponible (%2), usando nice")
+                                    .arg(policy == SCHED_FIFO ? "SCHED_FIFO" : "SCHED_RR", errnoText(err));
+        }
+    } else {
+        // Se aplica en caliente: volver a Default deshace un FIFO/RR anterior
+        sched_param param {};
+        param.sched_priority = 0;
+        const int err = pthread_setschedparam(pthread_self(), SCHED_OTHER, &param);
+        if (err != 0) {
+            report.fallbacks << QString("SCHED_OTHER rechazado (%1)").arg(errnoText(err));
+        }
+    }
+
+    // 2) Nice: ajuste normal o sustituto del tiempo real. Se fija siempre
+    // (también a 0) para no heredar el -10 de un fallback anterior
+    int nice = config.niceValue;
+    if (!realtime && config.policy != ThreadSchedulingConfig::Default && nice == 0) {
+        nice = -10;
+    }
+    if (!realtime) {
+        if (::setpriority(PRIO_PROCESS, id_t(currentTid()), qBound(-20, nice, 19)) != 0) {
+            report.fallbacks << QString("nice %1 rechazado (%2)").arg(nice).arg(errnoText(errno));
+        }
+    }
+
+    // 3) Afinidad: sin núcleos configurados se vuelve a permitir todos
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (config.cpuAffinity.isEmpty()) {
+        const int configured = qBound(1, int(::sysconf(_SC_NPROCESSORS_CONF)), int(CPU_SETSIZE));
+        for (int c = 0; c < configured; ++c) CPU_SET(c, &set);
+    } else {
+        for (int c : config.cpuAffinity) {
+            if (c >= 0 && c < CPU_SETSIZE) CPU_SET(c, &set);
+        }
+    }
+    const int affinityErr = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    if (affinityErr != 0) {
+        report.fallbacks << QString("afinidad rechazada (%1)").arg(errnoText(affinityErr));
+    }
+
+    readBack(report);
+    return report;
+}
+
+bool lockMemory(const void* address, std::size_t length, QString* error) {
+    if (!address || length == 0) return false;
+    if (::mlock(address, length) != 0) {
+        if (error) *error = errnoText(errno);
+        return false;
+    }
+    return true;
+}
+
+void unlockMemory(const void* address, std::size_t length) {
+    if (address && length > 0) {
+        ::munlock(address, length);
+    }
+}
+
+#else // !Q_OS_LINUX
+
+ThreadSchedulingReport applyToCurrentThread(const QString& threadName,
+                                            const ThreadSchedulingConfig& config) {
+    ThreadSchedulingReport report;
+    report.threadName = threadName;
+    report.policy = "QThread";
+
+    if (config.policy != ThreadSchedulingConfig::Default || config.niceValue < 0) {
+        QThread::currentThread()->setPriority(QThread::TimeCriticalPriority);
+        report.fallbacks << "política/nice no soportados, usando QThread::TimeCriticalPriority";
+    } else {
+        QThread::currentThread()->setPriority(QThread::NormalPriority);
+    }
+    if (!config.cpuAffinity.isEmpty()) {
+        report.fallbacks << "afinidad no soportada en esta plataforma";
+    }
+    return report;
+}
+
+bool lockMemory(const void*, std::size_t, QString* error) {
+    if (error) *error = "mlock no soportado en esta plataforma";
+    return false;
+}
+
+void unlockMemory(const void*, std::size_t) {}
+
+#endif
+
+} // namespace ThreadTuning
@@ -0,0 +1,54 @@
+#ifndef THREAD_TUNING_H
+#define THREAD_TUNING_H
+
+#include "config/audio_configs.h"
+#include <QMetaType>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <cstddef>
+
+/**
+ * @brief Planificación efectiva de un hilo tras aplicar la configuración
+ */
+struct ThreadSchedulingReport {
+    QString threadName;            ///< "capture", "dsp", ...
+    QString policy;                ///< Política leída del sistema
+    int priority = 0;              ///< Prioridad de tiempo real (0 si no aplica)
+    int niceValue = 0;             ///< Nice efectivo del hilo
+    QVector<int> affinity;         ///< Núcleos en los que puede ejecutarse
+    qint64 lockedBytes = 0;        ///< Memoria bloqueada con mlock
+    QStringList fallbacks;         ///< Ajustes que no se pudieron aplicar y su motivo
+
+    /** Resumen en una línea para estadísticas y logs */
+    QString toString() const;
+};
+
+Q_DECLARE_METATYPE(ThreadSchedulingReport)
+
+/**
+ * @brief Utilidades de planificación para los hilos del pipeline
+ *
+ * Implementado con pthread/sched en Linux. En otras plataformas sólo se
+ * ajusta la prioridad de QThread y el resto se informa como fallback.
+ */
+namespace ThreadTuning {
+
+/**
+ * @brief Aplica la configuración al hilo que llama y devuelve lo conseguido
+ *
+ * Se puede volver a llamar en caliente: Default devuelve el hilo a
+ * SCHED_OTHER con el nice configurado, y una afinidad vacía a todos los núcleos.
+ */
+ThreadSchedulingReport applyToCurrentThread(const QString& threadName,
+                                            const ThreadSchedulingConfig& config);
+
+/** Bloquea en RAM una región (mlock); error opcional con el motivo */
+bool lockMemory(const void* address, std::size_t length, QString* error = nullptr);
+
+/** Desbloquea una región previamente bloqueada */
+void unlockMemory(const void* address, std::size_t length);
+
+} // namespace ThreadTuning
+
+#endif // THREAD_TUNING_H
@@ -0,0 +1,106 @@
+#include "transfer_function.h"
+#include <QDebug>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+TransferFunctionEstimator::TransferFunctionEstimator(const TransferFunctionConfig& config)
+{
+    setConfig(config);
+}
+
+void TransferFunctionEstimator::setConfig(const TransferFunctionConfig& config) {
+    m_config = config;
+
+    if (m_config.fftSize <= 0) {
+        qWarning() << "TransferFunctionEstimator: fftSize inválido, usando 1024";
+        m_config.fftSize = 1024;
+    }
+    if (m_config.averages < 0) {
+        m_config.averages = 0;
+    }
+
+    reset();
+}
+
+void TransferFunctionEstimator::reset() {
+    const int bins = m_config.fftSize / 2 + 1;
+    m_gxx.fill(0.0f, bins);
+    m_gyy.fill(0.0f, bins);
+    m_gxyRe.fill(0.0f, bins);
+    m_gxyIm.fill(0.0f, bins);
+    m_count = 0;
+}
+
+TransferFunctionFrame TransferFunctionEstimator::process(const QVector<ComplexSpectrum>& spectra) {
+    TransferFunctionFrame out;
+
+    const int ref = m_config.referenceChannel;
+    const int rsp = m_config.responseChannel;
+    if (ref < 0 || rsp < 0 || ref >= spectra.size() || rsp >= spectra.size()) {
+        return out;
+    }
+
+    const int bins = m_gxx.size();
+    const ComplexSpectrum& X = spectra[ref];
+    const ComplexSpectrum& Y = spectra[rsp];
+    if (X.bins() != bins || Y.bins() != bins) {
+        qWarning() << "TransferFunctionEstimator: bins inesperados" << X.bins() << Y.bins()
+                   << "esperados" << bins;
+        return out;
+    }
+
+    // Peso del nuevo frame: media exacta hasta `averages`, luego exponencial
+    ++m_count;
+    const qint64 n = (m_config.averages > 0) ? std::min<qint64>(m_count, m_config.averages) : m_count;
+    const float w = 1.0f / float(n);
+
+    {
+        const float* __restrict xr = X.re.constData();
+        const float* __restrict xi = X.im.constData();
+        const float* __restrict yr = Y.re.constData();
+        const float* __restrict yi = Y.im.constData();
+        float* __restrict gxx = m_gxx.data();
+        float* __restrict gyy = m_gyy.data();
+        float* __restrict gre = m_gxyRe.data();
+        float* __restrict gim = m_gxyIm.data();
+
+        for (int k = 0; k < bins; ++k) {
+            const float pxx = xr[k] * xr[k] + xi[k] * xi[k];
+            const float pyy = yr[k] * yr[k] + yi[k] * yi[k];
+            // conj(X) · Y
+            const float cre = xr[k] * yr[k] + xi[k] * yi[k];
+            const float cim = xr[k] * yi[k] - xi[k] * yr[k];
+            gxx[k] += w * (pxx - gxx[k]);
+            gyy[k] += w * (pyy - gyy[k]);
+            gre[k] += w * (cre - gre[k]);
+            gim[k] += w * (cim - gim[k]);
+        }
+    }
+
+    out.h1MagDb.resize(bins);
+    out.h2MagDb.resize(bins);
+    out.phaseRad.resize(bins);
+    out.coherence.resize(bins);
+    out.averages = int(std::min<qint64>(m_count, std::numeric_limits<int>::max()));
+
+    constexpr float eps = 1e-30f;
+    const float floorDb = m_config.floorDb;
+    for (int k = 0; k < bins; ++k) {
+        const float gxx = m_gxx[k];
+        const float gyy = m_gyy[k];
+        const float absGxy2 = m_gxyRe[k] * m_gxyRe[k] + m_gxyIm[k] * m_gxyIm[k];
+        const float absGxy = std::sqrt(absGxy2);
+
+        // |H1| = |Gxy|/Gxx ; |H2| = Gyy/|Gxy|
+        out.h1MagDb[k] = (gxx > eps && absGxy > eps)
+                             ? 20.0f * std::log10(absGxy / gxx) : floorDb;
+        out.h2MagDb[k] = (absGxy > eps && gyy > eps)
+                             ? 20.0f * std::log10(gyy / absGxy) : floorDb;
+        out.phaseRad[k] = std::atan2(m_gxyIm[k], m_gxyRe[k]);
+        out.coherence[k] = (gxx > eps && gyy > eps)
+                               ? std::clamp(absGxy2 / (gxx * gyy), 0.0f, 1.0f) : 0.0f;
+    }
+
+    return out;
+}
@@ -0,0 +1,58 @@
+#ifndef TRANSFER_FUNCTION_H
+#define TRANSFER_FUNCTION_H
+
+#include "core/analysis_types.h"
+#include <QVector>
+#include <QtTypes>
+
+/**
+ * @brief Configuración del estimador de función de transferencia
+ */
+struct TransferFunctionConfig {
+    int   fftSize = 1024;          ///< Debe coincidir con el de los espectros de entrada
+    int   referenceChannel = 0;    ///< Canal de excitación (x)
+    int   responseChannel = 1;     ///< Canal de respuesta (y)
+    int   averages = 64;           ///< Longitud del promedio (0 = acumulativo sin límite)
+    float floorDb = -100.0f;       ///< Valor para magnitudes nulas
+};
+
+/**
+ * @brief Estimador incremental H1/H2 y coherencia (Welch)
+ *
+ * Mantiene Gxx, Gyy y Gxy por bin. Los primeros `averages` frames se
+ * promedian de forma exacta; a partir de ahí el promedio pasa a ser
+ * exponencial con peso 1/averages. La memoria es constante (cuatro
+ * arrays de bins) sea cual sea la duración del promedio, y el resultado
+ * se refina con cada hop.
+ */
+class TransferFunctionEstimator
+{
+public:
+    explicit TransferFunctionEstimator(const TransferFunctionConfig& config);
+
+    TransferFunctionConfig getConfig() const { return m_config; }
+    void setConfig(const TransferFunctionConfig& config);
+
+    /** Descarta el promedio acumulado */
+    void reset();
+
+    /** Frames acumulados */
+    qint64 count() const { return m_count; }
+
+    /**
+     * @brief Acumula un hop (espectros complejos por canal) y devuelve
+     *        la estimación actualizada
+     */
+    TransferFunctionFrame process(const QVector<ComplexSpectrum>& spectra);
+
+private:
+    TransferFunctionConfig m_config;
+    qint64 m_count = 0;
+
+    QVector<float> m_gxx;          ///< Autoespectro de referencia
+    QVector<float> m_gyy;          ///< Autoespectro de respuesta
+    QVector<float> m_gxyRe;        ///< Espectro cruzado conj(X)·Y (real)
+    QVector<float> m_gxyIm;        ///< Espectro cruzado conj(X)·Y (imag)
+};
+
+#endif // TRANSFER_FUNCTION_H
@@ -4,17 +4,28 @@
 #include <QFileDialog>
 #include <QColorDialog>
 #include <QDir>
+#include <QFile>
 #include <QFileInfo>
 #include <QDebug>
 #include <QRadioButton>
+#include <algorithm>
+#include <stdexcept>
 #include "core/controller.h"
+#include "core/async_logger.h"
+#include "core/startup_profiler.h"
+#include "core/metrics_registry.h"
+#include "core/audio_db_reader.h"
+#include "core/session_file.h"
+#include "receivers/network_receiver.h"
 
 
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
     , m_audioDb(nullptr)
     , m_waveformRenderer(nullptr)
+    , m_waveformProvider(nullptr)
     , m_spectrogramRenderer(nullptr)
+    , m_spectrumAnalyzer(nullptr)
     , m_centralWidget(nullptr)
     , m_isStreaming(false)
     , m_isPaused(false)
@@ -118,6 +129,20 @@ void MainWindow::setupMenuBar()
     m_fullScreenAction->setCheckable(true);
     m_viewMenu->addAction(m_fullScreenAction);
 
+    m_timingHudAction = new QAction("Render &Timing HUD", this);
+    m_timingHudAction->setCheckable(true);
+    m_timingHudAction->setStatusTip("Show processing and paint times on the waveform and spectrogram");
+    m_viewMenu->addAction(m_timingHudAction);
+
+    m_overviewAction = new QAction("New &Overview Window", this);
+    m_overviewAction->setStatusTip("Open another waveform and spectrogram over the whole retained stream");
+    m_viewMenu->addAction(m_overviewAction);
+
+    m_historyAction = new QAction("Session &History", this);
+    m_historyAction->setCheckable(true);
+    m_historyAction->setStatusTip("Show the whole stored session in the waveform and spectrogram");
+    m_viewMenu->addAction(m_historyAction);
+
     // Tools Menu
     m_toolsMenu = menuBar()->addMenu("&Tools");
 
@@ -202,18 +227,26 @@ void MainWindow::setupCentralWidget()
     // Crear renderers
     m_waveformRenderer = new WaveformRenderer;
     m_spectrogramRenderer = new SpectrogramRenderer;
+    m_spectrumAnalyzer = new SpectrumAnalyzerView;
+
+    // Historial de la waveform (Session History): la sesión se asigna al mostrarlo
+    m_waveformProvider = new WaveformDataProvider(this);
+    m_waveformRenderer->setDataProvider(m_waveformProvider);
 
     // Configurar políticas de tamaño
     m_waveformRenderer->setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Expanding);
     m_spectrogramRenderer->setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Expanding);
+    m_spectrumAnalyzer->setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Expanding);
 
     // Añadir widgets al splitter vertical
     m_visualSplitter->addWidget(m_waveformRenderer);
     m_visualSplitter->addWidget(m_spectrogramRenderer);
+    m_visualSplitter->addWidget(m_spectrumAnalyzer);
 
-    // Configurar proporciones del splitter vertical (3:1 para Waveform vs Spectrogram)
+    // Configurar proporciones del splitter vertical (3:1:1 para Waveform, Spectrogram y analizador)
     m_visualSplitter->setStretchFactor(0, 3);
     m_visualSplitter->setStretchFactor(1, 1);
+    m_visualSplitter->setStretchFactor(2, 1);
 
     // Crear panel de configuración
     m_settingsTab = new QTabWidget;
@@ -509,6 +542,12 @@ void MainWindow::setupConnections()
     connect(m_settingsAction, &QAction::triggered, this, &MainWindow::showSettings);
     connect(m_aboutAction, &QAction::triggered, this, &MainWindow::showAbout);
     connect(m_fullScreenAction, &QAction::triggered, this, &MainWindow::toggleFullScreen);
+    connect(m_overviewAction, &QAction::triggered, this, &MainWindow::openOverviewWindow);
+    connect(m_historyAction, &QAction::toggled, this, &MainWindow::showSessionHistory);
+    connect(m_timingHudAction, &QAction::toggled, [this](bool visible) {
+        m_waveformRenderer->setTimingHudVisible(visible);
+        m_spectrogramRenderer->setTimingHudVisible(visible);
+    });
 
     // Toolbar actions
     connect(m_startAction, &QAction::triggered, this, &MainWindow::startStreaming);
@@ -547,12 +586,16 @@ void MainWindow::setupConnections()
     connect(m_clearDbBtn, &QPushButton::clicked, [this]() {
         if (QMessageBox::question(this, "Clear Database",
                                   "Are you sure you want to clear all database records?") == QMessageBox::Yes) {
-            if (m_audioDb) {
-                m_audioDb->clearDatabase();
-                m_statusLabel->setText("Database cleared");
-            }
+            m_statusLabel->setText("Clearing database...");
+            m_ctrl->clearSession();
         }
     });
+    connect(m_ctrl, &Controller::sessionCleared, this, [this](const QString& path, bool ok) {
+        if (path.isEmpty())
+            m_statusLabel->setText("No finished session to clear");
+        else
+            m_statusLabel->setText(ok ? "Database cleared" : "Failed to clear database (see log)");
+    });
 
     connect(m_testConnectionBtn, &QPushButton::clicked, [this]() {
         // Test network connection
@@ -589,6 +632,7 @@ void MainWindow::initializeComponents()
     // Enchufa las vistas al Controller
     m_ctrl->setWaveformView(m_waveformRenderer);
     m_ctrl->setSpectrogramView(m_spectrogramRenderer);
+    m_ctrl->setSpectrumAnalyzerView(m_spectrumAnalyzer);
 
     // Logs
     connect(m_ctrl, &Controller::databaseChanged, [](const QString& p){
@@ -597,8 +641,21 @@ void MainWindow::initializeComponents()
     connect(m_ctrl, &Controller::errorOccurred, [](const QString& e){
         qWarning() << "[MAINWINDOW] ERROR:" << e;
     });
-    connect(m_ctrl, &Controller::framesReady, [](const QVector<FrameData>& frames){
-        qDebug() << "[MAINWINDOW] Frames:" << frames.size();
+    // El Controller puede parar por su cuenta (p. ej. la DB no abrió)
+    connect(m_ctrl, &Controller::capturingChanged, this, [this](bool capturing){
+        if (!capturing && m_isStreaming) {
+            stopStreaming();
+            m_statusLabel->setText("Capture stopped (see log)");
+        }
+    });
+    connect(m_ctrl, &Controller::sessionFinalized, this, [this](const QString& path, qint64, qint64){
+        if (path != m_finalizingSession) return;
+        m_finalizingSession.clear();
+        m_saveAction->setEnabled(true);
+        if (!m_isStreaming) m_statusLabel->setText("Session finalized");
+    });
+    connect(m_ctrl, &Controller::threadSchedulingReported, this, [this](const ThreadSchedulingReport&){
+        m_statusLabel->setToolTip(m_ctrl->schedulingSummary());
     });
     connect(m_ctrl, &Controller::audioFormatDetected, this, [this](const QAudioFormat& f){
         m_statusLabel->setText(
@@ -674,7 +731,17 @@ void MainWindow::initializeComponents()
         m_urlEdit->setText("http://stream.radioparadise.com/aac-128");
     }
 
-    refreshAudioDevices();              // llena m_audioDeviceCombo
+    // Enumerar dispositivos (QMediaDevices) y cargar GStreamer es lo más
+    // caro del arranque: se hace tras mostrar la ventana, no antes
+    m_audioDeviceCombo->addItem("<Enumerating devices...>");
+    m_audioDeviceCombo->setEnabled(false);
+    QTimer::singleShot(0, this, [this]() {
+        ensureAudioDevices();
+        StartupProfiler::instance().mark("audio devices");
+    });
+    // gst_init en segundo plano, una vez mostrada la ventana
+    QTimer::singleShot(0, this, []() { NetworkReceiver::prewarm(); });
+
     QMetaObject::invokeMethod(this, [this](){
         // sincroniza habilitado inicial según el radio seleccionado
         if (m_inputRadioNetwork) {
@@ -689,6 +756,23 @@ void MainWindow::initializeComponents()
 
 
 
+namespace {
+
+// Copia el fichero de sesión en el pool de E/S; sustituye el destino
+Task<void> copySessionFile(QObject* context, CancellationToken token, QString from, QString to)
+{
+    co_await AsyncTask::run(context, token, [from, to]() {
+        if (QFile::exists(to) && !QFile::remove(to)) {
+            throw std::runtime_error(QString("cannot replace %1").arg(to).toStdString());
+        }
+        if (!QFile::copy(from, to)) {
+            throw std::runtime_error(QString("cannot copy %1").arg(from).toStdString());
+        }
+    });
+}
+
+} // namespace
+
 // Slot implementations
 void MainWindow::newSession()
 {
@@ -697,6 +781,7 @@ void MainWindow::newSession()
     }
 
     resetAnalysis();
+    closeOpenedSession();
     m_currentSession.clear();
     setWindowTitle("Audio Analyzer - New Session");
     m_statusLabel->setText("New session created");
@@ -707,28 +792,108 @@ void MainWindow::openSession()
     QString fileName = QFileDialog::getOpenFileName(this,
                                                     "Open Session", "", "Session Files (*.session);;All Files (*)");
 
-    if (!fileName.isEmpty()) {
-        // Load session implementation
-        m_currentSession = fileName;
-        setWindowTitle("Audio Analyzer - " + QFileInfo(fileName).baseName());
-        m_statusLabel->setText("Session loaded: " + QFileInfo(fileName).baseName());
+    if (fileName.isEmpty()) {
+        return;
+    }
+
+    // Mapeo + índice: no se lee ningún chunk, el coste no depende de la duración
+    auto reader = QSharedPointer<SessionFileReader>::create();
+    if (!reader->open(fileName)) {
+        m_statusLabel->setText("Cannot open session: " + reader->errorString());
+        return;
+    }
+
+    const SessionFileHeader& header = reader->header();
+    const double seconds = double(reader->lastTimestampNs() - header.startTimestampNs) / 1e9;
+
+    // Guardar después pide un destino nuevo: nunca se escribe sobre el abierto
+    m_openedSession = fileName;
+    m_openedSessionFile = reader;
+    m_currentSession.clear();
+    setWindowTitle("Audio Analyzer - " + QFileInfo(fileName).baseName());
+    m_statusLabel->setText(QString("Session loaded: %1 (%2 blocks, %3 s, %4 chunks%5)")
+                               .arg(QFileInfo(fileName).baseName())
+                               .arg(reader->blockCount())
+                               .arg(seconds, 0, 'f', 1)
+                               .arg(reader->chunks().size())
+                               .arg(reader->isRecovered() ? ", recovered" : ""));
+
+    // Las vistas históricas leen del fichero abierto
+    if (m_historyAction->isChecked()) {
+        showSessionHistory(true);
+    } else {
+        m_historyAction->setChecked(true);
+    }
+}
+
+void MainWindow::closeOpenedSession()
+{
+    if (!m_openedSessionFile) {
+        return;
+    }
+    const bool showing = m_historyAction->isChecked();
+    m_openedSessionFile.reset();
+    m_openedSession.clear();
+    if (showing) {
+        m_historyAction->setChecked(false);
     }
 }
 
 void MainWindow::saveSession()
 {
+    // El fichero sólo está completo (con índice) tras cerrar la captura
+    if (m_isStreaming) {
+        QMessageBox::information(this, "Save Session", "Stop the capture before saving the session.");
+        return;
+    }
+    if (!m_finalizingSession.isEmpty()) {
+        QMessageBox::information(this, "Save Session", "The capture is still being finalized. Try again in a moment.");
+        return;
+    }
+
+    const QString source = Controller::sessionFilePathFor(m_ctrl->currentSessionPath());
+    if (source.isEmpty() || !QFileInfo::exists(source)) {
+        QMessageBox::information(this, "Save Session", "There is no session file to save yet.");
+        return;
+    }
+
     QString fileName = m_currentSession;
     if (fileName.isEmpty()) {
         fileName = QFileDialog::getSaveFileName(this,
                                                 "Save Session", "", "Session Files (*.session);;All Files (*)");
     }
 
-    if (!fileName.isEmpty()) {
-        // Save session implementation
-        m_currentSession = fileName;
-        setWindowTitle("Audio Analyzer - " + QFileInfo(fileName).baseName());
+    if (fileName.isEmpty()) {
+        return;
+    }
+
+    // El fichero abierto es otra sesión (y está mapeado): no se sustituye
+    if (!m_openedSession.isEmpty() &&
+        QFileInfo(fileName).absoluteFilePath() == QFileInfo(m_openedSession).absoluteFilePath()) {
+        QMessageBox::warning(this, "Save Session",
+                             "That file is the opened session. Choose another file to save the capture.");
+        return;
+    }
+
+    m_currentSession = fileName;
+    setWindowTitle("Audio Analyzer - " + QFileInfo(fileName).baseName());
+    if (QFileInfo(fileName).absoluteFilePath() == QFileInfo(source).absoluteFilePath()) {
         m_statusLabel->setText("Session saved: " + QFileInfo(fileName).baseName());
+        return;
     }
+
+    m_saveToken.cancel();
+    m_saveToken = CancellationToken();
+    m_statusLabel->setText("Saving session...");
+
+    copySessionFile(this, m_saveToken, source, fileName)
+        .then(this,
+              [this, fileName]() {
+                  m_statusLabel->setText("Session saved: " + QFileInfo(fileName).baseName());
+              },
+              [this](const QString& error) {
+                  m_statusLabel->setText("Save failed: " + error);
+              });
 }
 
 void MainWindow::exportData()
@@ -736,10 +901,30 @@ void MainWindow::exportData()
     QString fileName = QFileDialog::getSaveFileName(this,
                                                     "Export Data", "", "CSV Files (*.csv);;JSON Files (*.json);;All Files (*)");
 
-    if (!fileName.isEmpty()) {
-        // Export data implementation
-        m_statusLabel->setText("Data exported to: " + QFileInfo(fileName).baseName());
+    if (fileName.isEmpty()) {
+        return;
+    }
+
+    const QString dbPath = m_ctrl->currentSessionPath();
+    if (dbPath.isEmpty()) {
+        QMessageBox::information(this, "Export Data", "There is no session to export yet.");
+        return;
     }
+
+    // Lectura y escritura en el pool de E/S: la GUI sigue respondiendo
+    m_exportToken.cancel();
+    m_exportToken = CancellationToken();
+    m_statusLabel->setText("Exporting...");
+
+    AudioDbReader(dbPath).exportPeaks(this, m_exportToken, fileName, 0, LLONG_MAX)
+        .then(this,
+              [this, fileName](qint64 rows) {
+                  m_statusLabel->setText(QString("Data exported to: %1 (%2 rows)")
+                                             .arg(QFileInfo(fileName).baseName()).arg(rows));
+              },
+              [this](const QString& error) {
+                  m_statusLabel->setText("Export failed: " + error);
+              });
 }
 
 void MainWindow::showSettings()
@@ -762,6 +947,118 @@ void MainWindow::showAbout()
                        "• Network streaming support");
 }
 
+void MainWindow::showSessionHistory(bool show)
+{
+    m_historyToken.cancel();
+    if (!show) {
+        m_spectrogramRenderer->showLive();
+        m_waveformRenderer->showLive();
+        return;
+    }
+
+    // Fichero abierto con Open Session: índice mapeado, sin DB
+    if (m_openedSessionFile) {
+        const SessionFileHeader& header = m_openedSessionFile->header();
+        WaveformDataProvider::Config waveCfg;
+        waveCfg.channels = std::max(1, header.channels);
+        waveCfg.blockFrames = std::max(1, header.blockSize / waveCfg.channels);
+        m_waveformProvider->setSessionFile(m_openedSessionFile, waveCfg);
+        const qint64 blocks = m_openedSessionFile->blockCount();
+        if (blocks > 0) {
+            m_waveformRenderer->showFrameRange(0, blocks * waveCfg.blockFrames);
+        }
+
+        const qint64 lastNs = m_openedSessionFile->lastTimestampNs();
+        if (lastNs > header.startTimestampNs) {
+            m_spectrogramRenderer->showTimeSpan(m_openedSessionFile, header.startTimestampNs, lastNs);
+        }
+        m_statusLabel->setText("Showing " + QFileInfo(m_openedSession).baseName());
+        return;
+    }
+
+    const QString dbPath = m_ctrl->currentSessionPath();
+    if (dbPath.isEmpty()) {
+        m_statusLabel->setText("No session to show");
+        m_historyAction->setChecked(false);
+        return;
+    }
+
+    m_historyToken = CancellationToken();
+
+    // Waveform: todo el audio guardado; el proveedor elige bloques crudos,
+    // su pirámide de picos o los rollups según el zoom
+    WaveformDataProvider::Config waveCfg;
+    waveCfg.channels = std::max(1, m_dspConfig.channelCount);
+    waveCfg.blockFrames = std::max(1, m_dspConfig.blockSize / waveCfg.channels);
+    waveCfg.sampleRate = m_dspConfig.sampleRate;
+    m_waveformProvider->setSession(dbPath, waveCfg);
+    AudioDbReader(dbPath).sampleExtent(this, m_historyToken)
+        .then(this, [this, channels = waveCfg.channels](qint64 samples) {
+            if (!m_historyAction->isChecked() || samples < channels) return;
+            m_waveformRenderer->showFrameRange(0, samples / channels);
+        });
+
+    // Espectrograma: la pirámide de teselas cubre toda la duración con una
+    // lectura por tesela visible
+    AudioDbReader(dbPath).tileTimeSpan(this, m_historyToken)
+        .then(this, [this, dbPath](const QPair<qint64, qint64>& span) {
+            if (!m_historyAction->isChecked()) return;
+            if (span.second <= span.first) {
+                m_statusLabel->setText("Session has no spectrogram tiles yet");
+                return;
+            }
+            m_spectrogramRenderer->showTimeSpan(dbPath, span.first, span.second);
+            m_statusLabel->setText("Showing session history");
+        }, [this](const QString& error) {
+            m_statusLabel->setText("History unavailable: " + error);
+            m_historyAction->setChecked(false);
+        });
+}
+
+void MainWindow::openOverviewWindow()
+{
+    // Vista general de todo lo retenido en el almacén compartido. Lee los
+    // mismos datos que las vistas principales: no añade copias por lote,
+    // sólo su imagen y las teselas de su zoom en la caché común.
+    SpectrumStore* store = m_ctrl->spectrumStore();
+    const SpectrumStoreConfig storeCfg = store->config();
+    const int overviewStride = 8;
+    const QString suffix = QString::number(++m_overviewCount);
+
+    auto* window = new QWidget(this, Qt::Window);
+    window->setAttribute(Qt::WA_DeleteOnClose);
+    window->setWindowTitle("Overview " + suffix);
+    auto* layout = new QVBoxLayout(window);
+
+    auto* waveform = new WaveformRenderer(window);
+    WaveformConfig waveCfg = m_waveformRenderer->getConfig();
+    waveCfg.maxVisibleBlocks = storeCfg.peakCapacity;
+    waveform->setConfig(waveCfg);
+    waveform->setMetricsName("waveform.overview" + suffix);
+    waveform->attachStore(store);
+
+    auto* spectrogram = new SpectrogramRenderer(window);
+    SpectrogramConfig specCfg = m_spectrogramRenderer->config();
+    specCfg.blockWidth = 1;
+    specCfg.maxColumns = storeCfg.spectrumCapacity / overviewStride;
+    spectrogram->setConfig(specCfg);
+    spectrogram->setColorMap(m_spectrogramRenderer->colorMapType());
+    spectrogram->setColumnsPerPixel(overviewStride);
+    spectrogram->setMetricsName("spectrogram.overview" + suffix);
+    spectrogram->attachStore(store, m_ctrl->tileCache());
+
+    const bool showHud = m_timingHudAction->isChecked();
+    waveform->setTimingHudVisible(showHud);
+    spectrogram->setTimingHudVisible(showHud);
+    connect(m_timingHudAction, &QAction::toggled, waveform, &WaveformRenderer::setTimingHudVisible);
+    connect(m_timingHudAction, &QAction::toggled, spectrogram, &SpectrogramRenderer::setTimingHudVisible);
+
+    layout->addWidget(waveform, 1);
+    layout->addWidget(spectrogram, 2);
+    window->resize(900, 500);
+    window->show();
+}
+
 void MainWindow::toggleFullScreen()
 {
     if (isFullScreen()) {
@@ -777,6 +1074,11 @@ void MainWindow::startStreaming()
 {
     if (m_isStreaming) return;
 
+    // La captura nueva pasa a ser la sesión de Session History y se guarda
+    // en un destino propio: no se reutiliza el de la captura anterior
+    closeOpenedSession();
+    m_currentSession.clear();
+
     try {
         // Aplica DSPConfig (si tu Controller expone setter para DSP; si no, lo usará al crear el DSPWorker)
         // m_ctrl->setDspConfig(m_dspConfig); // (si tienes este setter)
@@ -792,6 +1094,7 @@ void MainWindow::startStreaming()
             m_ctrl->setAudioSource(Controller::NetworkAudioInput);
         } else {
             // Físico
+            ensureAudioDevices();
             PhysicalInputConfig phy = buildPhysicalConfigFromUi();
             int err = phy.isValid();
             if (err != 0) {
@@ -834,6 +1137,10 @@ void MainWindow::stopStreaming()
     m_isStreaming = false;
     m_isPaused = false;
 
+    // stopCapture no espera: el .session se completa al llegar sessionFinalized
+    m_finalizingSession = m_ctrl->finalizingSessionPath();
+    m_saveAction->setEnabled(m_finalizingSession.isEmpty());
+
     enableControls(false);
     m_startAction->setEnabled(true);
     m_stopAction->setEnabled(false);
@@ -933,6 +1240,14 @@ void MainWindow::updateSpectrogramConfig()
 
     // Antes: m_spectrogramRenderer->setConfig(m_spectrogramConfig);
     m_ctrl->setSpectrogramConfig(m_spectrogramConfig);   // <<--- vía Controller
+
+    // El analizador comparte frecuencia de muestreo y rango de dB
+    SpectrumAnalyzerConfig analyzerConfig = m_spectrumAnalyzer->config();
+    analyzerConfig.sampleRate = m_spectrogramConfig.sampleRate;
+    analyzerConfig.minDb      = m_spectrogramConfig.minDb;
+    analyzerConfig.maxDb      = m_spectrogramConfig.maxDb;
+    m_spectrumAnalyzer->setConfig(analyzerConfig);
+
     m_statusLabel->setText("Spectrogram configuration updated");
 }
 
@@ -961,7 +1276,7 @@ void MainWindow::updateStats(qint64 blocks, qint64 samples, int buffer)
     m_bufferProgressBar->setValue(buffer);
 
     if (blocks % 50 == 0) {
-        qDebug() << "Stats - Blocks:" << blocks << "Samples:" << samples << "Buffer:" << buffer;
+        TFT_DEBUG(lcUi) << "Stats - Blocks:" << blocks << "Samples:" << samples << "Buffer:" << buffer;
     }
 }
 
@@ -1051,6 +1366,33 @@ void MainWindow::loadSettings()
     m_settings->beginGroup("Database");
     m_dbPathEdit->setText(m_settings->value("path", "/home/m4rc/Desktop/tft-app/TFT-App/audio_capture.db").toString());
     m_settings->endGroup();
+
+    // Planificación de hilos (sin UI; se edita en el fichero de ajustes)
+    m_ctrl->setCaptureThreadScheduling(loadThreadScheduling("Scheduling/Capture"));
+    m_ctrl->setDspThreadScheduling(loadThreadScheduling("Scheduling/DSP"));
+}
+
+ThreadSchedulingConfig MainWindow::loadThreadScheduling(const QString& group) const
+{
+    ThreadSchedulingConfig cfg;
+    m_settings->beginGroup(group);
+    const QString policy = m_settings->value("policy", "default").toString().toLower();
+    if (policy == "fifo") {
+        cfg.policy = ThreadSchedulingConfig::Fifo;
+    } else if (policy == "rr") {
+        cfg.policy = ThreadSchedulingConfig::RoundRobin;
+    }
+    cfg.realtimePriority = qBound(1, m_settings->value("realtimePriority", cfg.realtimePriority).toInt(), 99);
+    cfg.niceValue = qBound(-20, m_settings->value("nice", cfg.niceValue).toInt(), 19);
+    const QStringList cpus = m_settings->value("cpuAffinity").toStringList();
+    for (const QString& cpu : cpus) {
+        bool ok = false;
+        const int index = cpu.trimmed().toInt(&ok);
+        if (ok && index >= 0) cfg.cpuAffinity.append(index);
+    }
+    cfg.lockMemory = m_settings->value("lockMemory", false).toBool();
+    m_settings->endGroup();
+    return cfg;
 }
 
 void MainWindow::saveSettings()
@@ -1085,6 +1427,9 @@ void MainWindow::closeEvent(QCloseEvent *event)
     }
 
     saveSettings();
+
+    // Tiempos de renderizado de la sesión, para diagnósticos sin perfilador
+    TFT_INFO(lcUi).noquote() << MetricsRegistry::instance().report("render.");
     event->accept();
 }
 
@@ -1096,8 +1441,16 @@ void MainWindow::resetToDefaults() {
     // … implementación
 }
 
+void MainWindow::ensureAudioDevices()
+{
+    if (!m_devicesEnumerated) {
+        refreshAudioDevices();
+    }
+}
+
 void MainWindow::refreshAudioDevices()
 {
+    m_devicesEnumerated = true;
     m_audioDeviceCombo->clear();
 
     const auto devices = QMediaDevices::audioInputs(); // Qt 6
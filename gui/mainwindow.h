@@ -31,12 +31,17 @@
 #include <QMediaDevices>
 #include <QAudioDevice>
 #include <QRadioButton>
+#include <QSharedPointer>
 
+#include "core/async_task.h"
 #include "core/audio_db.h"
+#include "core/session_file.h"
 #include "core/dsp_worker.h"
 #include "receivers/network_receiver.h"
 #include "views/waveform_render.h"
+#include "views/waveform_data_provider.h"
 #include "views/spectrogram_renderer.h"
+#include "views/spectrum_analyzer_view.h"
 
 QT_BEGIN_NAMESPACE
 class QSplitter;
@@ -65,6 +70,8 @@ private slots:
     void showSettings();
     void showAbout();
     void toggleFullScreen();
+    void openOverviewWindow();
+    void showSessionHistory(bool show);
 
     // Control de reproducción
     void startStreaming();
@@ -91,6 +98,9 @@ private slots:
 
     void refreshAudioDevices();
 
+    /** Enumera los dispositivos si aún no se hizo (antes de capturar) */
+    void ensureAudioDevices();
+
 private:
     Controller* m_ctrl = nullptr;
 
@@ -108,15 +118,21 @@ private:
 
     void loadSettings();
     void saveSettings();
+    ThreadSchedulingConfig loadThreadScheduling(const QString& group) const;
     void applySettings();
 
     void updateUIFromConfig();
     void enableControls(bool enabled);
 
+    /** Suelta el .session abierto (y su vista histórica) */
+    void closeOpenedSession();
+
     // Componentes principales
     AudioDb* m_audioDb;
     WaveformRenderer* m_waveformRenderer;
+    WaveformDataProvider* m_waveformProvider;
     SpectrogramRenderer* m_spectrogramRenderer;
+    SpectrumAnalyzerView* m_spectrumAnalyzer;
 
     // UI Principal
     QWidget* m_centralWidget;
@@ -139,6 +155,9 @@ private:
     QAction* m_settingsAction;
     QAction* m_aboutAction;
     QAction* m_fullScreenAction;
+    QAction* m_timingHudAction;
+    QAction* m_overviewAction;
+    QAction* m_historyAction;
 
     QActionGroup* m_viewModeGroup;
     QAction* m_waveformOnlyAction;
@@ -245,7 +264,15 @@ private:
     // Estado
     bool m_isStreaming;
     bool m_isPaused;
-    QString m_currentSession;
+    int m_overviewCount = 0;
+    bool m_devicesEnumerated = false;
+    CancellationToken m_exportToken;
+    CancellationToken m_saveToken;
+    CancellationToken m_historyToken;
+    QString m_currentSession;                 ///< Destino elegido al guardar
+    QString m_openedSession;                  ///< Fichero abierto con Open Session
+    QString m_finalizingSession;              ///< Captura parada cuyo .session aún se está cerrando
+    QSharedPointer<SessionFileReader> m_openedSessionFile;
     QSettings* m_settings;
     QTimer* m_uiUpdateTimer;
 
@@ -3,16 +3,32 @@
 #include <QDebug>
 #include "core/controller.h"
 #include "gui/mainwindow.h"
+#include "core/async_logger.h"
+#include "core/startup_profiler.h"
 #include <QCoreApplication>
 
 
 int main(int argc, char *argv[])
 {
+    StartupProfiler::instance().start();
+
     QApplication app(argc, argv);
+    StartupProfiler::instance().mark("QApplication");
+
+    // Logging asíncrono: qDebug/qWarning no bloquean los hilos de captura y DSP
+    AsyncLogger::instance().install();
+    StartupProfiler::instance().mark("logger");
 
-    MainWindow w;
-    w.show();
+    int rc = 0;
+    {
+        MainWindow w;
+        StartupProfiler::instance().mark("MainWindow");
+        w.show();
+        StartupProfiler::instance().mark("show");
+        rc = app.exec();
+    }
 
-    return app.exec();
+    AsyncLogger::instance().shutdown();
+    return rc;
 }
 
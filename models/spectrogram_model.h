@@ -42,7 +42,11 @@ public:
         switch(role) {
         case TimestampRole:    return qint64(f.timestamp);
         case BlockIndexRole:   return f.sampleOffset;  // or f.sampleOffset?
-        case MagnitudesRole:   return QVariant::fromValue(f.spectrum);
+        case MagnitudesRole:
+            // Formato compacto: se expande sólo al consultarlo
+            if (f.spectrum.isEmpty() && !f.compactSpectrum.isEmpty())
+                return QVariant::fromValue(f.compactSpectrum.toFloat());
+            return QVariant::fromValue(f.spectrum);
         case FrequenciesRole:  return QVariant::fromValue(f.frequencies);
         case WindowGainRole:   return f.windowGain;
         default:               return {};
@@ -1,17 +1,31 @@
 #include "receivers/network_receiver.h"
 #include "config/audio_configs.h"
+#include "core/async_logger.h"
 #include <QDebug>
 #include <QDateTime>
+#include <QThreadPool>
+#include <mutex>
+#include "core/startup_profiler.h"
+
+namespace {
+std::once_flag gstInitOnce;
+}
+
+void NetworkReceiver::ensureGstInitialized() {
+    std::call_once(gstInitOnce, []() {
+        gst_init(nullptr, nullptr);
+        StartupProfiler::instance().mark("gst_init");
+    });
+}
+
+void NetworkReceiver::prewarm() {
+    QThreadPool::globalInstance()->start([]() { ensureGstInitialized(); });
+}
 
 NetworkReceiver::NetworkReceiver(QObject* parent)
     : IReceiver(parent)
 {
-    static bool gstInitialized = false;
-    if (!gstInitialized) {
-        gst_init(nullptr, nullptr);
-        gstInitialized = true;
-    }
-
+    // gst_init se difiere a start(): crear el receptor no escanea plugins
     m_busTimer = new QTimer(this);
     // Usar configuración por defecto inicialmente
     m_busTimer->setInterval(m_config.busTimerInterval);
@@ -95,6 +109,9 @@ void NetworkReceiver::start() {
         return;
     }
 
+    // Normalmente ya inicializado por prewarm() en segundo plano
+    ensureGstInitialized();
+
     // Usar el método del config para generar el pipeline
     QString pipelineStr = m_config.getPipelineString();
 
@@ -292,7 +309,7 @@ GstFlowReturn NetworkReceiver::handleNewSample(GstAppSink* appsink) {
 
     // 8) Debug output: usar configuración para decidir si mostrar
     if (m_config.logBufferStats) {
-        qDebug() << QString("Buffer de %1 muestras a %2 Hz → %.3f s → freq ≈ %.1f Hz")
+        TFT_DEBUG(lcNet) << QString("Buffer de %1 muestras a %2 Hz → %3 s → freq ≈ %4 Hz")
                         .arg(sampleCount)
                         .arg(rate)
                         .arg(durSec, 0, 'f', 3)
@@ -25,6 +25,12 @@ public:
     void start() override;
     void stop() override;
 
+    /** Inicializa GStreamer una sola vez (bloquea si otro hilo lo está haciendo) */
+    static void ensureGstInitialized();
+
+    /** Lanza la inicialización de GStreamer (escaneo de plugins) en segundo plano */
+    static void prewarm();
+
 signals:
     void streamFinished();
 
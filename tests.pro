@@ -1,4 +1,4 @@
-QT += core gui widgets testlib
+QT += core gui widgets sql testlib
 CONFIG += c++20 console
 CONFIG -= app_bundle
 
@@ -8,10 +8,55 @@ TEMPLATE = app
 # Archivos fuente
 SOURCES += \
     tests/spectrogram_test.cpp \
-    core/spectrogram_calculator.cpp
+    core/spectrogram_calculator.cpp \
+    core/spectrogram_pyramid.cpp \
+    core/compact_spectrum.cpp \
+    core/spectrum_kernels.cpp \
+    core/fft_plan_cache.cpp \
+    core/metrics_registry.cpp \
+    core/render_timing_stats.cpp \
+    core/spectrum_store.cpp \
+    core/session_file.cpp \
+    core/sparse_block_index.cpp \
+    core/gorilla_codec.cpp \
+    core/rollup_aggregator.cpp \
+    core/fingerprinter.cpp \
+    core/cross_correlator.cpp \
+    core/transfer_function.cpp \
+    core/envelope_analyzer.cpp \
+    core/feature_extractor.cpp \
+    core/async_task.cpp \
+    core/async_logger.cpp \
+    core/audio_db.cpp \
+    core/audio_db_reader.cpp \
+    views/waveform_raster.cpp \
+    views/waveform_data_provider.cpp
 
 HEADERS += \
-    core/spectrogram_calculator.h
+    core/analysis_types.h \
+    core/compact_spectrum.h \
+    core/spectrum_kernels.h \
+    core/spectrogram_calculator.h \
+    core/spectrogram_pyramid.h \
+    core/fft_plan_cache.h \
+    core/metrics_registry.h \
+    core/render_timing_stats.h \
+    core/spectrum_store.h \
+    core/session_file.h \
+    core/sparse_block_index.h \
+    core/gorilla_codec.h \
+    core/rollup_aggregator.h \
+    core/fingerprinter.h \
+    core/cross_correlator.h \
+    core/transfer_function.h \
+    core/envelope_analyzer.h \
+    core/feature_extractor.h \
+    core/async_task.h \
+    core/async_logger.h \
+    core/audio_db.h \
+    core/audio_db_reader.h \
+    views/waveform_raster.h \
+    views/waveform_data_provider.h
 
 # FFTW library
 LIBS += -lfftw3f
@@ -6,6 +6,35 @@
 #include <QTime>
 #include <QElapsedTimer>
 #include "../core/spectrogram_calculator.h"
+#include "../core/spectrum_kernels.h"
+#include "../core/fft_plan_cache.h"
+#include "../core/spectrogram_pyramid.h"
+#include "../core/render_timing_stats.h"
+#include "../core/metrics_registry.h"
+#include "../core/spectrum_store.h"
+#include "../core/session_file.h"
+#include "../core/sparse_block_index.h"
+#include "../core/gorilla_codec.h"
+#include "../core/rollup_aggregator.h"
+#include "../core/fingerprinter.h"
+#include "../core/cross_correlator.h"
+#include "../core/transfer_function.h"
+#include "../core/envelope_analyzer.h"
+#include "../core/feature_extractor.h"
+#include "../core/async_task.h"
+#include "../views/waveform_raster.h"
+#include "../views/waveform_data_provider.h"
+#include "../core/audio_db.h"
+#include "../core/audio_db_reader.h"
+#include <QFile>
+#include <QSemaphore>
+#include <QSet>
+#include <QThread>
+#include <QtEndian>
+#include <QTemporaryDir>
+#include <atomic>
+#include <cmath>
+#include <limits>
 
 class SpectrogramTest : public QObject
 {
@@ -24,6 +53,27 @@ private slots:
     void testPerformance();
     void testWindowCalculation();
     void testWindowTypeString();
+    void testCompactSpectrum();
+    void testSpecializedKernels();
+    void testSpectrogramPyramid();
+    void testRenderTimingStats();
+    void testSpectrumStore();
+    void testSessionFile();
+    void testSparseBlockIndex();
+    void testGorillaCodec();
+    void testRollupAggregator();
+    void testRollupTrend();
+    void testFingerprintClipMatchesCapture();
+    void testCrossCorrelator();
+    void testTransferFunction();
+    void testEnvelopeAnalyzer();
+    void testFeatureExtractor();
+    void testWaveformRasterSpans();
+    void testWaveformRasterCoverage();
+    void testTaskResumesOnContextThread();
+    void testTaskCancellation();
+    void testTaskContextDestroyed();
+    void testWaveformDataProvider();
 
 private:
     SpectrogramCalculator* calculator;
@@ -31,6 +81,9 @@ private:
     // Función auxiliar para generar señal sinusoidal
     QVector<float> generateSineWave(float frequency, float sampleRate, int samples, float amplitude = 1.0f);
 
+    // Función auxiliar para generar ruido blanco uniforme en [-amplitude, amplitude] (reproducible)
+    QVector<float> generateNoise(int samples, quint32 seed, float amplitude = 1.0f);
+
     // Función auxiliar para verificar picos de frecuencia
     bool findPeakNearFrequency(const QVector<float>& magnitudes, const QVector<float>& frequencies,
                                float targetFreq, float tolerance = 50.0f);
@@ -359,6 +412,1522 @@ void SpectrogramTest::testWindowTypeString()
     qDebug() << "✓ Conversión a string correcta";
 }
 
+void SpectrogramTest::testCompactSpectrum()
+{
+    qDebug() << "Test: Formatos compactos de espectro";
+
+    SpectrogramConfig config;
+    config.fftSize = 1024;
+    config.sampleRate = 44100;
+    config.windowType = WindowType::Hann;
+    config.logScale = true;
+    config.noiseFloor = -120.0f;
+    config.maxDb = 20.0f;
+    calculator->setConfig(config);
+
+    QVector<float> sineWave = generateSineWave(1000.0f, 44100, 1024, 0.5f);
+    const SpectrogramFrame reference = calculator->calculateFrame(sineWave);
+    QVERIFY(!reference.magnitudes.isEmpty());
+    QVERIFY(reference.compact.isEmpty());
+
+    // Error admisible: relativo para float16 (10 bits de mantisa), medio
+    // paso de cuantificación sobre [-120, 20] dB para los enteros
+    struct Case { SpectrumFormat format; int bytes; float tolerance; bool relative; };
+    const QVector<Case> cases = {
+        { SpectrumFormat::Float16, 2, 0.0005f, true },
+        { SpectrumFormat::UInt16,  2, 0.005f, false },
+        { SpectrumFormat::UInt8,   1, 0.3f, false }
+    };
+
+    for (const Case& c : cases) {
+        config.outputFormat = c.format;
+        calculator->setConfig(config);
+
+        const SpectrogramFrame frame = calculator->calculateFrame(sineWave);
+        QVERIFY(frame.magnitudes.isEmpty());
+        QCOMPARE(frame.compact.bins, reference.magnitudes.size());
+        QCOMPARE(frame.compact.data.size(), qsizetype(frame.compact.bins) * c.bytes);
+
+        const QVector<float> decoded = frame.compact.toFloat();
+        for (int i = 0; i < decoded.size(); ++i) {
+            const float expected = c.relative
+                ? reference.magnitudes[i]
+                : qBound(config.noiseFloor, reference.magnitudes[i], config.maxDb);
+            const float tolerance = c.relative ? qAbs(expected) * c.tolerance + 1e-3f : c.tolerance;
+            QVERIFY2(qAbs(decoded[i] - expected) <= tolerance,
+                     qPrintable(QString("bin %1: %2 vs %3").arg(i).arg(decoded[i]).arg(expected)));
+        }
+
+        // El kernel directo y el empaquetado a posteriori coinciden: mismos
+        // bytes salvo redondeos de frontera, como mucho un código de diferencia
+        const CompactSpectrum packed = CompactSpectrum::encode(reference.magnitudes, c.format,
+                                                               config.noiseFloor, config.maxDb);
+        QCOMPARE(packed.format, frame.compact.format);
+        QCOMPARE(packed.bins, frame.compact.bins);
+        QCOMPARE(packed.data.size(), frame.compact.data.size());
+        const float step = c.relative
+            ? 0.0f
+            : (config.maxDb - config.noiseFloor) / float(CompactSpectrum::maxCode(c.format));
+        int differing = 0;
+        for (int i = 0; i < packed.bins; ++i) {
+            const float a = packed.valueAt(i);
+            const float b = frame.compact.valueAt(i);
+            if (a == b) continue;
+            ++differing;
+            const float tolerance = c.relative ? qAbs(a) * c.tolerance + 1e-3f : step * 1.001f;
+            QVERIFY2(qAbs(a - b) <= tolerance,
+                     qPrintable(QString("bin %1: encode %2 vs kernel %3").arg(i).arg(a).arg(b)));
+        }
+        QVERIFY2(differing <= packed.bins / 100 + 1,
+                 qPrintable(QString("%1 bins difieren").arg(differing)));
+    }
+
+    config.outputFormat = SpectrumFormat::Float32;
+    calculator->setConfig(config);
+
+    qDebug() << "✓ Formatos compactos dentro de tolerancia";
+}
+
+void SpectrogramTest::testSpecializedKernels()
+{
+    qDebug() << "Test: Kernels especializados frente al genérico";
+
+    QVERIFY(SpectrumKernels::isSpecialized(1024));
+    QVERIFY(!SpectrumKernels::isSpecialized(1000));
+
+    for (int N : {256, 1024, 8192, 1000}) {
+        const int bins = N / 2 + 1;
+        const QVector<float> window = SpectrogramCalculator::calculateWindow(WindowType::Hann, N);
+        // Frame más corto que N para cubrir el relleno con ceros
+        const QVector<float> samples = generateSineWave(1000.0f, 44100, N - N / 4, 0.5f);
+
+        for (bool windowed : {false, true}) {
+            for (bool logScale : {false, true}) {
+                QVector<float> scratch(N), magA(bins), magB(bins), re(bins), im(bins);
+                QVector<float> spectrum(bins * 2);
+
+                SpectrumKernelIo io;
+                io.samples = samples.constData();
+                io.count = samples.size();
+                io.fftSize = N;
+                io.window = window.constData();
+                io.scratch = scratch.data();
+                io.spectrum = reinterpret_cast<fftwf_complex*>(spectrum.data());
+                io.plan = FftPlanCache::instance().r2c(N);
+                io.normDiv = float(N);
+                io.noiseFloor = -100.0f;
+                QVERIFY(io.plan != nullptr);
+
+                io.magnitudes = magA.data();
+                io.re = re.data();
+                io.im = im.data();
+                SpectrumKernels::select(N, windowed, logScale)(io);
+
+                io.magnitudes = magB.data();
+                io.re = io.im = nullptr;
+                SpectrumKernels::generic(windowed, logScale)(io);
+
+                for (int k = 0; k < bins; ++k) {
+                    QCOMPARE(magA[k], magB[k]);
+                }
+
+                // Referencia independiente de los kernels: el camino clásico
+                // applyWindow + applyFFT (relleno, ventana, r2c, |X|/norma, dB)
+                QVector<float> windowedData(N, 0.0f);
+                for (int i = 0; i < samples.size(); ++i) {
+                    windowedData[i] = windowed ? samples[i] * window[i] : samples[i];
+                }
+                QVector<float> refSpectrum(bins * 2);
+                fftwf_execute_dft_r2c(io.plan, windowedData.data(),
+                                      reinterpret_cast<fftwf_complex*>(refSpectrum.data()));
+                for (int k = 0; k < bins; ++k) {
+                    const float rk = refSpectrum[2 * k], ik = refSpectrum[2 * k + 1];
+                    const float refLinear = std::sqrt(rk * rk + ik * ik) / io.normDiv;
+                    if (logScale && refLinear == 0.0f) {
+                        QCOMPARE(magA[k], io.noiseFloor);
+                        continue;
+                    }
+                    // En lineal para no amplificar en dB el ruido de redondeo de bins casi nulos
+                    const float gotLinear = logScale ? std::pow(10.0f, magA[k] / 20.0f) : magA[k];
+                    QVERIFY2(qAbs(gotLinear - refLinear) <= 1e-5f * refLinear + 1e-7f,
+                             qPrintable(QString("N=%1 bin %2: kernel %3 vs referencia %4")
+                                            .arg(N).arg(k).arg(gotLinear).arg(refLinear)));
+                }
+
+                // La salida compleja opcional coincide con la magnitud
+                const int peak = int(std::max_element(magA.begin(), magA.end()) - magA.begin());
+                const float linear = std::sqrt(re[peak] * re[peak] + im[peak] * im[peak]) / N;
+                const float expected = logScale ? 20.0f * std::log10(linear) : linear;
+                QVERIFY(qAbs(magA[peak] - expected) < 1e-3f * qMax(1.0f, qAbs(expected)));
+            }
+        }
+    }
+
+    qDebug() << "✓ Kernels especializados equivalentes al genérico y al camino clásico";
+}
+
+void SpectrogramTest::testSpectrogramPyramid()
+{
+    PyramidConfig cfg;
+    cfg.bins = 8;
+    cfg.tileColumns = 4;
+    cfg.levels = 3;
+    cfg.freqDecimation = 2;
+    cfg.minDb = -100.0f;
+    cfg.maxDb = 0.0f;
+
+    SpectrogramPyramid pyramid(cfg);
+    QCOMPARE(pyramid.outputBins(), 4);
+
+    // Columna par: tono en el bin 1; impar: silencio
+    QVector<SpectrogramTile> completed;
+    QVector<float> column(8);
+    for (int i = 0; i < 8; ++i) {
+        column.fill(-100.0f);
+        if (i % 2 == 0) column[1] = 0.0f;
+        completed += pyramid.append(column.constData(), column.size(), qint64(i + 1) * 1000);
+    }
+
+    // 8 columnas: 2 teselas de nivel 0 y 1 de nivel 1
+    int level0 = 0, level1 = 0;
+    for (const SpectrogramTile& t : completed) {
+        if (t.level == 0) ++level0;
+        if (t.level == 1) ++level1;
+        QCOMPARE(t.columns, 4);
+        QCOMPARE(t.data.size(), 4 * 4);
+    }
+    QCOMPARE(level0, 2);
+    QCOMPARE(level1, 1);
+
+    // La reducción por máximo conserva el tono en todas las columnas del nivel 1
+    for (const SpectrogramTile& t : completed) {
+        if (t.level != 1) continue;
+        QCOMPARE(t.firstTimestamp, qint64(1000));
+        for (int c = 0; c < t.columns; ++c) {
+            const CompactSpectrum col = t.column(c);
+            QCOMPARE(col.bins, 4);
+            QVERIFY(col.valueAt(0) > -1.0f);   // bins 0-1 -> máximo del grupo
+            QVERIFY(col.valueAt(1) < -99.0f);
+        }
+    }
+
+    // Queda la tesela parcial del nivel 2 (2 columnas)
+    const QVector<SpectrogramTile> pending = pyramid.pendingTiles();
+    QCOMPARE(pending.size(), 1);
+    QCOMPARE(pending[0].level, 2);
+    QCOMPARE(pending[0].columns, 2);
+
+    QCOMPARE(SpectrogramPyramid::levelForSpan(1000, 250, 12), 2);
+    QCOMPARE(SpectrogramPyramid::levelForSpan(100, 250, 12), 0);
+
+    // Continuar una pirámide guardada: los índices siguen a los existentes
+    // (nivel 0 ya tenía 0..1) y nunca retroceden
+    SpectrogramPyramid resumed(cfg);
+    resumed.continueTileIndices({2, 1, 0});
+    resumed.continueTileIndices({0, 0, 0});
+    QVector<SpectrogramTile> resumedTiles;
+    for (int i = 0; i < 8; ++i) {
+        column.fill(-100.0f);
+        resumedTiles += resumed.append(column.constData(), column.size(), qint64(i + 9) * 1000);
+    }
+    QVector<qint64> level0Indices;
+    for (const SpectrogramTile& t : resumedTiles) {
+        if (t.level == 0) level0Indices.append(t.tileIndex);
+        if (t.level == 1) QCOMPARE(t.tileIndex, qint64(1));
+    }
+    QCOMPARE(level0Indices, QVector<qint64>({2, 3}));
+
+    qDebug() << "✓ Pirámide de teselas con reducción por máximo";
+}
+
+void SpectrogramTest::testRenderTimingStats()
+{
+    RenderTimingStats stats("test", 100);
+
+    // 1..100 ms: media 50.5, p99 = 99 ms (rango más cercano)
+    for (int i = 1; i <= 100; ++i) {
+        stats.record(RenderTimingStats::Paint, qint64(i) * 1000000);
+    }
+    RenderTimingStats::Summary paint = stats.summary(RenderTimingStats::Paint);
+    QCOMPARE(paint.samples, 100);
+    QCOMPARE(paint.lastMs, 100.0);
+    QCOMPARE(paint.avgMs, 50.5);
+    QCOMPARE(paint.p99Ms, 99.0);
+
+    // El anillo descarta lo más antiguo: 101..150 sustituyen a 1..50
+    for (int i = 101; i <= 150; ++i) {
+        stats.record(RenderTimingStats::Paint, qint64(i) * 1000000);
+    }
+    paint = stats.summary(RenderTimingStats::Paint);
+    QCOMPARE(paint.samples, 100);
+    QCOMPARE(paint.avgMs, 100.5);
+    QCOMPARE(stats.summary(RenderTimingStats::ImageUpdate).samples, 0);
+
+    // Cuatro frames en un tick = tres fusionados; descartados según el acumulado del bus
+    stats.recordTick(4, 7);
+    stats.recordTick(1, 9);
+    QCOMPARE(stats.coalescedFrames(), quint64(3));
+    QCOMPARE(stats.droppedFrames(), quint64(9));
+
+    stats.publish();
+    MetricsRegistry& registry = MetricsRegistry::instance();
+    QCOMPARE(registry.value("render.test.paint.last_ms"), 150.0);
+    QCOMPARE(registry.value("render.test.coalesced_frames"), 3.0);
+    QVERIFY(registry.snapshot("render.test.").size() >= 11);
+
+    // Tras reset() los descartados cuentan desde el acumulado actual
+    stats.reset();
+    stats.recordTick(1, 12);
+    QCOMPARE(stats.droppedFrames(), quint64(3));
+
+    registry.removePrefix("render.test.");
+    QVERIFY(!registry.contains("render.test.paint.last_ms"));
+
+    // Retirar una vista no borra las que comparten su prefijo ("waveform.overviewN")
+    {
+        RenderTimingStats overview("test.overview1", 10);
+        overview.record(RenderTimingStats::Paint, 2000000);
+        overview.publish();
+        {
+            RenderTimingStats main("test", 10);
+            main.publish();
+            QVERIFY(registry.contains("render.test.paint.last_ms"));
+        }
+        QVERIFY(!registry.contains("render.test.paint.last_ms"));
+        QCOMPARE(registry.value("render.test.overview1.paint.last_ms"), 2.0);
+
+        stats.setName("test.renamed");
+        QCOMPARE(registry.value("render.test.overview1.paint.last_ms"), 2.0);
+    }
+    QVERIFY(registry.snapshot("render.test.overview1.").isEmpty());
+
+    qDebug() << "✓ Estadísticas de tiempos de renderizado";
+}
+
+void SpectrogramTest::testSpectrumStore()
+{
+    SpectrumStoreConfig cfg;
+    cfg.spectrumCapacity = 4;
+    cfg.peakCapacity = 8;
+    cfg.peakLevels = 3;
+    SpectrumStore store(cfg);
+
+    // Bloque i: picos ±(i+1), RMS 1, espectro Float32 de 8 bins
+    QVector<FrameData> batch;
+    for (int i = 0; i < 10; ++i) {
+        FrameData frame;
+        frame.timestamp = quint64(i);
+        frame.sampleOffset = i;
+        frame.peakMin = -float(i + 1);
+        frame.peakMax = float(i + 1);
+        frame.peakRms = 1.0f;
+        frame.spectrum = QVector<float>(8, -50.0f);
+        batch.append(frame);
+    }
+    const quint64 generation = store.generation();
+    store.append(batch);
+
+    // El anillo de espectros retiene las 4 últimas columnas, ya en UInt8
+    QCOMPARE(store.firstColumn(), qint64(6));
+    QCOMPARE(store.endColumn(), qint64(10));
+    QVector<CompactSpectrum> columns;
+    QCOMPARE(store.columns(0, 10, columns), qint64(6));
+    QCOMPARE(columns.size(), 4);
+    QCOMPARE(columns.first().format, SpectrumFormat::UInt8);
+    QVERIFY(qAbs(columns.first().valueAt(3) + 50.0f) < 0.5f);
+
+    // Nivel 0: 8 bloques retenidos
+    QCOMPARE(store.firstBlock(), qint64(2));
+    QCOMPARE(store.endBlock(), qint64(10));
+
+    // Nivel 1: pares completos 1..4 (bloques 2..10)
+    QVector<float> mins, maxs, rms;
+    SpectrumStore::PeakRange range = store.readPeaks(1, 0, 10, mins, maxs, &rms);
+    QCOMPARE(range.firstBlock, qint64(2));
+    QCOMPARE(range.endBlock, qint64(10));
+    QCOMPARE(range.count(), 4);
+    QCOMPARE(mins[0], -4.0f);
+    QCOMPARE(maxs[3], 10.0f);
+    QCOMPARE(rms[2], 1.0f);
+
+    // Nivel 2: sólo grupos completos; retiene el mismo intervalo que el nivel 0
+    range = store.readPeaks(2, 0, 10, mins, maxs, nullptr);
+    QCOMPARE(range.firstBlock, qint64(0));
+    QCOMPARE(range.endBlock, qint64(8));
+    QCOMPARE(maxs[1], 8.0f);
+
+    QCOMPARE(store.peakLevelFor(1.0), 0);
+    QCOMPARE(store.peakLevelFor(4.0), 2);
+    QCOMPARE(store.peakLevelFor(1000.0), 2);
+
+    // Vaciar invalida las teselas pintadas con la generación anterior
+    store.clearSpectra();
+    QCOMPARE(store.endColumn(), qint64(0));
+    QCOMPARE(store.endBlock(), qint64(10));
+    QVERIFY(store.generation() != generation);
+
+    qDebug() << "✓ Almacén compartido de espectros y pirámide de picos";
+}
+
+void SpectrogramTest::testSessionFile()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString path = dir.filePath("test.session");
+
+    SessionFileHeader header;
+    header.sampleRate = 48000;
+    header.blockSize = 4;
+    header.startTimestampNs = 1000;
+
+    SessionFileWriter writer(3);   // 3 bloques por chunk
+    QVERIFY(writer.open(path, header));
+    for (int b = 0; b < 10; ++b) {
+        const float samples[4] = { float(b), -float(b), 0.5f, -0.5f };
+        const qint64 ts = 1000 + b * 100;
+        writer.appendRawBlock(b, b * 4, ts, samples, 4);
+        writer.appendPeak(SessionPeak{ b, b * 4, ts, -float(b), float(b), 0.5f });
+        writer.appendSpectrum(b, ts, CompactSpectrum::encode(QVector<float>{ -10.0f, -20.0f },
+                                                             SpectrumFormat::UInt8, -100.0f, 0.0f));
+    }
+    // Un hueco en los bloques abre otro chunk
+    writer.appendPeak(SessionPeak{ 20, 80, 3000, -1.0f, 1.0f, 0.5f });
+
+    SpectrogramTile tile;
+    tile.level = 1;
+    tile.tileIndex = 0;
+    tile.columns = 2;
+    tile.bins = 3;
+    tile.firstTimestamp = 1000;
+    tile.lastTimestamp = 1100;
+    tile.data = QByteArray("abcdef");
+    writer.appendTile(tile);
+    writer.flush();
+
+    // Sin índice todavía: se recupera recorriendo los chunks
+    {
+        SessionFileReader recovered;
+        QVERIFY(recovered.open(path));
+        QVERIFY(recovered.isRecovered());
+        QCOMPARE(recovered.peaks(0, 100).size(), 11);
+    }
+
+    QVERIFY(writer.close());
+
+    SessionFileReader reader;
+    QVERIFY(reader.open(path));
+    QVERIFY(!reader.isRecovered());
+    QCOMPARE(reader.header().sampleRate, 48000);
+    QCOMPARE(reader.header().startTimestampNs, qint64(1000));
+    QCOMPARE(reader.blockCount(), qint64(21));
+    QCOMPARE(reader.lastTimestampNs(), qint64(3000));
+    for (const SessionChunkInfo& chunk : reader.chunks()) {
+        QVERIFY(reader.verify(chunk));
+    }
+
+    const QVector<SessionChunkInfo> around = reader.chunksForBlocks(SessionChunkType::Peaks, 4, 5);
+    QCOMPARE(around.size(), 1);
+    QCOMPARE(around.first().firstBlock, qint64(3));
+    QCOMPARE(around.first().blockCount, quint32(3));
+
+    const QVector<SessionPeak> peaks = reader.peaks(2, 8);
+    QCOMPARE(peaks.size(), 6);
+    QCOMPARE(peaks.first().blockIndex, qint64(2));
+    QCOMPARE(peaks.first().maxValue, 2.0f);
+    QCOMPARE(peaks.last().timestampNs, qint64(1700));
+
+    const QVector<SessionRawBlock> blocks = reader.rawBlocks(5, 7);
+    QCOMPARE(blocks.size(), 2);
+    QCOMPARE(blocks.first().sampleOffset, qint64(20));
+    QCOMPARE(blocks.first().samples.size(), 4);
+    QCOMPARE(blocks.first().samples[0], 5.0f);
+    QCOMPARE(blocks.last().samples[1], -6.0f);
+
+    const QVector<SpectrogramTile> tiles = reader.tiles(1);
+    QCOMPARE(tiles.size(), 1);
+    QCOMPARE(tiles.first().columns, 2);
+    QCOMPARE(tiles.first().data, QByteArray("abcdef"));
+    QVERIFY(reader.tiles(0).isEmpty());
+
+    // Pie perdido (captura cortada al cerrar): los chunks siguen ahí
+    const int chunkCount = reader.chunks().size();
+    reader.close();
+    QFile file(path);
+    QVERIFY(file.open(QIODevice::ReadWrite));
+    QVERIFY(file.resize(file.size() - 40));
+    file.close();
+
+    QVERIFY(reader.open(path));
+    QVERIFY(reader.isRecovered());
+    QCOMPARE(reader.chunks().size(), chunkCount);
+
+    // Teselas por intervalo: el nivel se elige sobre el índice como en la DB
+    {
+        const QString tilesPath = dir.filePath("tiles.session");
+        SessionFileWriter tileWriter(3);
+        QVERIFY(tileWriter.open(tilesPath, header));
+        SpectrogramTile t;
+        t.columns = 4;
+        t.bins = 1;
+        t.data = QByteArray("wxyz");
+        for (int i = 0; i < 2; ++i) {
+            t.level = 0;
+            t.tileIndex = i;
+            t.firstTimestamp = i * 400;
+            t.lastTimestamp = i * 400 + 300;
+            tileWriter.appendTile(t);
+        }
+        t.level = 1;
+        t.tileIndex = 0;
+        t.firstTimestamp = 0;
+        t.lastTimestamp = 600;
+        tileWriter.appendTile(t);
+        QVERIFY(tileWriter.close());
+
+        SessionFileReader tileReader;
+        QVERIFY(tileReader.open(tilesPath));
+        QVector<SpectrogramTile> span = tileReader.tilesForSpan(0, 700, 8);
+        QCOMPARE(span.size(), 2);
+        QCOMPARE(span.first().level, 0);
+        QCOMPARE(span.last().tileIndex, qint64(1));
+
+        span = tileReader.tilesForSpan(0, 700, 4);
+        QCOMPARE(span.size(), 1);
+        QCOMPARE(span.first().level, 1);
+
+        span = tileReader.tilesForSpan(0, 250, 8);
+        QCOMPARE(span.size(), 1);
+        QCOMPARE(span.first().tileIndex, qint64(0));
+        QCOMPARE(span.first().data, QByteArray("wxyz"));
+    }
+
+    qDebug() << "✓ Fichero de sesión columnar: escritura, índice y recuperación";
+}
+
+void SpectrogramTest::testSparseBlockIndex()
+{
+    // Bloques de 1024 muestras a 48 kHz, como los timestamps del DSP
+    const qint64 start = 1'000'000'000;
+    const double nsPerSample = 1e9 / 48000.0;
+    auto tsFor = [&](qint64 offset) { return start + qint64(offset * nsPerSample); };
+
+    SparseBlockIndex index(16);
+    qint64 row = 1;
+    for (qint64 b = 0; b < 100; ++b) {
+        index.append(b, b * 1024, tsFor(b * 1024), row++);
+    }
+    // Hueco: se pierden los bloques 100-109 (y su audio)
+    for (qint64 b = 110; b < 150; ++b) {
+        index.append(b, b * 1024, tsFor(b * 1024), row++);
+    }
+
+    QCOMPARE(index.blockCount(), qint64(140));
+    QCOMPARE(index.endBlock(), qint64(150));
+    QCOMPARE(index.gapCount(), 1);
+    QVERIFY(index.entryCount() <= 140 / 16 + 3);
+
+    // Bloque -> offset, timestamp (±1 µs) y fila
+    const BlockLocation b37 = index.locate(37);
+    QVERIFY(b37.isValid());
+    QCOMPARE(b37.sampleOffset, qint64(37 * 1024));
+    QVERIFY(qAbs(b37.timestampNs - tsFor(37 * 1024)) <= 1000);
+    QCOMPARE(b37.location, qint64(38));
+
+    const BlockLocation b120 = index.locate(120);
+    QCOMPARE(b120.location, qint64(111));   // 100 filas antes del hueco + 10
+    QVERIFY(!index.locate(105).isValid());
+    QVERIFY(!index.locate(150).isValid());
+
+    // Offset / tiempo -> bloque que lo contiene
+    QCOMPARE(index.locateSampleOffset(37 * 1024 + 500).blockIndex, qint64(37));
+    QCOMPARE(index.locateSampleOffset(105 * 1024).blockIndex, qint64(99));   // en el hueco
+    QCOMPARE(index.firstAtOrAfterSampleOffset(99 * 1024 + 1).blockIndex, qint64(110));
+    QCOMPARE(index.locateTimestamp(tsFor(64 * 1024) + 10).blockIndex, qint64(64));
+    QVERIFY(!index.locateTimestamp(start - 1).isValid());
+
+    // Persistencia
+    SparseBlockIndex loaded;
+    QVERIFY(loaded.fromByteArray(index.toByteArray()));
+    QCOMPARE(loaded.entryCount(), index.entryCount());
+    QCOMPARE(loaded.locate(120).sampleOffset, b120.sampleOffset);
+    QVERIFY(!loaded.fromByteArray(QByteArray("basura")));
+
+    // Cabecera válida con un número de entradas imposible: se rechaza sin reservar
+    QByteArray corrupt = index.toByteArray();
+    qToBigEndian<qint32>(std::numeric_limits<qint32>::max(), corrupt.data() + 40);
+    QVERIFY(!loaded.fromByteArray(corrupt));
+    QCOMPARE(loaded.entryCount(), 0);
+    corrupt = index.toByteArray();
+    qToBigEndian<qint32>(qint32(index.entryCount() + 1), corrupt.data() + 40);
+    QVERIFY(!loaded.fromByteArray(corrupt));
+
+    qDebug() << "✓ Índice disperso de bloques: búsquedas, huecos y persistencia";
+}
+
+void SpectrogramTest::testGorillaCodec()
+{
+    // Picos de bloques de 1024 muestras a 48 kHz: {timestamp, bloque, offset}, {min, max}
+    const qint64 start = 1'700'000'000'000'000'000;
+    const double nsPerBlock = 1024 * 1e9 / 48000.0;
+    const int rows = 470;
+
+    GorillaEncoder encoder(3, 2);
+    QVector<qint64> ts, blocks;
+    QVector<float> mins, maxs;
+    for (int i = 0; i < rows; ++i) {
+        const qint64 block = i < 200 ? i : i + 7;   // hueco de 7 bloques
+        // Picos float sin cuantizar, con min y max asimétricos
+        const float amp = float(0.5 + 0.25 * qSin(i * 0.05) + 0.01 * qSin(i * 1.7));
+        const float hi = i % 50 == 0 ? 0.0f : amp;   // silencio cada 50
+        const float lo = i % 50 == 0 ? 0.0f : -amp * float(0.9 + 0.05 * qCos(i * 0.3));
+        const qint64 ints[] = { start + qint64(block * nsPerBlock), block, block * 1024 };
+        const float floats[] = { lo, hi };
+        encoder.append(ints, floats);
+        ts << ints[0];
+        blocks << block;
+        mins << lo;
+        maxs << hi;
+    }
+    QCOMPARE(encoder.rowCount(), rows);
+    QCOMPARE(encoder.lastInt(1), blocks.last());
+
+    const QByteArray chunk = encoder.data();
+    QCOMPARE(GorillaDecoder::rowCount(chunk), rows);
+
+    GorillaColumns cols;
+    QVERIFY(GorillaDecoder::decode(chunk, cols));
+    QCOMPARE(cols.rows, rows);
+    QCOMPARE(cols.ints.size(), 3);
+    QCOMPARE(cols.floats.size(), 2);
+    for (int i = 0; i < rows; ++i) {
+        QCOMPARE(cols.ints[0][i], ts[i]);
+        QCOMPARE(cols.ints[1][i], blocks[i]);
+        QCOMPARE(cols.ints[2][i], blocks[i] * 1024);
+        QCOMPARE(cols.floats[0][i], mins[i]);
+        QCOMPARE(cols.floats[1][i], maxs[i]);
+    }
+
+    // Frente a una fila de audio_peaks (5 columnas de 8 bytes sin contar índices).
+    // Con floats reales los picos apenas comprimen; lo que se gana viene de
+    // timestamps, bloques y offsets regulares
+    const qint64 rowBytes = qint64(rows) * 40;
+    const double ratio = double(rowBytes) / chunk.size();
+    qDebug() << "  ratio frente a audio_peaks:" << QString::number(ratio, 'f', 2);
+    QVERIFY(ratio > 2.0);
+
+    // Valores extremos: ida y vuelta exacta, bit a bit
+    GorillaEncoder extreme(1, 1);
+    const qint64 ints[] = { std::numeric_limits<qint64>::min(), std::numeric_limits<qint64>::max(), 0, -5 };
+    const float floats[] = { std::numeric_limits<float>::infinity(), -0.0f, 1e-38f, 3.5f };
+    for (int i = 0; i < 4; ++i) {
+        extreme.append(&ints[i], &floats[i]);
+    }
+    QVERIFY(GorillaDecoder::decode(extreme.data(), cols));
+    for (int i = 0; i < 4; ++i) {
+        QCOMPARE(cols.ints[0][i], ints[i]);
+        QCOMPARE(std::signbit(cols.floats[0][i]), std::signbit(floats[i]));
+        QCOMPARE(cols.floats[0][i], floats[i]);
+    }
+
+    // Truncado o con cabecera absurda: se rechaza
+    QVERIFY(!GorillaDecoder::decode(chunk.left(chunk.size() / 2), cols));
+    QCOMPARE(cols.rows, 0);
+    QByteArray bogus = chunk;
+    qToLittleEndian<quint32>(100000000, bogus.data() + 4);
+    QVERIFY(!GorillaDecoder::decode(bogus, cols));
+
+    // Descriptores con compresión: las columnas REAL quedan NULL y la lectura
+    // los recompone desde ts_chunks
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    {
+        AudioDb db(dir.filePath("features.db"));
+        QVERIFY(db.initialize());
+        for (int i = 0; i < 20; ++i) {
+            AudioFeatures f;
+            f.centroidHz = 1000.0f + 13.7f * i;
+            f.rolloffHz = 4000.0f + 0.31f * i;
+            f.flatness = 0.01f * i;
+            f.zeroCrossingRate = 0.003f * i;
+            f.mfcc = { 1.0f, -2.0f };
+            QVERIFY(db.insertFeatures(i, quint64(start + i * 1000), f));
+        }
+        const QList<FeatureRecord> features = db.getFeaturesByTime(start, start + 19'000);
+        QCOMPARE(features.size(), 20);
+        for (const FeatureRecord& r : features) {
+            const int i = int(r.blockIndex);
+            QCOMPARE(r.features.centroidHz, 1000.0f + 13.7f * i);
+            QCOMPARE(r.features.rolloffHz, 4000.0f + 0.31f * i);
+            QCOMPARE(r.features.flatness, 0.01f * i);
+            QCOMPARE(r.features.zeroCrossingRate, 0.003f * i);
+            QCOMPARE(r.features.mfcc.size(), 2);
+        }
+        db.shutdown();
+    }
+
+    qDebug() << "✓ Codec Gorilla:" << chunk.size() << "bytes para" << rows << "picos";
+}
+
+void SpectrogramTest::testRollupAggregator()
+{
+    // 150 s de bloques de 1024 a 48 kHz empezando a las 0:59:59.5: cruza hora y minutos
+    const qint64 start = 3'599'500'000'000;
+    const double nsPerBlock = 1024 * 1e9 / 48000.0;
+    const int blocks = int(150e9 / nsPerBlock);
+
+    RollupAggregator agg;
+    QVector<RollupBucket> changed;
+    qint64 expectedPeaks = 0;
+    for (int i = 0; i < blocks; ++i) {
+        const float amp = i % 100 < 3 ? 0.95f : 0.1f;   // ráfaga de 3 bloques cada 100
+        expectedPeaks += amp > agg.peakThreshold() ? 1 : 0;
+        agg.addBlock(start + qint64(i * nsPerBlock), -amp, amp, amp / std::sqrt(2.0f), &changed);
+    }
+
+    // Segundos cerrados + el abierto cubren todos los bloques una sola vez
+    qint64 total = 0, peaks = 0, events = 0;
+    int closedSeconds = 0;
+    for (const RollupBucket& b : changed) {
+        if (b.level == 0) {
+            ++closedSeconds;
+            total += b.blockCount;
+            peaks += b.peakCount;
+            events += b.eventCount;
+        }
+    }
+    const RollupBucket second = agg.current(0);
+    total += second.blockCount;
+    peaks += second.peakCount;
+    events += second.eventCount;
+    QCOMPARE(closedSeconds, 150);
+    QCOMPARE(total, qint64(blocks));
+    QCOMPARE(peaks, expectedPeaks);
+    QCOMPARE(events, qint64((blocks + 99) / 100));
+
+    // La hora en curso más la anterior (medio segundo) suman todo
+    const RollupBucket hour = agg.current(2);
+    QCOMPARE(hour.startNs, qint64(3'600'000'000'000));
+    qint64 previousHour = 0;
+    for (const RollupBucket& b : changed) {
+        if (b.level == 2 && b.startNs == 0) previousHour = b.blockCount;
+    }
+    QVERIFY(previousHour > 0);
+    QCOMPARE(previousHour + hour.blockCount, qint64(blocks));
+
+    // La hora en curso se publica cada segundo: sólo le falta el segundo abierto
+    qint64 publishedHour = 0;
+    for (const RollupBucket& b : changed) {
+        if (b.level == 2 && b.startNs == hour.startNs) publishedHour = b.blockCount;
+    }
+    QCOMPARE(publishedHour, hour.blockCount - second.blockCount);
+    QCOMPARE(hour.minValue, -0.95f);
+    QCOMPARE(hour.maxValue, 0.95f);
+
+    // RMS / Leq: un seno de amplitud 0.1 da -23 dBFS; las ráfagas lo suben
+    RollupAggregator quiet;
+    for (int i = 0; i < 10; ++i) {
+        quiet.addBlock(qint64(i * nsPerBlock), -0.1f, 0.1f, 0.1f / std::sqrt(2.0f));
+    }
+    QVERIFY(qAbs(quiet.current(0).rms() - 0.1 / std::sqrt(2.0)) < 1e-6);
+    QVERIFY(qAbs(quiet.current(0).leqDb() + 23.0103) < 1e-3);
+    QCOMPARE(quiet.current(0).eventCount, qint64(0));
+    QVERIFY(hour.leqDb() > -23.0 && hour.leqDb() < -15.0);
+    QCOMPARE(RollupBucket().leqDb(), -200.0);
+
+    // Enrutado: el nivel más grueso que no supera la resolución pedida
+    const qint64 week = 7LL * 24 * 3600 * 1'000'000'000;
+    QCOMPARE(RollupAggregator::levelForResolution(500'000'000), -1);
+    QCOMPARE(RollupAggregator::levelForResolution(2'000'000'000), 0);
+    QCOMPARE(RollupAggregator::levelForResolution(week / 2000), 1);
+    QCOMPARE(RollupAggregator::levelForResolution(week / 100), 2);
+    QCOMPARE(RollupAggregator::bucketStart(1, 3'659'999'999'999), qint64(3'600'000'000'000));
+
+    qDebug() << "✓ Rollups 1 s / 1 min / 1 h:" << closedSeconds << "segundos," << events << "eventos";
+}
+
+void SpectrogramTest::testRollupTrend()
+{
+    qDebug() << "Test: AudioDb rollups y tendencia (enrutado, agrupado y reapertura)";
+
+    // 150 s a 10 bloques por segundo desde una hora en punto
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString path = dir.filePath("trend.db");
+    const qint64 t0 = 3'600'000'000'000LL;
+    const qint64 second = 1'000'000'000LL;
+    auto amplitude = [](int i) { return 0.2f + 0.01f * float(i % 7); };
+    auto blockCount = [](const QList<RollupBucket>& buckets) {
+        qint64 n = 0;
+        for (const RollupBucket& b : buckets) n += b.blockCount;
+        return n;
+    };
+
+    {
+        AudioDb db(path);
+        QVERIFY(db.initialize());
+        for (int i = 0; i < 1500; ++i) {
+            const quint64 ts = quint64(t0 + qint64(i) * 100'000'000LL);
+            const float a = amplitude(i);
+            QVERIFY(db.insertPeak(i, qint64(i) * 64, -a, a, 0.5f * a, ts));
+            QVERIFY(db.updateRollups(ts, -a, a, 0.5f * a));
+        }
+
+        // El escritor suma el bucket abierto; un lector va como mucho 1 s por detrás
+        QCOMPARE(blockCount(db.getRollups(0, t0, t0 + 150 * second)), qint64(1500));
+        const QList<RollupBucket> hour = db.getRollups(2, t0, t0 + 150 * second);
+        QCOMPARE(hour.size(), 1);
+        QCOMPARE(hour.first().blockCount, qint64(1500));
+        {
+            AudioDb reader(path);
+            reader.setReadOnly(true);
+            QVERIFY(reader.initialize());
+            const QList<RollupBucket> published = reader.getRollups(2, t0, t0 + 150 * second);
+            QCOMPARE(published.size(), 1);
+            QVERIFY(published.first().blockCount >= 1490);
+            reader.shutdown();
+        }
+
+        // 10 s por punto: segundos agrupados de 10 en 10
+        QList<RollupBucket> trend = db.getTrend(t0, t0 + 150 * second - 1, 15);
+        QCOMPARE(trend.size(), 15);
+        for (int p = 0; p < trend.size(); ++p) {
+            QCOMPARE(trend[p].level, 0);
+            QCOMPARE(trend[p].startNs, t0 + p * 10 * second);
+            QCOMPARE(trend[p].blockCount, qint64(100));
+            QCOMPARE(trend[p].maxValue, amplitude(6));
+        }
+
+        // 75 s por punto: minutos agrupados en tramos alineados de 2 min
+        trend = db.getTrend(t0, t0 + 150 * second - 1, 2);
+        QCOMPARE(trend.size(), 2);
+        QCOMPARE(trend[0].level, 1);
+        QCOMPARE(trend[0].startNs, t0);
+        QCOMPARE(trend[0].blockCount, qint64(1200));
+        QCOMPARE(trend[1].startNs, t0 + 120 * second);
+        QCOMPARE(trend[1].blockCount, qint64(300));
+
+        // Por debajo de 1 s por punto: picos por bloque, con su RMS
+        trend = db.getTrend(t0, t0 + second - 1, 20);
+        QCOMPARE(trend.size(), 10);
+        for (int p = 0; p < trend.size(); ++p) {
+            QCOMPARE(trend[p].level, -1);
+            QCOMPARE(trend[p].blockCount, qint64(1));
+            QCOMPARE(trend[p].maxValue, amplitude(p));
+            QVERIFY(qAbs(trend[p].rms() - 0.5 * amplitude(p)) < 1e-6);
+        }
+        db.shutdown();
+    }
+
+    // Otra captura sobre el mismo fichero continúa los buckets, incluido el
+    // segundo 149 que la primera dejó a medias
+    {
+        AudioDb db(path);
+        QVERIFY(db.initialize());
+        for (int i = 0; i < 300; ++i) {
+            const quint64 ts = quint64(t0 + 149'950'000'000LL + qint64(i) * 100'000'000LL);
+            QVERIFY(db.updateRollups(ts, -0.9f, 0.9f, 0.45f));
+        }
+        const QList<RollupBucket> hour = db.getRollups(2, t0, t0 + 180 * second);
+        QCOMPARE(hour.size(), 1);
+        QCOMPARE(hour.first().blockCount, qint64(1800));
+        db.shutdown();
+    }
+
+    AudioDb reader(path);
+    reader.setReadOnly(true);
+    QVERIFY(reader.initialize());
+    const QList<RollupBucket> seconds = reader.getRollups(0, t0, t0 + 180 * second);
+    QCOMPARE(blockCount(seconds), qint64(1800));
+    for (const RollupBucket& b : seconds) {
+        if (b.startNs == t0 + 149 * second) QCOMPARE(b.blockCount, qint64(11));
+    }
+    const QList<RollupBucket> minutes = reader.getRollups(1, t0, t0 + 180 * second);
+    QCOMPARE(minutes.size(), 3);
+    QCOMPARE(minutes[2].blockCount, qint64(600));
+    QCOMPARE(minutes[2].maxValue, 0.9f);
+    QCOMPARE(minutes[2].minValue, -0.9f);
+    const QList<RollupBucket> hour = reader.getRollups(2, t0, t0 + 180 * second);
+    QCOMPARE(hour.size(), 1);
+    QCOMPARE(hour.first().blockCount, qint64(1800));
+    QCOMPARE(hour.first().lastNs, t0 + 149'950'000'000LL + 299 * 100'000'000LL);
+    reader.shutdown();
+
+    qDebug() << "✓ Rollups en AudioDb:" << hour.first().blockCount << "bloques en la hora tras reabrir";
+}
+
+void SpectrogramTest::testFingerprintClipMatchesCapture()
+{
+    // Configuración no por defecto: Blackman y bloques de 512 rellenados hasta FFT 1024
+    FingerprintConfig fpConfig;
+    fpConfig.fftSize = 1024;
+    fpConfig.sampleRate = 48000;
+    fpConfig.hopSize = 512;
+    fpConfig.windowType = int(WindowType::Blackman);
+    fpConfig.minFreqHz = 300.0f;
+    fpConfig.maxFreqHz = 6000.0f;
+
+    // Tres tonos por bloque que cambian cada 4 bloques (pseudoaleatorio reproducible)
+    const int blocks = 400;
+    QVector<float> signal(blocks * fpConfig.hopSize);
+    quint32 lcg = 12345;
+    float freqs[3] = {};
+    for (int b = 0; b < blocks; ++b) {
+        if (b % 4 == 0) {
+            for (float& f : freqs) {
+                lcg = lcg * 1664525u + 1013904223u;
+                f = 400.0f + float(lcg >> 8) / float(1 << 24) * 5000.0f;
+            }
+        }
+        for (int i = 0; i < fpConfig.hopSize; ++i) {
+            const int n = b * fpConfig.hopSize + i;
+            float v = 0.0f;
+            for (float f : freqs) v += 0.3f * qSin(2.0 * M_PI * f * n / fpConfig.sampleRate);
+            signal[n] = v;
+        }
+    }
+
+    // Captura: un espectro por bloque como DSPWorker::computeChannelSpectra
+    SpectrogramConfig spConfig(fpConfig.fftSize, fpConfig.hopSize, fpConfig.sampleRate);
+    spConfig.windowType = WindowType::Blackman;
+    SpectrogramCalculator calculator(spConfig);
+    Fingerprinter capture(fpConfig);
+    QSet<QPair<quint32, qint64>> stored;
+    ComplexSpectrum spectrum;
+    for (int b = 0; b < blocks; ++b) {
+        calculator.calculateFrame(signal.mid(b * fpConfig.hopSize, fpConfig.hopSize), 0, 0, &spectrum);
+        for (const FingerprintHash& h : capture.process(spectrum, b)) {
+            stored.insert(qMakePair(h.hash, h.anchorFrame));
+        }
+    }
+    QVERIFY(stored.size() > 1000);
+
+    // Consulta: un clip que empieza en el bloque 150 (más un resto que se descarta)
+    const int clipStart = 150;
+    const QVector<float> clip = signal.mid(clipStart * fpConfig.hopSize, 120 * fpConfig.hopSize + 100);
+    Fingerprinter query(fpConfig);
+    const QVector<FingerprintHash> hashes = query.fingerprintClip(clip);
+    QVERIFY(!hashes.isEmpty());
+
+    // Fuera del arranque del clip (historial incompleto) los hashes son idénticos
+    int comparable = 0, found = 0;
+    for (const FingerprintHash& h : hashes) {
+        if (h.anchorFrame < fpConfig.maxDeltaFrames) continue;
+        ++comparable;
+        found += stored.contains(qMakePair(h.hash, h.anchorFrame + clipStart)) ? 1 : 0;
+    }
+    QVERIFY(comparable > 100);
+    QCOMPARE(found, comparable);
+
+    qDebug() << "✓ Huella de clip:" << found << "de" << comparable << "hashes coinciden con la captura";
+}
+
+void SpectrogramTest::testCrossCorrelator()
+{
+    qDebug() << "Test: CrossCorrelator (GCC-PHAT con retardos enteros conocidos)";
+
+    // Canal 0 de referencia; los demás son el mismo ruido retrasado 7, 20
+    // (justo el límite de maxDelaySec) y 40 muestras (fuera de la búsqueda)
+    const int N = 1024;
+    const int sampleRate = 48000;
+    const int delays[] = { 0, 7, 20, 40 };
+    const int channels = 4;
+    const int margin = 64;
+    const QVector<float> source = generateNoise(N + margin, 4242u, 0.5f);
+
+    CrossCorrelatorConfig ccConfig;
+    ccConfig.fftSize = N;
+    ccConfig.sampleRate = sampleRate;
+    ccConfig.channelCount = channels;
+    ccConfig.pairs = { { 0, 1 }, { 0, 2 }, { 0, 3 } };
+    ccConfig.maxDelaySec = 19.5 / sampleRate;   // ceil -> 20 muestras
+    CrossCorrelator correlator(ccConfig);
+    QCOMPARE(correlator.pairs().size(), 3);
+
+    SpectrogramConfig spConfig(N, N, sampleRate);
+    SpectrogramCalculator calc(spConfig);
+    QVector<ComplexSpectrum> spectra(channels);
+    for (int c = 0; c < channels; ++c) {
+        // x_c[n] = s[n - d_c]: el canal c va d_c muestras por detrás del 0
+        const QVector<float> samples = source.mid(margin - delays[c], N);
+        calc.calculateFrame(samples, 0, 0, &spectra[c]);
+        QCOMPARE(spectra[c].bins(), N / 2 + 1);
+    }
+
+    const QVector<TdoaEstimate> tdoa = correlator.process(spectra);
+    QCOMPARE(tdoa.size(), 3);
+
+    QCOMPARE(tdoa[0].channelA, 0);
+    QCOMPARE(tdoa[0].channelB, 1);
+    QVERIFY2(qAbs(tdoa[0].delaySamples - 7.0f) < 0.25f, qPrintable(QString::number(tdoa[0].delaySamples)));
+    QVERIFY(qAbs(tdoa[0].delaySeconds - 7.0f / sampleRate) < 0.25f / sampleRate);
+    QVERIFY(tdoa[0].peak > 0.3f);
+
+    // En el límite todavía se encuentra
+    QVERIFY2(qAbs(tdoa[1].delaySamples - 20.0f) < 0.5f, qPrintable(QString::number(tdoa[1].delaySamples)));
+
+    // Fuera del límite no: la búsqueda no pasa de ±20 (+ media muestra de interpolación)
+    QVERIFY(qAbs(tdoa[2].delaySamples) <= 20.5f);
+    QVERIFY(qAbs(tdoa[2].delaySamples - 40.0f) > 10.0f);
+
+    // Retardo negativo: intercambiando el par cambia el signo
+    ccConfig.pairs = { { 1, 0 } };
+    correlator.setConfig(ccConfig);
+    const QVector<TdoaEstimate> swapped = correlator.process(spectra);
+    QCOMPARE(swapped.size(), 1);
+    QVERIFY(qAbs(swapped[0].delaySamples + 7.0f) < 0.25f);
+
+    qDebug() << "✓ GCC-PHAT: retardo" << tdoa[0].delaySamples << "muestras, pico" << tdoa[0].peak;
+}
+
+void SpectrogramTest::testTransferFunction()
+{
+    qDebug() << "Test: TransferFunctionEstimator (ganancia pura y ruido incorrelado)";
+
+    const int N = 256;
+    const int bins = N / 2 + 1;
+    SpectrogramConfig spConfig(N, N, 48000);
+    SpectrogramCalculator calc(spConfig);
+    QVector<ComplexSpectrum> spectra(2);
+
+    // y = g·x: |H1| = |H2| = 20·log10(g) y coherencia 1 en todos los bins
+    const float gain = 0.5f;
+    const float gainDb = 20.0f * std::log10(gain);
+    TransferFunctionConfig tfConfig;
+    tfConfig.fftSize = N;
+    tfConfig.averages = 8;
+    TransferFunctionEstimator linear(tfConfig);
+    TransferFunctionFrame frame;
+    for (int f = 0; f < 16; ++f) {
+        const QVector<float> x = generateNoise(N, 100u + f);
+        QVector<float> y(N);
+        for (int i = 0; i < N; ++i) y[i] = gain * x[i];
+        calc.calculateFrame(x, 0, 0, &spectra[0]);
+        calc.calculateFrame(y, 0, 0, &spectra[1]);
+        frame = linear.process(spectra);
+    }
+    QCOMPARE(frame.h1MagDb.size(), bins);
+    QCOMPARE(frame.averages, 16);
+    for (int k = 1; k < bins - 1; ++k) {
+        QVERIFY2(qAbs(frame.h1MagDb[k] - gainDb) < 0.01f, qPrintable(QString("H1 bin %1").arg(k)));
+        QVERIFY2(qAbs(frame.h2MagDb[k] - gainDb) < 0.01f, qPrintable(QString("H2 bin %1").arg(k)));
+        QVERIFY(frame.coherence[k] > 0.999f);
+        QVERIFY(qAbs(frame.phaseRad[k]) < 1e-3f);
+    }
+
+    // Ruido incorrelado: la coherencia media baja hacia 0 al alargar el promedio
+    auto meanCoherence = [&](int averages) {
+        TransferFunctionConfig cfg = tfConfig;
+        cfg.averages = averages;
+        TransferFunctionEstimator estimator(cfg);
+        TransferFunctionFrame last;
+        for (int f = 0; f < 256; ++f) {
+            calc.calculateFrame(generateNoise(N, 1000u + 2 * f), 0, 0, &spectra[0]);
+            calc.calculateFrame(generateNoise(N, 1001u + 2 * f), 0, 0, &spectra[1]);
+            last = estimator.process(spectra);
+        }
+        double sum = 0.0;
+        for (int k = 1; k < bins - 1; ++k) sum += last.coherence[k];
+        return sum / (bins - 2);
+    };
+    const double short4 = meanCoherence(4);
+    const double mid16 = meanCoherence(16);
+    const double long64 = meanCoherence(64);
+    QVERIFY(short4 > mid16);
+    QVERIFY(mid16 > long64);
+    QVERIFY2(long64 < 0.1, qPrintable(QString::number(long64)));
+
+    qDebug() << "✓ Función de transferencia: coherencia de ruido" << short4 << "->" << long64;
+}
+
+void SpectrogramTest::testEnvelopeAnalyzer()
+{
+    qDebug() << "Test: EnvelopeAnalyzer (tono AM dentro de la banda)";
+
+    // Banda de 4 kHz a 48 kHz: decimación automática 48000 / (2.5 · 4000) = 4
+    EnvelopeConfig envConfig;
+    envConfig.sampleRate = 48000;
+    envConfig.bandLowHz = 2000.0f;
+    envConfig.bandHighHz = 6000.0f;
+    envConfig.segmentSize = 4096;
+    envConfig.spectrumSize = 1024;
+    EnvelopeAnalyzer analyzer(envConfig, 1);
+    QCOMPARE(analyzer.decimation(), 4);
+    QCOMPARE(analyzer.envelopeRate(), 12000.0f);
+
+    // Portadora de 4 kHz modulada al 50 % con fm centrada en el bin 20
+    const float binHz = analyzer.envelopeRate() / envConfig.spectrumSize;
+    const int modBin = 20;
+    const double fm = modBin * binHz;
+    const double fc = 4000.0;
+    const int total = envConfig.sampleRate;
+    QVector<float> signal(total);
+    for (int n = 0; n < total; ++n) {
+        const double t = double(n) / envConfig.sampleRate;
+        signal[n] = float((1.0 + 0.5 * std::cos(2.0 * M_PI * fm * t)) * std::sin(2.0 * M_PI * fc * t));
+    }
+
+    EnvelopeSpectrum spectrum;
+    bool produced = false;
+    for (int offset = 0; offset < total; offset += 1000) {
+        produced |= analyzer.process(signal.constData() + offset, std::min(1000, total - offset), &spectrum);
+    }
+    QVERIFY(produced);
+    QCOMPARE(spectrum.channel, 1);
+    QCOMPARE(spectrum.envelopeRate, 12000.0f);
+    QCOMPARE(spectrum.binHz, binHz);
+    QCOMPARE(spectrum.magnitudesDb.size(), envConfig.spectrumSize / 2 + 1);
+
+    // Sin contar la continua, el máximo es el bin de fm: espectro de un lado
+    // normalizado por la ventana, así que 0.5·cos da 0.25 (~-12 dB)
+    int peakBin = 1;
+    for (int k = 2; k < spectrum.magnitudesDb.size(); ++k) {
+        if (spectrum.magnitudesDb[k] > spectrum.magnitudesDb[peakBin]) peakBin = k;
+    }
+    QCOMPARE(peakBin, modBin);
+    QVERIFY2(qAbs(spectrum.magnitudesDb[peakBin] + 12.04f) < 1.5f,
+             qPrintable(QString::number(spectrum.magnitudesDb[peakBin])));
+    QVERIFY(spectrum.magnitudesDb[3 * modBin] < spectrum.magnitudesDb[peakBin] - 20.0f);
+
+    // La decimación sigue a la banda configurada, o al valor explícito
+    envConfig.bandLowHz = 1000.0f;
+    envConfig.bandHighHz = 2000.0f;
+    analyzer.setConfig(envConfig);
+    QCOMPARE(analyzer.decimation(), 19);
+    QCOMPARE(analyzer.envelopeRate(), 48000.0f / 19);
+    envConfig.decimation = 3;
+    analyzer.setConfig(envConfig);
+    QCOMPARE(analyzer.decimation(), 3);
+    QCOMPARE(analyzer.envelopeRate(), 16000.0f);
+
+    qDebug() << "✓ Envolvente: pico en" << peakBin * binHz << "Hz," << spectrum.magnitudesDb[modBin] << "dB";
+}
+
+void SpectrogramTest::testFeatureExtractor()
+{
+    qDebug() << "Test: FeatureExtractor (tono puro, ruido blanco y espectro plano)";
+
+    const int N = 1024;
+    const int sampleRate = 48000;
+    const float binHz = float(sampleRate) / N;
+    FeatureConfig featConfig;
+    featConfig.fftSize = N;
+    featConfig.sampleRate = sampleRate;
+    featConfig.melBands = 40;
+    featConfig.mfccCount = 20;
+    FeatureExtractor extractor(featConfig);
+
+    SpectrogramConfig spConfig(N, N, sampleRate);
+    SpectrogramCalculator calc(spConfig);
+    ComplexSpectrum spectrum;
+
+    // Tono centrado en el bin 100
+    const float toneHz = 100 * binHz;
+    const QVector<float> tone = generateSineWave(toneHz, sampleRate, N, 0.5f);
+    calc.calculateFrame(tone, 0, 0, &spectrum);
+    const AudioFeatures toneFeatures = extractor.process(spectrum, tone.constData(), tone.size());
+    QCOMPARE(toneFeatures.mfcc.size(), featConfig.mfccCount);
+    QVERIFY2(qAbs(toneFeatures.centroidHz - toneHz) < binHz, qPrintable(QString::number(toneFeatures.centroidHz)));
+    QVERIFY2(toneFeatures.rolloffHz >= toneHz && toneFeatures.rolloffHz <= toneHz + binHz,
+             qPrintable(QString::number(toneFeatures.rolloffHz)));
+    QVERIFY2(toneFeatures.flatness < 0.01f, qPrintable(QString::number(toneFeatures.flatness)));
+    const float expectedZcr = 2.0f * toneHz / sampleRate;
+    QVERIFY2(qAbs(toneFeatures.zeroCrossingRate - expectedZcr) < 0.005f,
+             qPrintable(QString::number(toneFeatures.zeroCrossingRate)));
+
+    // Ruido blanco: el periodograma de un frame tiene potencias exponenciales,
+    // así que su planitud ronda e^-γ ≈ 0.56 y no 1; muy por encima del tono
+    const QVector<float> noise = generateNoise(N, 777u, 0.5f);
+    calc.calculateFrame(noise, 0, 0, &spectrum);
+    const AudioFeatures noiseFeatures = extractor.process(spectrum, noise.constData(), noise.size());
+    QCOMPARE(noiseFeatures.mfcc.size(), featConfig.mfccCount);
+    QVERIFY2(noiseFeatures.flatness > 0.4f && noiseFeatures.flatness < 0.75f,
+             qPrintable(QString::number(noiseFeatures.flatness)));
+    QVERIFY(qAbs(noiseFeatures.centroidHz - sampleRate / 4.0f) < sampleRate / 16.0f);
+    QVERIFY(noiseFeatures.zeroCrossingRate > 0.4f);
+
+    // Espectro de magnitud constante (fase cualquiera): planitud 1
+    ComplexSpectrum flat = spectrum;
+    for (int k = 0; k < flat.bins(); ++k) {
+        const double phase = 0.37 * k * k;
+        flat.re[k] = float(std::cos(phase));
+        flat.im[k] = float(std::sin(phase));
+    }
+    const AudioFeatures flatFeatures = extractor.process(flat, nullptr, 0);
+    QVERIFY2(flatFeatures.flatness > 0.99f, qPrintable(QString::number(flatFeatures.flatness)));
+    QCOMPARE(flatFeatures.zeroCrossingRate, 0.0f);
+
+    // Otra longitud de MFCC
+    featConfig.mfccCount = 13;
+    extractor.setConfig(featConfig);
+    QCOMPARE(extractor.process(spectrum, nullptr, 0).mfcc.size(), 13);
+
+    qDebug() << "✓ Descriptores: planitud tono" << toneFeatures.flatness
+             << "ruido" << noiseFeatures.flatness << "plano" << flatFeatures.flatness;
+}
+
+void SpectrogramTest::testWaveformRasterSpans()
+{
+    qDebug() << "Test: reducción de bloques a tramos de columna";
+
+    // 10 bloques en 4 columnas (2.5 por columna): cada bloque cae en una sola
+    QVector<float> mins(10), maxs(10), rms(10);
+    for (int b = 0; b < 10; ++b) {
+        mins[b] = -0.05f * (b + 1);
+        maxs[b] = (b % 3 == 0) ? 0.9f - 0.05f * b : 0.1f;
+        rms[b] = 0.01f * (b + 1);
+    }
+    QVector<WaveformSpan> spans;
+    WaveformRaster::computeSpans(mins.constData(), maxs.constData(), rms.constData(), 10, 4, spans);
+    QCOMPARE(spans.size(), 4);
+
+    const int bounds[5] = {0, 2, 5, 7, 10};
+    for (int x = 0; x < 4; ++x) {
+        float lo = mins[bounds[x]], hi = maxs[bounds[x]];
+        double energy = 0.0;
+        for (int b = bounds[x]; b < bounds[x + 1]; ++b) {
+            lo = qMin(lo, mins[b]);
+            hi = qMax(hi, maxs[b]);
+            energy += double(rms[b]) * rms[b];
+        }
+        QCOMPARE(spans[x].minValue, lo);
+        QCOMPARE(spans[x].maxValue, hi);
+        QVERIFY(qAbs(spans[x].rmsValue - float(std::sqrt(energy / (bounds[x + 1] - bounds[x])))) < 1e-6f);
+    }
+
+    // Menos bloques que columnas: cada bloque se estira sobre las suyas
+    WaveformRaster::computeSpans(mins.constData(), maxs.constData(), nullptr, 2, 4, spans);
+    QCOMPARE(spans.size(), 4);
+    QCOMPARE(spans[0].minValue, mins[0]);
+    QCOMPARE(spans[1].minValue, mins[0]);
+    QCOMPARE(spans[2].minValue, mins[1]);
+    QCOMPARE(spans[3].maxValue, maxs[1]);
+    QCOMPARE(spans[3].rmsValue, 0.0f);   // sin RMS de entrada
+
+    WaveformRaster::computeSpans(mins.constData(), maxs.constData(), nullptr, 0, 4, spans);
+    QVERIFY(spans.isEmpty());
+
+    qDebug() << "✓ Tramos min/max/RMS por columna";
+}
+
+void SpectrogramTest::testWaveformRasterCoverage()
+{
+    qDebug() << "Test: cobertura del raster con y sin antialiasing";
+
+    // Carril de 22 px: centro 11, media altura 10 px por unidad de amplitud.
+    // Tramo ±0.25 -> [8.5, 13.5): medias filas en 8 y 13
+    const int H = 22;
+    const QVector<WaveformSpan> spans = { { -0.25f, 0.25f, 0.1f } };
+    const QRgb marker = qRgb(1, 2, 3);
+
+    WaveformRaster raster;
+    WaveformRaster::Style style;
+    style.peakColor = qRgb(200, 100, 50);
+    style.rmsColor = qRgb(0, 0, 255);
+
+    // Dos carriles apilados; sólo se pinta el segundo. Dos columnas: la
+    // segunda no tiene tramo y debe quedar transparente
+    QImage image(2, 2 * H, QImage::Format_ARGB32_Premultiplied);
+    const QRect lane(0, H, 2, H);
+    auto alphaAt = [&](int y) { return qAlpha(image.pixel(0, H + y)); };
+
+    image.fill(marker);
+    raster.render(image, lane, spans, style);
+    for (int y = 0; y < H; ++y) {
+        QCOMPARE(image.pixel(0, y), marker | 0xFF000000u);          // el otro carril intacto
+        QCOMPARE(qAlpha(image.pixel(1, H + y)), 0);
+        QCOMPARE(alphaAt(y), (y >= 8 && y <= 12) ? 255 : 0);        // muestreo en el centro de fila
+    }
+    QCOMPARE(image.pixel(0, H + 10), style.peakColor | 0xFF000000u);
+
+    style.antialias = true;
+    image.fill(marker);
+    raster.render(image, lane, spans, style);
+    for (int y = 0; y < H; ++y) {
+        const int expected = (y == 8 || y == 13) ? 128 : (y > 8 && y < 13) ? 255 : 0;
+        QCOMPARE(alphaAt(y), expected);
+    }
+    // Medio píxel de cobertura: color premultiplicado a la mitad
+    const QRgb half = reinterpret_cast<const QRgb*>(image.constScanLine(H + 8))[0];
+    QVERIFY(qAbs(qRed(half) - 100) <= 1 && qAbs(qGreen(half) - 50) <= 1 && qAbs(qBlue(half) - 25) <= 1);
+
+    // RMS ±0.1 -> [10, 12): su color dentro del pico, la cobertura total no cambia
+    style.showRms = true;
+    image.fill(marker);
+    raster.render(image, lane, spans, style);
+    for (int y = 8; y <= 13; ++y) {
+        QCOMPARE(alphaAt(y), (y == 8 || y == 13) ? 128 : 255);
+    }
+    QCOMPARE(image.pixel(0, H + 10), style.rmsColor | 0xFF000000u);
+    QCOMPARE(image.pixel(0, H + 11), style.rmsColor | 0xFF000000u);
+    QCOMPARE(image.pixel(0, H + 9), style.peakColor | 0xFF000000u);
+
+    qDebug() << "✓ Cobertura y colores del raster correctos";
+}
+
+namespace {
+// Corrutinas de prueba: parámetros por valor, sobreviven a cada suspensión
+
+Task<int> addOnPool(QObject* context, CancellationToken token, int a, int b)
+{
+    const int sum = co_await AsyncTask::run(context, token, [a, b]() { return a + b; });
+    co_return sum * 2;
+}
+
+Task<Qt::HANDLE> poolThreadId(QObject* context, Qt::HANDLE* resumedOn)
+{
+    const Qt::HANDLE id = co_await AsyncTask::run(context, CancellationToken(),
+                                                  []() { return QThread::currentThreadId(); });
+    *resumedOn = QThread::currentThreadId();
+    co_return id;
+}
+
+Task<int> failOnPool(QObject* context)
+{
+    co_return co_await AsyncTask::run(context, CancellationToken(), []() -> int {
+        throw std::runtime_error("fallo de prueba");
+    });
+}
+
+/** fn avisa en `started` y espera a `gate` antes de devolver 7 */
+Task<int> gatedValue(QObject* context, CancellationToken token,
+                     QSemaphore* started, QSemaphore* gate, std::atomic_bool* ran)
+{
+    co_return co_await AsyncTask::run(context, token, [started, gate, ran]() {
+        ran->store(true);
+        if (started) started->release();
+        if (gate) gate->acquire();
+        return 7;
+    });
+}
+
+Task<int> awaitGated(QObject* context, QSemaphore* started, QSemaphore* gate,
+                     std::atomic_bool* ran, bool* afterChild)
+{
+    const int value = co_await gatedValue(context, CancellationToken(), started, gate, ran);
+    *afterChild = true;
+    co_return value;
+}
+} // namespace
+
+void SpectrogramTest::testTaskResumesOnContextThread()
+{
+    qDebug() << "Test: Task<> ejecuta en el pool y reanuda en el hilo del contexto";
+
+    QObject context;
+
+    bool gotResult = false;
+    int result = 0;
+    addOnPool(&context, CancellationToken(), 20, 1)
+        .then(&context, [&](int value) { result = value; gotResult = true; });
+    QTRY_VERIFY(gotResult);
+    QCOMPARE(result, 42);
+
+    Qt::HANDLE resumedOn = nullptr;
+    Qt::HANDLE poolId = nullptr;
+    bool done = false;
+    poolThreadId(&context, &resumedOn)
+        .then(&context, [&](Qt::HANDLE id) { poolId = id; done = true; });
+    QTRY_VERIFY(done);
+    QVERIFY(poolId != QThread::currentThreadId());
+    QCOMPARE(resumedOn, QThread::currentThreadId());
+
+    // Las excepciones de fn llegan a onError con su mensaje
+    QString error;
+    bool called = false;
+    failOnPool(&context).then(&context, [&](int) { called = true; },
+                              [&](const QString& message) { error = message; });
+    QTRY_COMPARE(error, QString("fallo de prueba"));
+    QVERIFY(!called);
+
+    qDebug() << "✓ Resultado, hilo de reanudación y errores correctos";
+}
+
+void SpectrogramTest::testTaskCancellation()
+{
+    qDebug() << "Test: CancellationToken antes y durante la ejecución";
+
+    QObject context;
+    bool resultCalled = false;
+    bool errorCalled = false;
+    auto onResult = [&](int) { resultCalled = true; };
+    auto onError = [&](const QString&) { errorCalled = true; };
+
+    // Cancelada antes de empezar: fn no se ejecuta y la tarea acaba en el acto
+    std::atomic_bool ranBefore { false };
+    CancellationToken early;
+    early.cancel();
+    Task<int> cancelledEarly = gatedValue(&context, early, nullptr, nullptr, &ranBefore);
+    QVERIFY(cancelledEarly.isDone());
+    cancelledEarly.then(&context, onResult, onError);
+
+    // Cancelada mientras fn corre: el resultado se descarta sin error
+    QSemaphore started, gate;
+    std::atomic_bool ranDuring { false };
+    CancellationToken late;
+    Task<int> cancelledLate = gatedValue(&context, late, &started, &gate, &ranDuring);
+    cancelledLate.then(&context, onResult, onError);
+    QVERIFY(started.tryAcquire(1, 5000));
+    late.cancel();
+    gate.release();
+    QTRY_VERIFY(cancelledLate.isDone());
+    QCoreApplication::processEvents();
+
+    QVERIFY(!ranBefore.load());
+    QVERIFY(ranDuring.load());
+    QVERIFY(!resultCalled);
+    QVERIFY(!errorCalled);
+
+    qDebug() << "✓ Cancelación sin resultado ni error";
+}
+
+void SpectrogramTest::testTaskContextDestroyed()
+{
+    qDebug() << "Test: destruir el contexto con una espera en curso";
+
+    QObject observer;
+    auto* context = new QObject;
+    QSemaphore started, gate;
+    std::atomic_bool ran { false };
+    bool afterChild = false;
+    bool resultCalled = false;
+    bool errorCalled = false;
+
+    // La tarea externa espera a otra que espera al pool
+    Task<int> outer = awaitGated(context, &started, &gate, &ran, &afterChild);
+    outer.then(&observer, [&](int) { resultCalled = true; },
+               [&](const QString&) { errorCalled = true; });
+
+    QVERIFY(started.tryAcquire(1, 5000));
+    delete context;
+    gate.release();
+
+    // La cancelación sube hasta la tarea externa: termina, no se queda colgada
+    QTRY_VERIFY(outer.isDone());
+    QVERIFY(!afterChild);
+    QVERIFY(!resultCalled);
+    QVERIFY(!errorCalled);
+
+    qDebug() << "✓ Contexto destruido: la espera termina como cancelada";
+}
+
+void SpectrogramTest::testWaveformDataProvider()
+{
+    qDebug() << "Test: WaveformDataProvider (pirámide con RMS, caché y nivel grueso)";
+
+    // Reparto de buckets por columnas: uno de 1 s y otro de 5 s que cubre
+    // cinco columnas; las demás quedan vacías
+    {
+        RollupBucket narrow;
+        narrow.startNs = 2'000'000'000LL;
+        narrow.lastNs = 2'900'000'000LL;
+        narrow.blockCount = 1;
+        narrow.minValue = -0.5f;
+        narrow.maxValue = 0.5f;
+        narrow.sumSquares = 0.04;
+        RollupBucket wide = narrow;
+        wide.startNs = 5'000'000'000LL;
+        wide.lastNs = 9'900'000'000LL;
+        wide.maxValue = 0.75f;
+
+        const WaveformWindow w = WaveformDataProvider::composeTrend(0, 100, 10, 0, 10'000'000'000LL,
+                                                                    { narrow, wide });
+        QCOMPARE(w.spans.size(), 10);
+        QVERIFY(!w.exact);
+        QCOMPARE(w.spans[2].maxValue, 0.5f);
+        QVERIFY(qAbs(w.spans[2].rmsValue - 0.2f) < 1e-6f);
+        for (int c : { 0, 1, 3, 4 }) {
+            QCOMPARE(w.spans[c].maxValue, 0.0f);
+            QCOMPARE(w.spans[c].rmsValue, 0.0f);
+        }
+        for (int c = 5; c < 10; ++c) {
+            QCOMPARE(w.spans[c].maxValue, 0.75f);
+            QVERIFY(qAbs(w.spans[c].rmsValue - 0.2f) < 1e-6f);
+        }
+    }
+
+    // Sesión de 60 s: 10 bloques de 64 frames por segundo, amplitud creciente
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString path = dir.filePath("waveform.db");
+    const int blockFrames = 64;
+    const int sampleRate = 640;
+    const int blocks = 600;
+    const qint64 t0 = 1'000'000'000'000LL;
+    auto amplitude = [](int i) { return 0.1f + 0.001f * i; };
+    {
+        AudioDb db(path);
+        QVERIFY(db.initialize());
+        for (int i = 0; i < blocks; ++i) {
+            const quint64 ts = quint64(t0 + qint64(i) * 100'000'000LL);
+            const float a = amplitude(i);
+            QVERIFY(db.insertPeak(i, qint64(i) * blockFrames, -a, a, 0.5f * a, ts));
+            db.updateRollups(ts, -a, a, 0.5f * a);
+        }
+        db.shutdown();
+    }
+
+    WaveformDataProvider provider;
+    WaveformWindow window;
+    bool ready = false;
+    connect(&provider, &WaveformDataProvider::windowReady, this,
+            [&](const WaveformWindow& w) { window = w; ready = true; });
+
+    WaveformDataProvider::Config cfg;
+    cfg.channels = 1;
+    cfg.blockFrames = blockFrames;
+    cfg.summaryPageBlocks = 16;
+    cfg.summaryCachePages = 4;
+    cfg.maxRawBlocksPerRequest = 8;
+
+    // Pirámide: 4 bloques por columna, el RMS sale de los picos
+    cfg.sampleRate = sampleRate;
+    provider.setSession(path, cfg);
+    provider.request(0, 64 * blockFrames, 16);
+    QTRY_VERIFY(ready);
+    QVERIFY(!window.exact);
+    QCOMPARE(window.spans.size(), 16);
+    for (int c = 0; c < 16; ++c) {
+        double energy = 0.0;
+        for (int i = 4 * c; i < 4 * c + 4; ++i) {
+            energy += 0.25 * amplitude(i) * amplitude(i);
+        }
+        QCOMPARE(window.spans[c].maxValue, amplitude(4 * c + 3));
+        QCOMPARE(window.spans[c].minValue, -amplitude(4 * c + 3));
+        QVERIFY(qAbs(window.spans[c].rmsValue - float(std::sqrt(energy / 4))) < 1e-5f);
+    }
+
+    // Sin nivel grueso, una ventana de más páginas que la caché debe
+    // llegar entera: la caché crece en vez de expulsar sus propias páginas
+    cfg.sampleRate = 0;
+    provider.setSession(path, cfg);
+    ready = false;
+    provider.request(0, 6 * 16 * blockFrames, 24);
+    QTRY_VERIFY(ready);
+    for (int c = 0; c < 24; ++c) {
+        QCOMPARE(window.spans[c].maxValue, amplitude(4 * c + 3));
+        QVERIFY(window.spans[c].rmsValue > 0.0f);
+    }
+
+    // Nivel grueso: toda la sesión (38 páginas > 4 en caché) desde los rollups
+    cfg.sampleRate = sampleRate;
+    provider.setSession(path, cfg);
+    ready = false;
+    provider.request(0, qint64(blocks) * blockFrames, 6);
+    QTRY_VERIFY(ready);
+    QCOMPARE(window.spans.size(), 6);
+    float previousMax = 0.0f;
+    for (const WaveformSpan& span : window.spans) {
+        QVERIFY(span.maxValue >= previousMax);
+        QCOMPARE(span.minValue, -span.maxValue);
+        QVERIFY(span.rmsValue > 0.0f && span.rmsValue <= 0.5f * span.maxValue + 1e-6f);
+        previousMax = span.maxValue;
+    }
+    QCOMPARE(window.spans.last().maxValue, amplitude(blocks - 1));
+
+    AudioDbReader::invalidate(path);
+    qDebug() << "✓ Pirámide, caché por petición y nivel grueso correctos";
+}
+
 // Funciones auxiliares
 QVector<float> SpectrogramTest::generateSineWave(float frequency, float sampleRate, int samples, float amplitude)
 {
@@ -372,6 +1941,17 @@ QVector<float> SpectrogramTest::generateSineWave(float frequency, float sampleRa
     return wave;
 }
 
+QVector<float> SpectrogramTest::generateNoise(int samples, quint32 seed, float amplitude)
+{
+    QVector<float> noise(samples);
+    quint32 lcg = seed;
+    for (int i = 0; i < samples; ++i) {
+        lcg = lcg * 1664525u + 1013904223u;
+        noise[i] = amplitude * (float(lcg >> 8) / float(1 << 23) - 1.0f);
+    }
+    return noise;
+}
+
 bool SpectrogramTest::findPeakNearFrequency(const QVector<float>& magnitudes,
                                             const QVector<float>& frequencies,
                                             float targetFreq, float tolerance)
@@ -0,0 +1,25 @@
+#include "rendered_tile_cache.h"
+#include <algorithm>
+
+RenderedTileCache::RenderedTileCache(int maxCostKb)
+    : m_tiles(std::max(1, maxCostKb))
+{
+}
+
+const QImage* RenderedTileCache::find(const RenderedTileKey& key) const {
+    // QCache::object() actualiza el orden LRU
+    return m_tiles.object(key);
+}
+
+void RenderedTileCache::insert(const RenderedTileKey& key, const QImage& tile) {
+    const qsizetype costKb = std::max<qsizetype>(1, tile.sizeInBytes() / 1024);
+    m_tiles.insert(key, new QImage(tile), costKb);
+}
+
+void RenderedTileCache::clear() {
+    m_tiles.clear();
+}
+
+void RenderedTileCache::setMaxCostKb(int maxCostKb) {
+    m_tiles.setMaxCost(std::max(1, maxCostKb));
+}
@@ -0,0 +1,60 @@
+#ifndef RENDERED_TILE_CACHE_H
+#define RENDERED_TILE_CACHE_H
+
+#include <QCache>
+#include <QHashFunctions>
+#include <QImage>
+#include <QtTypes>
+
+/**
+ * @brief Identifica una tesela de espectrograma ya coloreada
+ *
+ * Dos vistas con el mismo zoom (columnas del almacén por píxel) y la misma
+ * paleta comparten teselas; `generation` es la de SpectrumStore, así que
+ * un clear() o un cambio de rango de dB deja las antiguas sin uso.
+ */
+struct RenderedTileKey {
+    quint64 generation = 0;
+    int     stride = 1;          ///< Columnas del almacén por píxel
+    qint64  index = 0;           ///< Tesela (índice de píxel / TileColumns)
+    quint64 palette = 0;         ///< Paleta + rango de dB de la vista
+
+    bool operator==(const RenderedTileKey& o) const {
+        return generation == o.generation && stride == o.stride &&
+               index == o.index && palette == o.palette;
+    }
+};
+
+inline size_t qHash(const RenderedTileKey& key, size_t seed = 0) {
+    return qHashMulti(seed, key.generation, key.stride, key.index, key.palette);
+}
+
+/**
+ * @brief Caché LRU de teselas pintadas compartida entre vistas
+ *
+ * Cada tesela tiene TileColumns píxeles de ancho y una fila por bin. Sólo
+ * se guardan teselas completas (datos que ya no cambian); la última,
+ * parcial, la pinta cada vista en su tick. El coste es en KiB, así que la
+ * memoria total la fija maxCostKb y no el número de vistas. Sólo se usa
+ * desde el hilo GUI.
+ */
+class RenderedTileCache
+{
+public:
+    static constexpr int TileColumns = 128;
+
+    explicit RenderedTileCache(int maxCostKb = 64 * 1024);
+
+    const QImage* find(const RenderedTileKey& key) const;
+    void insert(const RenderedTileKey& key, const QImage& tile);
+    void clear();
+
+    void setMaxCostKb(int maxCostKb);
+    int totalCostKb() const { return int(m_tiles.totalCost()); }
+    int count() const { return int(m_tiles.count()); }
+
+private:
+    QCache<RenderedTileKey, QImage> m_tiles;
+};
+
+#endif // RENDERED_TILE_CACHE_H
@@ -1,10 +1,29 @@
 #include "spectrogram_renderer.h"
+#include "core/audio_db_reader.h"
 #include <QPainter>
 #include <QPalette>
 #include <QtMath>
 #include <QWheelEvent>
 #include <QMouseEvent>
 #include <QApplication>
+#include <QFloat16>
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+namespace {
+
+// Selección de teselas sobre el índice y copia en el pool de E/S
+Task<QList<SpectrogramTile>> sessionFileTiles(QObject* context, CancellationToken token,
+                                              QSharedPointer<const SessionFileReader> file,
+                                              qint64 tStart, qint64 tEnd, int maxColumns)
+{
+    co_return co_await AsyncTask::run(context, token, [file, tStart, tEnd, maxColumns]() {
+        return file->tilesForSpan(tStart, tEnd, maxColumns);
+    });
+}
+
+} // namespace
 
 SpectrogramRenderer::SpectrogramRenderer(QWidget* parent)
     : QWidget(parent)
@@ -36,9 +55,43 @@ SpectrogramRenderer::SpectrogramRenderer(QWidget* parent)
 }
 
 SpectrogramRenderer::~SpectrogramRenderer() {
+    m_historyToken.cancel();
     if (m_timer && m_timer->isActive()) {
         m_timer->stop();
     }
+    attachFrameBus(nullptr, FrameSubscription());
+}
+
+void SpectrogramRenderer::attachFrameBus(FrameBus* bus, const FrameSubscription& subscription) {
+    if (m_frameBus) {
+        m_frameBus->unsubscribe(m_busId);
+    }
+    m_frameBus = bus;
+    m_busId = bus ? bus->subscribe(subscription) : 0;
+}
+
+void SpectrogramRenderer::attachStore(SpectrumStore* store, RenderedTileCache* cache) {
+    QMutexLocker lock(&m_mutex);
+    m_store = store;
+    if (store && !cache) {
+        if (!m_ownTileCache) {
+            m_ownTileCache = std::make_unique<RenderedTileCache>(8 * 1024);
+        }
+        cache = m_ownTileCache.get();
+    }
+    m_tileCache = cache;
+    m_storeEnd = -1;
+    m_image = QImage();
+    m_needsUpdate = true;
+}
+
+void SpectrogramRenderer::setColumnsPerPixel(int stride) {
+    QMutexLocker lock(&m_mutex);
+    stride = qMax(1, stride);
+    if (stride == m_stride) return;
+    m_stride = stride;
+    m_image = QImage();
+    m_needsUpdate = true;
 }
 
 void SpectrogramRenderer::setConfig(const SpectrogramConfig& cfg) {
@@ -64,7 +117,9 @@ void SpectrogramRenderer::setConfig(const SpectrogramConfig& cfg) {
 
     if (needsImageUpdate) {
         m_columns.clear();
+        m_liveColumns.clear();
         m_image = QImage();
+        m_lutValid = false;
         // Recalcular valores de escala
         m_dbRange = m_cfg.maxDb - m_cfg.minDb;
         m_dbScale = 255.0f / m_dbRange;
@@ -103,11 +158,17 @@ double SpectrogramRenderer::scrollPosition() const {
 
 int SpectrogramRenderer::columnCount() const {
     QMutexLocker lock(&m_mutex);
+    if (usesStore()) {
+        return int(m_store->endColumn() - m_store->firstColumn());
+    }
     return m_columns.size();
 }
 
 bool SpectrogramRenderer::isEmpty() const {
     QMutexLocker lock(&m_mutex);
+    if (usesStore()) {
+        return m_store->endColumn() == 0;
+    }
     return m_columns.isEmpty();
 }
 
@@ -117,14 +178,16 @@ void SpectrogramRenderer::processFrames(const QVector<FrameData>& frames) {
     QMutexLocker lock(&m_mutex);
     bool dataAdded = false;
 
+    // En modo histórico lo nuevo se guarda aparte y no se repinta
+    QVector<CompactSpectrum>& target = m_historyMode ? m_liveColumns : m_columns;
     for (const auto& frame : frames) {
-        if (!frame.spectrum.isEmpty()) {
-            appendColumn(frame.spectrum);
+        if (!frame.spectrum.isEmpty() || !frame.compactSpectrum.isEmpty()) {
+            appendColumn(target, frame);
             dataAdded = true;
         }
     }
 
-    if (dataAdded) {
+    if (dataAdded && !m_historyMode) {
         m_needsUpdate = true;
         emit dataRangeChanged(m_columns.size());
     }
@@ -132,10 +195,14 @@ void SpectrogramRenderer::processFrames(const QVector<FrameData>& frames) {
 
 void SpectrogramRenderer::clear() {
     QMutexLocker lock(&m_mutex);
+    m_historyToken.cancel();
+    m_historyMode = false;
+    m_liveColumns.clear();
     m_columns.clear();
     m_image = QImage();
     m_needsUpdate = true;
     m_lastColumnCount = 0;
+    m_storeEnd = -1;
     emit dataRangeChanged(0);
 }
 
@@ -149,34 +216,153 @@ void SpectrogramRenderer::pause(bool paused) {
     }
 }
 
-void SpectrogramRenderer::appendColumn(const QVector<float>& mags) {
-    m_columns.append(mags);
+void SpectrogramRenderer::appendColumn(QVector<CompactSpectrum>& columns, const FrameData& frame) {
+    if (!frame.compactSpectrum.isEmpty()) {
+        // Ya empaquetado por el DSP: se comparte el buffer, sin copia
+        columns.append(frame.compactSpectrum);
+    } else {
+        // Float32: 8 bits sobre [minDb, maxDb] bastan para 256 colores
+        // (un cambio de rango limpia las columnas en setConfig)
+        columns.append(CompactSpectrum::encode(frame.spectrum, SpectrumFormat::UInt8,
+                                               m_cfg.minDb, m_cfg.maxDb));
+    }
 
-    if (m_cfg.maxColumns > 0 && m_columns.size() > m_cfg.maxColumns) {
+    if (m_cfg.maxColumns > 0 && columns.size() > m_cfg.maxColumns) {
         // Usar deque semántica para mejor performance
-        int toRemove = m_columns.size() - m_cfg.maxColumns;
+        int toRemove = columns.size() - m_cfg.maxColumns;
         for (int i = 0; i < toRemove; ++i) {
-            m_columns.removeFirst();
+            columns.removeFirst();
         }
     }
 
     optimizeMemoryUsage();
 }
 
+void SpectrogramRenderer::showTimeSpan(const QString& dbPath, qint64 tStartNs, qint64 tEndNs) {
+    if (dbPath.isEmpty() || tEndNs <= tStartNs) return;
+
+    const int maxColumns = beginHistorySpan();
+    AudioDbReader reader(dbPath);
+    reader.tilesForSpan(this, m_historyToken, tStartNs, tEndNs, maxColumns)
+        .then(this, [this](const QList<SpectrogramTile>& tiles) { setHistoryTiles(tiles); });
+}
+
+void SpectrogramRenderer::showTimeSpan(QSharedPointer<const SessionFileReader> file,
+                                       qint64 tStartNs, qint64 tEndNs) {
+    if (!file || !file->isOpen() || tEndNs <= tStartNs) return;
+
+    const int maxColumns = beginHistorySpan();
+    sessionFileTiles(this, m_historyToken, file, tStartNs, tEndNs, maxColumns)
+        .then(this, [this](const QList<SpectrogramTile>& tiles) { setHistoryTiles(tiles); });
+}
+
+int SpectrogramRenderer::beginHistorySpan() {
+    int maxColumns = 0;
+    {
+        QMutexLocker lock(&m_mutex);
+        if (!m_historyMode) {
+            m_liveColumns = m_columns;
+            m_historyMode = true;
+        }
+        maxColumns = qMax(1, width() / m_cfg.blockWidth);
+    }
+
+    // Un intervalo nuevo invalida la lectura anterior
+    m_historyToken.cancel();
+    m_historyToken = CancellationToken();
+    return maxColumns;
+}
+
+void SpectrogramRenderer::setHistoryTiles(const QList<SpectrogramTile>& tiles) {
+    QMutexLocker lock(&m_mutex);
+    if (!m_historyMode) return;
+
+    // Las columnas de las teselas se copian ya cuantificadas: el pintado
+    // usa la misma tabla de color que las columnas UInt8 en vivo
+    m_columns.clear();
+    for (const SpectrogramTile& tile : tiles) {
+        for (int c = 0; c < tile.columns; ++c) {
+            m_columns.append(tile.column(c));
+        }
+    }
+    m_image = QImage();
+    m_needsUpdate = true;
+    emit dataRangeChanged(m_columns.size());
+}
+
+void SpectrogramRenderer::showLive() {
+    m_historyToken.cancel();
+
+    QMutexLocker lock(&m_mutex);
+    if (!m_historyMode) return;
+
+    m_columns = std::move(m_liveColumns);
+    m_liveColumns.clear();
+    m_historyMode = false;
+    m_image = QImage();
+    m_needsUpdate = true;
+    emit dataRangeChanged(m_columns.size());
+}
+
+bool SpectrogramRenderer::isShowingHistory() const {
+    QMutexLocker lock(&m_mutex);
+    return m_historyMode;
+}
+
+void SpectrogramRenderer::setTimingHudVisible(bool visible) {
+    m_showTimingHud = visible;
+    update();
+}
+
 void SpectrogramRenderer::onUpdateTimeout() {
+    if (m_frameBus) {
+        const QVector<FrameData> frames = m_frameBus->take(m_busId);
+        if (!frames.isEmpty()) {
+            RenderTimingStats::Scope timing(m_timing, RenderTimingStats::ProcessFrames);
+            processFrames(frames);
+        }
+        m_timing.recordTick(frames.size(), m_frameBus->droppedFrames(m_busId));
+    }
+    m_timing.publishIfDue();
+
+    // Con almacén sólo se mira si ha crecido: los datos no pasan por la vista
+    if (usesStore()) {
+        const qint64 end = m_store->endColumn();
+        const quint64 generation = m_store->generation();
+        if (end != m_storeEnd || generation != m_storeGeneration) {
+            m_storeEnd = end;
+            m_storeGeneration = generation;
+            m_needsUpdate = true;
+            if (end == 0) {
+                m_image = QImage();
+                update();
+            }
+            emit dataRangeChanged(int(end - m_store->firstColumn()));
+        }
+    }
+
     if (!shouldUpdateImage()) return;
 
     updateVisibleRange();
-    updateImageBuffer();
+    {
+        RenderTimingStats::Scope timing(m_timing, RenderTimingStats::ImageUpdate);
+        updateImageBuffer();
+    }
     update();
     m_needsUpdate = false;
 }
 
 bool SpectrogramRenderer::shouldUpdateImage() const {
-    return m_needsUpdate && !m_paused && !m_columns.isEmpty();
+    const bool hasData = usesStore() ? m_storeEnd > 0 : !m_columns.isEmpty();
+    return m_needsUpdate && !m_paused && hasData;
 }
 
 void SpectrogramRenderer::updateVisibleRange() {
+    if (usesStore()) {
+        updateStoreVisibleRange();
+        return;
+    }
+
     int total = m_columns.size();
     int maxVis = (m_cfg.maxColumns > 0) ? qMin(total, m_cfg.maxColumns) : total;
 
@@ -198,8 +384,15 @@ void SpectrogramRenderer::updateVisibleRange() {
 }
 
 void SpectrogramRenderer::updateImageBuffer() {
+    if (usesStore()) {
+        updateStoreImage();
+        return;
+    }
+
     int cols = m_visibleEnd - m_visibleStart;
-    int rows = m_cfg.fftSize / 2 + 1;
+    // Las teselas pueden venir reducidas en frecuencia
+    int rows = (m_historyMode && !m_columns.isEmpty()) ? m_columns.first().bins
+                                                       : m_cfg.fftSize / 2 + 1;
 
     if (cols <= 0 || rows <= 0) return;
 
@@ -211,14 +404,21 @@ void SpectrogramRenderer::updateImageBuffer() {
 
     m_image.fill(Qt::black);
 
-    // Renderizado optimizado
+    // Renderizado optimizado: el color sale de una tabla indexada por código
     for (int i = m_visibleStart; i < m_visibleEnd; ++i) {
         int col = i - m_visibleStart;
-        const auto& mags = m_columns[i];
-        int actualRows = qMin(rows, mags.size());
+        const CompactSpectrum& column = m_columns[i];
+        int actualRows = qMin(rows, column.bins);
+
+        const QRgb* lut = colorLutFor(column);
+        const bool wideCodes = CompactSpectrum::bytesPerBin(column.format) == 2;
+        const uchar* codes8 = reinterpret_cast<const uchar*>(column.data.constData());
+        const quint16* codes16 = reinterpret_cast<const quint16*>(column.data.constData());
 
         for (int j = 0; j < actualRows; ++j) {
-            QRgb color = colorForDb(mags[j]);
+            QRgb color = !lut     ? colorForDb(column.valueAt(j))
+                         : wideCodes ? lut[codes16[j]]
+                                     : lut[codes8[j]];
             int yPos = rows - 1 - j;
 
             // Optimización: escribir directamente en scanLine
@@ -234,6 +434,175 @@ void SpectrogramRenderer::updateImageBuffer() {
     }
 }
 
+void SpectrogramRenderer::updateStoreVisibleRange() {
+    // En píxeles absolutos: el píxel p cubre las columnas [p*m_stride, (p+1)*m_stride)
+    const qint64 first = (m_store->firstColumn() + m_stride - 1) / m_stride;
+    const qint64 end = m_storeEnd / m_stride;   // sólo píxeles completos
+    const qint64 total = qMax<qint64>(0, end - first);
+    const qint64 maxVis = (m_cfg.maxColumns > 0) ? qMin<qint64>(total, m_cfg.maxColumns) : total;
+
+    if (m_cfg.autoScroll) {
+        m_storeVisibleEnd = end;
+        m_storeVisibleStart = end - maxVis;
+    } else {
+        const qint64 scrollRange = total - maxVis;
+        m_storeVisibleStart = first + qRound64(m_manualScrollPos * scrollRange);
+        m_storeVisibleEnd = m_storeVisibleStart + maxVis;
+    }
+
+    if (total > 0) {
+        double currentPos = double(m_storeVisibleStart - first) / qMax<qint64>(1, total - maxVis);
+        emit scrollPositionChanged(currentPos);
+    }
+}
+
+quint64 SpectrogramRenderer::paletteKey(int rows) const {
+    return quint64(qHashMulti(0, int(m_colorMapType), m_cfg.minDb, m_cfg.maxDb, rows));
+}
+
+void SpectrogramRenderer::updateStoreImage() {
+    const int cols = int(m_storeVisibleEnd - m_storeVisibleStart);
+    if (cols <= 0 || !m_tileCache) return;
+
+    // Las filas salen de la última columna (cambian con fftSize)
+    m_store->columns(m_storeEnd - 1, m_storeEnd, m_tileColumns);
+    const int rows = m_tileColumns.isEmpty() ? 0 : m_tileColumns.first().bins;
+    if (rows <= 0) return;
+
+    constexpr int TileColumns = RenderedTileCache::TileColumns;
+    const int bw = m_cfg.blockWidth;
+    const QSize newSize(cols * bw, rows);
+    if (m_image.size() != newSize) {
+        m_image = QImage(newSize, QImage::Format_RGB32);
+    }
+    if (m_partialTile.width() != TileColumns || m_partialTile.height() != rows) {
+        m_partialTile = QImage(TileColumns, rows, QImage::Format_RGB32);
+    }
+
+    const qint64 firstColumn = m_store->firstColumn();
+    const quint64 palette = paletteKey(rows);
+
+    for (qint64 t = m_storeVisibleStart / TileColumns; t * TileColumns < m_storeVisibleEnd; ++t) {
+        const qint64 t0 = t * TileColumns;
+
+        // Completa: todas sus columnas siguen en el almacén y ya no cambian
+        const bool complete = t0 * m_stride >= firstColumn &&
+                              (t0 + TileColumns) * m_stride <= m_storeEnd;
+        const RenderedTileKey key{m_storeGeneration, m_stride, t, palette};
+        const QImage* tile = complete ? m_tileCache->find(key) : nullptr;
+        if (!tile) {
+            renderStoreTile(m_partialTile, t, rows);
+            if (complete) {
+                m_tileCache->insert(key, m_partialTile);
+            }
+            tile = &m_partialTile;
+        }
+
+        // Tramo visible de la tesela, copiado por filas
+        const int a = int(qMax(t0, m_storeVisibleStart) - t0);
+        const int b = int(qMin(t0 + TileColumns, m_storeVisibleEnd) - t0);
+        const int dst = int(t0 + a - m_storeVisibleStart) * bw;
+        for (int y = 0; y < rows; ++y) {
+            const QRgb* src = reinterpret_cast<const QRgb*>(tile->constScanLine(y)) + a;
+            QRgb* out = reinterpret_cast<QRgb*>(m_image.scanLine(y)) + dst;
+            if (bw == 1) {
+                std::memcpy(out, src, size_t(b - a) * sizeof(QRgb));
+            } else {
+                for (int x = 0; x < b - a; ++x) {
+                    std::fill(out + x * bw, out + (x + 1) * bw, src[x]);
+                }
+            }
+        }
+    }
+}
+
+void SpectrogramRenderer::renderStoreTile(QImage& tile, qint64 index, int rows) {
+    constexpr int TileColumns = RenderedTileCache::TileColumns;
+    const qint64 p0 = index * TileColumns;
+    const qint64 first = m_store->columns(p0 * m_stride, (p0 + TileColumns) * m_stride, m_tileColumns);
+
+    tile.fill(Qt::black);
+    uchar* bits = tile.bits();
+    const qsizetype bpl = tile.bytesPerLine();
+    auto pixel = [&](int x, int j) -> QRgb& {
+        return reinterpret_cast<QRgb*>(bits + (rows - 1 - j) * bpl)[x];
+    };
+
+    for (int x = 0; x < TileColumns; ++x) {
+        const qint64 c0 = qMax<qint64>((p0 + x) * m_stride - first, 0);
+        const qint64 c1 = qMin<qint64>((p0 + x + 1) * m_stride - first, m_tileColumns.size());
+        if (c0 >= c1) continue;
+
+        if (c1 - c0 == 1) {
+            // Una columna por píxel: color por código, como updateImageBuffer()
+            const CompactSpectrum& column = m_tileColumns[int(c0)];
+            const int n = qMin(rows, column.bins);
+            const QRgb* lut = colorLutFor(column);
+            const bool wideCodes = CompactSpectrum::bytesPerBin(column.format) == 2;
+            const uchar* codes8 = reinterpret_cast<const uchar*>(column.data.constData());
+            const quint16* codes16 = reinterpret_cast<const quint16*>(column.data.constData());
+            for (int j = 0; j < n; ++j) {
+                pixel(x, j) = !lut     ? colorForDb(column.valueAt(j))
+                              : wideCodes ? lut[codes16[j]]
+                                          : lut[codes8[j]];
+            }
+        } else {
+            // Varias columnas por píxel: máximo por bin, para no perder transitorios
+            m_tileMaxDb.fill(-std::numeric_limits<float>::infinity(), rows);
+            int n = 0;
+            for (qint64 c = c0; c < c1; ++c) {
+                const CompactSpectrum& column = m_tileColumns[int(c)];
+                m_tileDecoded.resize(column.bins);
+                column.decode(m_tileDecoded.data());
+                const int bins = qMin(rows, column.bins);
+                for (int j = 0; j < bins; ++j) {
+                    m_tileMaxDb[j] = qMax(m_tileMaxDb[j], m_tileDecoded[j]);
+                }
+                n = qMax(n, bins);
+            }
+            for (int j = 0; j < n; ++j) {
+                pixel(x, j) = colorForDb(m_tileMaxDb[j]);
+            }
+        }
+    }
+}
+
+const QRgb* SpectrogramRenderer::colorLutFor(const CompactSpectrum& column) {
+    if (column.format == SpectrumFormat::Float32) {
+        return nullptr;
+    }
+
+    if (m_lutValid && m_lutFormat == column.format &&
+        m_lutMinDb == column.minDb && m_lutMaxDb == column.maxDb) {
+        return m_codeLut.constData();
+    }
+
+    // Se recalcula sólo al cambiar formato, rango, paleta o minDb/maxDb
+    const int codes = (column.format == SpectrumFormat::UInt8) ? 256 : 65536;
+    m_codeLut.resize(codes);
+
+    if (column.format == SpectrumFormat::Float16) {
+        for (int c = 0; c < codes; ++c) {
+            const quint16 bits = quint16(c);
+            qfloat16 h;
+            std::memcpy(&h, &bits, sizeof(bits));
+            const float db = float(h);
+            m_codeLut[c] = qIsNaN(db) ? m_colorMap[0] : colorForDb(db);
+        }
+    } else {
+        const float step = (column.maxDb - column.minDb) / float(codes - 1);
+        for (int c = 0; c < codes; ++c) {
+            m_codeLut[c] = colorForDb(column.minDb + c * step);
+        }
+    }
+
+    m_lutFormat = column.format;
+    m_lutMinDb = column.minDb;
+    m_lutMaxDb = column.maxDb;
+    m_lutValid = true;
+    return m_codeLut.constData();
+}
+
 QRgb SpectrogramRenderer::colorForDb(float db) const {
     // Usar valores precalculados para mejor performance
     float norm = (db - m_cfg.minDb) * m_dbScale / 255.0f;
@@ -244,6 +613,7 @@ QRgb SpectrogramRenderer::colorForDb(float db) const {
 
 void SpectrogramRenderer::buildColorMap() {
     m_colorMap.resize(256);
+    m_lutValid = false;
 
     switch (m_colorMapType) {
     case ColorMapType::Roesus:
@@ -349,29 +719,78 @@ void SpectrogramRenderer::mouseMoveEvent(QMouseEvent* event) {
     }
 }
 
+namespace {
+// Márgenes para métricas
+constexpr int LeftMargin   = 50;  // espacio para eje de frecuencia
+constexpr int BottomMargin = 20;  // espacio para eje de tiempo
+}
+
 void SpectrogramRenderer::paintEvent(QPaintEvent* event) {
     Q_UNUSED(event);
+    RenderTimingStats::Scope timing(m_timing, RenderTimingStats::Paint);
     QPainter painter(this);
     painter.setRenderHint(QPainter::SmoothPixmapTransform, false);
 
-    // 1) Fondo negro
-    painter.fillRect(rect(), Qt::black);
-
     QMutexLocker lock(&m_mutex);
-    if (m_image.isNull()) return;
+    if (m_image.isNull()) {
+        painter.fillRect(rect(), Qt::black);
+        return;
+    }
 
-    // 2) Márgenes para métricas
-    const int leftMargin   = 50;  // espacio para eje de frecuencia
-    const int bottomMargin = 20;  // espacio para eje de tiempo
-    int W = width(), H = height();
-    int drawW = W - leftMargin;
-    int drawH = H - bottomMargin;
+    // 1) Fondo y ejes desde la caché
+    ensureAxesLayer(m_image.width() * (usesStore() ? m_stride : 1));
+    painter.drawPixmap(0, 0, m_axesLayer);
 
-    // 3) Dibujar la imagen del espectrograma en el área central
-    QRect spectrogramRect(leftMargin, 0, drawW, drawH);
+    // 2) Imagen del espectrograma en el área central
+    QRect spectrogramRect(LeftMargin, 0, width() - LeftMargin, height() - BottomMargin);
     painter.drawImage(spectrogramRect, m_image);
 
-    // 4) Dibujar eje de frecuencia (izquierda)
+    // 3) Contorno por encima de los datos
+    painter.setPen(QPen(Qt::white, 1));
+    painter.drawRect(spectrogramRect);
+
+    // 4) Tiempos de renderizado (valores hasta el frame anterior)
+    if (m_showTimingHud) {
+        drawTimingHud(painter, spectrogramRect);
+    }
+}
+
+void SpectrogramRenderer::drawTimingHud(QPainter& painter, const QRect& area) {
+    const QStringList lines = m_timing.hudLines();
+    QFontMetrics fm = painter.fontMetrics();
+    const int lineH = fm.height();
+    int textW = 0;
+    for (const QString& line : lines) {
+        textW = qMax(textW, fm.horizontalAdvance(line));
+    }
+
+    QRect hudRect(area.left() + 5, area.top() + 5, textW + 10, lineH * lines.size() + 6);
+    painter.fillRect(hudRect, QColor(0, 0, 0, 160));
+    painter.setPen(QColor(200, 200, 200));
+    for (int i = 0; i < lines.size(); ++i) {
+        painter.drawText(hudRect.left() + 5, hudRect.top() + 3 + i * lineH + fm.ascent(), lines[i]);
+    }
+}
+
+void SpectrogramRenderer::ensureAxesLayer(int columns) {
+    // Las etiquetas de tiempo dependen del número de columnas visibles,
+    // que sólo cambia mientras se llena el buffer o al hacer zoom
+    const qreal dpr = devicePixelRatioF();
+    if (!m_axesLayer.isNull() && m_axesSize == size() && m_axesDpr == dpr &&
+        m_axesFftSize == m_cfg.fftSize && m_axesSampleRate == m_cfg.sampleRate &&
+        m_axesColumns == columns) {
+        return;
+    }
+
+    m_axesLayer = QPixmap(size() * dpr);
+    m_axesLayer.setDevicePixelRatio(dpr);
+    m_axesLayer.fill(Qt::black);
+
+    QPainter painter(&m_axesLayer);
+    int drawW = width() - LeftMargin;
+    int drawH = height() - BottomMargin;
+
+    // Eje de frecuencia (izquierda)
     painter.setPen(Qt::white);
     QFontMetrics fm = painter.fontMetrics();
     double maxFreq = m_cfg.sampleRate / 2.0;      // Nyquist
@@ -381,27 +800,26 @@ void SpectrogramRenderer::paintEvent(QPaintEvent* event) {
         double freq = maxFreq * (freqTicks - i) / freqTicks;
         int y       = int(t * drawH);
         // Línea de marca
-        painter.drawLine(leftMargin - 5, y, leftMargin, y);
+        painter.drawLine(LeftMargin - 5, y, LeftMargin, y);
         // Etiqueta en kHz
         QString lbl = QString::number(freq/1000.0, 'f', 1) + " kHz";
         painter.drawText(
-            QRect(0, y - fm.height()/2, leftMargin - 8, fm.height()),
+            QRect(0, y - fm.height()/2, LeftMargin - 8, fm.height()),
             Qt::AlignRight,
             lbl
             );
     }
 
-    // 5) Dibujar eje de tiempo (abajo)
+    // Eje de tiempo (abajo)
     //    Cada columna corresponde a hopSize muestras:
     double hopSize     = m_cfg.fftSize / 2.0;
     double secPerCol   = hopSize / m_cfg.sampleRate;
-    int cols           = m_image.width();
-    double visDuration = cols * secPerCol;
+    double visDuration = columns * secPerCol;
     int timeTicks      = 5; // 6 marcas incluyendo 0 y fin
     for (int i = 0; i <= timeTicks; ++i) {
         double t       = double(i) / timeTicks;
         double tSec    = t * visDuration;
-        int x          = leftMargin + int(t * drawW);
+        int x          = LeftMargin + int(t * drawW);
         // Línea de marca
         painter.drawLine(x, drawH, x, drawH + 5);
         // Etiqueta en segundos
@@ -415,9 +833,11 @@ void SpectrogramRenderer::paintEvent(QPaintEvent* event) {
             );
     }
 
-    // 6) Si quieres, dibuja un contorno alrededor
-    painter.setPen(QPen(Qt::white, 1));
-    painter.drawRect(spectrogramRect);
+    m_axesSize = size();
+    m_axesDpr = dpr;
+    m_axesFftSize = m_cfg.fftSize;
+    m_axesSampleRate = m_cfg.sampleRate;
+    m_axesColumns = columns;
 }
 
 
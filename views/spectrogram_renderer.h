@@ -4,11 +4,21 @@
 #include <QWidget>
 #include <QVector>
 #include <QMutex>
+#include <QPointer>
 #include <QTimer>
 #include <QImage>
+#include <QPainter>
+#include <QPixmap>
 #include <QRect>
+#include <QSharedPointer>
 #include <memory>
 #include "core/dsp_worker.h"
+#include "core/frame_bus.h"
+#include "core/async_task.h"
+#include "core/render_timing_stats.h"
+#include "core/session_file.h"
+#include "core/spectrum_store.h"
+#include "views/rendered_tile_cache.h"
 
 struct SpectrogramConfig {
     int    fftSize        = 1024;      // debe coincidir con DSPConfig.fftSize
@@ -55,6 +65,41 @@ public:
     int columnCount() const;
     bool isEmpty() const;
 
+    // Suscripción al bus de frames (el buzón se vacía en cada tick)
+    void attachFrameBus(FrameBus* bus, const FrameSubscription& subscription);
+
+    /**
+     * Lee el stream en vivo del almacén compartido en lugar de copiar
+     * columnas: la imagen se compone con teselas de `cache`, compartidas
+     * con las demás vistas del mismo zoom y paleta. Sin caché se usa una
+     * propia. nullptr vuelve al modo de columnas propias.
+     */
+    void attachStore(SpectrumStore* store, RenderedTileCache* cache = nullptr);
+
+    /** Columnas del almacén por píxel (zoom temporal; sólo con almacén) */
+    void setColumnsPerPixel(int stride);
+    int columnsPerPixel() const { return m_stride; }
+
+    /** Nombre bajo el que se publican los tiempos ("render.<nombre>.") */
+    void setMetricsName(const QString& name) { m_timing.setName(name); }
+
+    /**
+     * Muestra un intervalo de una sesión leyendo la pirámide de teselas
+     * (spectrogram_tiles) en el pool de E/S. Los frames en vivo siguen
+     * acumulándose y se recuperan con showLive().
+     */
+    void showTimeSpan(const QString& dbPath, qint64 tStartNs, qint64 tEndNs);
+
+    /** Igual, desde las teselas de un fichero .session abierto */
+    void showTimeSpan(QSharedPointer<const SessionFileReader> file, qint64 tStartNs, qint64 tEndNs);
+    void showLive();
+    bool isShowingHistory() const;
+
+    // HUD de tiempos; las medidas se publican en "render.spectrogram." aunque esté oculto
+    void setTimingHudVisible(bool visible);
+    bool isTimingHudVisible() const { return m_showTimingHud; }
+    const RenderTimingStats& timingStats() const { return m_timing; }
+
 public slots:
     void processFrames(const QVector<FrameData>& frames);
     void clear();
@@ -77,12 +122,24 @@ private slots:
 
 private:
     // Gestión de datos
-    void appendColumn(const QVector<float>& magnitudes);
+    void appendColumn(QVector<CompactSpectrum>& columns, const FrameData& frame);
+    void setHistoryTiles(const QList<SpectrogramTile>& tiles);
+    int beginHistorySpan();   ///< Entra en modo histórico; devuelve las columnas visibles
     void updateVisibleRange();
     void updateImageBuffer();
 
+    // Modo almacén compartido
+    bool usesStore() const { return m_store && !m_historyMode; }
+    void updateStoreVisibleRange();
+    void updateStoreImage();
+    void renderStoreTile(QImage& tile, qint64 index, int rows);
+    quint64 paletteKey(int rows) const;
+
     // Renderizado
+    void ensureAxesLayer(int columns);
+    void drawTimingHud(QPainter& painter, const QRect& area);
     QRgb colorForDb(float db) const;
+    const QRgb* colorLutFor(const CompactSpectrum& column);
     void buildColorMap();
     void buildRoesusColorMap();
     void buildViridisColorMap();
@@ -99,9 +156,30 @@ private:
     // Miembros de datos
     mutable QMutex               m_mutex;
     SpectrogramConfig            m_cfg;
-    QVector<QVector<float>>      m_columns;
+    QVector<CompactSpectrum>     m_columns;     ///< Columnas empaquetadas (1-2 bytes por bin)
     QImage                       m_image;
     std::unique_ptr<QTimer>      m_timer;
+    QPointer<FrameBus>           m_frameBus;
+    FrameBus::SubscriberId       m_busId = 0;
+
+    // Almacén compartido y teselas ya pintadas (la caché no es propiedad de la vista)
+    QPointer<SpectrumStore>      m_store;
+    RenderedTileCache*           m_tileCache = nullptr;
+    std::unique_ptr<RenderedTileCache> m_ownTileCache;
+    int                          m_stride = 1;
+    qint64                       m_storeEnd = -1;
+    quint64                      m_storeGeneration = 0;
+    qint64                       m_storeVisibleStart = 0;   ///< En píxeles absolutos (columna / m_stride)
+    qint64                       m_storeVisibleEnd = 0;
+    QImage                       m_partialTile;
+    QVector<CompactSpectrum>     m_tileColumns;
+    QVector<float>               m_tileDecoded;
+    QVector<float>               m_tileMaxDb;
+
+    // Vista histórica desde la pirámide de teselas
+    bool                         m_historyMode = false;
+    QVector<CompactSpectrum>     m_liveColumns; ///< Columnas en vivo mientras se ve el histórico
+    CancellationToken            m_historyToken;
 
     // Estado de renderizado
     bool                         m_needsUpdate;
@@ -113,11 +191,30 @@ private:
     QVector<QRgb>                m_colorMap;
     ColorMapType                 m_colorMapType;
 
+    // Código empaquetado -> color (256 o 65536 entradas según el formato)
+    QVector<QRgb>                m_codeLut;
+    SpectrumFormat               m_lutFormat = SpectrumFormat::Float32;
+    float                        m_lutMinDb = 0.0f;
+    float                        m_lutMaxDb = 0.0f;
+    bool                         m_lutValid = false;
+
     // Interacción del usuario
     bool                         m_dragging;
     QPoint                       m_lastMousePos;
     double                       m_manualScrollPos;
 
+    // Fondo y ejes en caché: se regeneran sólo si cambia la clave
+    QPixmap                      m_axesLayer;
+    QSize                        m_axesSize;
+    qreal                        m_axesDpr = 0.0;
+    int                          m_axesFftSize = 0;
+    int                          m_axesSampleRate = 0;
+    int                          m_axesColumns = -1;
+
+    // Tiempos de renderizado
+    RenderTimingStats            m_timing{QStringLiteral("spectrogram")};
+    bool                         m_showTimingHud = false;
+
     // Optimizaciones
     QSize                        m_lastSize;
     int                          m_lastColumnCount;
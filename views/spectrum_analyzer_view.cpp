@@ -0,0 +1,343 @@
+#include "spectrum_analyzer_view.h"
+#include <QDebug>
+#include <QPainter>
+#include <QResizeEvent>
+#include <algorithm>
+#include <cmath>
+
+namespace {
+// Márgenes para métricas
+constexpr int LeftMargin   = 40;  // etiquetas de dB
+constexpr int BottomMargin = 18;  // etiquetas de frecuencia
+constexpr int TopMargin    = 4;
+constexpr int RightMargin  = 4;
+}
+
+SpectrumAnalyzerView::SpectrumAnalyzerView(QWidget* parent)
+    : QWidget(parent)
+    , m_timer(std::make_unique<QTimer>(this))
+{
+    setAutoFillBackground(false);
+    setAttribute(Qt::WA_OpaquePaintEvent);
+    setMinimumSize(200, 100);
+
+    m_timer->setInterval(m_cfg.updateInterval);
+    connect(m_timer.get(), &QTimer::timeout, this, &SpectrumAnalyzerView::onUpdateTimeout);
+    m_timer->start();
+}
+
+SpectrumAnalyzerView::~SpectrumAnalyzerView() {
+    if (m_timer && m_timer->isActive()) {
+        m_timer->stop();
+    }
+    attachFrameBus(nullptr, FrameSubscription());
+}
+
+void SpectrumAnalyzerView::attachFrameBus(FrameBus* bus, const FrameSubscription& subscription) {
+    if (m_frameBus) {
+        m_frameBus->unsubscribe(m_busId);
+    }
+    m_frameBus = bus;
+    m_busId = bus ? bus->subscribe(subscription) : 0;
+}
+
+void SpectrumAnalyzerView::setConfig(const SpectrumAnalyzerConfig& cfg) {
+    if (!cfg.isValid()) {
+        qWarning("SpectrumAnalyzerView: Invalid configuration provided");
+        return;
+    }
+
+    const bool mapChanged = cfg.sampleRate != m_cfg.sampleRate ||
+                            cfg.logFrequency != m_cfg.logFrequency ||
+                            cfg.minFreqHz != m_cfg.minFreqHz;
+
+    m_cfg = cfg;
+    m_timer->setInterval(m_cfg.updateInterval);
+
+    if (mapChanged) {
+        m_mapBins = 0;   // se reconstruye en el siguiente tick
+    }
+    if (!m_cfg.peakHold) {
+        m_peak.clear();
+    }
+    if (!m_cfg.showAverage) {
+        m_average.clear();
+        m_hasAverage = false;
+    }
+    m_axesDirty = true;
+    m_needsUpdate = true;
+}
+
+void SpectrumAnalyzerView::processFrames(const QVector<FrameData>& frames) {
+    if (frames.isEmpty() || m_paused) return;
+
+    for (const FrameData& frame : frames) {
+        if (!frame.compactSpectrum.isEmpty()) {
+            m_decoded.resize(frame.compactSpectrum.bins);
+            frame.compactSpectrum.decode(m_decoded.data());
+            ingest(m_decoded.constData(), m_decoded.size(), frame.timestamp);
+        } else if (!frame.spectrum.isEmpty()) {
+            ingest(frame.spectrum.constData(), frame.spectrum.size(), frame.timestamp);
+        }
+    }
+}
+
+void SpectrumAnalyzerView::ingest(const float* db, int bins, quint64 timestampNs) {
+    if (m_current.size() != bins) {
+        // Cambio de tamaño de FFT: las trazas acumuladas ya no son comparables
+        m_current.resize(bins);
+        m_average.clear();
+        m_peak.clear();
+        m_hasAverage = false;
+        m_mapBins = 0;
+    }
+    std::copy(db, db + bins, m_current.begin());
+
+    // Media exponencial, O(bins)
+    if (m_cfg.showAverage) {
+        if (!m_hasAverage) {
+            m_average = m_current;
+            m_hasAverage = true;
+        } else {
+            const float a = m_cfg.averagingAlpha;
+            const float b = 1.0f - a;
+            float* __restrict avg = m_average.data();
+            const float* __restrict cur = m_current.constData();
+            for (int k = 0; k < bins; ++k) {
+                avg[k] = b * avg[k] + a * cur[k];
+            }
+        }
+    }
+
+    // Peak-hold con caída lineal en dB según el tiempo entre frames
+    if (m_cfg.peakHold) {
+        if (m_peak.size() != bins) {
+            m_peak = m_current;
+        } else {
+            float decay = 0.0f;
+            if (m_cfg.peakDecayDbPerS > 0.0f && m_lastTimestamp > 0 && timestampNs > m_lastTimestamp) {
+                decay = m_cfg.peakDecayDbPerS * float(double(timestampNs - m_lastTimestamp) * 1e-9);
+            }
+            float* __restrict peak = m_peak.data();
+            const float* __restrict cur = m_current.constData();
+            for (int k = 0; k < bins; ++k) {
+                peak[k] = std::max(cur[k], peak[k] - decay);
+            }
+        }
+    }
+
+    m_lastTimestamp = timestampNs;
+    m_needsUpdate = true;
+}
+
+void SpectrumAnalyzerView::clear() {
+    m_current.clear();
+    m_average.clear();
+    m_peak.clear();
+    m_hasAverage = false;
+    m_lastTimestamp = 0;
+    m_currentLine.clear();
+    m_averageLine.clear();
+    m_peakLine.clear();
+    m_mapBins = 0;
+    update();
+}
+
+void SpectrumAnalyzerView::resetPeakHold() {
+    m_peak = m_current;
+    m_needsUpdate = true;
+}
+
+void SpectrumAnalyzerView::pause(bool paused) {
+    m_paused = paused;
+    if (m_paused) {
+        m_timer->stop();
+    } else {
+        m_timer->start();
+    }
+}
+
+QRect SpectrumAnalyzerView::plotRect() const {
+    return QRect(LeftMargin, TopMargin,
+                 std::max(1, width() - LeftMargin - RightMargin),
+                 std::max(1, height() - TopMargin - BottomMargin));
+}
+
+void SpectrumAnalyzerView::rebuildColumnMap(int bins, int columns) {
+    m_colStart.resize(columns);
+    m_colEnd.resize(columns);
+
+    const double nyquist = m_cfg.sampleRate / 2.0;
+    const double binHz = nyquist / std::max(1, bins - 1);
+    const double minHz = std::min<double>(m_cfg.minFreqHz, nyquist * 0.5);
+    const double logSpan = std::log(nyquist / minHz);
+
+    auto freqAt = [&](int x) -> double {
+        const double t = double(x) / columns;
+        return m_cfg.logFrequency ? minHz * std::exp(t * logSpan) : t * nyquist;
+    };
+
+    for (int c = 0; c < columns; ++c) {
+        const int start = std::clamp(int(freqAt(c) / binHz + 0.5), 0, bins - 1);
+        const int end = std::clamp(int(freqAt(c + 1) / binHz + 0.5), start + 1, bins);
+        m_colStart[c] = start;
+        m_colEnd[c] = end;
+    }
+
+    m_mapBins = bins;
+    m_mapColumns = columns;
+}
+
+void SpectrumAnalyzerView::reduceToPolyline(const QVector<float>& src, bool useMax, QPolygonF& out) const {
+    const QRect plot = plotRect();
+    const int columns = m_mapColumns;
+    out.resize(columns);
+    if (src.size() != m_mapBins) {
+        out.clear();
+        return;
+    }
+
+    const float* data = src.constData();
+    const float yScale = plot.height() / (m_cfg.maxDb - m_cfg.minDb);
+    for (int c = 0; c < columns; ++c) {
+        const float* __restrict first = data + m_colStart[c];
+        const int n = m_colEnd[c] - m_colStart[c];
+
+        // Reducción sobre bins contiguos (el máximo lo vectoriza el compilador)
+        float v;
+        if (useMax) {
+            v = first[0];
+            for (int i = 1; i < n; ++i) v = std::max(v, first[i]);
+        } else {
+            float sum = 0.0f;
+            for (int i = 0; i < n; ++i) sum += first[i];
+            v = sum / n;
+        }
+
+        const float y = std::clamp((m_cfg.maxDb - v) * yScale, 0.0f, float(plot.height()));
+        out[c] = QPointF(plot.left() + c + 0.5, plot.top() + y);
+    }
+}
+
+void SpectrumAnalyzerView::onUpdateTimeout() {
+    if (m_frameBus) {
+        processFrames(m_frameBus->take(m_busId));
+    }
+
+    const int columns = plotRect().width();
+    const bool mapStale = !m_current.isEmpty() &&
+                          (m_mapBins != m_current.size() || m_mapColumns != columns);
+    if (!m_needsUpdate && !mapStale) return;
+    if (m_current.isEmpty()) return;
+
+    if (mapStale) {
+        rebuildColumnMap(m_current.size(), columns);
+    }
+
+    reduceToPolyline(m_current, true, m_currentLine);
+    if (m_cfg.showAverage && m_hasAverage) {
+        reduceToPolyline(m_average, false, m_averageLine);
+    } else {
+        m_averageLine.clear();
+    }
+    if (m_cfg.peakHold && !m_peak.isEmpty()) {
+        reduceToPolyline(m_peak, true, m_peakLine);
+    } else {
+        m_peakLine.clear();
+    }
+
+    m_needsUpdate = false;
+    update();
+}
+
+void SpectrumAnalyzerView::ensureAxesLayer() {
+    const qreal dpr = devicePixelRatioF();
+    if (!m_axesDirty && m_axesLayer.size() == size() * dpr) {
+        return;
+    }
+
+    m_axesLayer = QPixmap(size() * dpr);
+    m_axesLayer.setDevicePixelRatio(dpr);
+    m_axesLayer.fill(Qt::black);
+
+    QPainter painter(&m_axesLayer);
+    const QRect plot = plotRect();
+    QFontMetrics fm = painter.fontMetrics();
+    const QPen gridPen(QColor(50, 50, 50), 1);
+    const QPen labelPen(Qt::white);
+
+    // Rejilla de dB (cada 20 dB, o 5 divisiones si el rango es pequeño)
+    const float range = m_cfg.maxDb - m_cfg.minDb;
+    const float step = range >= 60.0f ? 20.0f : range / 5.0f;
+    for (float db = std::ceil(m_cfg.minDb / step) * step; db <= m_cfg.maxDb + 1e-3f; db += step) {
+        const int y = plot.top() + int((m_cfg.maxDb - db) / range * plot.height());
+        painter.setPen(gridPen);
+        painter.drawLine(plot.left(), y, plot.right(), y);
+        painter.setPen(labelPen);
+        painter.drawText(QRect(0, y - fm.height() / 2, LeftMargin - 4, fm.height()),
+                         Qt::AlignRight, QString::number(db, 'f', 0));
+    }
+
+    // Rejilla de frecuencia
+    const double nyquist = m_cfg.sampleRate / 2.0;
+    QVector<double> ticks;
+    if (m_cfg.logFrequency) {
+        for (double decade = 10.0; decade < nyquist; decade *= 10.0) {
+            for (double m : {1.0, 2.0, 5.0}) {
+                const double f = decade * m;
+                if (f >= m_cfg.minFreqHz && f <= nyquist) ticks.append(f);
+            }
+        }
+    } else {
+        for (int i = 0; i <= 4; ++i) ticks.append(nyquist * i / 4.0);
+    }
+
+    const double minHz = std::min<double>(m_cfg.minFreqHz, nyquist * 0.5);
+    for (double f : std::as_const(ticks)) {
+        const double t = m_cfg.logFrequency ? std::log(f / minHz) / std::log(nyquist / minHz)
+                                            : f / nyquist;
+        const int x = plot.left() + int(t * plot.width());
+        painter.setPen(gridPen);
+        painter.drawLine(x, plot.top(), x, plot.bottom());
+
+        const QString lbl = f >= 1000.0 ? QString::number(f / 1000.0, 'g', 3) + "k"
+                                        : QString::number(f, 'f', 0);
+        const int tw = fm.horizontalAdvance(lbl);
+        painter.setPen(labelPen);
+        painter.drawText(x - tw / 2, plot.bottom() + 3, tw, fm.height(),
+                         Qt::AlignHCenter | Qt::AlignTop, lbl);
+    }
+
+    painter.setPen(QPen(Qt::white, 1));
+    painter.drawRect(plot);
+    m_axesDirty = false;
+}
+
+void SpectrumAnalyzerView::paintEvent(QPaintEvent* event) {
+    Q_UNUSED(event);
+    QPainter painter(this);
+
+    ensureAxesLayer();
+    painter.drawPixmap(0, 0, m_axesLayer);
+
+    // Trazas: polilíneas de una muestra por columna, sin antialiasing
+    painter.setClipRect(plotRect());
+    if (!m_averageLine.isEmpty()) {
+        painter.setPen(QPen(QColor(80, 200, 120), 1));
+        painter.drawPolyline(m_averageLine);
+    }
+    if (!m_currentLine.isEmpty()) {
+        painter.setPen(QPen(QColor(100, 149, 237), 1));
+        painter.drawPolyline(m_currentLine);
+    }
+    if (!m_peakLine.isEmpty()) {
+        painter.setPen(QPen(QColor(240, 200, 60), 1));
+        painter.drawPolyline(m_peakLine);
+    }
+}
+
+void SpectrumAnalyzerView::resizeEvent(QResizeEvent* event) {
+    QWidget::resizeEvent(event);
+    m_axesDirty = true;
+    m_needsUpdate = true;
+}
@@ -0,0 +1,107 @@
+#ifndef SPECTRUM_ANALYZER_VIEW_H
+#define SPECTRUM_ANALYZER_VIEW_H
+
+#include "core/dsp_worker.h"
+#include "core/frame_bus.h"
+#include <QPixmap>
+#include <QPointer>
+#include <QPolygonF>
+#include <QTimer>
+#include <QVector>
+#include <QWidget>
+#include <memory>
+
+struct SpectrumAnalyzerConfig {
+    int    sampleRate       = 44100;
+    bool   logFrequency     = true;     // eje de frecuencia logarítmico
+    float  minFreqHz        = 20.0f;    // inicio del eje logarítmico
+    float  minDb            = -100.0f;
+    float  maxDb            =   0.0f;
+    bool   showAverage      = true;
+    float  averagingAlpha   = 0.2f;     // peso del frame nuevo en la media exponencial
+    bool   peakHold         = true;
+    float  peakDecayDbPerS  = 20.0f;    // caída del peak-hold (0 = retención infinita)
+    int    updateInterval   = 30;       // ms entre repintados
+
+    bool isValid() const {
+        return sampleRate > 0 && minFreqHz > 0.0f && minDb < maxDb &&
+               averagingAlpha > 0.0f && averagingAlpha <= 1.0f && updateInterval > 0;
+    }
+};
+
+/**
+ * @brief Analizador de espectro instantáneo (magnitud frente a frecuencia)
+ *
+ * Se alimenta del FrameBus. Por cada frame actualiza en O(bins) la media
+ * exponencial y el peak-hold; en cada repintado reduce los bins a una
+ * columna por píxel con un mapa bin→columna precalculado (lineal o
+ * logarítmico), con máximo para el espectro y el peak-hold y media para
+ * el promedio. Así cada traza es una polilínea de como mucho `anchura`
+ * puntos aunque la FFT tenga 64k bins. Rejilla y etiquetas van en un
+ * pixmap en caché.
+ */
+class SpectrumAnalyzerView : public QWidget {
+    Q_OBJECT
+
+public:
+    explicit SpectrumAnalyzerView(QWidget* parent = nullptr);
+    ~SpectrumAnalyzerView() override;
+
+    void setConfig(const SpectrumAnalyzerConfig& cfg);
+    SpectrumAnalyzerConfig config() const { return m_cfg; }
+
+    void attachFrameBus(FrameBus* bus, const FrameSubscription& subscription);
+
+public slots:
+    void processFrames(const QVector<FrameData>& frames);
+    void clear();
+    void resetPeakHold();
+    void pause(bool paused = true);
+
+protected:
+    void paintEvent(QPaintEvent* event) override;
+    void resizeEvent(QResizeEvent* event) override;
+
+private slots:
+    void onUpdateTimeout();
+
+private:
+    void ingest(const float* db, int bins, quint64 timestampNs);
+    void rebuildColumnMap(int bins, int columns);
+    void reduceToPolyline(const QVector<float>& src, bool useMax, QPolygonF& out) const;
+    void ensureAxesLayer();
+    QRect plotRect() const;
+
+    SpectrumAnalyzerConfig m_cfg;
+    std::unique_ptr<QTimer> m_timer;
+    QPointer<FrameBus> m_frameBus;
+    FrameBus::SubscriberId m_busId = 0;
+
+    // Trazas por bin (dB)
+    QVector<float> m_current;
+    QVector<float> m_average;
+    QVector<float> m_peak;
+    QVector<float> m_decoded;          ///< Espectro compacto decodificado
+    quint64 m_lastTimestamp = 0;
+    bool m_hasAverage = false;
+
+    // Mapa columna -> [m_colStart[c], m_colEnd[c]) bins
+    QVector<int> m_colStart;
+    QVector<int> m_colEnd;
+    int m_mapBins = 0;
+    int m_mapColumns = 0;
+
+    // Polilíneas ya reducidas
+    QPolygonF m_currentLine;
+    QPolygonF m_averageLine;
+    QPolygonF m_peakLine;
+
+    // Rejilla en caché
+    QPixmap m_axesLayer;
+    bool m_axesDirty = true;
+
+    bool m_needsUpdate = false;
+    bool m_paused = false;
+};
+
+#endif // SPECTRUM_ANALYZER_VIEW_H
@@ -0,0 +1,455 @@
+#include "waveform_data_provider.h"
+#include "core/audio_db_reader.h"
+#include <QDebug>
+#include <QtMath>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+WaveformDataProvider::WaveformDataProvider(QObject* parent)
+    : QObject(parent)
+{
+    setSession(QString(), Config());
+}
+
+WaveformDataProvider::~WaveformDataProvider() {
+    m_token.cancel();
+}
+
+void WaveformDataProvider::setSession(const QString& dbPath, const Config& config) {
+    m_token.cancel();
+    m_dbPath = dbPath;
+    m_file.reset();
+    m_config = config;
+
+    if (m_config.channels <= 0) {
+        qWarning() << "WaveformDataProvider: channels inválido, usando 1";
+        m_config.channels = 1;
+    }
+    m_config.channel = std::clamp(m_config.channel, 0, m_config.channels - 1);
+    if (m_config.blockFrames <= 0) {
+        qWarning() << "WaveformDataProvider: blockFrames inválido, usando 1024";
+        m_config.blockFrames = 1024;
+    }
+    // Potencia de 2: cada nivel de la pirámide divide la página exactamente
+    m_config.summaryPageBlocks = int(qNextPowerOfTwo(quint32(std::max(2, m_config.summaryPageBlocks) - 1)));
+    m_config.rawCacheBlocks = std::max(1, m_config.rawCacheBlocks);
+    m_config.summaryCachePages = std::max(1, m_config.summaryCachePages);
+    m_config.maxRawBlocksPerRequest = std::clamp(m_config.maxRawBlocksPerRequest, 1, m_config.rawCacheBlocks);
+    m_config.sampleRate = std::max(0, m_config.sampleRate);
+
+    m_summaryLevels = 1;
+    while ((1 << m_summaryLevels) <= m_config.summaryPageBlocks) {
+        ++m_summaryLevels;
+    }
+
+    m_rawPages.setMaxCost(m_config.rawCacheBlocks);
+    m_summaryPages.setMaxCost(m_config.summaryCachePages);
+    m_anchorNs = -1;
+    invalidate();
+}
+
+void WaveformDataProvider::setSessionFile(QSharedPointer<const SessionFileReader> file, const Config& config) {
+    setSession(QString(), config);
+    m_file = file;
+}
+
+void WaveformDataProvider::invalidate() {
+    m_rawPages.clear();
+    m_summaryPages.clear();
+}
+
+void WaveformDataProvider::request(qint64 frameStart, qint64 frameEnd, int columns) {
+    if ((m_dbPath.isEmpty() && !m_file) || columns <= 0 || frameEnd <= frameStart) {
+        return;
+    }
+
+    // Sólo interesa el último intervalo pedido
+    m_token.cancel();
+    m_token = CancellationToken();
+
+    Request req;
+    req.frameStart = std::max<qint64>(0, frameStart);
+    req.frameEnd = std::max(req.frameStart + 1, frameEnd);
+    req.columns = columns;
+
+    if (useRawData(req)) {
+        fetchRaw(req);
+    } else if (useCoarseData(req)) {
+        fetchCoarse(req);
+    } else {
+        fetchSummary(req);
+    }
+}
+
+bool WaveformDataProvider::useRawData(const Request& req) const {
+    const qint64 span = req.frameEnd - req.frameStart;
+    const double framesPerColumn = double(span) / req.columns;
+    const qint64 blocks = span / m_config.blockFrames + 2;
+    return framesPerColumn < m_config.blockFrames && blocks <= m_config.maxRawBlocksPerRequest;
+}
+
+bool WaveformDataProvider::useCoarseData(const Request& req) const {
+    if (m_config.sampleRate <= 0 || m_file) {
+        return false;
+    }
+    const qint64 pages = (req.frameEnd - 1) / pageFrames() - req.frameStart / pageFrames() + 1;
+    return pages > m_config.summaryCachePages;
+}
+
+void WaveformDataProvider::fetchRaw(const Request& req) {
+    const qint64 b0 = req.frameStart / m_config.blockFrames;
+    const qint64 b1 = (req.frameEnd - 1) / m_config.blockFrames;
+
+    qint64 firstMissing = -1;
+    qint64 lastMissing = -1;
+    for (qint64 b = b0; b <= b1; ++b) {
+        if (!m_rawPages.contains(b)) {
+            if (firstMissing < 0) firstMissing = b;
+            lastMissing = b;
+        }
+    }
+
+    if (firstMissing < 0) {
+        emit windowReady(composeRaw(req));
+        return;
+    }
+
+    readBlocks(firstMissing, lastMissing + 1, m_token)
+        .then(this, [this, req](const QList<RawBlockRecord>& blocks) {
+            storeRawBlocks(blocks);
+            emit windowReady(composeRaw(req));
+        });
+}
+
+void WaveformDataProvider::fetchSummary(const Request& req) {
+    const qint64 p0 = req.frameStart / pageFrames();
+    const qint64 p1 = (req.frameEnd - 1) / pageFrames();
+
+    // Todas las páginas de la ventana deben caber a la vez: si no, las
+    // últimas en llegar expulsan a las primeras antes de componer
+    const int pages = int(std::min<qint64>(p1 - p0 + 1, std::numeric_limits<int>::max()));
+    if (pages > m_summaryPages.maxCost()) {
+        m_summaryPages.setMaxCost(pages);
+    }
+
+    qint64 firstMissing = -1;
+    qint64 lastMissing = -1;
+    for (qint64 p = p0; p <= p1; ++p) {
+        const SummaryPage* page = m_summaryPages.object(p);
+        if (!page || !page->complete) {
+            if (firstMissing < 0) firstMissing = p;
+            lastMissing = p;
+        }
+    }
+
+    if (firstMissing < 0) {
+        emit windowReady(composeSummary(req));
+        return;
+    }
+
+    const qint64 pageBlocks = m_config.summaryPageBlocks;
+    readPeaks(firstMissing * pageBlocks, (lastMissing + 1) * pageBlocks, m_token)
+        .then(this, [this, req, firstMissing, lastMissing](const QList<PeakRecord>& peaks) {
+            storeSummaryPages(firstMissing, lastMissing, peaks);
+            emit windowReady(composeSummary(req));
+        });
+}
+
+void WaveformDataProvider::fetchCoarse(const Request& req) {
+    loadCoarse(req, m_token).then(this, [this](const WaveformWindow& window) {
+        emit windowReady(window);
+    });
+}
+
+Task<WaveformWindow> WaveformDataProvider::loadCoarse(Request req, CancellationToken token) {
+    // Los rollups van por timestamp: un pico da la correspondencia frame -> ns
+    if (m_anchorNs < 0) {
+        const qint64 pageBlocks = m_config.summaryPageBlocks;
+        const qint64 page = req.frameStart / pageFrames();
+        QList<PeakRecord> peaks = co_await readPeaks(page * pageBlocks, (page + 1) * pageBlocks, token);
+        if (peaks.isEmpty() && page > 0) {
+            peaks = co_await readPeaks(0, pageBlocks, token);
+        }
+        if (peaks.isEmpty()) {
+            co_return composeTrend(req.frameStart, req.frameEnd, req.columns, 0, 0, {});
+        }
+        m_anchorFrame = peaks.first().sampleOffset / m_config.channels;
+        m_anchorNs = peaks.first().timestamp;
+    }
+
+    const double nsPerFrame = 1e9 / m_config.sampleRate;
+    const qint64 tStart = m_anchorNs + qint64(double(req.frameStart - m_anchorFrame) * nsPerFrame);
+    const qint64 tEnd = m_anchorNs + qint64(double(req.frameEnd - m_anchorFrame) * nsPerFrame);
+    const QList<RollupBucket> buckets = co_await AudioDbReader(m_dbPath).trend(this, token, tStart, tEnd,
+                                                                               req.columns);
+    co_return composeTrend(req.frameStart, req.frameEnd, req.columns, tStart, tEnd, buckets);
+}
+
+Task<QList<RawBlockRecord>> WaveformDataProvider::readBlocks(qint64 firstBlock, qint64 endBlock,
+                                                             CancellationToken token) {
+    if (!m_file) {
+        co_return co_await AudioDbReader(m_dbPath).blocksInRange(this, token, firstBlock * blockSamples(),
+                                                                 endBlock * blockSamples());
+    }
+
+    co_return co_await AsyncTask::run(this, token, [file = m_file, firstBlock, endBlock]() {
+        QList<RawBlockRecord> out;
+        for (const SessionRawBlock& b : file->rawBlocks(firstBlock, endBlock)) {
+            RawBlockRecord rec;
+            rec.blockIndex = b.blockIndex;
+            rec.sampleOffset = b.sampleOffset;
+            rec.data = QByteArray(reinterpret_cast<const char*>(b.samples.constData()),
+                                  b.samples.size() * qsizetype(sizeof(float)));
+            out.append(rec);
+        }
+        return out;
+    });
+}
+
+Task<QList<PeakRecord>> WaveformDataProvider::readPeaks(qint64 firstBlock, qint64 endBlock,
+                                                        CancellationToken token) {
+    if (!m_file) {
+        co_return co_await AudioDbReader(m_dbPath).peaksByOffset(this, token, firstBlock * blockSamples(),
+                                                                 endBlock * blockSamples());
+    }
+
+    co_return co_await AsyncTask::run(this, token, [file = m_file, firstBlock, endBlock]() {
+        QList<PeakRecord> out;
+        for (const SessionPeak& p : file->peaks(firstBlock, endBlock)) {
+            PeakRecord rec;
+            rec.timestamp = p.timestampNs;
+            rec.blockIndex = p.blockIndex;
+            rec.sampleOffset = p.sampleOffset;
+            rec.minValue = p.minValue;
+            rec.maxValue = p.maxValue;
+            rec.rmsValue = p.rmsValue;
+            out.append(rec);
+        }
+        return out;
+    });
+}
+
+void WaveformDataProvider::storeRawBlocks(const QList<RawBlockRecord>& blocks) {
+    const int channels = m_config.channels;
+    const int channel = m_config.channel;
+
+    for (const RawBlockRecord& rec : blocks) {
+        const float* src = reinterpret_cast<const float*>(rec.data.constData());
+        const int frames = int(rec.data.size() / qsizetype(sizeof(float))) / channels;
+
+        auto* page = new RawPage;
+        page->firstFrame = rec.sampleOffset / channels;
+        page->samples.resize(frames);
+        float* dst = page->samples.data();
+        for (int i = 0; i < frames; ++i) {
+            dst[i] = src[i * channels + channel];
+        }
+        m_rawPages.insert(rec.sampleOffset / blockSamples(), page, 1);
+    }
+}
+
+void WaveformDataProvider::storeSummaryPages(qint64 firstPage, qint64 lastPage,
+                                             const QList<PeakRecord>& peaks) {
+    const int pageBlocks = m_config.summaryPageBlocks;
+    const int pageCount = int(lastPage - firstPage + 1);
+
+    QVector<SummaryPage*> pages(pageCount);
+    QVector<int> filled(pageCount, 0);
+    for (int i = 0; i < pageCount; ++i) {
+        pages[i] = new SummaryPage;
+        pages[i]->levels.resize(m_summaryLevels);
+        pages[i]->levels[0].resize(pageBlocks);
+    }
+
+    // Nivel 0: un tramo por bloque (los bloques ausentes quedan en 0)
+    for (const PeakRecord& peak : peaks) {
+        const qint64 block = peak.sampleOffset / blockSamples();
+        const int p = int(block / pageBlocks - firstPage);
+        if (p < 0 || p >= pageCount) continue;
+        WaveformSpan& span = pages[p]->levels[0][int(block % pageBlocks)];
+        span.minValue = peak.minValue;
+        span.maxValue = peak.maxValue;
+        span.rmsValue = peak.rmsValue;
+        ++filled[p];
+    }
+
+    // Niveles superiores: pares del nivel anterior
+    for (int i = 0; i < pageCount; ++i) {
+        SummaryPage* page = pages[i];
+        page->complete = filled[i] == pageBlocks;
+        for (int k = 1; k < m_summaryLevels; ++k) {
+            const QVector<WaveformSpan>& prev = page->levels[k - 1];
+            QVector<WaveformSpan>& cur = page->levels[k];
+            cur.resize(prev.size() / 2);
+            for (int e = 0; e < cur.size(); ++e) {
+                const WaveformSpan& a = prev[2 * e];
+                const WaveformSpan& b = prev[2 * e + 1];
+                cur[e].minValue = std::min(a.minValue, b.minValue);
+                cur[e].maxValue = std::max(a.maxValue, b.maxValue);
+                cur[e].rmsValue = std::sqrt(0.5f * (a.rmsValue * a.rmsValue + b.rmsValue * b.rmsValue));
+            }
+        }
+        m_summaryPages.insert(firstPage + i, page, 1);
+    }
+}
+
+WaveformWindow WaveformDataProvider::composeRaw(const Request& req) const {
+    WaveformWindow window;
+    window.frameStart = req.frameStart;
+    window.frameEnd = req.frameEnd;
+    window.framesPerColumn = double(req.frameEnd - req.frameStart) / req.columns;
+    window.exact = true;
+    window.spans.resize(req.columns);
+
+    const double fpc = window.framesPerColumn;
+    const qint64 b0 = req.frameStart / m_config.blockFrames;
+    const qint64 b1 = (req.frameEnd - 1) / m_config.blockFrames;
+
+    if (fpc >= 1.0) {
+        // Varias muestras por columna: min/max/RMS exactos
+        QVector<int> counts(req.columns, 0);
+        QVector<double> energy(req.columns, 0.0);
+        for (qint64 b = b0; b <= b1; ++b) {
+            const RawPage* page = m_rawPages.object(b);
+            if (!page) continue;
+
+            const qint64 first = std::max(req.frameStart, page->firstFrame);
+            const qint64 last = std::min(req.frameEnd, page->firstFrame + page->samples.size());
+            for (qint64 f = first; f < last; ++f) {
+                const float v = page->samples[int(f - page->firstFrame)];
+                const int c = std::min(req.columns - 1, int((f - req.frameStart) / fpc));
+                WaveformSpan& span = window.spans[c];
+                if (counts[c]++ == 0) {
+                    span.minValue = span.maxValue = v;
+                } else {
+                    span.minValue = std::min(span.minValue, v);
+                    span.maxValue = std::max(span.maxValue, v);
+                }
+                energy[c] += double(v) * v;
+            }
+        }
+        for (int c = 0; c < req.columns; ++c) {
+            if (counts[c] > 0) {
+                window.spans[c].rmsValue = float(std::sqrt(energy[c] / counts[c]));
+            }
+        }
+        return window;
+    }
+
+    // Menos muestras que columnas: interpolación lineal entre muestras, cada
+    // columna cubre el tramo entre sus dos bordes para que la línea sea continua
+    auto sampleAt = [&](qint64 f) -> float {
+        const RawPage* page = m_rawPages.object(f / m_config.blockFrames);
+        if (!page) return 0.0f;
+        const qint64 i = f - page->firstFrame;
+        return (i >= 0 && i < page->samples.size()) ? page->samples[int(i)] : 0.0f;
+    };
+    auto valueAt = [&](double x) -> float {
+        const qint64 f = qint64(std::floor(x));
+        const float t = float(x - double(f));
+        const float a = sampleAt(f);
+        return t > 0.0f ? a + t * (sampleAt(f + 1) - a) : a;
+    };
+
+    float left = valueAt(double(req.frameStart));
+    for (int c = 0; c < req.columns; ++c) {
+        const float right = valueAt(req.frameStart + (c + 1) * fpc);
+        WaveformSpan& span = window.spans[c];
+        span.minValue = std::min(left, right);
+        span.maxValue = std::max(left, right);
+        span.rmsValue = std::abs(0.5f * (left + right));
+        left = right;
+    }
+    return window;
+}
+
+WaveformWindow WaveformDataProvider::composeSummary(const Request& req) const {
+    WaveformWindow window;
+    window.frameStart = req.frameStart;
+    window.frameEnd = req.frameEnd;
+    window.framesPerColumn = double(req.frameEnd - req.frameStart) / req.columns;
+    window.exact = false;
+    window.spans.resize(req.columns);
+
+    // Nivel más grueso que aún deja al menos una entrada por columna
+    const double blocksPerColumn = window.framesPerColumn / m_config.blockFrames;
+    const int level = std::clamp(int(std::floor(std::log2(std::max(1.0, blocksPerColumn)))),
+                                 0, m_summaryLevels - 1);
+    const int entriesPerPage = m_config.summaryPageBlocks >> level;
+
+    qint64 cachedIndex = -1;
+    const SummaryPage* cached = nullptr;
+
+    for (int c = 0; c < req.columns; ++c) {
+        const qint64 b0 = qint64((req.frameStart + c * window.framesPerColumn) / m_config.blockFrames);
+        const qint64 b1 = std::max(b0 + 1, qint64((req.frameStart + (c + 1) * window.framesPerColumn)
+                                                  / m_config.blockFrames));
+        const qint64 e0 = b0 >> level;
+        const qint64 e1 = std::max(e0 + 1, (b1 + (qint64(1) << level) - 1) >> level);
+
+        WaveformSpan& span = window.spans[c];
+        bool any = false;
+        float energy = 0.0f;
+        int count = 0;
+        for (qint64 e = e0; e < e1; ++e) {
+            const qint64 pageIndex = e / entriesPerPage;
+            if (pageIndex != cachedIndex) {
+                cached = m_summaryPages.object(pageIndex);
+                cachedIndex = pageIndex;
+            }
+            if (!cached) continue;
+
+            const WaveformSpan& s = cached->levels[level][int(e % entriesPerPage)];
+            span.minValue = any ? std::min(span.minValue, s.minValue) : s.minValue;
+            span.maxValue = any ? std::max(span.maxValue, s.maxValue) : s.maxValue;
+            energy += s.rmsValue * s.rmsValue;
+            ++count;
+            any = true;
+        }
+        if (count > 0) {
+            span.rmsValue = std::sqrt(energy / count);
+        }
+    }
+    return window;
+}
+
+WaveformWindow WaveformDataProvider::composeTrend(qint64 frameStart, qint64 frameEnd, int columns,
+                                                 qint64 tStart, qint64 tEnd,
+                                                 const QList<RollupBucket>& buckets) {
+    WaveformWindow window;
+    window.frameStart = frameStart;
+    window.frameEnd = frameEnd;
+    window.framesPerColumn = columns > 0 ? double(frameEnd - frameStart) / columns : 0.0;
+    window.exact = false;
+    if (columns <= 0) {
+        return window;
+    }
+    window.spans.resize(columns);
+    if (tEnd <= tStart) {
+        return window;
+    }
+
+    const double nsPerColumn = double(tEnd - tStart) / columns;
+    auto columnAt = [&](qint64 t) {
+        return int(std::clamp<double>(std::floor(double(t - tStart) / nsPerColumn), 0.0, columns - 1));
+    };
+
+    QVector<RollupBucket> merged(columns);
+    for (const RollupBucket& b : buckets) {
+        if (b.isEmpty() || b.lastNs < tStart || b.startNs > tEnd) continue;
+        const int c1 = columnAt(std::max(b.startNs, b.lastNs));
+        for (int c = columnAt(b.startNs); c <= c1; ++c) {
+            merged[c].merge(b);
+        }
+    }
+
+    for (int c = 0; c < columns; ++c) {
+        if (merged[c].isEmpty()) continue;
+        WaveformSpan& span = window.spans[c];
+        span.minValue = merged[c].minValue;
+        span.maxValue = merged[c].maxValue;
+        span.rmsValue = float(merged[c].rms());
+    }
+    return window;
+}
@@ -0,0 +1,139 @@
+#ifndef WAVEFORM_DATA_PROVIDER_H
+#define WAVEFORM_DATA_PROVIDER_H
+
+#include "core/async_task.h"
+#include "core/audio_db.h"
+#include "core/session_file.h"
+#include "views/waveform_raster.h"
+#include <QCache>
+#include <QObject>
+#include <QSharedPointer>
+#include <QString>
+#include <QVector>
+#include <QtTypes>
+
+/**
+ * @brief Columnas de waveform para un intervalo de frames
+ */
+struct WaveformWindow {
+    qint64 frameStart = 0;
+    qint64 frameEnd = 0;
+    double framesPerColumn = 0.0;
+    bool exact = false;               ///< Calculado desde las muestras crudas
+    QVector<WaveformSpan> spans;      ///< Un tramo por columna
+};
+
+/**
+ * @brief Datos de waveform de una sesión a cualquier nivel de zoom
+ *
+ * Alejado (>= un bloque por columna) sirve una pirámide min/max/RMS
+ * construida sobre los picos (ts_chunks o audio_peaks), leída por páginas
+ * de summaryPageBlocks bloques. Si la ventana abarca más páginas de las
+ * que caben en caché (horas o días) y se conoce sampleRate, se usa el
+ * nivel grueso: los rollups de 1 s / 1 min / 1 h vía trend(), sin leer
+ * un pico por bloque. Cerca lee los bloques crudos exactos del intervalo
+ * (audio_blocks) y los decodifica a páginas float de un canal.
+ * Las páginas se guardan en cachés LRU (QCache), y las lecturas van al pool de E/S mediante
+ * AudioDbReader: request() nunca bloquea y emite windowReady() al completar.
+ *
+ * La misma sesión puede venir de un fichero .session abierto
+ * (setSessionFile): picos y bloques salen de sus chunks columnares, sin
+ * nivel grueso porque el fichero no guarda rollups.
+ *
+ * Las posiciones se expresan en frames (sample_offset / channels).
+ */
+class WaveformDataProvider : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Config {
+        int channels = 1;             ///< Canales intercalados en audio_blocks
+        int channel = 0;              ///< Canal mostrado
+        int blockFrames = 1024;       ///< Frames por bloque (DSPConfig::blockSize / channels)
+        int summaryPageBlocks = 4096; ///< Bloques por página de la pirámide (potencia de 2)
+        int rawCacheBlocks = 512;     ///< Bloques crudos decodificados en caché
+        int summaryCachePages = 64;   ///< Páginas de la pirámide en caché
+        int maxRawBlocksPerRequest = 256; ///< Por encima se usa la pirámide
+        int sampleRate = 0;           ///< Hz; 0 = sin nivel grueso (sólo la pirámide)
+    };
+
+    explicit WaveformDataProvider(QObject* parent = nullptr);
+    ~WaveformDataProvider() override;
+
+    void setSession(const QString& dbPath, const Config& config);
+    void setSessionFile(QSharedPointer<const SessionFileReader> file, const Config& config);
+    QString sessionPath() const { return m_dbPath; }
+    const Config& config() const { return m_config; }
+
+    /**
+     * @brief Pide `columns` tramos para [frameStart, frameEnd)
+     *
+     * Si todas las páginas están en caché se emite windowReady() antes de
+     * volver; si no, se cancela la lectura anterior y se emite al llegar
+     * los datos.
+     */
+    void request(qint64 frameStart, qint64 frameEnd, int columns);
+
+    /** Vacía las cachés (p. ej. si la sesión ha cambiado en disco) */
+    void invalidate();
+
+    /**
+     * @brief Reparte buckets de rollup entre las columnas de [tStart, tEnd]
+     *
+     * Cada bucket se acumula en todas las columnas que solapa, de modo que
+     * un bucket más ancho que una columna la rellena en lugar de dejar
+     * huecos. Las columnas sin buckets quedan a 0.
+     */
+    static WaveformWindow composeTrend(qint64 frameStart, qint64 frameEnd, int columns,
+                                       qint64 tStart, qint64 tEnd,
+                                       const QList<RollupBucket>& buckets);
+
+signals:
+    void windowReady(const WaveformWindow& window);
+
+private:
+    struct RawPage {
+        qint64 firstFrame = 0;
+        QVector<float> samples;       ///< Canal seleccionado, ya desintercalado
+    };
+
+    struct SummaryPage {
+        bool complete = false;        ///< false = última página, puede crecer
+        QVector<QVector<WaveformSpan>> levels;   ///< levels[k][i] cubre 2^k bloques
+    };
+
+    struct Request {
+        qint64 frameStart = 0;
+        qint64 frameEnd = 0;
+        int columns = 0;
+    };
+
+    bool useRawData(const Request& req) const;
+    bool useCoarseData(const Request& req) const;
+    void fetchRaw(const Request& req);
+    void fetchSummary(const Request& req);
+    void fetchCoarse(const Request& req);
+    Task<WaveformWindow> loadCoarse(Request req, CancellationToken token);
+    Task<QList<RawBlockRecord>> readBlocks(qint64 firstBlock, qint64 endBlock, CancellationToken token);
+    Task<QList<PeakRecord>> readPeaks(qint64 firstBlock, qint64 endBlock, CancellationToken token);
+    void storeRawBlocks(const QList<RawBlockRecord>& blocks);
+    void storeSummaryPages(qint64 firstPage, qint64 lastPage, const QList<PeakRecord>& peaks);
+    WaveformWindow composeRaw(const Request& req) const;
+    WaveformWindow composeSummary(const Request& req) const;
+
+    qint64 blockSamples() const { return qint64(m_config.blockFrames) * m_config.channels; }
+    qint64 pageFrames() const { return qint64(m_config.summaryPageBlocks) * m_config.blockFrames; }
+
+    QString m_dbPath;
+    QSharedPointer<const SessionFileReader> m_file;   ///< Alternativa a m_dbPath
+    Config m_config;
+    int m_summaryLevels = 1;
+    QCache<qint64, RawPage> m_rawPages;         ///< Clave: índice de bloque
+    QCache<qint64, SummaryPage> m_summaryPages; ///< Clave: índice de página
+    qint64 m_anchorFrame = 0;                   ///< Frame con timestamp conocido (nivel grueso)
+    qint64 m_anchorNs = -1;                     ///< -1 = aún sin leer
+    CancellationToken m_token;
+};
+
+#endif // WAVEFORM_DATA_PROVIDER_H
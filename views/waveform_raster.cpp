@@ -0,0 +1,136 @@
+#include "waveform_raster.h"
+#include <QDebug>
+#include <algorithm>
+#include <cmath>
+
+void WaveformRaster::computeSpans(const float* mins, const float* maxs, const float* rms,
+                                  int blocks, int columns, QVector<WaveformSpan>& out) {
+    if (blocks <= 0 || columns <= 0 || !mins || !maxs) {
+        out.clear();
+        return;
+    }
+    out.resize(columns);
+
+    const double blocksPerColumn = double(blocks) / columns;
+    for (int x = 0; x < columns; ++x) {
+        const int start = std::min(int(x * blocksPerColumn), blocks - 1);
+        const int end = std::min(blocks, std::max(start + 1, int((x + 1) * blocksPerColumn)));
+
+        float lo = mins[start];
+        float hi = maxs[start];
+        float energy = 0.0f;
+        for (int b = start; b < end; ++b) {
+            lo = std::min(lo, mins[b]);
+            hi = std::max(hi, maxs[b]);
+            if (rms) energy += rms[b] * rms[b];
+        }
+
+        WaveformSpan& span = out[x];
+        span.minValue = lo;
+        span.maxValue = hi;
+        // RMS combinado: raíz de la energía media de los bloques de la columna
+        span.rmsValue = rms ? std::sqrt(energy / float(end - start)) : 0.0f;
+    }
+}
+
+void WaveformRaster::updateLuts(const Style& style) {
+    if (m_lutValid && m_lutPeakColor == style.peakColor && m_lutRmsColor == style.rmsColor) {
+        return;
+    }
+
+    for (int a = 0; a < 256; ++a) {
+        m_peakLut[a] = qPremultiply(qRgba(qRed(style.peakColor), qGreen(style.peakColor),
+                                          qBlue(style.peakColor), a));
+        m_rmsLut[a] = qPremultiply(qRgba(qRed(style.rmsColor), qGreen(style.rmsColor),
+                                         qBlue(style.rmsColor), a));
+    }
+    m_lutPeakColor = style.peakColor;
+    m_lutRmsColor = style.rmsColor;
+    m_lutValid = true;
+}
+
+void WaveformRaster::render(QImage& image, const QRect& lane, const QVector<WaveformSpan>& spans,
+                            const Style& style) {
+    if (image.format() != QImage::Format_ARGB32_Premultiplied) {
+        qWarning() << "WaveformRaster: se esperaba Format_ARGB32_Premultiplied";
+        return;
+    }
+
+    const QRect area = lane.intersected(image.rect());
+    const int W = std::min(area.width(), int(spans.size()));
+    const int H = area.height();
+    if (W <= 0 || H <= 0) return;
+
+    updateLuts(style);
+
+    // 1) Extremos de cada tramo en píxeles (misma escala que scaleValue)
+    m_peakTop.resize(W);
+    m_peakBottom.resize(W);
+    m_rmsTop.resize(W);
+    m_rmsBottom.resize(W);
+
+    const float center = H / 2.0f;
+    const float halfRange = style.scale * (H / 2.2f);
+    const float height = float(H);
+    for (int x = 0; x < W; ++x) {
+        const WaveformSpan& s = spans[x];
+        float top = std::clamp(center - s.maxValue * halfRange, 0.0f, height);
+        float bottom = std::clamp(center - s.minValue * halfRange, 0.0f, height);
+        // Al menos un píxel de trazo, como la línea del pintado vectorial
+        if (bottom - top < 1.0f) {
+            top = std::min(top, height - 1.0f);
+            bottom = top + 1.0f;
+        }
+        m_peakTop[x] = top;
+        m_peakBottom[x] = bottom;
+
+        if (style.showRms) {
+            // El RMS queda siempre dentro del tramo de pico
+            const float rmsTop = std::clamp(center - s.rmsValue * halfRange, top, bottom);
+            const float rmsBottom = std::clamp(center + s.rmsValue * halfRange, rmsTop, bottom);
+            m_rmsTop[x] = rmsTop;
+            m_rmsBottom[x] = rmsBottom;
+        } else {
+            m_rmsTop[x] = m_rmsBottom[x] = 0.0f;
+        }
+    }
+
+    // 2) Relleno fila a fila. Cobertura de la fila [y, y+1) por cada tramo;
+    //    sin antialiasing se muestrea en el centro de la fila (0 o 1).
+    //    Los colores premultiplicados de pico y RMS se suman por canal
+    //    sin acarreo porque las coberturas suman como mucho 255.
+    const float* __restrict pTop = m_peakTop.constData();
+    const float* __restrict pBottom = m_peakBottom.constData();
+    const float* __restrict rTop = m_rmsTop.constData();
+    const float* __restrict rBottom = m_rmsBottom.constData();
+    const QRgb* peakLut = m_peakLut;
+    const QRgb* rmsLut = m_rmsLut;
+
+    for (int y = 0; y < H; ++y) {
+        QRgb* __restrict row = reinterpret_cast<QRgb*>(image.scanLine(area.top() + y)) + area.left();
+        const float y0 = float(y);
+        const float y1 = y0 + 1.0f;
+        const float yc = y0 + 0.5f;
+
+        if (style.antialias) {
+            for (int x = 0; x < W; ++x) {
+                const float cov = std::clamp(std::min(y1, pBottom[x]) - std::max(y0, pTop[x]), 0.0f, 1.0f);
+                const float covRms = std::clamp(std::min(y1, rBottom[x]) - std::max(y0, rTop[x]), 0.0f, 1.0f);
+                const int a = int(cov * 255.0f + 0.5f);
+                const int aRms = std::min(a, int(covRms * 255.0f + 0.5f));
+                row[x] = rmsLut[aRms] + peakLut[a - aRms];
+            }
+        } else {
+            for (int x = 0; x < W; ++x) {
+                const int inPeak = (yc >= pTop[x]) & (yc < pBottom[x]);
+                const int inRms = (yc >= rTop[x]) & (yc < rBottom[x]);
+                row[x] = inRms ? rmsLut[255] : (inPeak ? peakLut[255] : 0u);
+            }
+        }
+
+        // Columnas sin tramo dentro del carril
+        for (int x = W; x < area.width(); ++x) {
+            row[x] = 0u;
+        }
+    }
+}
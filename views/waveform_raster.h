@@ -0,0 +1,75 @@
+#ifndef WAVEFORM_RASTER_H
+#define WAVEFORM_RASTER_H
+
+#include <QImage>
+#include <QRect>
+#include <QVector>
+#include <QtTypes>
+
+/**
+ * @brief Tramo vertical de una columna de píxeles
+ */
+struct WaveformSpan {
+    float minValue = 0.0f;
+    float maxValue = 0.0f;
+    float rmsValue = 0.0f;
+};
+
+/**
+ * @brief Motor raster de waveform: escribe tramos verticales en un QImage
+ *
+ * En lugar de un drawLine por columna a través del motor de pintado, se
+ * calcula por columna el tramo min/max/RMS y se rellena directamente el
+ * buffer de scanlines. El relleno recorre fila a fila con comparaciones
+ * por columna sin ramas, de modo que el compilador vectoriza el bucle.
+ *
+ * Con antialiasing, la cobertura de los extremos del tramo se calcula en
+ * coma flotante y se traduce a color premultiplicado con una tabla de 256
+ * entradas. Cada canal se dibuja en su propio carril (lane) de la imagen.
+ */
+class WaveformRaster
+{
+public:
+    struct Style {
+        QRgb peakColor = qRgb(100, 149, 237);
+        QRgb rmsColor = qRgb(70, 130, 180);
+        bool showRms = false;
+        bool antialias = false;
+        float scale = 1.0f;            ///< Amplitud -> fracción de media altura del carril
+    };
+
+    /**
+     * @brief Reduce bloques min/max/RMS a `columns` tramos
+     *
+     * Si hay menos bloques que columnas, cada bloque se estira sobre las
+     * columnas que le corresponden.
+     */
+    static void computeSpans(const float* mins, const float* maxs, const float* rms,
+                             int blocks, int columns, QVector<WaveformSpan>& out);
+
+    /**
+     * @brief Pinta los tramos en el carril `lane` de `image`
+     *
+     * `image` debe ser Format_ARGB32_Premultiplied; las filas del carril se
+     * sobrescriben (transparente fuera del tramo).
+     */
+    void render(QImage& image, const QRect& lane, const QVector<WaveformSpan>& spans,
+                const Style& style);
+
+private:
+    void updateLuts(const Style& style);
+
+    QVector<float> m_peakTop;          ///< Extremo superior del pico por columna (px)
+    QVector<float> m_peakBottom;
+    QVector<float> m_rmsTop;
+    QVector<float> m_rmsBottom;
+
+    // Color premultiplicado por nivel de cobertura (0..255)
+    QRgb m_peakLut[256];
+    QRgb m_rmsLut[256];
+    QRgb m_lutPeakColor = 0;
+    QRgb m_lutRmsColor = 0;
+    bool m_lutValid = false;
+};
+
+#endif // WAVEFORM_RASTER_H
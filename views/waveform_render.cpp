@@ -31,6 +31,10 @@ WaveformRenderer::WaveformRenderer(QWidget* parent)
     // Configurar colores y configuración inicial para waveform estilo Audacity
     initializeForAudacityStyle();
 
+    m_statusFont = font();
+    m_statusFont.setPointSize(9);
+    m_statusFont.setFamily("Arial");
+
     qDebug() << "WaveformRenderer inicializado con estilo Audacity";
 }
 
@@ -39,6 +43,82 @@ WaveformRenderer::~WaveformRenderer()
     if (m_updateTimer) {
         m_updateTimer->stop();
     }
+    attachFrameBus(nullptr, FrameSubscription());
+}
+
+void WaveformRenderer::attachFrameBus(FrameBus* bus, const FrameSubscription& subscription)
+{
+    if (m_frameBus) {
+        m_frameBus->unsubscribe(m_busId);
+    }
+    m_frameBus = bus;
+    m_busId = bus ? bus->subscribe(subscription) : 0;
+}
+
+void WaveformRenderer::attachStore(SpectrumStore* store)
+{
+    QMutexLocker locker(&m_mutex);
+    m_store = store;
+    m_storeEnd = -1;
+    m_dataDirty = true;
+    m_needsUpdate = true;
+}
+
+bool WaveformRenderer::hasLiveData() const
+{
+    return m_store ? m_storeEnd > 0 : !m_blocks.isEmpty();
+}
+
+void WaveformRenderer::setDataProvider(WaveformDataProvider* provider)
+{
+    if (m_provider) {
+        disconnect(m_provider, nullptr, this, nullptr);
+    }
+    m_provider = provider;
+    if (m_provider) {
+        connect(m_provider, &WaveformDataProvider::windowReady,
+                this, &WaveformRenderer::onWindowReady);
+    }
+}
+
+void WaveformRenderer::showFrameRange(qint64 frameStart, qint64 frameEnd)
+{
+    if (!m_provider || frameEnd <= frameStart) {
+        return;
+    }
+    m_historyMode = true;
+    m_historyStart = std::max<qint64>(0, frameStart);
+    m_historyEnd = std::max(m_historyStart + 1, frameEnd);
+    requestHistoryWindow();
+}
+
+void WaveformRenderer::showLive()
+{
+    if (!m_historyMode) {
+        return;
+    }
+    m_historyMode = false;
+    m_historyWindow = WaveformWindow();
+    m_dataDirty = true;
+    m_needsUpdate = true;
+    update();
+}
+
+void WaveformRenderer::requestHistoryWindow()
+{
+    // Una columna por píxel físico del área de la waveform
+    const int columns = std::max(1, int((width() - LeftMargin) * devicePixelRatioF()));
+    m_provider->request(m_historyStart, m_historyEnd, columns);
+}
+
+void WaveformRenderer::onWindowReady(const WaveformWindow& window)
+{
+    if (!m_historyMode || window.frameStart != m_historyStart || window.frameEnd != m_historyEnd) {
+        return;
+    }
+    m_historyWindow = window;
+    m_dataDirty = true;
+    update();
 }
 
 void WaveformRenderer::setConfig(const WaveformConfig& config)
@@ -57,6 +137,8 @@ void WaveformRenderer::setConfig(const WaveformConfig& config)
     setPalette(palette);
     setAutoFillBackground(true);
 
+    m_staticDirty = true;
+    m_dataDirty = true;
     m_needsUpdate = true;
     update();
 }
@@ -104,8 +186,14 @@ void WaveformRenderer::processFrames(const QVector<FrameData>& frames)
         block.sampleOffset = frame.sampleOffset;
         block.samples = frame.waveform;
 
-        // Calcular estadísticas del bloque
+        // Calcular estadísticas del bloque; si el DSP envió los extremos
+        // exactos del bloque completo, prevalecen sobre los de la decimación
         calculateBlockStats(block);
+        if (frame.peakMin < frame.peakMax) {
+            block.minValue = frame.peakMin;
+            block.maxValue = frame.peakMax;
+            block.rmsValue = frame.peakRms;
+        }
 
         // Añadir el bloque
         addBlock(block);
@@ -114,6 +202,10 @@ void WaveformRenderer::processFrames(const QVector<FrameData>& frames)
         m_latestTimestamp = frame.timestamp;
     }
 
+    // En modo histórico lo nuevo se acumula sin repintar la ventana mostrada
+    if (!m_historyMode) {
+        m_dataDirty = true;
+    }
     m_needsUpdate = true;
     emit waveformUpdated(m_blocks.size());
 }
@@ -128,6 +220,8 @@ void WaveformRenderer::clear()
     m_visibleEndIndex = 0;
     m_totalBlocks = 0;
     m_latestTimestamp = 0;
+    m_storeEnd = -1;
+    m_dataDirty = true;
     m_needsUpdate = true;
     update();
 }
@@ -143,12 +237,43 @@ void WaveformRenderer::setPaused(bool paused)
 void WaveformRenderer::setZoom(float zoom)
 {
     m_zoom = std::max(0.1f, std::min(10.0f, zoom));
+    m_dataDirty = true;
     m_needsUpdate = true;
     update();
 }
 
+void WaveformRenderer::setTimingHudVisible(bool visible)
+{
+    m_showTimingHud = visible;
+    update();
+}
+
 void WaveformRenderer::updateDisplay()
 {
+    if (m_frameBus) {
+        const QVector<FrameData> frames = m_frameBus->take(m_busId);
+        if (!frames.isEmpty()) {
+            RenderTimingStats::Scope timing(m_timing, RenderTimingStats::ProcessFrames);
+            processFrames(frames);
+        }
+        m_timing.recordTick(frames.size(), m_frameBus->droppedFrames(m_busId));
+    }
+    m_timing.publishIfDue();
+
+    // Con almacén sólo se mira si ha crecido: los bloques no pasan por la vista
+    if (m_store && !m_paused) {
+        const qint64 end = m_store->endBlock();
+        const quint64 generation = m_store->generation();
+        if (end != m_storeEnd || generation != m_storeGeneration) {
+            m_storeEnd = end;
+            m_storeGeneration = generation;
+            if (!m_historyMode) {
+                m_dataDirty = true;
+            }
+            m_needsUpdate = true;
+        }
+    }
+
     if (!m_needsUpdate) {
         return;
     }
@@ -161,75 +286,186 @@ void WaveformRenderer::updateDisplay()
 void WaveformRenderer::paintEvent(QPaintEvent* event)
 {
     Q_UNUSED(event);
+    RenderTimingStats::Scope timing(m_timing, RenderTimingStats::Paint);
     QPainter painter(this);
-    painter.setRenderHint(QPainter::Antialiasing, true);
 
-    // 1) Fondo completo estilo Audacity
-    QRect fullRect = rect();
-    drawAudacityBackground(painter, fullRect);
+    // 1) Fondo y escala: pixmap en caché, se regenera sólo al cambiar tamaño o configuración
+    ensureStaticLayer();
+    painter.drawPixmap(0, 0, m_staticLayer);
 
     QMutexLocker locker(&m_mutex);
 
     // 2) Si no hay datos, mostramos mensaje y salimos
-    if (m_blocks.isEmpty()) {
+    if (!hasLiveData() && !m_historyMode) {
         painter.setPen(QColor(180, 180, 180));
         QFont f = painter.font();
         f.setPointSize(10);
         painter.setFont(f);
-        painter.drawText(fullRect, Qt::AlignCenter,
+        painter.drawText(rect(), Qt::AlignCenter,
                          tr("Esperando datos de audio..."));
         return;
     }
 
-    // 3) Definir margen izquierdo para la escala lineal
-    const int marginLeft = 40;
-    int fullW = fullRect.width();
-    int fullH = fullRect.height();
-    int wfW   = fullW - marginLeft;
-    int wfH   = fullH;
-    QRect waveformRect(fullRect.left() + marginLeft,
-                       fullRect.top(),
-                       wfW, wfH);
+    // 3) Waveform: se vuelve a trazar sólo cuando llegan datos o cambia el zoom
+    ensureDataLayer();
+    painter.drawImage(LeftMargin, 0, m_dataLayer);
+
+    // 4) Información de estado (capa dinámica, sin antialiasing)
+    drawStatusInfo(painter, rect());
+
+    // 5) Tiempos de renderizado (valores hasta el frame anterior)
+    if (m_showTimingHud) {
+        drawTimingHud(painter, rect());
+    }
+}
+
+QPixmap WaveformRenderer::createLayer(const QSize& size, bool transparent) const
+{
+    const qreal dpr = devicePixelRatioF();
+    QPixmap layer(size * dpr);
+    layer.setDevicePixelRatio(dpr);
+    layer.fill(transparent ? Qt::transparent : m_config.backgroundColor);
+    return layer;
+}
+
+void WaveformRenderer::ensureStaticLayer()
+{
+    const QSize layerSize = size();
+    if (!m_staticDirty && m_staticLayer.deviceIndependentSize().toSize() == layerSize) {
+        return;
+    }
+
+    m_staticLayer = createLayer(layerSize, false);
+    QPainter painter(&m_staticLayer);
 
-    // 4) Dibujar escala vertical lineal
+    const QRect fullRect(QPoint(0, 0), layerSize);
+    drawAudacityBackground(painter, fullRect);
+
+    // Escala vertical lineal en el margen izquierdo
     painter.setPen(Qt::white);
     QFontMetrics fm(painter.font());
+    const int wfH = fullRect.height();
     int ticks = 4;  // 5 líneas: +1, +0.5, 0, -0.5, -1
     for (int i = 0; i <= ticks; ++i) {
         float norm = 1.0f - 2.0f * (float(i) / ticks);  // de 1 a -1
-        int y = waveformRect.top()
-                + int(((1.0f - norm) / 2.0f) * wfH);
+        int y = int(((1.0f - norm) / 2.0f) * wfH);
         // Marca pequeña
-        painter.drawLine(waveformRect.left() - 5, y,
-                         waveformRect.left() - 1, y);
+        painter.drawLine(LeftMargin - 5, y, LeftMargin - 1, y);
         // Etiqueta lineal
         QString linLabel = QString::number(norm, 'f', 1);
         painter.drawText(QRect(0, y - fm.height()/2,
-                               marginLeft - 8, fm.height()),
+                               LeftMargin - 8, fm.height()),
                          Qt::AlignRight, linLabel);
     }
 
-    // 5) Dibujar la waveform en el área restante
-    painter.save();
-    painter.translate(waveformRect.topLeft());
-    painter.setClipRect(0, 0, wfW, wfH);
-    drawAudacityWaveform(painter, wfH, wfW);
-    painter.restore();
+    m_staticDirty = false;
+}
 
-    // 6) Línea central horizontal
-    painter.setPen(QPen(QColor(100,100,100), 1));
-    int centerY = waveformRect.top() + wfH / 2;
-    painter.drawLine(waveformRect.left(),  centerY,
-                     waveformRect.right(), centerY);
+void WaveformRenderer::ensureDataLayer()
+{
+    const qreal dpr = devicePixelRatioF();
+    const QSize layerSize = QSize(std::max(1, width() - LeftMargin), std::max(1, height())) * dpr;
+    if (!m_dataDirty && m_dataLayer.size() == layerSize) {
+        return;
+    }
+
+    RenderTimingStats::Scope timing(m_timing, RenderTimingStats::ImageUpdate);
 
-    // 7) Información de estado
-    drawStatusInfo(painter, fullRect);
+    if (m_dataLayer.size() != layerSize) {
+        m_dataLayer = QImage(layerSize, QImage::Format_ARGB32_Premultiplied);
+        m_dataLayer.setDevicePixelRatio(dpr);
+    }
+
+    if (m_config.rasterEngine || m_historyMode || m_store) {
+        renderRasterWaveform();
+    } else {
+        m_dataLayer.fill(Qt::transparent);
+        QPainter painter(&m_dataLayer);
+        painter.setRenderHint(QPainter::Antialiasing, true);
+
+        const int wfW = std::max(1, width() - LeftMargin);
+        const int wfH = std::max(1, height());
+        drawAudacityWaveform(painter, wfH, wfW);
+
+        // Línea central horizontal
+        painter.setRenderHint(QPainter::Antialiasing, false);
+        painter.setPen(QPen(QColor(100,100,100), 1));
+        painter.drawLine(0, wfH / 2, wfW - 1, wfH / 2);
+    }
+
+    m_dataDirty = false;
+}
+
+void WaveformRenderer::renderRasterWaveform()
+{
+    if (m_historyMode) {
+        // El proveedor ya entrega un tramo por columna
+        m_spans = m_historyWindow.spans;
+    } else if (m_store) {
+        readStoreSpans(m_dataLayer.width());
+    } else {
+        // Extremos por bloque en arrays contiguos para la reducción por columna
+        const int blocks = m_blocks.size();
+        m_blockMin.resize(blocks);
+        m_blockMax.resize(blocks);
+        m_blockRms.resize(blocks);
+        for (int i = 0; i < blocks; ++i) {
+            m_blockMin[i] = m_blocks[i].minValue;
+            m_blockMax[i] = m_blocks[i].maxValue;
+            m_blockRms[i] = m_blocks[i].rmsValue;
+        }
+
+        // Una columna por píxel físico
+        const int columns = m_dataLayer.width();
+        WaveformRaster::computeSpans(m_blockMin.constData(), m_blockMax.constData(),
+                                     m_blockRms.constData(), blocks, columns, m_spans);
+    }
+
+    WaveformRaster::Style style;
+    style.peakColor = m_config.peakColor.rgb();
+    style.rmsColor = m_config.rmsColor.rgb();
+    style.showRms = m_config.showRMS;
+    style.antialias = m_config.antialias;
+    style.scale = amplitudeScale();
+    m_raster.render(m_dataLayer, m_dataLayer.rect(), m_spans, style);
+
+    // Línea central encima de la waveform
+    const QRgb centerColor = qRgb(100, 100, 100);
+    QRgb* row = reinterpret_cast<QRgb*>(m_dataLayer.scanLine(m_dataLayer.height() / 2));
+    std::fill(row, row + m_dataLayer.width(), centerColor);
+}
+
+void WaveformRenderer::readStoreSpans(int columns)
+{
+    // Últimos maxVisibleBlocks bloques, desde el nivel con ~1 entrada por columna
+    const qint64 end = m_storeEnd;
+    const qint64 start = std::max(m_store->firstBlock(),
+                                  end - std::max(1, m_config.maxVisibleBlocks));
+    const int level = m_store->peakLevelFor(double(end - start) / std::max(1, columns));
+    const SpectrumStore::PeakRange range =
+        m_store->readPeaks(level, start, end, m_blockMin, m_blockMax, &m_blockRms);
+    m_storeVisibleBlocks = range.endBlock - range.firstBlock;
+
+    const int entries = range.count();
+    if (m_config.autoScale) {
+        for (int i = 0; i < entries; ++i) {
+            m_maxAmplitude = std::max(m_maxAmplitude,
+                                      std::max(std::abs(m_blockMin[i]), std::abs(m_blockMax[i])));
+        }
+    }
+    WaveformRaster::computeSpans(m_blockMin.constData(), m_blockMax.constData(),
+                                 m_blockRms.constData(), entries, columns, m_spans);
 }
 
 void WaveformRenderer::resizeEvent(QResizeEvent* event)
 {
     QWidget::resizeEvent(event);
     updateVisibleRange();
+    if (m_historyMode && m_provider) {
+        requestHistoryWindow();
+    }
+    m_staticDirty = true;
+    m_dataDirty = true;
     m_needsUpdate = true;
 }
 
@@ -246,6 +482,20 @@ void WaveformRenderer::mousePressEvent(QMouseEvent* event)
 
 void WaveformRenderer::wheelEvent(QWheelEvent* event)
 {
+    // Modo histórico: zoom temporal alrededor del cursor, hasta unas pocas muestras
+    if (m_historyMode && !(event->modifiers() & Qt::ShiftModifier)) {
+        const double factor = event->angleDelta().y() > 0 ? 1.0 / 1.25 : 1.25;
+        const qint64 span = m_historyEnd - m_historyStart;
+        const double rel = std::clamp(double(event->position().x() - LeftMargin)
+                                          / std::max(1, width() - LeftMargin), 0.0, 1.0);
+        const double anchor = m_historyStart + rel * span;
+        const qint64 newSpan = std::max<qint64>(8, qint64(std::llround(span * factor)));
+        const qint64 newStart = std::max<qint64>(0, qint64(std::llround(anchor - rel * newSpan)));
+        showFrameRange(newStart, newStart + newSpan);
+        event->accept();
+        return;
+    }
+
     // Zoom con la rueda del ratón
     float zoomFactor = 1.2f;
     if (event->angleDelta().y() > 0) {
@@ -434,21 +684,44 @@ void WaveformRenderer::drawStatusInfo(QPainter& painter, const QRect& rect)
     QRect statusRect(rect.left() + 5, rect.top() + 5, 250, 20);
     painter.fillRect(statusRect, QColor(0, 0, 0, 100));
 
-    // Texto con estilo Audacity
+    // Texto con estilo Audacity (fuente preparada en el constructor)
     painter.setPen(QColor(200, 200, 200));
-    QFont font = painter.font();
-    font.setPointSize(9);
-    font.setFamily("Arial");
-    painter.setFont(font);
-
-    QString statusText = QString("Bloques: %1 | Zoom: %2x | Amplitud: %3")
-                             .arg(m_blocks.size())
-                             .arg(m_zoom, 0, 'f', 1)
-                             .arg(m_maxAmplitude, 0, 'f', 3);
+    painter.setFont(m_statusFont);
+
+    QString statusText = m_historyMode
+        ? QString("Muestras: %1-%2 | %3 muestras/px%4")
+              .arg(m_historyStart)
+              .arg(m_historyEnd)
+              .arg(m_historyWindow.framesPerColumn, 0, 'f', 2)
+              .arg(m_historyWindow.exact ? "" : " (resumen)")
+        : QString("Bloques: %1 | Zoom: %2x | Amplitud: %3")
+              .arg(m_store ? m_storeVisibleBlocks : qint64(m_blocks.size()))
+              .arg(m_zoom, 0, 'f', 1)
+              .arg(m_maxAmplitude, 0, 'f', 3);
 
     painter.drawText(statusRect, Qt::AlignLeft | Qt::AlignVCenter, statusText);
 }
 
+void WaveformRenderer::drawTimingHud(QPainter& painter, const QRect& rect)
+{
+    const QStringList lines = m_timing.hudLines();
+    QFontMetrics fm(m_statusFont);
+    const int lineH = fm.height();
+    int textW = 0;
+    for (const QString& line : lines) {
+        textW = std::max(textW, fm.horizontalAdvance(line));
+    }
+
+    // Esquina superior derecha, para no tapar la línea de estado
+    QRect hudRect(rect.right() - textW - 15, rect.top() + 5, textW + 10, lineH * lines.size() + 6);
+    painter.fillRect(hudRect, QColor(0, 0, 0, 160));
+    painter.setPen(QColor(200, 200, 200));
+    painter.setFont(m_statusFont);
+    for (int i = 0; i < lines.size(); ++i) {
+        painter.drawText(hudRect.left() + 5, hudRect.top() + 3 + i * lineH + fm.ascent(), lines[i]);
+    }
+}
+
 void WaveformRenderer::drawPixelDensityWaveform(QPainter& painter, int height, int width)
 {
     // Redirigir al método específico de Audacity
@@ -523,14 +796,17 @@ void WaveformRenderer::updateVisibleRange()
     }
 }
 
-float WaveformRenderer::scaleValue(float value, int height) const
+float WaveformRenderer::amplitudeScale() const
 {
-    float scale = m_config.autoScale ?
-                      (1.0f / (m_maxAmplitude * m_zoom)) :
-                      m_config.manualScale * m_zoom;
+    return m_config.autoScale ?
+               (1.0f / (m_maxAmplitude * m_zoom)) :
+               m_config.manualScale * m_zoom;
+}
 
+float WaveformRenderer::scaleValue(float value, int height) const
+{
     // Usar todo el espacio disponible con un poco de margen
-    return value * scale * (height / 2.2f);
+    return value * amplitudeScale() * (height / 2.2f);
 }
 
 int WaveformRenderer::getBlockAtPosition(int x) const
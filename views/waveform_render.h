@@ -2,11 +2,17 @@
 #define WAVEFORM_RENDER_H
 
 #include "core/dsp_worker.h"
+#include "core/frame_bus.h"
+#include "core/render_timing_stats.h"
+#include "core/spectrum_store.h"
+#include "views/waveform_data_provider.h"
 #include <QWidget>
 #include <QVector>
 #include <QPainter>
+#include <QPixmap>
 #include <QTimer>
 #include <QMutex>
+#include <QPointer>
 #include <QtTypes>
 
 #include <QMetaType>
@@ -44,6 +50,8 @@ struct WaveformConfig {
     float manualScale = 1.0f;       ///< Escala manual cuando autoScale = false
     bool scrolling = true;          ///< Desplazamiento automático
     int updateInterval = 30;        ///< Intervalo de actualización en ms
+    bool rasterEngine = true;       ///< Tramos escritos directamente en un QImage (false = QPainter)
+    bool antialias = false;         ///< Cobertura en los extremos de cada tramo (motor raster)
 };
 
 Q_DECLARE_METATYPE(WaveformConfig);
@@ -70,6 +78,51 @@ public:
     int getVisibleBlocks() const;
     qint64 getLatestTimestamp() const;
 
+    /**
+     * @brief Suscribe la vista al bus de frames
+     *
+     * El buzón se vacía en cada tick de updateDisplay(); nullptr desconecta.
+     */
+    void attachFrameBus(FrameBus* bus, const FrameSubscription& subscription);
+
+    /**
+     * @brief Lee el stream en vivo de la pirámide de picos compartida
+     *
+     * La vista no guarda bloques: en cada tick lee el nivel de la pirámide
+     * que corresponde a maxVisibleBlocks / anchura, así que varias vistas
+     * a distinto zoom cuestan sólo sus píxeles. nullptr vuelve a los
+     * bloques propios.
+     */
+    void attachStore(SpectrumStore* store);
+
+    /** Nombre bajo el que se publican los tiempos ("render.<nombre>.") */
+    void setMetricsName(const QString& name) { m_timing.setName(name); }
+
+    /**
+     * @brief Proveedor para ver la sesión guardada a cualquier zoom
+     *
+     * En modo histórico la rueda hace zoom temporal alrededor del cursor
+     * (con Shift, zoom de amplitud) y los datos se piden al proveedor.
+     */
+    void setDataProvider(WaveformDataProvider* provider);
+
+    /** Muestra [frameStart, frameEnd) de la sesión del proveedor */
+    void showFrameRange(qint64 frameStart, qint64 frameEnd);
+
+    /** Vuelve a la vista en vivo */
+    void showLive();
+    bool isShowingHistory() const { return m_historyMode; }
+
+    /**
+     * @brief HUD con los tiempos de procesado, capa de datos y pintado
+     *
+     * Los tiempos se miden siempre y se publican en el MetricsRegistry
+     * bajo "render.waveform."; el HUD sólo controla si se dibujan.
+     */
+    void setTimingHudVisible(bool visible);
+    bool isTimingHudVisible() const { return m_showTimingHud; }
+    const RenderTimingStats& timingStats() const { return m_timing; }
+
 public slots:
     /** Procesar frames del DSPWorker */
     void processFrames(const QVector<FrameData>& frames);
@@ -98,6 +151,7 @@ protected:
 
 private slots:
     void updateDisplay();
+    void onWindowReady(const WaveformWindow& window);
 
 private:
     // Métodos de configuración
@@ -114,6 +168,16 @@ private:
     void drawAudacityInterpolatedWaveform(QPainter& painter, int height, int width);
     void drawAudacityDensityWaveform(QPainter& painter, int height, int width, float blocksPerPixel);
     void drawStatusInfo(QPainter& painter, const QRect& rect);
+    void drawTimingHud(QPainter& painter, const QRect& rect);
+
+    // Capas en caché: fondo + escala (estática) y waveform (datos)
+    void ensureStaticLayer();
+    void ensureDataLayer();
+    void renderRasterWaveform();
+    void readStoreSpans(int columns);
+    bool hasLiveData() const;
+    void requestHistoryWindow();
+    QPixmap createLayer(const QSize& size, bool transparent) const;
 
     // Métodos de manejo de bloques
     void addBlock(const WaveformBlock& block);
@@ -121,15 +185,22 @@ private:
 
     // Métodos de utilidad
     void updateVisibleRange();
+    float amplitudeScale() const;
     float scaleValue(float value, int height) const;
     int getBlockAtPosition(int x) const;
 
+    static constexpr int LeftMargin = 40;   ///< Espacio para la escala vertical
+
     // Configuración y datos
     WaveformConfig m_config;
     QVector<WaveformBlock> m_blocks;
     mutable QMutex m_mutex;
     QTimer* m_updateTimer;
 
+    // Suscripción al bus de frames
+    QPointer<FrameBus> m_frameBus;
+    FrameBus::SubscriberId m_busId = 0;
+
     // Estado de renderizado
     float m_maxAmplitude;
     float m_zoom;
@@ -137,6 +208,37 @@ private:
     bool m_paused;
     bool m_needsUpdate;
 
+    // Capas de pintado; la estática sólo cambia con el tamaño o la configuración
+    QPixmap m_staticLayer;
+    QImage m_dataLayer;                    ///< ARGB32 premultiplicado, en píxeles físicos
+    bool m_staticDirty = true;
+    bool m_dataDirty = true;
+    QFont m_statusFont;
+
+    // Motor raster y buffers reutilizados entre frames
+    WaveformRaster m_raster;
+    QVector<WaveformSpan> m_spans;
+    QVector<float> m_blockMin;
+    QVector<float> m_blockMax;
+    QVector<float> m_blockRms;
+
+    // Pirámide de picos compartida (modo almacén)
+    QPointer<SpectrumStore> m_store;
+    qint64 m_storeEnd = -1;
+    quint64 m_storeGeneration = 0;
+    qint64 m_storeVisibleBlocks = 0;
+
+    // Vista histórica servida por el proveedor
+    QPointer<WaveformDataProvider> m_provider;
+    bool m_historyMode = false;
+    qint64 m_historyStart = 0;
+    qint64 m_historyEnd = 0;
+    WaveformWindow m_historyWindow;
+
+    // Tiempos de renderizado
+    RenderTimingStats m_timing{QStringLiteral("waveform")};
+    bool m_showTimingHud = false;
+
     // Rango visible
     int m_visibleStartIndex;
     int m_visibleEndIndex;